@@ -0,0 +1,49 @@
+#-------------------------------------------------
+#
+# Tests and benchmarks, linked with the application sources
+#
+#-------------------------------------------------
+
+include(AnimusZ.pro)
+
+TARGET = AnimusTests
+CONFIG += console testcase
+QT += testlib
+
+SOURCES -= main.cpp
+
+SOURCES += Tests/TestMain.cpp \
+        Tests/TestUtils.cpp \
+        Tests/PartitionedVideoRecorderTest.cpp \
+        Tests/SessionDataWriterBenchmark.cpp \
+        Tests/MapTilePackTest.cpp \
+        Tests/BallisticMacroTest.cpp \
+        Tests/ImageCorrectorTest.cpp \
+        Tests/XPlaneVideoReceiverTest.cpp \
+        Tests/ImageTrackerCorrelationTest.cpp \
+        Tests/ImageStabilazationBenchmark.cpp \
+        Tests/MUSVProtocolTest.cpp \
+        Tests/UdpBatchReceiverTest.cpp \
+        Tests/MapTileDownloaderTest.cpp \
+        UAVSimulator/UAVSimTileServer.cpp \
+        UAVSimulator/UAVSimXPlaneVideoEncoder.cpp
+
+HEADERS += Tests/TestUtils.h \
+        Tests/PartitionedVideoRecorderTest.h \
+        Tests/SessionDataWriterBenchmark.h \
+        Tests/MapTilePackTest.h \
+        Tests/BallisticMacroTest.h \
+        Tests/ImageCorrectorTest.h \
+        Tests/XPlaneVideoReceiverTest.h \
+        Tests/ImageTrackerCorrelationTest.h \
+        Tests/ImageStabilazationBenchmark.h \
+        Tests/MUSVProtocolTest.h \
+        Tests/UdpBatchReceiverTest.h \
+        Tests/MapTileDownloaderTest.h \
+        UAVSimulator/UAVSimTileServer.h \
+        UAVSimulator/UAVSimXPlaneVideoEncoder.h
+
+OBJECTS_DIR = $$DESTDIR/.obj_tests
+MOC_DIR = $$DESTDIR/.moc_tests
+RCC_DIR = $$DESTDIR/.qrc_tests
+UI_DIR = $$DESTDIR/.ui_tests
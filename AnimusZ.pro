@@ -81,11 +81,14 @@ SOURCES += main.cpp \
         Map/GSIUAVMarker.cpp \
         Map/GSIAntennaMarker.cpp \
         Map/GSITrackedObject.cpp \
+        Map/GSITrajectory.cpp \
         Map/HeightMapContainer.cpp\
         Map/MapTileContainer.cpp\
         Map/MapTileDownloader.cpp\
+        Map/MapTileLoader.cpp \
         Map/MapTilesExporter.cpp \
         Map/MapTilesImporter.cpp \
+        Map/MapTilePack.cpp \
         Map/MarkerThesaurus.cpp \
         Map/MarkerStorage.cpp \
         Map/MarkerStorageItems.cpp \
@@ -97,9 +100,13 @@ SOURCES += main.cpp \
         ApplicationSettings.cpp\
         PreferenceAssociation.cpp \
         TelemetryDataStorage.cpp \
+        PipelineBenchmark.cpp \
+        SessionDataWriter.cpp \
         VideoRecorder/CameraFrameGrabber.cpp \
         VideoRecorder/PartitionedVideoRecorder.cpp \
+        VideoRecorder/MJPEGAviWriter.cpp \
         TelemetryDataFrame.cpp \
+        TelemetryFrameStore.cpp \
         EnterProc.cpp \
         ImageProcessor/ImageProcessor.cpp \
         ImageProcessor/ImageStabilazation.cpp \
@@ -117,6 +124,7 @@ SOURCES += main.cpp \
         HardwareLink/CalibrationImageVideoReceiver.cpp \
         HardwareLink/lz4.c \
         HardwareLink/TrackerHardwareLink.cpp \
+        HardwareLink/UdpBatchReceiver.cpp \
         HardwareLink/MUSV/protocol.cpp \        
         #HardwareLink/MUSV2/CorrelationVideoTrackerProtocolParser.cpp \
         #HardwareLink/MUSV2/VideoDataProtocolParser.cpp \
@@ -183,11 +191,14 @@ HEADERS  += stable.h \
         Map/GSIUAVMarker.h \
         Map/GSIAntennaMarker.h \
         Map/GSITrackedObject.h \
+        Map/GSITrajectory.h \
         Map/HeightMapContainer.h \
         Map/MapTileContainer.h\
         Map/MapTileDownloader.h\
+        Map/MapTileLoader.h \
         Map/MapTilesExporter.h \
         Map/MapTilesImporter.h \
+        Map/MapTilePack.h \
         Map/MarkerThesaurus.h \
         Map/MarkerStorage.h \
         Map/MarkerStorageItems.h \
@@ -199,9 +210,13 @@ HEADERS  += stable.h \
         ApplicationSettings.h \
         PreferenceAssociation.h \
         TelemetryDataStorage.h \
+        PipelineBenchmark.h \
+        SessionDataWriter.h \
         VideoRecorder/CameraFrameGrabber.h \
         VideoRecorder/PartitionedVideoRecorder.h \
+        VideoRecorder/MJPEGAviWriter.h \
         TelemetryDataFrame.h \
+        TelemetryFrameStore.h \
         EnterProc.h \
         ImageProcessor/ImageProcessor.h \
         ImageProcessor/ImageStabilazation.h \
@@ -220,6 +235,7 @@ HEADERS  += stable.h \
         HardwareLink/lz4.h \
         HardwareLink/MUSV/protocol.h \
         HardwareLink/TrackerHardwareLink.h \
+        HardwareLink/UdpBatchReceiver.h \
         #HardwareLink/MUSV2/CorrelationVideoTrackerVersion.h \
         #HardwareLink/MUSV2/CorrelationVideoTrackerDataStructures.h \
         #HardwareLink/MUSV2/CorrelationVideoTrackerProtocolParser.h \
@@ -235,6 +251,7 @@ HEADERS  += stable.h \
         Common/CommonWidgets.h \
         Common/CommonData.h \
         Common/CommonUtils.h \
+        Common/SpscRingBuffer.h \
         Constants.h \
         Common/BinaryContent.h
 
@@ -268,12 +285,14 @@ QMAKE_LIBS += -lgomp -lpthread
 
 SOURCES +=  ImageProcessor/ImageTracker.cpp \
             ImageProcessor/CorrelationVideoTracker/ImageTrackerCorrelation.cpp \
-            ImageProcessor/CorrelationVideoTracker/CorrelationVideoTracker.cpp
+            ImageProcessor/CorrelationVideoTracker/CorrelationVideoTracker.cpp \
+            ImageProcessor/CorrelationVideoTracker/RealFFT2D.cpp
 
 HEADERS +=  ImageProcessor/ImageTracker.h \
             ImageProcessor/CorrelationVideoTracker/ImageTrackerCorrelation.h \
             ImageProcessor/CorrelationVideoTracker/CorrelationVideoTracker.h \
-            ImageProcessor/CorrelationVideoTracker/CorrelationVideoTrackerDataStructures.h
+            ImageProcessor/CorrelationVideoTracker/CorrelationVideoTrackerDataStructures.h \
+            ImageProcessor/CorrelationVideoTracker/RealFFT2D.h
 
 
 DESTDIR = ./
@@ -20,6 +20,7 @@ const QString DefaultJoystickMapping = "a:b2,b:b1,x:b3,y:b0,back:b8,start:b9,lef
                                        "b4,rightshoulder:b5,dpup:h0.1,dpdown:h0.4,dpleft:h0.8,dpright:h0.2,leftx:a0,lef"
                                        "ty:a1,rightx:a2,righty:a4,lefttrigger:b6,righttrigger:b7,platform:Windows,";
 
+// CoordinateCalculator evaluates this macro natively (CalculateStockTimeToDropBomb), keep them in sync
 const QString DefaultBallisticMacro =
     "// wind_direction, wind_speed, uav_lat, uav_lon, uav_hmsl, \n"
     "// uav_groundspeed, uav_airspeed, uav_course, uav_airspeed, \n"
@@ -59,6 +60,7 @@ ApplicationSettings::ApplicationSettings() : ApplicationSettingsRoot(),
     InstalledCameraIndex(this, "Sessions/CurrentCameraIndex", 0),
 
     TileReceivingMode(this, "Databases/TileReceivingMode", 0), // TileReceivingMode::DatabaseOnly == 0
+    TileServerURL(this, "Databases/TileServerURL", ""), // replaces the tile providers when set
     DatabaseMapDownloadCashe(this, "Databases/DatabaseDownloadCashe", "DownloadCashe.db"),
     DatabaseHeightMap(this, "Databases/DatabaseHeightMap", "HeightMap.db"),
     DatabaseGeocoder(this, "Databases/DatabaseGeocoder", "GeoCoder.db"),
@@ -69,6 +71,7 @@ ApplicationSettings::ApplicationSettings() : ApplicationSettingsRoot(),
     SessionsFolder(this, "Sessions/SessionsFolder", "Sessions"),
     LogFolderMaxSizeMb(this, "Sessions/LogFolderMaxSizeMb", 50),
     LogFolderCleanup(this, "Sessions/LogFolderCleanup", true),
+    TelemetryHistoryMemoryLimitMb(this, "Sessions/TelemetryHistoryMemoryLimitMb", 256),
     CommandSendingInterval(this, "Sessions/CommandSendingInterval", 300),
     CommandProtocol(this, "Sessions/CommandProtocol", CommandProtocols::MUSV),
     CommandTransport(this, "Sessions/CommandTransport", CommandTransports::UDP),
@@ -83,6 +86,7 @@ ApplicationSettings::ApplicationSettings() : ApplicationSettingsRoot(),
 
     UseExtTelemetryUDP(this, "Sessions/UseExtTelemetryUDP", false),
     ExtTelemetryUDPPort(this, "Sessions/ExtTelemetryUDPPort", 1122),
+    UseBatchUDPReceiving(this, "Sessions/UseBatchUDPReceiving", false),
 
     VideoLagFromTelemetry(this, "Sessions/VideoLagFromTelemetry", 0),
     VideoLagFromCameraTelemetry(this, "Sessions/VideoLagFromCameraTelemetry", 0),
@@ -98,8 +102,12 @@ ApplicationSettings::ApplicationSettings() : ApplicationSettingsRoot(),
     ArtilleryMountAddress(this, "Sessions/ArtilleryMountAddress", "192.168.1.101"),
     ArtilleryMountTCPPort(this, "Sessions/ArtilleryMountTCPPort", 60000),
     ExternalDataConsoleUDPPort(this, "Sessions/ExternalDataConsoleUDPPort", 45570),
+    ExternalDataConsoleSubscriptionPortOffset(this, "Sessions/ExternalDataConsoleSubscriptionPortOffset", 1),
+    ExternalDataConsoleAlwaysBroadcast(this, "Sessions/ExternalDataConsoleAlwaysBroadcast", false),
     ObjectTrackerType(this, "Sessions/ObjectTrackerType", ObjectTrackerTypeEnum::InternalCorrelation),
     ShowExternalTrackerRectangle(this, "Sessions/ShowExternalTrackerRectangle", false),
+    VideoProcessingQueueSize(this, "Sessions/VideoProcessingQueueSize", 4),
+    VideoProcessingDropPolicy(this, "Sessions/VideoProcessingDropPolicy", VideoFrameDropPolicy::DropOldestVideoFrame),
     TrackerCommandUDPPort(this, "Sessions/TrackerCommandUDPPort", 50001),
     TrackerCommandUDPAddress(this, "Sessions/TrackerCommandUDPAddress", "192.168.100.2"),
     TrackerTelemetryUDPPort(this, "Sessions/TrackerTelemetryUDPPort", 50003),
@@ -315,6 +315,7 @@ public:
     ApplicationPreferenceInt InstalledCameraIndex;
 
     ApplicationPreferenceInt TileReceivingMode;
+    ApplicationPreferenceString TileServerURL;
     ApplicationPreferenceString DatabaseMapDownloadCashe;
     ApplicationPreferenceString DatabaseHeightMap;
     ApplicationPreferenceString DatabaseGeocoder;
@@ -325,6 +326,7 @@ public:
     ApplicationPreferenceString SessionsFolder;
     ApplicationPreferenceInt LogFolderMaxSizeMb;
     ApplicationPreferenceBool LogFolderCleanup;
+    ApplicationPreferenceInt TelemetryHistoryMemoryLimitMb;
     ApplicationPreferenceInt CommandSendingInterval;
     ApplicationPreferenceEnum<CommandProtocols> CommandProtocol;
     ApplicationPreferenceEnum<CommandTransports> CommandTransport;
@@ -338,6 +340,7 @@ public:
     ApplicationPreferenceInt CamTelemetryUDPPort;
     ApplicationPreferenceBool UseExtTelemetryUDP;
     ApplicationPreferenceInt ExtTelemetryUDPPort;
+    ApplicationPreferenceBool UseBatchUDPReceiving;
     ApplicationPreferenceInt VideoLagFromTelemetry;
     ApplicationPreferenceInt VideoLagFromCameraTelemetry;
     ApplicationPreferenceBool EnableForwarding;
@@ -352,8 +355,12 @@ public:
     ApplicationPreferenceString ArtilleryMountAddress;
     ApplicationPreferenceInt ArtilleryMountTCPPort;
     ApplicationPreferenceInt ExternalDataConsoleUDPPort;
+    ApplicationPreferenceInt ExternalDataConsoleSubscriptionPortOffset;
+    ApplicationPreferenceBool ExternalDataConsoleAlwaysBroadcast;
     ApplicationPreferenceEnum<ObjectTrackerTypeEnum> ObjectTrackerType;
     ApplicationPreferenceBool ShowExternalTrackerRectangle;
+    ApplicationPreferenceInt VideoProcessingQueueSize;
+    ApplicationPreferenceEnum<VideoFrameDropPolicy> VideoProcessingDropPolicy;
     ApplicationPreferenceInt TrackerCommandUDPPort;
     ApplicationPreferenceString TrackerCommandUDPAddress;
     ApplicationPreferenceInt TrackerTelemetryUDPPort;
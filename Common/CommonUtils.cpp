@@ -31,6 +31,17 @@ double GetCurrentDateTimeFrom1970Secs()
     return dateTimeResult;
 }
 
+const QString getCommandLineValue(const QStringList &arguments, const QString &key)
+{
+    foreach (auto keyValue, arguments)
+    {
+        int separatorPos = keyValue.indexOf('=');
+        if (separatorPos > 0 && keyValue.left(separatorPos).compare(key, Qt::CaseInsensitive) == 0)
+            return keyValue.mid(separatorPos + 1);
+    }
+    return "";
+}
+
 const QString getTimeAsString(quint32 timeMs)
 {
     quint32 msec = timeMs % 1000;
@@ -25,6 +25,8 @@ double GetCurrentDateTimeFrom1970Secs();
 const QString getTimeAsString(quint32 timeMs);
 int randomBetween(int low, int high);
 const QFont getMonospaceFont();
+// Value of the KEY=value command line argument, the key is case insensitive
+const QString getCommandLineValue(const QStringList &arguments, const QString &key);
 
 // Range (0, 360)
 double constrainAngle360(double x);
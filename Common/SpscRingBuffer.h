@@ -0,0 +1,67 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+// Lock-free bounded queue for exactly one producer thread and one consumer thread.
+// Capacity is rounded up to a power of two.
+template <typename T>
+class SpscRingBuffer final
+{
+    std::vector<T> _items;
+    size_t _mask;
+    alignas(64) std::atomic<size_t> _head; // next item to pop, written by the consumer
+    alignas(64) std::atomic<size_t> _tail; // next free slot, written by the producer
+
+public:
+    explicit SpscRingBuffer(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        _items.resize(size);
+        _mask = size - 1;
+        _head.store(0, std::memory_order_relaxed);
+        _tail.store(0, std::memory_order_relaxed);
+    }
+
+    bool push(const T &item)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) > _mask)
+            return false;
+        _items[tail & _mask] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &item)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire))
+            return false;
+        item = std::move(_items[head & _mask]);
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const
+    {
+        return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const
+    {
+        return _mask + 1;
+    }
+
+    bool isEmpty() const
+    {
+        return size() == 0;
+    }
+};
+
+#endif // SPSCRINGBUFFER_H
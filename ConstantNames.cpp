@@ -93,6 +93,16 @@ const QMap<int, QString> ConstantNames::ObjectTrackerTypeCaptions()
     return mapObjectTrackerTypeCaptions;
 }
 
+const QMap<int, QString> ConstantNames::VideoFrameDropPolicyCaptions()
+{
+    static const QMap<int, QString> mapVideoFrameDropPolicyCaptions {
+        { VideoFrameDropPolicy::DropOldestVideoFrame,   tr("Drop Oldest Frames")  },
+        { VideoFrameDropPolicy::KeepLatestVideoFrame,   tr("Keep Latest Frame")   },
+        { VideoFrameDropPolicy::BlockVideoReceiving,    tr("Wait for Processing") }
+    };
+    return mapVideoFrameDropPolicyCaptions;
+}
+
 
 const QMap<int, QString> ConstantNames::ApplicationLanguageCaptions()
 {
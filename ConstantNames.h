@@ -19,6 +19,7 @@ public:
     static const QMap<int, QString> UAVTelemetryFormatCaptions();
     static const QMap<int, QString> CommandProtocolCaptions();
     static const QMap<int, QString> ObjectTrackerTypeCaptions();
+    static const QMap<int, QString> VideoFrameDropPolicyCaptions();
     static const QMap<int, QString> ApplicationLanguageCaptions();
     static const QMap<int, QString> ApplicationStyleCaptions();
     static const QMap<int, QString> CameraControlModeCaptions();
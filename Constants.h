@@ -128,6 +128,13 @@ enum ObjectTrackerTypeEnum
     External
 };
 
+enum VideoFrameDropPolicy
+{
+    DropOldestVideoFrame,
+    KeepLatestVideoFrame,
+    BlockVideoReceiving
+};
+
 enum OSDTelemetryTimeFormat
 {
     NoDateTime,
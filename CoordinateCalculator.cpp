@@ -45,6 +45,116 @@ WorldGPSCoord CalculatePointPosition(const TelemetryDataFrame &telemetryDataFram
 }
 
 
+// Native version of the stock ballistic macro (DefaultBallisticMacro), keep them in sync
+double CalculateStockTimeToDropBomb(const TelemetryDataFrame &telemetryDataFrame)
+{
+    const double groundSpeed = telemetryDataFrame.GroundSpeed_GPS;
+    if (!(groundSpeed > 0))
+        return -1;
+
+    const double fallHeight = telemetryDataFrame.UavAltitude_GPS - telemetryDataFrame.BombingPlacePosHmsl;
+    const double fallTime = sqrt(2 * fallHeight / 9.80665);
+    const double bombOffset = groundSpeed * fallTime;
+    const double dropPointDistance = telemetryDataFrame.DistanceToBombingPlace - bombOffset * 0.92;
+    return dropPointDistance < 0 ? -1 : (dropPointDistance / groundSpeed + 0.5);
+}
+
+// Macro arguments, the order must match the argument list in BallisticMacroSolver::timeToDropByMacro
+constexpr char BALLISTIC_MACRO_ARGUMENTS[] =
+        "wind_direction, wind_speed, "
+        "uav_lat, uav_lon, uav_hmsl, uav_groundspeed, uav_airspeed, uav_course, uav_verticalspeed, "
+        "target_lat, target_lon, target_hmsl, target_distance, target_azimuth";
+
+BallisticMacroSolver::BallisticMacroSolver()
+{
+    _useNativeSolver = false;
+}
+
+void BallisticMacroSolver::setMacro(const QString &macro, bool allowNativeSolver)
+{
+    ApplicationSettings& applicationSettings = ApplicationSettings::Instance();
+    _macro = macro;
+    _useNativeSolver = allowNativeSolver && (_macro.trimmed() == applicationSettings.BallisticMacro.defaultValue().trimmed());
+    _function = QJSValue();
+    if (_useNativeSolver)
+        return;
+
+    // Macro assigns its results to droppoint_time, droppoint_distance and debug_info,
+    // they are local variables of the wrapper function and returned as an array
+    const QString functionSource = QString(
+                "(function(%1) {\n"
+                "var droppoint_time = 0, droppoint_distance = 0, debug_info = '';\n"
+                "%2\n"
+                ";return [droppoint_time, droppoint_distance, debug_info];\n"
+                "})").arg(BALLISTIC_MACRO_ARGUMENTS, _macro);
+
+    QJSValue function = _scriptEngine.evaluate(functionSource);
+    if (function.isError() || !function.isCallable())
+        qWarning() << "Ballistic macro compilation failed:" << function.toString();
+    else
+        _function = function;
+}
+
+const QString &BallisticMacroSolver::macro() const
+{
+    return _macro;
+}
+
+bool BallisticMacroSolver::isNativeSolverUsed() const
+{
+    return _useNativeSolver;
+}
+
+double BallisticMacroSolver::timeToDrop(const TelemetryDataFrame &telemetryFrame)
+{
+    return _useNativeSolver ? CalculateStockTimeToDropBomb(telemetryFrame) : timeToDropByMacro(telemetryFrame);
+}
+
+double BallisticMacroSolver::timeToDropByMacro(const TelemetryDataFrame &telemetryFrame)
+{
+    if (!_function.isCallable())
+        return -1;
+
+    const QJSValueList arguments = {
+        telemetryFrame.WindDirection,
+        telemetryFrame.WindSpeed,
+        telemetryFrame.UavLatitude_GPS,
+        telemetryFrame.UavLongitude_GPS,
+        telemetryFrame.UavAltitude_GPS,
+        telemetryFrame.GroundSpeed_GPS,
+        telemetryFrame.AirSpeed,
+        telemetryFrame.Course_GPS,
+        telemetryFrame.VerticalSpeed,
+        telemetryFrame.BombingPlacePosLat,
+        telemetryFrame.BombingPlacePosLon,
+        telemetryFrame.BombingPlacePosHmsl,
+        telemetryFrame.DistanceToBombingPlace,
+        telemetryFrame.AzimuthToBombingPlace
+    };
+
+    const QJSValue result = _function.call(arguments);
+    if (result.isError())
+    {
+        qDebug() << "TFN: " << telemetryFrame.TelemetryFrameNumber << " Ballistic macro error: " << result.toString();
+        return -1;
+    }
+
+    double timeToDrop = -1;
+    auto scriptDropPointTimeProperty = result.property(0);
+    if (scriptDropPointTimeProperty.isNumber())
+        timeToDrop = scriptDropPointTimeProperty.toNumber();
+
+    auto scriptDebugInfoProperty = result.property(2);
+    if (!scriptDebugInfoProperty.isNull() && !scriptDebugInfoProperty.isUndefined())
+    {
+        QString info = scriptDebugInfoProperty.toString();
+        if (!info.isEmpty())
+            qDebug() << "TFN: " << telemetryFrame.TelemetryFrameNumber << " DebugInfo: " << info;
+    }
+
+    return timeToDrop;
+}
+
 //---------------------------------------------------------------------------------------
 
 const WorldGPSCoord CoordinateCalculator::getScreenPointCoord(TelemetryDataFrame *telemetryFrame, int x, int y) const
@@ -59,7 +169,7 @@ CoordinateCalculator::CoordinateCalculator(QObject *parent, HeightMapContainer *
     _heightMapContainer(heightMapContainer)
 {
     ApplicationSettings& applicationSettings = ApplicationSettings::Instance();
-    _ballisticMacro = applicationSettings.BallisticMacro;
+    _ballisticSolver.setMacro(applicationSettings.BallisticMacro);
     _useLaserRangefinderForGroundLevelCalculation =
             applicationSettings.UseLaserRangefinderForGroundLevelCalculation && applicationSettings.isLaserRangefinderLicensed();
     _useBombCaclulation = applicationSettings.isBombingTabLicensed();
@@ -184,9 +294,24 @@ void CoordinateCalculator::updateViewFieldBorderPoints(TelemetryDataFrame *telem
     auto camPreferences = _camAssemblyPreferences->opticalDevice(telemetryFrame->OpticalSystemId);
     int imageWidth  = camPreferences->frameWidth();
     int imageHeight = camPreferences->frameHeight();
+    _viewFieldBorderCoords.resize(ViewFieldBorderPointsCount);
+    for (int n = 0; n < ViewFieldBorderPointsCount; n++)
+        _viewFieldBorderCoords[n] = getScreenPointCoord(telemetryFrame, ViewFieldBorderPoints[n][0] * imageWidth, ViewFieldBorderPoints[n][1] * imageHeight);
+
+    // Points are projected to the ground level under the UAV first, then once more to the terrain found under them
+    _heightMapContainer->GetHeights(_viewFieldBorderCoords, _viewFieldBorderHeights);
     for (int n = 0; n < ViewFieldBorderPointsCount; n++)
     {
-        auto point = getScreenPointCoord(telemetryFrame, ViewFieldBorderPoints[n][0] * imageWidth, ViewFieldBorderPoints[n][1] * imageHeight);
+        if (_viewFieldBorderHeights[n] != INCORRECT_COORDINATE)
+        {
+            auto terrainPoint = CalculatePointPosition(*telemetryFrame, camPreferences,
+                                                       ViewFieldBorderPoints[n][0] * imageWidth, ViewFieldBorderPoints[n][1] * imageHeight,
+                                                       _viewFieldBorderHeights[n]);
+            // Terrain above the UAV or out of the visible range keeps the point on the ground level
+            if (!terrainPoint.isIncorrect())
+                _viewFieldBorderCoords[n] = terrainPoint;
+        }
+        const WorldGPSCoord &point = _viewFieldBorderCoords[n];
         telemetryFrame->ViewFieldBorderPointsLat[n] = point.lat;
         telemetryFrame->ViewFieldBorderPointsLon[n] = point.lon;
         telemetryFrame->ViewFieldBorderPointsHmsl[n] = point.hmsl;
@@ -233,63 +358,15 @@ void CoordinateCalculator::updateRemainingTimeToDropBomb(TelemetryDataFrame *tel
         telemetryFrame->RemainingTimeToDropBomb = INCORRECT_TIME;
         return;
     }
-    double timeToDrop = -1;
-
 
     // https://habr.com/ru/articles/481142/
 
-    auto activationObject = _scriptEngine.globalObject();
-
-    activationObject.setProperty("wind_direction", telemetryFrame->WindDirection);
-    activationObject.setProperty("wind_speed",telemetryFrame->WindSpeed);
-
-    activationObject.setProperty("uav_lat", telemetryFrame->UavLatitude_GPS);
-    activationObject.setProperty("uav_lon", telemetryFrame->UavLongitude_GPS);
-    activationObject.setProperty("uav_hmsl", telemetryFrame->UavAltitude_GPS);
-    activationObject.setProperty("uav_groundspeed", telemetryFrame->GroundSpeed_GPS);
-    activationObject.setProperty("uav_airspeed", telemetryFrame->AirSpeed);
-    activationObject.setProperty("uav_course", telemetryFrame->Course_GPS);
-    activationObject.setProperty("uav_verticalspeed", telemetryFrame->VerticalSpeed);
-
-    activationObject.setProperty("target_lat", telemetryFrame->BombingPlacePosLat);
-    activationObject.setProperty("target_lon", telemetryFrame->BombingPlacePosLon);
-    activationObject.setProperty("target_hmsl", telemetryFrame->BombingPlacePosHmsl);
-
-    activationObject.setProperty("target_distance", telemetryFrame->DistanceToBombingPlace);
-    activationObject.setProperty("target_azimuth", telemetryFrame->AzimuthToBombingPlace);
-
-    activationObject.setProperty("droppoint_time", 0);
-    activationObject.setProperty("droppoint_distance", 0);
-
-    activationObject.setProperty("debug_info", QString());
-
-    _scriptEngine.evaluate(_ballisticMacro);
-
-    auto scriptDropPointTimeProperty = activationObject.property("droppoint_time");
-    if (scriptDropPointTimeProperty.isNumber())
-        timeToDrop = scriptDropPointTimeProperty.toNumber();
-
-    auto scriptDebugInfoProperty = activationObject.property("debug_info");
-    if (!scriptDebugInfoProperty.isNull())
-    {
-        QString info = scriptDebugInfoProperty.toString();
-        if (!info.isEmpty())
-            qDebug() << "TFN: " << telemetryFrame->TelemetryFrameNumber << " DebugInfo: " << info;
-    }
-
-
-
-    /*
-    outPropertyToDebug(activationObject, "uav_hmsl");
-    outPropertyToDebug(activationObject, "uav_groundspeed");
-    outPropertyToDebug(activationObject, "target_hmsl");
-    outPropertyToDebug(activationObject, "target_distance");
-    outPropertyToDebug(activationObject, "droppoint_time");
-    outPropertyToDebug(activationObject, "droppoint_distance");
-    */
-
-    telemetryFrame->RemainingTimeToDropBomb = timeToDrop;
+    ApplicationSettings& applicationSettings = ApplicationSettings::Instance();
+    const QString ballisticMacro = applicationSettings.BallisticMacro;
+    if (ballisticMacro != _ballisticSolver.macro())
+        _ballisticSolver.setMacro(ballisticMacro);
 
+    telemetryFrame->RemainingTimeToDropBomb = _ballisticSolver.timeToDrop(*telemetryFrame);
 }
 
 void CoordinateCalculator::updateTargetSpeedFrames(TelemetryDataFrame *telemetryFrame)
@@ -4,7 +4,9 @@
 #include <QObject>
 #include <QPoint>
 #include <QJSEngine>
+#include <QJSValue>
 #include <QString>
+#include <QVector>
 #include "Common/CommonData.h"
 #include "TelemetryDataFrame.h"
 #include "CamPreferences.h"
@@ -12,19 +14,41 @@
 #include "HardwareLink/DelayLine.h"
 #include "ApplicationSettings.h"
 
+// Time to drop by the ballistic macro. The macro is compiled into a function once, the stock macro is solved natively
+class BallisticMacroSolver final
+{
+    QJSEngine _scriptEngine;
+    QString _macro;
+    QJSValue _function;     // macro compiled into a function, rebuilt only when the macro text changes
+    bool _useNativeSolver;  // the macro is the stock one, it is evaluated without script engine
+
+    double timeToDropByMacro(const TelemetryDataFrame &telemetryFrame);
+public:
+    BallisticMacroSolver();
+
+    // allowNativeSolver = false runs the stock macro through the script engine too
+    void setMacro(const QString &macro, bool allowNativeSolver = true);
+    const QString &macro() const;
+    bool isNativeSolverUsed() const;
+    double timeToDrop(const TelemetryDataFrame &telemetryFrame);
+};
+
 class CoordinateCalculator final: public QObject
 {
     Q_OBJECT
-    QJSEngine  _scriptEngine;
     HeightMapContainer *_heightMapContainer;
     CamAssemblyPreferences *_camAssemblyPreferences;
-    QString _ballisticMacro;
+    BallisticMacroSolver _ballisticSolver;
     bool _useLaserRangefinderForGroundLevelCalculation;
     bool _useBombCaclulation;
 
     double _trackedTargetSpeed, _trackedTargetDirection;
     TelemetryDelayLine *_targetSpeedFrames;
 
+    // Reused for every frame, heights of the view field border points are read in one batch
+    QVector<WorldGPSCoord> _viewFieldBorderCoords;
+    QVector<double> _viewFieldBorderHeights;
+
     const WorldGPSCoord getScreenPointCoord(TelemetryDataFrame *telemetryFrame, int x, int y) const;
 
     bool needUpdateBombingData(TelemetryDataFrame *telemetryFrame);
@@ -46,4 +70,6 @@ public:
     void processTelemetryDataFrame(TelemetryDataFrame *telemetryFrame);
 };
 
+double CalculateStockTimeToDropBomb(const TelemetryDataFrame &telemetryDataFrame);
+
 #endif // COORDINATECALCULATOR_H
@@ -1,50 +1,247 @@
 #include "EnterProc.h"
-#include <QList>
-#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QSaveFile>
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QtAlgorithms>
 #include <QDebug>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <limits>
+
+// Histogram keeps exact values below 16 ns and 8 sub-buckets per power of two above, the error is below 12.5%
+const int HISTOGRAM_LINEAR_BUCKET_COUNT = 16;
+const int HISTOGRAM_SUB_BUCKET_BITS = 3;
+const int HISTOGRAM_SUB_BUCKET_COUNT = 1 << HISTOGRAM_SUB_BUCKET_BITS;
+const int HISTOGRAM_FIRST_EXPONENT = 4;
+const int HISTOGRAM_BUCKET_COUNT = HISTOGRAM_LINEAR_BUCKET_COUNT + (64 - HISTOGRAM_FIRST_EXPONENT) * HISTOGRAM_SUB_BUCKET_COUNT;
+
+// Number of the latest calls kept per thread for the trace export
+const int TRACE_EVENT_COUNT = 16384;
+
+const quint32 OVERFLOW_PROBE_ID = EnterProc::MAX_PROBE_COUNT - 1;
+
+static int histogramBucket(quint64 timeNs)
+{
+    if (timeNs < HISTOGRAM_LINEAR_BUCKET_COUNT)
+        return static_cast<int>(timeNs);
+    int exponent = 63 - qCountLeadingZeroBits(timeNs);
+    int subBucket = static_cast<int>(timeNs >> (exponent - HISTOGRAM_SUB_BUCKET_BITS)) & (HISTOGRAM_SUB_BUCKET_COUNT - 1);
+    return HISTOGRAM_LINEAR_BUCKET_COUNT + (exponent - HISTOGRAM_FIRST_EXPONENT) * HISTOGRAM_SUB_BUCKET_COUNT + subBucket;
+}
+
+static quint64 histogramBucketUpperBound(int bucket)
+{
+    if (bucket < HISTOGRAM_LINEAR_BUCKET_COUNT)
+        return static_cast<quint64>(bucket);
+    int exponent = (bucket - HISTOGRAM_LINEAR_BUCKET_COUNT) / HISTOGRAM_SUB_BUCKET_COUNT + HISTOGRAM_FIRST_EXPONENT;
+    int subBucket = (bucket - HISTOGRAM_LINEAR_BUCKET_COUNT) % HISTOGRAM_SUB_BUCKET_COUNT;
+    quint64 lowerBound = static_cast<quint64>(HISTOGRAM_SUB_BUCKET_COUNT + subBucket) << (exponent - HISTOGRAM_SUB_BUCKET_BITS);
+    return lowerBound + (1ull << (exponent - HISTOGRAM_SUB_BUCKET_BITS)) - 1;
+}
+
+// Counters have a single writer (the owner thread), so relaxed load and store are enough
+template <typename T>
+inline void addRelaxed(std::atomic<T> &counter, T value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+struct ProbeStatistics final
+{
+    std::atomic<quint64> CallCount;
+    std::atomic<quint64> TotalTimeNs;
+    std::atomic<quint64> MinTimeNs;
+    std::atomic<quint64> MaxTimeNs;
+    std::atomic<quint32> Buckets[HISTOGRAM_BUCKET_COUNT];
+
+    ProbeStatistics()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        CallCount.store(0, std::memory_order_relaxed);
+        TotalTimeNs.store(0, std::memory_order_relaxed);
+        MinTimeNs.store(std::numeric_limits<quint64>::max(), std::memory_order_relaxed);
+        MaxTimeNs.store(0, std::memory_order_relaxed);
+        for (auto &bucket : Buckets)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+
+    void append(quint64 timeNs)
+    {
+        addRelaxed<quint64>(CallCount, 1);
+        addRelaxed<quint64>(TotalTimeNs, timeNs);
+        if (timeNs < MinTimeNs.load(std::memory_order_relaxed))
+            MinTimeNs.store(timeNs, std::memory_order_relaxed);
+        if (timeNs > MaxTimeNs.load(std::memory_order_relaxed))
+            MaxTimeNs.store(timeNs, std::memory_order_relaxed);
+        addRelaxed<quint32>(Buckets[histogramBucket(timeNs)], 1);
+    }
+
+    // Adds the statistics of a finished thread, both are not written meanwhile
+    void merge(const ProbeStatistics &other)
+    {
+        addRelaxed<quint64>(CallCount, other.CallCount.load(std::memory_order_relaxed));
+        addRelaxed<quint64>(TotalTimeNs, other.TotalTimeNs.load(std::memory_order_relaxed));
+        if (other.MinTimeNs.load(std::memory_order_relaxed) < MinTimeNs.load(std::memory_order_relaxed))
+            MinTimeNs.store(other.MinTimeNs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        if (other.MaxTimeNs.load(std::memory_order_relaxed) > MaxTimeNs.load(std::memory_order_relaxed))
+            MaxTimeNs.store(other.MaxTimeNs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        for (int bucket = 0; bucket < HISTOGRAM_BUCKET_COUNT; bucket++)
+            addRelaxed<quint32>(Buckets[bucket], other.Buckets[bucket].load(std::memory_order_relaxed));
+    }
+};
+
+struct TraceEvent final
+{
+    quint32 ProbeId;
+    qint64 StartTimeNs;
+    qint64 DurationNs;
+};
+
+// Buffers of a single thread. When the thread finishes, its counters are moved to the retired ones and the buffers
+// are reused by the next thread, the trace events are exported until then
+struct ThreadStatistics final
+{
+    int ThreadNumber;
+    QString ThreadName;
+    bool Finished;
+    std::atomic<int> Generation;
+    std::atomic<ProbeStatistics *> Probes[EnterProc::MAX_PROBE_COUNT];
+    std::vector<TraceEvent> TraceEvents;
+    std::atomic<quint64> TraceEventCount;
+
+    ThreadStatistics(int threadNumber, const QString &threadName, int generation) :
+        ThreadNumber(threadNumber),
+        ThreadName(threadName),
+        Finished(false),
+        Generation(generation),
+        TraceEvents(TRACE_EVENT_COUNT),
+        TraceEventCount(0)
+    {
+        for (auto &probe : Probes)
+            probe.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~ThreadStatistics()
+    {
+        for (auto &probe : Probes)
+            delete probe.load(std::memory_order_relaxed);
+    }
+
+    void reset(int generation)
+    {
+        for (auto &probe : Probes)
+        {
+            ProbeStatistics *statistics = probe.load(std::memory_order_relaxed);
+            if (statistics != nullptr)
+                statistics->reset();
+        }
+        TraceEventCount.store(0, std::memory_order_release);
+        Generation.store(generation, std::memory_order_release);
+    }
+
+    void append(quint32 probeId, qint64 startTimeNs, qint64 durationNs)
+    {
+        ProbeStatistics *statistics = Probes[probeId].load(std::memory_order_relaxed);
+        if (statistics == nullptr)
+        {
+            statistics = new ProbeStatistics();
+            Probes[probeId].store(statistics, std::memory_order_release);
+        }
+        statistics->append(static_cast<quint64>(durationNs));
+
+        quint64 eventNumber = TraceEventCount.load(std::memory_order_relaxed);
+        TraceEvents[eventNumber % TRACE_EVENT_COUNT] = {probeId, startTimeNs, durationNs};
+        TraceEventCount.store(eventNumber + 1, std::memory_order_release);
+    }
+};
 
 class StatisticsKeeper final
 {
-    QHash<QString, EnterProcMeasure *> _measures;
-    QElapsedTimer  _globalTime;
+    const std::chrono::steady_clock::time_point _startTime;
+
+    QMutex _mutex;
+    QHash<QString, quint32> _probeIds;
+    QVector<QString> _probeNames;
+    std::vector<std::unique_ptr<ThreadStatistics>> _threads;
+    std::vector<ThreadStatistics *> _finishedThreads;
+    int _threadCount;
+    std::atomic<int> _generation;
+
+    // Counters of the finished threads
+    std::vector<std::unique_ptr<ProbeStatistics>> _retiredProbes;
+    int _retiredGeneration;
+
+    bool isActual(const ThreadStatistics *thread) const;
 public:
     StatisticsKeeper();
-    ~StatisticsKeeper();
 
-    EnterProcMeasure *getMeasureByName(const QString &procName);
+    qint64 currentTimeNs() const;
+    quint32 registerProbe(const QString &procName);
+    ThreadStatistics *createThreadStatistics();
+    void releaseThreadStatistics(ThreadStatistics *thread);
+    int generation() const;
 
-    int getGlobalTime();
     void clear();
-    QList<EnterProcMeasure *> getMeasures();
+    QList<EnterProcMeasure> getMeasures();
     void outStatisticsToDebug(StatisticsSortMode sortMode);
+    bool exportChromeTrace(const QString &fileName);
 };
 
 static StatisticsKeeper gStatisticsKeeper;
-static bool gEnableComputingStatistics = false;
 
+// Returns the buffers to the keeper when the thread finishes, pool threads come and go
+struct ThreadStatisticsHolder final
+{
+    ThreadStatistics *Statistics = nullptr;
 
+    ~ThreadStatisticsHolder()
+    {
+        if (Statistics != nullptr)
+            gStatisticsKeeper.releaseThreadStatistics(Statistics);
+    }
+};
+
+static thread_local ThreadStatisticsHolder gThreadStatistics;
 
-EnterProc::EnterProc(const QString procName)
+std::atomic<bool> EnterProc::_enabled(false);
+
+void EnterProc::finish()
 {
-    if (!gEnableComputingStatistics)
+    qint64 durationNs = currentTimeNs() - _startTimeNs;
+
+    ThreadStatistics *threadStatistics = gThreadStatistics.Statistics;
+    if (threadStatistics == nullptr)
     {
-        _localProcMeasure = nullptr;
-        return;
+        threadStatistics = gStatisticsKeeper.createThreadStatistics();
+        gThreadStatistics.Statistics = threadStatistics;
     }
-    _localProcMeasure = gStatisticsKeeper.getMeasureByName(procName);
-    _localStartTime = gStatisticsKeeper.getGlobalTime();
+
+    // Statistics are cleared by the owner thread, there is no other writer
+    int generation = gStatisticsKeeper.generation();
+    if (threadStatistics->Generation.load(std::memory_order_relaxed) != generation)
+        threadStatistics->reset(generation);
+
+    threadStatistics->append(_probeId, _startTimeNs, durationNs);
 }
 
-EnterProc::~EnterProc()
+qint64 EnterProc::currentTimeNs()
 {
-    if (_localProcMeasure == nullptr)
-        return;
-    int currentTime = gStatisticsKeeper.getGlobalTime();
-    _localProcMeasure->appendCallTime(currentTime - _localStartTime);
+    return gStatisticsKeeper.currentTimeNs();
 }
 
-void EnterProc::begin()
+quint32 EnterProc::registerProbe(const char *procName)
 {
+    return gStatisticsKeeper.registerProbe(QString::fromLatin1(procName));
 }
 
 void EnterProc::outStatisticsToDebug(StatisticsSortMode sortMode)
@@ -54,7 +251,7 @@ void EnterProc::outStatisticsToDebug(StatisticsSortMode sortMode)
 
 void EnterProc::setEnableComputingStatistics(bool enable)
 {
-    gEnableComputingStatistics = enable;
+    _enabled.store(enable, std::memory_order_relaxed);
 }
 
 void EnterProc::clearStatistics()
@@ -62,10 +259,14 @@ void EnterProc::clearStatistics()
     gStatisticsKeeper.clear();
 }
 
-QList<EnterProcMeasure *> EnterProc::getMeasures()
+QList<EnterProcMeasure> EnterProc::getMeasures()
 {
-    QList<EnterProcMeasure *> measures = gStatisticsKeeper.getMeasures();
-    return measures;
+    return gStatisticsKeeper.getMeasures();
+}
+
+bool EnterProc::exportChromeTrace(const QString &fileName)
+{
+    return gStatisticsKeeper.exportChromeTrace(fileName);
 }
 
 
@@ -73,85 +274,221 @@ QList<EnterProcMeasure *> EnterProc::getMeasures()
 
 EnterProcMeasure::EnterProcMeasure()
 {
-    TotalTime = 0;
     CallCount = 0;
-    MinTime = 0;
-    MaxTime = 0;
-}
-
-EnterProcMeasure::~EnterProcMeasure()
-{
+    TotalTimeNs = 0;
+    MinTimeNs = 0;
+    MaxTimeNs = 0;
+    P50TimeNs = 0;
+    P99TimeNs = 0;
 }
 
-int EnterProcMeasure::getAvgTime()
+quint64 EnterProcMeasure::getAvgTimeNs() const
 {
     if (CallCount > 0)
-        return TotalTime / CallCount;
+        return TotalTimeNs / CallCount;
     else
         return 0;
 }
 
-void EnterProcMeasure::appendCallTime(int timeMs)
+StatisticsKeeper::StatisticsKeeper() :
+    _startTime(std::chrono::steady_clock::now()),
+    _threadCount(0),
+    _generation(0),
+    _retiredProbes(EnterProc::MAX_PROBE_COUNT),
+    _retiredGeneration(0)
 {
-    CallCount++;
-    TotalTime += timeMs;
-    if (MinTime > timeMs || CallCount == 1)
-        MinTime = timeMs;
-    if (MaxTime < timeMs)
-        MaxTime = timeMs;
+    _probeNames.resize(EnterProc::MAX_PROBE_COUNT);
+    _probeNames[OVERFLOW_PROBE_ID] = "<Other>";
 }
 
-StatisticsKeeper::StatisticsKeeper()
+qint64 StatisticsKeeper::currentTimeNs() const
 {
-    _globalTime.start();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _startTime).count();
 }
 
-StatisticsKeeper::~StatisticsKeeper()
+quint32 StatisticsKeeper::registerProbe(const QString &procName)
 {
-    clear();
+    QMutexLocker locker(&_mutex);
+
+    auto i = _probeIds.constFind(procName);
+    if (i != _probeIds.constEnd())
+        return i.value();
+
+    quint32 probeId = static_cast<quint32>(_probeIds.count());
+    if (probeId >= OVERFLOW_PROBE_ID)
+    {
+        qWarning() << "Too many statistics probes, probe" << procName << "is measured as" << _probeNames[OVERFLOW_PROBE_ID];
+        return OVERFLOW_PROBE_ID;
+    }
+
+    _probeIds.insert(procName, probeId);
+    _probeNames[probeId] = procName;
+    return probeId;
 }
 
-void StatisticsKeeper::clear()
+ThreadStatistics *StatisticsKeeper::createThreadStatistics()
 {
-    auto i = _measures.begin();
-    while (i != _measures.end())
+    QMutexLocker locker(&_mutex);
+
+    int threadNumber = ++_threadCount;
+    QString threadName = QThread::currentThread()->objectName();
+    if (threadName.isEmpty())
+        threadName = QString("Thread %1").arg(threadNumber);
+
+    if (!_finishedThreads.empty())
     {
-        auto measure = i.value();
-        i = _measures.erase(i);
-        delete measure;
+        ThreadStatistics *thread = _finishedThreads.back();
+        _finishedThreads.pop_back();
+        thread->ThreadNumber = threadNumber;
+        thread->ThreadName = threadName;
+        thread->Finished = false;
+        thread->reset(generation());
+        return thread;
     }
+
+    _threads.emplace_back(new ThreadStatistics(threadNumber, threadName, generation()));
+    return _threads.back().get();
+}
+
+void StatisticsKeeper::releaseThreadStatistics(ThreadStatistics *thread)
+{
+    QMutexLocker locker(&_mutex);
+
+    if (_retiredGeneration != generation())
+    {
+        for (auto &retiredProbe : _retiredProbes)
+            if (retiredProbe)
+                retiredProbe->reset();
+        _retiredGeneration = generation();
+    }
+
+    // Counters cleared after the last measure of the thread are dropped
+    if (isActual(thread))
+    {
+        for (quint32 probeId = 0; probeId < EnterProc::MAX_PROBE_COUNT; probeId++)
+        {
+            ProbeStatistics *statistics = thread->Probes[probeId].load(std::memory_order_relaxed);
+            if (statistics == nullptr || statistics->CallCount.load(std::memory_order_relaxed) == 0)
+                continue;
+            if (!_retiredProbes[probeId])
+                _retiredProbes[probeId].reset(new ProbeStatistics());
+            _retiredProbes[probeId]->merge(*statistics);
+            statistics->reset();
+        }
+    }
+
+    thread->Finished = true;
+    _finishedThreads.push_back(thread);
 }
 
-QList<EnterProcMeasure *> StatisticsKeeper::getMeasures()
+int StatisticsKeeper::generation() const
 {
-    QList<EnterProcMeasure *> measureList = _measures.values();
-    return measureList;
+    return _generation.load(std::memory_order_relaxed);
 }
 
-bool procNameLetssThan(const EnterProcMeasure * epm1, const EnterProcMeasure * epm2)
+bool StatisticsKeeper::isActual(const ThreadStatistics *thread) const
 {
-    return (*epm1).ProcName < (*epm2).ProcName;
+    return thread->Generation.load(std::memory_order_acquire) == generation();
 }
 
-bool maxTimeLetssThan(const EnterProcMeasure * epm1, const EnterProcMeasure * epm2)
+void StatisticsKeeper::clear()
+{
+    // Every thread resets its own statistics on the next measure, the previous ones are ignored until then
+    _generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+QList<EnterProcMeasure> StatisticsKeeper::getMeasures()
+{
+    QMutexLocker locker(&_mutex);
+
+    QList<EnterProcMeasure> measures;
+    QVector<quint64> buckets(HISTOGRAM_BUCKET_COUNT);
+    std::vector<const ProbeStatistics *> probeStatistics;
+
+    for (quint32 probeId = 0; probeId < EnterProc::MAX_PROBE_COUNT; probeId++)
+    {
+        EnterProcMeasure measure;
+        measure.MinTimeNs = std::numeric_limits<quint64>::max();
+        buckets.fill(0);
+
+        probeStatistics.clear();
+        if (_retiredProbes[probeId] && _retiredGeneration == generation())
+            probeStatistics.push_back(_retiredProbes[probeId].get());
+        for (auto &thread : _threads)
+        {
+            if (thread->Finished || !isActual(thread.get()))
+                continue;
+            ProbeStatistics *statistics = thread->Probes[probeId].load(std::memory_order_acquire);
+            if (statistics != nullptr)
+                probeStatistics.push_back(statistics);
+        }
+
+        for (auto statistics : probeStatistics)
+        {
+            measure.CallCount += statistics->CallCount.load(std::memory_order_relaxed);
+            measure.TotalTimeNs += statistics->TotalTimeNs.load(std::memory_order_relaxed);
+            measure.MinTimeNs = qMin(measure.MinTimeNs, statistics->MinTimeNs.load(std::memory_order_relaxed));
+            measure.MaxTimeNs = qMax(measure.MaxTimeNs, statistics->MaxTimeNs.load(std::memory_order_relaxed));
+            for (int bucket = 0; bucket < HISTOGRAM_BUCKET_COUNT; bucket++)
+                buckets[bucket] += statistics->Buckets[bucket].load(std::memory_order_relaxed);
+        }
+
+        if (measure.CallCount == 0)
+            continue;
+
+        quint64 histogramCallCount = 0;
+        for (auto bucketCallCount : buckets)
+            histogramCallCount += bucketCallCount;
+
+        // Percentiles are reported as the upper bound of the bucket
+        quint64 p50CallCount = (histogramCallCount + 1) / 2;
+        quint64 p99CallCount = (histogramCallCount * 99 + 99) / 100;
+        quint64 callCount = 0;
+        for (int bucket = 0; bucket < HISTOGRAM_BUCKET_COUNT; bucket++)
+        {
+            if (buckets[bucket] == 0)
+                continue;
+            bool p50Reached = callCount < p50CallCount;
+            bool p99Reached = callCount < p99CallCount;
+            callCount += buckets[bucket];
+            quint64 bucketTimeNs = qMin(histogramBucketUpperBound(bucket), measure.MaxTimeNs);
+            if (p50Reached && callCount >= p50CallCount)
+                measure.P50TimeNs = bucketTimeNs;
+            if (p99Reached && callCount >= p99CallCount)
+            {
+                measure.P99TimeNs = bucketTimeNs;
+                break;
+            }
+        }
+
+        measure.ProcName = _probeNames[static_cast<int>(probeId)];
+        measures.append(measure);
+    }
+
+    return measures;
+}
+
+bool procNameLetssThan(const EnterProcMeasure &epm1, const EnterProcMeasure &epm2)
 {
-    return (*epm1).MaxTime < (*epm2).MaxTime;
+    return epm1.ProcName < epm2.ProcName;
 }
 
-bool avgTimeLetssThan(const EnterProcMeasure * epm1, const EnterProcMeasure * epm2)
+bool maxTimeLetssThan(const EnterProcMeasure &epm1, const EnterProcMeasure &epm2)
 {
-    int time1 = (EnterProcMeasure(*epm1)).getAvgTime();
-    int time2 = (EnterProcMeasure(*epm2)).getAvgTime();
-    return (time1 < time2);
+    return epm1.MaxTimeNs < epm2.MaxTimeNs;
+}
+
+bool avgTimeLetssThan(const EnterProcMeasure &epm1, const EnterProcMeasure &epm2)
+{
+    return epm1.getAvgTimeNs() < epm2.getAvgTimeNs();
 }
 
 void StatisticsKeeper::outStatisticsToDebug(StatisticsSortMode sortMode)
 {
-    QList<EnterProcMeasure *> measuresList = _measures.values();
+    QList<EnterProcMeasure> measuresList = getMeasures();
     switch (sortMode)
     {
     case StatisticsSortMode::SortByProcName:
-
         std::sort(measuresList.begin(), measuresList.end(), procNameLetssThan);
         break;
     case StatisticsSortMode::SortByMaxTime:
@@ -162,36 +499,76 @@ void StatisticsKeeper::outStatisticsToDebug(StatisticsSortMode sortMode)
         break;
     }
 
-    for (QList<EnterProcMeasure *>::iterator i = measuresList.begin(); i != measuresList.end(); i++)
+    foreach (auto measure, measuresList)
     {
-        EnterProcMeasure * measure = *i;
-        QString logRecord = QString("%1 Calls: %2   Total(ms): %3   AVG(ms): %4   Min(ms): %5    Max(ms): %6")
-                .arg(measure->ProcName.leftJustified(60, ' '))
-                .arg(measure->CallCount, 5)
-                .arg(measure->TotalTime, 5)
-                .arg(measure->getAvgTime(), 5)
-                .arg(measure->MinTime, 5)
-                .arg(measure->MaxTime, 5);
+        QString logRecord = QString("%1 Calls: %2   Total(ms): %3   AVG(us): %4   P50(us): %5   P99(us): %6   Max(us): %7")
+                .arg(measure.ProcName.leftJustified(60, ' '))
+                .arg(measure.CallCount, 5)
+                .arg(measure.TotalTimeNs / 1000000, 5)
+                .arg(measure.getAvgTimeNs() / 1000.0, 8, 'f', 1)
+                .arg(measure.P50TimeNs / 1000.0, 8, 'f', 1)
+                .arg(measure.P99TimeNs / 1000.0, 8, 'f', 1)
+                .arg(measure.MaxTimeNs / 1000.0, 8, 'f', 1);
 
         qDebug() << logRecord;
     }
 }
 
-EnterProcMeasure *StatisticsKeeper::getMeasureByName(const QString &procName)
+static QString escapeJsonString(const QString &text)
 {
-    EnterProcMeasure * measure = _measures.value(procName, nullptr);
-    if (measure == nullptr)
-    {
-        QHash<QString, EnterProcMeasure *>::iterator i =
-                _measures.insert(procName, new EnterProcMeasure());
-        measure = i.value();
-        measure->ProcName = procName;
-    }
-    return measure;
+    QString result = text;
+    result.replace('\\', "\\\\");
+    result.replace('"', "\\\"");
+    return result;
 }
 
-int StatisticsKeeper::getGlobalTime()
+bool StatisticsKeeper::exportChromeTrace(const QString &fileName)
 {
-    int elapsedTime = _globalTime.elapsed();
-    return elapsedTime;
+    QMutexLocker locker(&_mutex);
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        qWarning() << "Unable to open trace file" << fileName;
+        return false;
+    }
+
+    QTextStream stream(&file);
+    stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"" << escapeJsonString(qAppName()) << "\"}}";
+
+    QVector<TraceEvent> events;
+    for (auto &thread : _threads)
+    {
+        stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->ThreadNumber
+               << ",\"args\":{\"name\":\"" << escapeJsonString(thread->ThreadName) << "\"}}";
+
+        if (!isActual(thread.get()))
+            continue;
+
+        // The owner thread keeps writing, events overwritten during copying are skipped
+        quint64 lastEventNumber = thread->TraceEventCount.load(std::memory_order_acquire);
+        quint64 firstEventNumber = lastEventNumber > TRACE_EVENT_COUNT ? lastEventNumber - TRACE_EVENT_COUNT : 0;
+        events.clear();
+        for (quint64 eventNumber = firstEventNumber; eventNumber < lastEventNumber; eventNumber++)
+            events.append(thread->TraceEvents[eventNumber % TRACE_EVENT_COUNT]);
+
+        quint64 writtenEventNumber = thread->TraceEventCount.load(std::memory_order_acquire);
+        int overwrittenEventCount = 0;
+        if (writtenEventNumber > TRACE_EVENT_COUNT && writtenEventNumber - TRACE_EVENT_COUNT > firstEventNumber)
+            overwrittenEventCount = static_cast<int>(qMin<quint64>(writtenEventNumber - TRACE_EVENT_COUNT - firstEventNumber, events.count()));
+
+        for (int i = overwrittenEventCount; i < events.count(); i++)
+        {
+            const TraceEvent &event = events[i];
+            stream << ",\n{\"name\":\"" << escapeJsonString(_probeNames[static_cast<int>(event.ProbeId)])
+                   << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->ThreadNumber
+                   << ",\"ts\":" << QString::number(event.StartTimeNs / 1000.0, 'f', 3)
+                   << ",\"dur\":" << QString::number(event.DurationNs / 1000.0, 'f', 3) << "}";
+        }
+    }
+
+    stream << "\n]}\n";
+    stream.flush();
+    return file.commit();
 }
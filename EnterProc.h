@@ -1,38 +1,73 @@
 #ifndef ENTERPROC_H
 #define ENTERPROC_H
-#include <QHash>
-#include <QTime>
+#include <QString>
+#include <QList>
+#include <atomic>
 
-#define EnterProcStart(x) EnterProc ep(x); ep.begin();
+// Probe is registered once per call site, so a disabled measure costs a single branch
+#define EnterProcStart(x) static const quint32 ep_probeId = EnterProc::registerProbe(x); EnterProc ep(ep_probeId);
 
 enum class StatisticsSortMode {SortByProcName, SortByMaxTime, SortByAvgTime};
 
-class EnterProcMeasure final
+// Statistics of a probe merged over all threads
+struct EnterProcMeasure final
 {
-public:
-    EnterProcMeasure();
-    ~EnterProcMeasure();
     QString ProcName;
-    int TotalTime;
-    int CallCount;
-    int MinTime;
-    int MaxTime;
-    int getAvgTime();
-    void appendCallTime(int timeMs);
+    quint64 CallCount;
+    quint64 TotalTimeNs;
+    quint64 MinTimeNs;
+    quint64 MaxTimeNs;
+    quint64 P50TimeNs;
+    quint64 P99TimeNs;
+
+    EnterProcMeasure();
+    quint64 getAvgTimeNs() const;
 };
 
-class EnterProc
+// Measures the scope time with nanosecond resolution. Every thread records into its own buffers without locks,
+// the histograms and the trace events are merged only on reading
+class EnterProc final
 {
-    int _localStartTime;
-    EnterProcMeasure * _localProcMeasure;
-public:   
-    EnterProc(const QString procName);
-    ~EnterProc();
-    void begin();
+    static std::atomic<bool> _enabled;
+
+    quint32 _probeId;
+    qint64 _startTimeNs;
+
+    void finish();
+public:
+    static const quint32 MAX_PROBE_COUNT = 1024;
+
+    explicit EnterProc(quint32 probeId)
+    {
+        if (Q_LIKELY(!_enabled.load(std::memory_order_relaxed)))
+        {
+            _startTimeNs = -1;
+            return;
+        }
+        _probeId = probeId;
+        _startTimeNs = currentTimeNs();
+    }
+
+    ~EnterProc()
+    {
+        if (_startTimeNs >= 0)
+            finish();
+    }
+
+    EnterProc(const EnterProc &) = delete;
+    EnterProc &operator=(const EnterProc &) = delete;
+
+    // Nanoseconds since the application start, steady clock
+    static qint64 currentTimeNs();
+    // Probes with the same name share statistics
+    static quint32 registerProbe(const char *procName);
+
     static void outStatisticsToDebug(StatisticsSortMode sortMode);
     static void setEnableComputingStatistics(bool enable);
     static void clearStatistics();
-    static QList<EnterProcMeasure *> getMeasures();
+    static QList<EnterProcMeasure> getMeasures();
+    // Writes recent calls of all threads in Chrome/Perfetto trace event format
+    static bool exportChromeTrace(const QString &fileName);
 };
 
 #endif // ENTERPROC_H
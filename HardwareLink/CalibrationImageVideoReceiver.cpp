@@ -1,11 +1,12 @@
 #include "CalibrationImageVideoReceiver.h"
 #include <QDebug>
 #include "EnterProc.h"
+#include "HardwareLink/DelayLine.h"
 
 void CalibrationImageVideoReceiver::timerEvent(QTimerEvent *event)
 {
     Q_UNUSED(event);
-    emit frameAvailable(_staticImage, _videoConnectionId);
+    emit frameAvailable(_staticImage, _videoConnectionId, getDelayLineTimeMs());
 }
 
 CalibrationImageVideoReceiver::CalibrationImageVideoReceiver(QObject *parent, quint32 videoConnectionId, const QString &selectedImage, const QString &defaultImage) : QObject(parent)
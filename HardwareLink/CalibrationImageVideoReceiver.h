@@ -17,7 +17,7 @@ protected:
 public:
     explicit CalibrationImageVideoReceiver(QObject *parent, quint32 videoConnectionId, const QString &selectedImage, const QString &defaultImage);
 signals:
-    void frameAvailable(const QImage &frame, quint32 videoConnectionId);
+    void frameAvailable(const QImage &frame, quint32 videoConnectionId, qint64 arrivalTimeMs);
 };
 
 #endif // CALIBRATIONIMAGEVIDEORECEIVER_H
@@ -1,9 +1,42 @@
 #include "DelayLine.h"
-#include <QTimer>
+#include <QElapsedTimer>
+#include <cmath>
+
+// Released frames are kept for interpolation of the past states
+constexpr qint64 DELAY_LINE_HISTORY_MS = 1000;
+
+qint64 getDelayLineTimeMs()
+{
+    QElapsedTimer timer;
+    timer.start();
+    return timer.msecsSinceReference();
+}
+
+template <typename T>
+inline T interpolateValue(T before, T after, double factor)
+{
+    return static_cast<T>(before + (after - before) * factor);
+}
+
+// Angles in degrees, the shortest way is used. The result is wrapped into [0, 360) as the headings are,
+// signed angles (roll, pitch) stay in [-180, 180)
+template <typename T>
+inline T interpolateAngle(T before, T after, double factor)
+{
+    double difference = std::remainder(static_cast<double>(after) - before, 360.0);
+    double angle = std::fmod(before + difference * factor + 360.0, 360.0);
+    if ((before < 0 || after < 0) && angle >= 180.0)
+        angle -= 360.0;
+    return static_cast<T>(angle);
+}
 
 TelemetryDelayLine::TelemetryDelayLine(QObject *parent, quint32 delayMs) : QObject(parent)
 {
     _delayMs = delayMs;
+
+    _releaseTimer.setSingleShot(true);
+    _releaseTimer.setTimerType(Qt::PreciseTimer);
+    connect(&_releaseTimer, &QTimer::timeout, this, &TelemetryDelayLine::onDelayTimer);
 }
 
 TelemetryDelayLine::~TelemetryDelayLine()
@@ -12,34 +45,42 @@ TelemetryDelayLine::~TelemetryDelayLine()
 }
 
 void TelemetryDelayLine::enqueue(const TelemetryDataFrame &value)
+{
+    enqueue(value, getDelayLineTimeMs());
+}
+
+void TelemetryDelayLine::enqueue(const TelemetryDataFrame &value, qint64 timeMs)
 {
     _tail = value;
+    _frames.append(timeMs, value);
+    _frames.removeReleasedBefore(timeMs - _delayMs - DELAY_LINE_HISTORY_MS);
 
     if (_delayMs <= 0)
     {
+        _frames.releaseFirstPendingFrame();
         emit dequeue(value);
     }
-    else
+    else if (!_releaseTimer.isActive())
     {
-        _frames.enqueue(value);
-        QTimer::singleShot(_delayMs, Qt::PreciseTimer, this, &TelemetryDelayLine::onDelayTimer);
+        scheduleRelease();
     }
 }
 
 void TelemetryDelayLine::clear()
 {
+    _releaseTimer.stop();
     _frames.clear();
     _tail.clear();
 }
 
 bool TelemetryDelayLine::isEmpty()
 {
-    return _frames.isEmpty();
+    return !_frames.hasPendingFrames();
 }
 
 const TelemetryDataFrame TelemetryDelayLine::head()
 {
-    return _frames.head();
+    return _frames.firstPendingFrame();
 }
 
 const TelemetryDataFrame TelemetryDelayLine::tail()
@@ -47,13 +88,59 @@ const TelemetryDataFrame TelemetryDelayLine::tail()
     return _tail;
 }
 
+bool TelemetryDelayLine::frameAt(qint64 timeMs, TelemetryDataFrame &frame) const
+{
+    const TelemetryDataFrame *before, *after;
+    double factor;
+    if (!_frames.findNeighbours(timeMs - _delayMs, before, after, factor))
+        return false;
+
+    // Discrete values are taken from the nearest frame
+    frame = factor < 0.5 ? *before : *after;
+    if (before == after)
+        return true;
+
+    frame.UavRoll = interpolateAngle(before->UavRoll, after->UavRoll, factor);
+    frame.UavPitch = interpolateAngle(before->UavPitch, after->UavPitch, factor);
+    frame.UavYaw = interpolateAngle(before->UavYaw, after->UavYaw, factor);
+    frame.UavLatitude_GPS = interpolateValue(before->UavLatitude_GPS, after->UavLatitude_GPS, factor);
+    frame.UavLongitude_GPS = interpolateValue(before->UavLongitude_GPS, after->UavLongitude_GPS, factor);
+    frame.UavAltitude_GPS = interpolateValue(before->UavAltitude_GPS, after->UavAltitude_GPS, factor);
+    frame.UavAltitude_Barometric = interpolateValue(before->UavAltitude_Barometric, after->UavAltitude_Barometric, factor);
+    frame.AirSpeed = interpolateValue(before->AirSpeed, after->AirSpeed, factor);
+    frame.GroundSpeed_GPS = interpolateValue(before->GroundSpeed_GPS, after->GroundSpeed_GPS, factor);
+    frame.Course_GPS = interpolateAngle(before->Course_GPS, after->Course_GPS, factor);
+    frame.VerticalSpeed = interpolateValue(before->VerticalSpeed, after->VerticalSpeed, factor);
+    frame.GroundSpeedNorth_GPS = interpolateValue(before->GroundSpeedNorth_GPS, after->GroundSpeedNorth_GPS, factor);
+    frame.GroundSpeedEast_GPS = interpolateValue(before->GroundSpeedEast_GPS, after->GroundSpeedEast_GPS, factor);
+    frame.CamRoll = interpolateAngle(before->CamRoll, after->CamRoll, factor);
+    frame.CamPitch = interpolateAngle(before->CamPitch, after->CamPitch, factor);
+    frame.CamYaw = interpolateAngle(before->CamYaw, after->CamYaw, factor);
+    frame.CamZoom = interpolateValue(before->CamZoom, after->CamZoom, factor);
+    return true;
+}
+
+void TelemetryDelayLine::scheduleRelease()
+{
+    if (!_frames.hasPendingFrames())
+        return;
+
+    qint64 waitTimeMs = _frames.firstPendingTimeMs() + _delayMs - getDelayLineTimeMs();
+    _releaseTimer.start(static_cast<int>(qMax<qint64>(0, waitTimeMs)));
+}
+
 void TelemetryDelayLine::onDelayTimer()
 {
-    if (!_frames.isEmpty())
+    qint64 releaseTimeMs = getDelayLineTimeMs() - _delayMs;
+    while (_frames.hasPendingFrames() && _frames.firstPendingTimeMs() <= releaseTimeMs)
     {
-        auto value = _frames.dequeue();
+        // The frame is copied, the slots may enqueue new frames into the same storage
+        auto value = _frames.firstPendingFrame();
+        _frames.releaseFirstPendingFrame();
         emit dequeue(value);
     }
+
+    scheduleRelease();
 }
 
 //----------------------------------------------
@@ -61,6 +148,10 @@ void TelemetryDelayLine::onDelayTimer()
 CameraTelemetryDelayLine::CameraTelemetryDelayLine(QObject *parent, quint32 delayMs): QObject(parent)
 {
     _delayMs = delayMs;
+
+    _releaseTimer.setSingleShot(true);
+    _releaseTimer.setTimerType(Qt::PreciseTimer);
+    connect(&_releaseTimer, &QTimer::timeout, this, &CameraTelemetryDelayLine::onDelayTimer);
 }
 
 CameraTelemetryDelayLine::~CameraTelemetryDelayLine()
@@ -70,27 +161,68 @@ CameraTelemetryDelayLine::~CameraTelemetryDelayLine()
 
 void CameraTelemetryDelayLine::enqueue(const CameraTelemetryDataFrame &value)
 {
+    enqueue(value, getDelayLineTimeMs());
+}
+
+void CameraTelemetryDelayLine::enqueue(const CameraTelemetryDataFrame &value, qint64 timeMs)
+{
+    _frames.append(timeMs, value);
+    _frames.removeReleasedBefore(timeMs - _delayMs - DELAY_LINE_HISTORY_MS);
+
     if (_delayMs <= 0)
     {
+        _frames.releaseFirstPendingFrame();
         emit dequeue(value);
     }
-    else
+    else if (!_releaseTimer.isActive())
     {
-        _frames.enqueue(value);
-        QTimer::singleShot(_delayMs, Qt::PreciseTimer, this, &CameraTelemetryDelayLine::onDelayTimer);
+        scheduleRelease();
     }
 }
 
 void CameraTelemetryDelayLine::clear()
 {
+    _releaseTimer.stop();
     _frames.clear();
 }
 
+bool CameraTelemetryDelayLine::frameAt(qint64 timeMs, CameraTelemetryDataFrame &frame) const
+{
+    const CameraTelemetryDataFrame *before, *after;
+    double factor;
+    if (!_frames.findNeighbours(timeMs - _delayMs, before, after, factor))
+        return false;
+
+    frame = factor < 0.5 ? *before : *after;
+    if (before == after)
+        return true;
+
+    frame.CamRoll = interpolateAngle(before->CamRoll, after->CamRoll, factor);
+    frame.CamPitch = interpolateAngle(before->CamPitch, after->CamPitch, factor);
+    frame.CamYaw = interpolateAngle(before->CamYaw, after->CamYaw, factor);
+    frame.CamZoom = interpolateValue(before->CamZoom, after->CamZoom, factor);
+    frame.RangefinderDistance = interpolateValue(before->RangefinderDistance, after->RangefinderDistance, factor);
+    return true;
+}
+
+void CameraTelemetryDelayLine::scheduleRelease()
+{
+    if (!_frames.hasPendingFrames())
+        return;
+
+    qint64 waitTimeMs = _frames.firstPendingTimeMs() + _delayMs - getDelayLineTimeMs();
+    _releaseTimer.start(static_cast<int>(qMax<qint64>(0, waitTimeMs)));
+}
+
 void CameraTelemetryDelayLine::onDelayTimer()
 {
-    if (!_frames.isEmpty())
+    qint64 releaseTimeMs = getDelayLineTimeMs() - _delayMs;
+    while (_frames.hasPendingFrames() && _frames.firstPendingTimeMs() <= releaseTimeMs)
     {
-        auto value = _frames.dequeue();
+        auto value = _frames.firstPendingFrame();
+        _frames.releaseFirstPendingFrame();
         emit dequeue(value);
     }
+
+    scheduleRelease();
 }
@@ -2,27 +2,161 @@
 #define DELAYLINE_H
 
 #include <QObject>
-#include <QQueue>
+#include <QVector>
+#include <QTimer>
 #include "TelemetryDataFrame.h"
 
+// Monotonic time shared by all delay lines, ms
+qint64 getDelayLineTimeMs();
 
+// Frames ordered by their receive time. Released frames are kept for a while for interpolation,
+// the storage is reused and grows only when the delay holds more frames than before
+template <typename T>
+class TimestampedFrameRing final
+{
+    struct Item
+    {
+        qint64 TimeMs;
+        T Frame;
+    };
+
+    QVector<Item> _items;
+    int _first;
+    int _count;
+    int _releasedCount;
+
+    const Item &at(int index) const
+    {
+        return _items[(_first + index) % _items.count()];
+    }
+
+    void grow()
+    {
+        QVector<Item> items(qMax(16, _items.count() * 2));
+        for (int i = 0; i < _count; i++)
+            items[i] = at(i);
+        _items.swap(items);
+        _first = 0;
+    }
+public:
+    TimestampedFrameRing() : _first(0), _count(0), _releasedCount(0)
+    {
+    }
+
+    bool isEmpty() const
+    {
+        return _count == 0;
+    }
+
+    void clear()
+    {
+        _first = 0;
+        _count = 0;
+        _releasedCount = 0;
+    }
+
+    // Time of the frame can't be earlier than the time of the previous frame
+    void append(qint64 timeMs, const T &frame)
+    {
+        if (_count == _items.count())
+            grow();
+        if (_count > 0)
+            timeMs = qMax(timeMs, at(_count - 1).TimeMs);
+
+        Item &item = _items[(_first + _count) % _items.count()];
+        item.TimeMs = timeMs;
+        item.Frame = frame;
+        _count++;
+    }
+
+    bool hasPendingFrames() const
+    {
+        return _releasedCount < _count;
+    }
+
+    qint64 firstPendingTimeMs() const
+    {
+        return at(_releasedCount).TimeMs;
+    }
+
+    const T &firstPendingFrame() const
+    {
+        return at(_releasedCount).Frame;
+    }
+
+    void releaseFirstPendingFrame()
+    {
+        _releasedCount++;
+    }
+
+    // Drops released frames older than the time, the last one before the time is kept for interpolation
+    void removeReleasedBefore(qint64 timeMs)
+    {
+        while (_releasedCount > 1 && at(1).TimeMs <= timeMs)
+        {
+            _first = (_first + 1) % _items.count();
+            _count--;
+            _releasedCount--;
+        }
+    }
+
+    // Finds frames around the time, factor is the position of the time between them. Times outside of the
+    // stored range are clamped to the first or the last frame
+    bool findNeighbours(qint64 timeMs, const T *&before, const T *&after, double &factor) const
+    {
+        if (_count == 0)
+            return false;
+
+        int low = 0, high = _count - 1;
+        if (timeMs <= at(low).TimeMs)
+            high = low;
+        else if (timeMs >= at(high).TimeMs)
+            low = high;
+        else
+        {
+            while (high - low > 1)
+            {
+                int middle = (low + high) / 2;
+                if (at(middle).TimeMs <= timeMs)
+                    low = middle;
+                else
+                    high = middle;
+            }
+        }
+
+        before = &at(low).Frame;
+        after = &at(high).Frame;
+        qint64 intervalMs = at(high).TimeMs - at(low).TimeMs;
+        factor = intervalMs > 0 ? static_cast<double>(timeMs - at(low).TimeMs) / intervalMs : 0;
+        return true;
+    }
+};
+
+// Frames are released after the delay by a single timer, which is always armed for the earliest pending frame
 class TelemetryDelayLine : public QObject
 {
     Q_OBJECT
-    quint32 _delayMs;
-    QQueue<TelemetryDataFrame> _frames;
+    qint64 _delayMs;
+    TimestampedFrameRing<TelemetryDataFrame> _frames;
     TelemetryDataFrame _tail;
+    QTimer _releaseTimer;
 
+    void scheduleRelease();
 public:
     explicit TelemetryDelayLine(QObject *parent, quint32 delayMs);
     ~TelemetryDelayLine();
 
     void enqueue(const TelemetryDataFrame &value);
+    // Time of the frame is its receive time on the delay line clock
+    void enqueue(const TelemetryDataFrame &value, qint64 timeMs);
     void clear();
 
     bool isEmpty();
     const TelemetryDataFrame head();
     const TelemetryDataFrame tail();
+
+    // State at the time with the delay applied, interpolated between the nearest frames
+    bool frameAt(qint64 timeMs, TelemetryDataFrame &frame) const;
 signals:
     void dequeue(const TelemetryDataFrame &value);
 private slots:
@@ -34,15 +168,21 @@ private slots:
 class CameraTelemetryDelayLine : public QObject
 {
     Q_OBJECT
-    quint32 _delayMs;
-    QQueue<CameraTelemetryDataFrame> _frames;
+    qint64 _delayMs;
+    TimestampedFrameRing<CameraTelemetryDataFrame> _frames;
+    QTimer _releaseTimer;
 
+    void scheduleRelease();
 public:
     explicit CameraTelemetryDelayLine(QObject *parent, quint32 delayMs);
     ~CameraTelemetryDelayLine();
 
     void enqueue(const CameraTelemetryDataFrame &value);
+    void enqueue(const CameraTelemetryDataFrame &value, qint64 timeMs);
     void clear();
+
+    // State at the time with the delay applied, interpolated between the nearest frames
+    bool frameAt(qint64 timeMs, CameraTelemetryDataFrame &frame) const;
 signals:
     void dequeue(const CameraTelemetryDataFrame &value);
 private slots:
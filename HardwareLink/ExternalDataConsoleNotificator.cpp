@@ -1,25 +1,82 @@
 #include "ExternalDataConsoleNotificator.h"
 #include <QByteArray>
 
-ExternalDataConsoleNotificator::ExternalDataConsoleNotificator(QObject *parent, quint32 udpConsolePort): QObject(parent)
+constexpr qint64 SUBSCRIPTION_TIMEOUT_MS = 5000;
+constexpr int FLUSH_INTERVAL_MS = 100;
+constexpr int MAXIMAL_DATAGRAM_SIZE = 1400; // fits the ethernet MTU
+
+ExternalDataConsoleNotificator::ExternalDataConsoleNotificator(QObject *parent, quint32 udpConsolePort, quint32 subscriptionPortOffset,
+                                                               bool alwaysBroadcast) : QObject(parent)
 {
     _udpConsolePort = udpConsolePort;
+    _subscriptionPortOffset = subscriptionPortOffset;
+    _alwaysBroadcast = alwaysBroadcast;
+
+    if (_udpConsolePort > 0 && _subscriptionPortOffset > 0)
+    {
+        _udpSubscriptionSocket.bind(QHostAddress::AnyIPv4, _udpConsolePort + _subscriptionPortOffset, QAbstractSocket::ShareAddress);
+        connect(&_udpSubscriptionSocket, &QUdpSocket::readyRead, this, &ExternalDataConsoleNotificator::processSubscriptionDatagrams);
+    }
+
+    _flushTimer.setInterval(FLUSH_INTERVAL_MS);
+    _flushTimer.setSingleShot(true);
+    connect(&_flushTimer, &QTimer::timeout, this, &ExternalDataConsoleNotificator::flush);
 }
 
 ExternalDataConsoleNotificator::~ExternalDataConsoleNotificator()
 {
+    flush();
+}
+
+bool ExternalDataConsoleNotificator::isBroadcasting() const
+{
+    if (_udpConsolePort == 0)
+        return false;
+    if (_alwaysBroadcast)
+        return true;
+    return _lastSubscriptionTime.isValid() && !_lastSubscriptionTime.hasExpired(SUBSCRIPTION_TIMEOUT_MS);
+}
+
+void ExternalDataConsoleNotificator::processSubscriptionDatagrams()
+{
+    while (_udpSubscriptionSocket.hasPendingDatagrams())
+        _udpSubscriptionSocket.receiveDatagram(0);
+    _lastSubscriptionTime.start();
+}
+
+void ExternalDataConsoleNotificator::appendLine(const QByteArray &content)
+{
+    if (!isBroadcasting())
+    {
+        _pendingDatagram.clear();
+        return;
+    }
+
+    QByteArray line = content.toHex();
+    if (!_pendingDatagram.isEmpty() && _pendingDatagram.size() + line.size() + 1 > MAXIMAL_DATAGRAM_SIZE)
+        flush();
+
+    _pendingDatagram.append(line).append('\n');
+    if (!_flushTimer.isActive())
+        _flushTimer.start();
+}
+
+void ExternalDataConsoleNotificator::flush()
+{
+    _flushTimer.stop();
+    if (_pendingDatagram.isEmpty())
+        return;
 
+    _udpConsoleSocket.writeDatagram(_pendingDatagram, QHostAddress::Broadcast, _udpConsolePort);
+    _pendingDatagram.clear();
 }
 
 void ExternalDataConsoleNotificator::onClientCommandSent(const DataExchangePackage &clientCommand)
 {
-    QByteArray datagram = clientCommand.ContentHEX.toUtf8();
-    _udpConsoleSocket.writeDatagram(datagram, QHostAddress::Broadcast, _udpConsolePort);
+    appendLine(clientCommand.Content);
 }
 
-void ExternalDataConsoleNotificator::onTelemetryReceived(const QString &telemetryHEX)
+void ExternalDataConsoleNotificator::onTelemetryReceived(const QByteArray &rawData)
 {
-    QByteArray datagram = telemetryHEX.toUtf8();
-    _udpConsoleSocket.writeDatagram(datagram, QHostAddress::Broadcast, _udpConsolePort);
-    //_udpConsoleSocket.writeDatagram(datagram, QHostAddress("192.168.1.126"), 45570);
+    appendLine(rawData);
 }
@@ -3,21 +3,42 @@
 
 #include <QObject>
 #include <QString>
+#include <QByteArray>
 #include <QUdpSocket>
+#include <QTimer>
+#include <QElapsedTimer>
 #include "TelemetryDataFrame.h"
 
+// Broadcasts hex lines of exchanged data to external data consoles, lines are batched into datagrams separated by '\n'.
+// A console subscribes by sending any datagram to the broadcast port + offset at least every few seconds,
+// nothing is formatted or sent while there are no subscribers unless always broadcasting is chosen.
+// Zero broadcast port turns the notificator off
 class ExternalDataConsoleNotificator : public QObject
 {
     Q_OBJECT
 private:
     QUdpSocket _udpConsoleSocket;
+    QUdpSocket _udpSubscriptionSocket;
     quint32 _udpConsolePort;
+    quint32 _subscriptionPortOffset;
+    bool _alwaysBroadcast;
+
+    QElapsedTimer _lastSubscriptionTime;
+    QByteArray _pendingDatagram;
+    QTimer _flushTimer;
+
+    void appendLine(const QByteArray &content);
+private slots:
+    void processSubscriptionDatagrams();
+    void flush();
 public:
-    explicit ExternalDataConsoleNotificator(QObject *parent, quint32 udpConsolePort);
+    explicit ExternalDataConsoleNotificator(QObject *parent, quint32 udpConsolePort, quint32 subscriptionPortOffset, bool alwaysBroadcast);
     ~ExternalDataConsoleNotificator();
+
+    bool isBroadcasting() const;
 public slots:
     void onClientCommandSent(const DataExchangePackage &clientCommand);
-    void onTelemetryReceived(const QString &telemetryHEX);
+    void onTelemetryReceived(const QByteArray &rawData);
 };
 
 #endif // EXTERNALDATACONSOLENOTIFICATOR_H
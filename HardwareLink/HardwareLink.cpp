@@ -5,6 +5,8 @@
 #include <QRegExp>
 #include <QDebug>
 #include <QNetworkDatagram>
+#include <QDateTime>
+#include <QMetaMethod>
 #include "HardwareLink/MUSVPhotoCommandBuilder.h"
 #include "HardwareLink/OtusCommonCommandBuilder.h"
 #include "EnterProc.h"
@@ -12,6 +14,13 @@
 
 #define UNASSIGNED_TIMER -1
 
+// Arrival time of the datagram on the delay line clock, frames of one batch keep their own moments
+static qint64 getDatagramDelayLineTimeMs(const UdpDatagram &datagram)
+{
+    qint64 ageMs = QDateTime::currentMSecsSinceEpoch() - datagram.ArrivalTimeNs / 1000000;
+    return getDelayLineTimeMs() - qMax<qint64>(0, ageMs);
+}
+
 #pragma pack(push, 1)
 struct UDPTelemetryMessageV4
 {
@@ -48,9 +57,61 @@ struct UDPTelemetryMessageV4
 };
 #pragma pack(pop)
 
+// Runs on the receiving thread, the settings and the format of the link are applied by processTelemetryDatagramV4
+static void decodeTelemetryDatagramV4(UdpDatagram &datagram)
+{
+    UDPTelemetryMessageV4 udpTelemetryMessage;
+
+    qint64 messageSize = sizeof(UDPTelemetryMessageV4);
+    if (messageSize != datagram.Data.size())
+        return;
+
+    memcpy(&udpTelemetryMessage, datagram.Data.constData(), messageSize);
+
+    TelemetryDataFrame telemetryDataFrame;
+
+    telemetryDataFrame.UavRoll =                 udpTelemetryMessage.UavRoll;
+    telemetryDataFrame.UavPitch =                udpTelemetryMessage.UavPitch;
+    telemetryDataFrame.UavYaw =                  udpTelemetryMessage.UavYaw;
+
+    telemetryDataFrame.UavLatitude_GPS =         udpTelemetryMessage.UavLatitude_GPS;
+    telemetryDataFrame.UavLongitude_GPS =        udpTelemetryMessage.UavLongitude_GPS;
+    telemetryDataFrame.UavAltitude_GPS =         udpTelemetryMessage.UavAltitude_GPS;
+    telemetryDataFrame.UavAltitude_Barometric =  udpTelemetryMessage.UavAltitude_Barometric;
+    telemetryDataFrame.Course_GPS =              udpTelemetryMessage.Course_GPS;
+
+    telemetryDataFrame.CamPitch =                udpTelemetryMessage.CamPitch;
+    telemetryDataFrame.CamRoll =                 udpTelemetryMessage.CamRoll;
+    telemetryDataFrame.CamYaw =                  udpTelemetryMessage.CamYaw;
+    telemetryDataFrame.CamZoom =                 udpTelemetryMessage.CamZoom;
+
+    telemetryDataFrame.CamEncoderRoll =          udpTelemetryMessage.CamEncoderRoll;
+    telemetryDataFrame.CamEncoderPitch =         udpTelemetryMessage.CamEncoderPitch;
+    telemetryDataFrame.CamEncoderYaw =           udpTelemetryMessage.CamEncoderYaw;
+
+    telemetryDataFrame.AirSpeed =                 udpTelemetryMessage.AirSpeed;
+    telemetryDataFrame.GroundSpeed_GPS =          udpTelemetryMessage.GroundSpeed_GPS;
+    telemetryDataFrame.WindDirection =            udpTelemetryMessage.WindDirection;
+    telemetryDataFrame.WindSpeed =                udpTelemetryMessage.WindSpeed;
+    telemetryDataFrame.GroundSpeedNorth_GPS =     udpTelemetryMessage.GroundSpeedNorth_GPS;
+    telemetryDataFrame.GroundSpeedEast_GPS =      udpTelemetryMessage.GroundSpeedEast_GPS;
+    telemetryDataFrame.VerticalSpeed =            udpTelemetryMessage.VerticalSpeed;
+    telemetryDataFrame.BombState =                udpTelemetryMessage.BombState;
+
+    telemetryDataFrame.RangefinderDistance =      udpTelemetryMessage.RangefinderDistance;
+
+    telemetryDataFrame.TrackedTargetCenterX =     udpTelemetryMessage.TargetCenterX;
+    telemetryDataFrame.TrackedTargetCenterY =     udpTelemetryMessage.TargetCenterY;
+    telemetryDataFrame.TrackedTargetRectWidth =   udpTelemetryMessage.TargetRectWidth;
+    telemetryDataFrame.TrackedTargetRectHeight =  udpTelemetryMessage.TargetRectHeight;
+    telemetryDataFrame.TrackedTargetState =       udpTelemetryMessage.TargetState;
+
+    datagram.Value = QVariant::fromValue(telemetryDataFrame);
+}
+
 HardwareLink::HardwareLink(QObject *parent) : VideoLink(parent)
 {
-    EnterProc("HardwareLink::HardwareLink");
+    EnterProcStart("HardwareLink::HardwareLink");
 
     _opened = false;
     _licenseState = getAnimusLicenseState();
@@ -67,6 +128,8 @@ HardwareLink::HardwareLink(QObject *parent) : VideoLink(parent)
     _useExtTelemetryUDP = applicationSettings.UseExtTelemetryUDP;
     _udpExtTelemetryPort = applicationSettings.ExtTelemetryUDPPort;
 
+    _useBatchUDPReceiving = applicationSettings.UseBatchUDPReceiving;
+
     _delayTelemetryDataFrames = new TelemetryDelayLine(this, applicationSettings.VideoLagFromTelemetry);
     connect(_delayTelemetryDataFrames, &TelemetryDelayLine::dequeue, this, &HardwareLink::onTelemetryDelayLineDequeue);
 
@@ -101,9 +164,13 @@ HardwareLink::HardwareLink(QObject *parent) : VideoLink(parent)
     _bombingPlacePos.setIncorrect();
 
 
-    connect(&_udpUAVTelemetrySocket, &QUdpSocket::readyRead, this, &HardwareLink::processUAVTelemetryPendingDatagrams);
-    connect(&_udpCamTelemetrySocket, &QUdpSocket::readyRead, this, &HardwareLink::processCamTelemetryPendingDatagrams);
-    connect(&_udpExtTelemetrySocket, &QUdpSocket::readyRead, this, &HardwareLink::processExtTelemetryPendingDatagrams);
+    _udpUAVTelemetryReceiver = new UdpBatchReceiver(this);
+    _udpCamTelemetryReceiver = new UdpBatchReceiver(this);
+    _udpExtTelemetryReceiver = new UdpBatchReceiver(this);
+    _udpUAVTelemetryReceiver->setDecoder(decodeTelemetryDatagramV4);
+    connect(_udpUAVTelemetryReceiver, &UdpBatchReceiver::datagramsReceived, this, &HardwareLink::processUAVTelemetryDatagrams);
+    connect(_udpCamTelemetryReceiver, &UdpBatchReceiver::datagramsReceived, this, &HardwareLink::processCamTelemetryDatagrams);
+    connect(_udpExtTelemetryReceiver, &UdpBatchReceiver::datagramsReceived, this, &HardwareLink::processExtTelemetryDatagrams);
 
     connect(&_serialCommandPort, &QSerialPort::readyRead, this, &HardwareLink::readSerialPortMUSVData);
 
@@ -125,9 +192,12 @@ HardwareLink::HardwareLink(QObject *parent) : VideoLink(parent)
     _camConnectionByteCounter = 0;
     _telemetryConnectionByteCounter = 0;
 
-    _externalDataConsoleNotificator = new ExternalDataConsoleNotificator(this, applicationSettings.ExternalDataConsoleUDPPort);
+    _protocolMUSV = new protocolName::protocol();
+
+    _externalDataConsoleNotificator = new ExternalDataConsoleNotificator(this, applicationSettings.ExternalDataConsoleUDPPort,
+                                                                         applicationSettings.ExternalDataConsoleSubscriptionPortOffset,
+                                                                         applicationSettings.ExternalDataConsoleAlwaysBroadcast);
     connect(this, &HardwareLink::onClientCommandSent, _externalDataConsoleNotificator, &ExternalDataConsoleNotificator::onClientCommandSent);
-    connect(this, &HardwareLink::onTelemetryReceived, _externalDataConsoleNotificator, &ExternalDataConsoleNotificator::onTelemetryReceived);
 
     CommandProtocols commandProtocol = applicationSettings.CommandProtocol;
     switch(commandProtocol)
@@ -184,6 +254,7 @@ HardwareLink::HardwareLink(QObject *parent) : VideoLink(parent)
 HardwareLink::~HardwareLink()
 {
     closeVideoSource();
+    delete _protocolMUSV;
 }
 
 bool HardwareLink::camConnectionOn()
@@ -234,7 +305,8 @@ void HardwareLink::doActivateCatapult()
 void HardwareLink::onTelemetryDelayLineDequeue(const TelemetryDataFrame &value)
 {
     _currentTelemetryDataFrame = value;
-    notifyDataReceived();
+    if (updateCurrentTelemetryDataFrame())
+        emit telemetryDataReceived(_currentTelemetryDataFrame);
 }
 
 void HardwareLink::onCameraTelemetryDelayLineDequeue(const CameraTelemetryDataFrame &value)
@@ -245,7 +317,7 @@ void HardwareLink::onCameraTelemetryDelayLineDequeue(const CameraTelemetryDataFr
 
 void HardwareLink::timerEvent(QTimerEvent *event)
 {
-    EnterProc("HardwareLink::timerEvent");
+    EnterProcStart("HardwareLink::timerEvent");
     Q_UNUSED(event)
 
     if (event->timerId() == _connectionsStatusesTimer)
@@ -290,14 +362,29 @@ void HardwareLink::doOnCommandSent(const BinaryContent &commandContent, const QS
     clientCommand.VideoFrameNumber = _currentTelemetryDataFrame.VideoFrameNumber;
     clientCommand.TelemetryFrameNumber = _currentTelemetryDataFrame.TelemetryFrameNumber;
     clientCommand.Direction = DataExchangePackageDirection::Outgoing;
-    clientCommand.ContentHEX = commandContent.toHex();
+    clientCommand.Content = commandContent.toByteArray();
     clientCommand.Description = commandDescription;
     emit onClientCommandSent(clientCommand);
 }
 
+bool HardwareLink::telemetryDiagnosticsEnabled()
+{
+    return isSignalConnected(QMetaMethod::fromSignal(&HardwareLink::onTelemetryReceived)) ||
+            _externalDataConsoleNotificator->isBroadcasting();
+}
+
+// Raw bytes are shared with the data console and the notificator, they format hex only when it is shown
+void HardwareLink::notifyTelemetryReceived(const QByteArray &rawData)
+{
+    if (isSignalConnected(QMetaMethod::fromSignal(&HardwareLink::onTelemetryReceived)))
+        emit onTelemetryReceived(rawData);
+    if (_externalDataConsoleNotificator->isBroadcasting())
+        _externalDataConsoleNotificator->onTelemetryReceived(rawData);
+}
+
 void HardwareLink::sendCommand(const BinaryContent &commandContent, const QString &commandDescription)
 {
-    EnterProc("HardwareLink::sendCommand");
+    EnterProcStart("HardwareLink::sendCommand");
 
     if (commandContent.size() == 0)
         return;
@@ -322,18 +409,26 @@ void HardwareLink::sendCommand(const BinaryContent &commandContent, const QStrin
     }
 }
 
-void HardwareLink::notifyDataReceived()
+bool HardwareLink::updateCurrentTelemetryDataFrame()
 {
-    _currentTelemetryDataFrame.VideoFrameNumber = _videoFrameNumber;
-    _currentTelemetryDataFrame.SessionTimeMs = getSessionTimeMs();
-    _currentTelemetryDataFrame.VideoFPS = _receivedVideoFrameCountPrevSec;
-    _currentTelemetryDataFrame.TelemetryFPS = _receivedTelemetryFrameCountPrevSec;
+    updateLinkValues(_currentTelemetryDataFrame);
+    return _opened && (_licenseState != AnimusLicenseState::Expired);
+}
 
-    updateTrackerValues(_currentTelemetryDataFrame);
-    updateAntennaValues(_currentTelemetryDataFrame);
+void HardwareLink::updateLinkValues(TelemetryDataFrame &telemetryDataFrame)
+{
+    telemetryDataFrame.VideoFrameNumber = _videoFrameNumber;
+    telemetryDataFrame.SessionTimeMs = getSessionTimeMs();
+    telemetryDataFrame.VideoFPS = _receivedVideoFrameCountPrevSec;
+    telemetryDataFrame.TelemetryFPS = _receivedTelemetryFrameCountPrevSec;
+    telemetryDataFrame.DroppedTelemetryDatagramCount =
+            _udpUAVTelemetryReceiver->droppedDatagrams() + _udpCamTelemetryReceiver->droppedDatagrams();
+    const protocolName::DecoderStatistics &decoderStatistics = _protocolMUSV->GetStatistics();
+    telemetryDataFrame.CameraTelemetryFramingErrorCount = decoderStatistics.framingErrors;
+    telemetryDataFrame.CameraTelemetryChecksumErrorCount = decoderStatistics.checksumErrors;
 
-    if (_opened && (_licenseState != AnimusLicenseState::Expired))
-        emit dataReceived(_currentTelemetryDataFrame, _videoFrame);
+    updateTrackerValues(telemetryDataFrame);
+    updateAntennaValues(telemetryDataFrame);
 }
 
 void HardwareLink::forwardTelemetryDataFrame(const char *data, qint64 len)
@@ -429,7 +524,7 @@ const TelemetryDataFrame HardwareLink::getTelemetryDataFrame()
 
 void HardwareLink::open()
 {
-    EnterProc("HardwareLink::open");
+    EnterProcStart("HardwareLink::open");
     _sessionTime.start();
     _videoFrameNumber = 0;
     _telemetryFrameNumber = 0;
@@ -454,25 +549,13 @@ void HardwareLink::open()
         _udpCommandSocket.setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 1000000);
 
         if (_useCamTelemetryUDP)
-        {
-            _udpCamTelemetrySocket.bind(_udpCamTelemetryPort, QUdpSocket::DefaultForPlatform);
-            _udpCamTelemetrySocket.setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 10000); // -1 == Unlimited ???
-        }
+            _udpCamTelemetryReceiver->open(QHostAddress::Any, _udpCamTelemetryPort, false, _useBatchUDPReceiving);
 
         if (_useExtTelemetryUDP)
-        {
-            _udpExtTelemetrySocket.bind(_udpExtTelemetryPort, QUdpSocket::DefaultForPlatform);
-            _udpExtTelemetrySocket.setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 10000); // -1 == Unlimited ???
-        }
+            _udpExtTelemetryReceiver->open(QHostAddress::Any, _udpExtTelemetryPort, false, _useBatchUDPReceiving);
 
         if (_uavTelemetrySourceTypes == UAVTelemetrySourceTypes::UDPChannel)
-        {
-            //_udpUAVTelemetrySocket.bind(QHostAddress::Any, _udpUAVTelemetryPort, QUdpSocket::DefaultForPlatform);
-            //_udpUAVTelemetrySocket.setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 10000); // -1 == Unlimited ???
-
-            _udpUAVTelemetrySocket.bind(QHostAddress::Any, _udpUAVTelemetryPort, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint);
-            //_udpUAVTelemetrySocket.setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 10000);
-        }
+            _udpUAVTelemetryReceiver->open(QHostAddress::Any, _udpUAVTelemetryPort, true, _useBatchUDPReceiving);
 
         break;
     }
@@ -503,8 +586,9 @@ void HardwareLink::close()
         _catapultSerialPort.close();
 
     _udpCommandSocket.close();
-    _udpUAVTelemetrySocket.close();
-    //???_udpCamTelemetrySocket.close();
+    _udpUAVTelemetryReceiver->close();
+    _udpCamTelemetryReceiver->close();
+    _udpExtTelemetryReceiver->close();
 
     if (_trackerHardwareLink != nullptr)
         _trackerHardwareLink->close();
@@ -523,7 +607,7 @@ AntennaHardwareLink *HardwareLink::antenna()
 
 void HardwareLink::setHardwareCamStabilization(bool enabled)
 {
-    EnterProc("HardwareLink::setHardwareCamStabilization");
+    EnterProcStart("HardwareLink::setHardwareCamStabilization");
     auto description = QString("SetHardwareCamStabilization: %1").arg(enabled);
     sendCommand(_commandBuilder->SetupHardwareCamStabilizationCommand(enabled), description);
 }
@@ -551,14 +635,14 @@ void HardwareLink::setCamZoom(float zoom)
 
 void HardwareLink::setCamMotorStatus(bool enabled)
 {
-    EnterProc("HardwareLink::setCamMotorStatus");
+    EnterProcStart("HardwareLink::setCamMotorStatus");
     auto description = QString("setCamMotorStatus: %1").arg(enabled);
     sendCommand(_commandBuilder->SetupCamMotorStatusCommand(enabled), description);
 }
 
 void HardwareLink::setActiveOpticalSystemId(quint32 camId)
 {
-    EnterProc("HardwareLink::selectActiveCam");
+    EnterProcStart("HardwareLink::selectActiveCam");
     auto description = QString("selectActiveCam: %1").arg(camId);
     sendCommand(_commandBuilder->SelectActiveCamCommand(camId), description);
 
@@ -568,7 +652,7 @@ void HardwareLink::setActiveOpticalSystemId(quint32 camId)
 
 void HardwareLink::parkCamera()
 {
-    EnterProc("HardwareLink::parkCamera");
+    EnterProcStart("HardwareLink::parkCamera");
     auto description = QString("parkCamera");
     sendCommand(_commandBuilder->ParkingCommand(), description);
 }
@@ -596,21 +680,21 @@ void HardwareLink::setBombingPlacePos(double lat, double lon, double hmsl)
 
 void HardwareLink::dropBomb(int index)
 {
-    EnterProc("HardwareLink::dropBomb");
+    EnterProcStart("HardwareLink::dropBomb");
     auto description = QString("dropBomb: %1").arg(index);
     sendCommand(_commandBuilder->DropBombCommand(index), description);
 }
 
 void HardwareLink::makeSnapshot()
 {
-    EnterProc("HardwareLink::makeSnapshot");
+    EnterProcStart("HardwareLink::makeSnapshot");
     auto description = QString("makeSnapshot");
     sendCommand(_commandBuilder->MakeSnapshotCommand(), description);
 }
 
 void HardwareLink::activateCatapult()
 {
-    EnterProc("HardwareLink::activateCatapult");
+    EnterProcStart("HardwareLink::activateCatapult");
     if (_catapultCommandIdx <= 0)
         doActivateCatapult();
 }
@@ -628,7 +712,7 @@ void HardwareLink::onEmulatorTelemetryDataFrame(const EmulatorTelemetryDataFrame
 
 void HardwareLink::startSnapshotSeries(int intervalMsec)
 {
-    EnterProc("HardwareLink::startSnapshotSeries");
+    EnterProcStart("HardwareLink::startSnapshotSeries");
     //sendCommand(_commandBuilder->MakeSnapshotSeriesCommand(intervalSec));
 
     stopSnapshotSeries();
@@ -643,42 +727,42 @@ bool HardwareLink::isSnapshotSeries()
 
 void HardwareLink::startCamRecording()
 {
-    EnterProc("HardwareLink::startCamRecording");
+    EnterProcStart("HardwareLink::startCamRecording");
     auto description = QString("startCamRecording");
     sendCommand(_commandBuilder->StartCamRecordingCommand(), description);
 }
 
 void HardwareLink::stopCamRecording()
 {
-    EnterProc("HardwareLink::stopCamRecording");
+    EnterProcStart("HardwareLink::stopCamRecording");
     auto description = QString("startCamRecording");
     sendCommand(_commandBuilder->StopCamRecordingCommand(), description);
 }
 
 void HardwareLink::lockTarget(const QPoint &targetCenter)
 {
-    EnterProc("HardwareLink::lockTarget");
+    EnterProcStart("HardwareLink::lockTarget");
     if (_trackerHardwareLink != nullptr)
         _trackerHardwareLink->lockTarget(targetCenter);
 }
 
 void HardwareLink::unlockTarget()
 {
-    EnterProc("HardwareLink::unlockTarget");
+    EnterProcStart("HardwareLink::unlockTarget");
     if (_trackerHardwareLink != nullptr)
         _trackerHardwareLink->unlockTarget();
 }
 
 void HardwareLink::setTargetSize(int targetSize)
 {
-    EnterProc("HardwareLink::setTargetSize");
+    EnterProcStart("HardwareLink::setTargetSize");
     if (_trackerHardwareLink != nullptr)
         _trackerHardwareLink->setTargetSize(targetSize);
 }
 
 void HardwareLink::stopSnapshotSeries()
 {
-    EnterProc("HardwareLink::stopSnapshotSeries");
+    EnterProcStart("HardwareLink::stopSnapshotSeries");
     //sendCommand(_commandBuilder->StopSnapshotSeriesCommand());
 
     if (_snapshotSeriesTimer != UNASSIGNED_TIMER)
@@ -688,38 +772,36 @@ void HardwareLink::stopSnapshotSeries()
     }
 }
 
-void HardwareLink::processUAVTelemetryPendingDatagrams()
+void HardwareLink::processUAVTelemetryDatagrams(const UdpDatagramBatch &datagrams)
 {
-    bool isProcessed = false;
+    EnterProcStart("HardwareLink::processUAVTelemetryDatagrams");
 
-    if ((_telemetryDataFormat == UAVTelemetryDataFormats::UAVTelemetryFormatV4) ||
-        (_telemetryDataFormat == UAVTelemetryDataFormats::UAVTelemetryFormatV4_1))
+    for (const UdpDatagram &datagram : datagrams)
     {
-        isProcessed = processTelemetryPendingDatagramsV4();
-        if (!isProcessed)
+        if ((_telemetryDataFormat == UAVTelemetryDataFormats::UAVTelemetryFormatV4) ||
+            (_telemetryDataFormat == UAVTelemetryDataFormats::UAVTelemetryFormatV4_1))
         {
+            if (processTelemetryDatagramV4(datagram))
+                continue;
+
             qInfo() << "Incorrect Telemetry Pending Datagram V4 Size.";
-            _telemetryDataFormat = UAVTelemetryDataFormats::UAVTelemetryFormatUnknown;
         }
-    }
-    else
-        _telemetryDataFormat = UAVTelemetryDataFormats::UAVTelemetryFormatUnknown;
 
-    if (_telemetryDataFormat == UAVTelemetryDataFormats::UAVTelemetryFormatUnknown)
-        processTelemetryPendingDatagramsUnknownFormat();
+        _telemetryDataFormat = UAVTelemetryDataFormats::UAVTelemetryFormatUnknown;
+        processTelemetryDatagramUnknownFormat(datagram);
+    }
 }
 
-void HardwareLink::processCamTelemetryPendingDatagrams()
+void HardwareLink::processCamTelemetryDatagrams(const UdpDatagramBatch &datagrams)
 {
-    while (_udpCamTelemetrySocket.hasPendingDatagrams())
+    EnterProcStart("HardwareLink::processCamTelemetryDatagrams");
+
+    for (const UdpDatagram &datagram : datagrams)
     {
-        qint64 messageSize = _udpCamTelemetrySocket.pendingDatagramSize();
-        QByteArray rawData(messageSize, 0);
-        _udpCamTelemetrySocket.readDatagram(rawData.data(), messageSize);
-        processNewCameraTelemetryDataFrame(rawData);
+        processNewCameraTelemetryDataFrame(datagram.Data, getDatagramDelayLineTimeMs(datagram));
 
-        _telemetryConnectionByteCounter += rawData.size();
-        emit onTelemetryReceived(rawData.toHex());
+        _telemetryConnectionByteCounter += datagram.Data.size();
+        notifyTelemetryReceived(datagram.Data);
     }
 
     if (_uavTelemetrySourceTypes == UAVTelemetrySourceTypes::Emulator)
@@ -735,20 +817,14 @@ void HardwareLink::processCamTelemetryPendingDatagrams()
     }
 }
 
-void HardwareLink::processExtTelemetryPendingDatagrams()
+void HardwareLink::processExtTelemetryDatagrams(const UdpDatagramBatch &datagrams)
 {
-    QByteArray datagram;
-    qint64 messageSize = 0;
+    QRegExp rx("Temperature = (.+) C; Pressure = (.+) hPa");
+    rx.setMinimal(true);
 
-    while (_udpExtTelemetrySocket.hasPendingDatagrams())
+    for (const UdpDatagram &datagram : datagrams)
     {
-        messageSize = _udpExtTelemetrySocket.pendingDatagramSize();
-        datagram.resize(messageSize);
-        _udpExtTelemetrySocket.readDatagram(datagram.data(), messageSize);
-
-        QString datagramAsString = QString(datagram);
-        QRegExp rx("Temperature = (.+) C; Pressure = (.+) hPa");
-        rx.setMinimal(true);
+        QString datagramAsString = QString(datagram.Data);
 
         int i = rx.indexIn(datagramAsString);
 
@@ -771,12 +847,10 @@ void HardwareLink::processExtTelemetryPendingDatagrams()
     }
 }
 
-void HardwareLink::processNewCameraTelemetryDataFrame(const QByteArray &rawData)
+void HardwareLink::processNewCameraTelemetryDataFrame(const QByteArray &rawData, qint64 timeMs)
 {
-    static protocolName::protocol protocolMUSV;
-    protocolMUSV.SetData(rawData);
-    protocolMUSV.DecodingData();
-    protocolName::InputData *info = protocolMUSV.GetData();
+    _protocolMUSV->SetData(rawData);
+    protocolName::InputData *info = _protocolMUSV->GetData();
 
     CameraTelemetryDataFrame cameraDataFrame;
 
@@ -800,13 +874,13 @@ void HardwareLink::processNewCameraTelemetryDataFrame(const QByteArray &rawData)
         cameraDataFrame.RangefinderTemperature = 0;
     }
 
-    _delayCameraTelemetryDataFrames->enqueue(cameraDataFrame);
+    _delayCameraTelemetryDataFrames->enqueue(cameraDataFrame, timeMs);
 }
 
 void HardwareLink::readSerialPortMUSVData()
 {
     auto rawData = _serialCommandPort.readAll();
-    processNewCameraTelemetryDataFrame(rawData);
+    processNewCameraTelemetryDataFrame(rawData, getDelayLineTimeMs());
 
     TelemetryDataFrame telemetryDataFrame;
     telemetryDataFrame.clear();
@@ -819,114 +893,73 @@ void HardwareLink::readSerialPortMUSVData()
     _telemetryConnectionByteCounter += rawData.size();
 
     _delayTelemetryDataFrames->enqueue(telemetryDataFrame);
-    emit onTelemetryReceived(rawData.toHex());
+    notifyTelemetryReceived(rawData);
 }
 
-bool HardwareLink::processTelemetryPendingDatagramsV4()
+bool HardwareLink::processTelemetryDatagramV4(const UdpDatagram &datagram)
 {
-    UDPTelemetryMessageV4 udpTelemetryMessage;
+    if (!datagram.Value.isValid())
+        return false;
 
-    qint64 messageSize = sizeof(UDPTelemetryMessageV4);
-    while (_udpUAVTelemetrySocket.hasPendingDatagrams())
-    {
-        if (messageSize != _udpUAVTelemetrySocket.pendingDatagramSize())
-            return false;
-
-        _udpUAVTelemetrySocket.readDatagram((char*)&udpTelemetryMessage, messageSize);
-
-        TelemetryDataFrame telemetryDataFrame;
+    TelemetryDataFrame telemetryDataFrame = datagram.Value.value<TelemetryDataFrame>();
 
-        telemetryDataFrame.TelemetryFrameNumber = ++_telemetryFrameNumber;
-
-        telemetryDataFrame.UavRoll =                 udpTelemetryMessage.UavRoll;
-        telemetryDataFrame.UavPitch =                udpTelemetryMessage.UavPitch;
-        telemetryDataFrame.UavYaw =                  udpTelemetryMessage.UavYaw;
+    telemetryDataFrame.TelemetryFrameNumber = ++_telemetryFrameNumber;
 
-        telemetryDataFrame.UavLatitude_GPS =         udpTelemetryMessage.UavLatitude_GPS;
-        telemetryDataFrame.UavLongitude_GPS =        udpTelemetryMessage.UavLongitude_GPS;
-        telemetryDataFrame.UavAltitude_GPS =         udpTelemetryMessage.UavAltitude_GPS;
-        telemetryDataFrame.UavAltitude_Barometric =  udpTelemetryMessage.UavAltitude_Barometric;
-        telemetryDataFrame.Course_GPS =              udpTelemetryMessage.Course_GPS;
+    //Fix Error in transfer order
+    if (_telemetryDataFormat == UAVTelemetryDataFormats::UAVTelemetryFormatV4_1)
+        std::swap(telemetryDataFrame.UavYaw, telemetryDataFrame.Course_GPS);
 
-        //Fix Error in transfer order
-        if (_telemetryDataFormat == UAVTelemetryDataFormats::UAVTelemetryFormatV4_1)
-        {
-            telemetryDataFrame.UavYaw =              udpTelemetryMessage.Course_GPS;
-            telemetryDataFrame.Course_GPS =          udpTelemetryMessage.UavYaw;
-        }
+    if (!_isRangefinderEnabled) //???
+        telemetryDataFrame.RangefinderDistance = 0;
 
-        telemetryDataFrame.CamPitch =                udpTelemetryMessage.CamPitch;
-        telemetryDataFrame.CamRoll =                 udpTelemetryMessage.CamRoll;
-        telemetryDataFrame.CamYaw =                  udpTelemetryMessage.CamYaw;
-        telemetryDataFrame.CamZoom =                 udpTelemetryMessage.CamZoom;
-
-        telemetryDataFrame.CamEncoderRoll =          udpTelemetryMessage.CamEncoderRoll;
-        telemetryDataFrame.CamEncoderPitch =         udpTelemetryMessage.CamEncoderPitch;
-        telemetryDataFrame.CamEncoderYaw =           udpTelemetryMessage.CamEncoderYaw;
-
-        telemetryDataFrame.AirSpeed =                 udpTelemetryMessage.AirSpeed;
-        telemetryDataFrame.GroundSpeed_GPS =          udpTelemetryMessage.GroundSpeed_GPS;
-        telemetryDataFrame.WindDirection =            udpTelemetryMessage.WindDirection;
-        telemetryDataFrame.WindSpeed =                udpTelemetryMessage.WindSpeed;
-        telemetryDataFrame.GroundSpeedNorth_GPS =     udpTelemetryMessage.GroundSpeedNorth_GPS;
-        telemetryDataFrame.GroundSpeedEast_GPS =      udpTelemetryMessage.GroundSpeedEast_GPS;
-        telemetryDataFrame.VerticalSpeed =            udpTelemetryMessage.VerticalSpeed;
-        telemetryDataFrame.BombState =                udpTelemetryMessage.BombState;
-
-        if (_isRangefinderEnabled) //???
-            telemetryDataFrame.RangefinderDistance =      udpTelemetryMessage.RangefinderDistance;
-        else
-            telemetryDataFrame.RangefinderDistance =      0;
-
-        telemetryDataFrame.TrackedTargetCenterX =     udpTelemetryMessage.TargetCenterX;
-        telemetryDataFrame.TrackedTargetCenterY =     udpTelemetryMessage.TargetCenterY;
-        telemetryDataFrame.TrackedTargetRectWidth =   udpTelemetryMessage.TargetRectWidth;
-        telemetryDataFrame.TrackedTargetRectHeight =  udpTelemetryMessage.TargetRectHeight;
-        telemetryDataFrame.TrackedTargetState =       udpTelemetryMessage.TargetState;
+    updateTelemetryValues(telemetryDataFrame);
 
-        updateTelemetryValues(telemetryDataFrame);
+    _telemetryConnectionByteCounter += datagram.Data.size();
 
-        _telemetryConnectionByteCounter += sizeof(udpTelemetryMessage);
+    _delayTelemetryDataFrames->enqueue(telemetryDataFrame, getDatagramDelayLineTimeMs(datagram));
 
-        _delayTelemetryDataFrames->enqueue(telemetryDataFrame);
+    if (telemetryDiagnosticsEnabled())
+        notifyTelemetryReceived(datagram.Data);
 
-        QByteArray rawData = QByteArray((char*)&udpTelemetryMessage, messageSize);
-        emit onTelemetryReceived(rawData.toHex());
-
-        forwardTelemetryDataFrame((char*)&udpTelemetryMessage, messageSize);
-    }
+    forwardTelemetryDataFrame(datagram.Data.constData(), datagram.Data.size());
     return true;
 }
 
-void HardwareLink::processTelemetryPendingDatagramsUnknownFormat()
+void HardwareLink::processTelemetryDatagramUnknownFormat(const UdpDatagram &datagram)
 {
-    QByteArray datagram;
-    qint64 messageSize = 0;
-
-    //Ignore all datagrams
-    while (_udpUAVTelemetrySocket.hasPendingDatagrams())
-    {
-        messageSize = _udpUAVTelemetrySocket.pendingDatagramSize();
-        datagram.resize(messageSize);
-        _udpUAVTelemetrySocket.readDatagram(datagram.data(), messageSize);
-    }
-
-    if (messageSize == sizeof(UDPTelemetryMessageV4) &&
+    //Ignore the datagram, its size selects the format of the next ones
+    if (datagram.Data.size() == sizeof(UDPTelemetryMessageV4) &&
         (_telemetryDataFormat != UAVTelemetryDataFormats::UAVTelemetryFormatV4_1) )
         _telemetryDataFormat = UAVTelemetryDataFormats::UAVTelemetryFormatV4;
     //else the same UnknownFormat
 }
 
-void HardwareLink::videoFrameReceivedInternal(const QImage &frame, quint32 videoConnectionId)
+void HardwareLink::videoFrameReceivedInternal(const QImage &frame, quint32 videoConnectionId, qint64 arrivalTimeMs)
 {
     if (videoConnectionId != activeVideoConnectionId())
         return;
 
     _camConnectionByteCounter += frame.sizeInBytes();
     _videoFrameNumber++;
-    _videoFrame = frame;
 
-    //???    updateCameraTelemetry();
+    if (!updateCurrentTelemetryDataFrame())
+        return;
+
+    // Video frame gets the telemetry of its arrival moment instead of the last released telemetry frame.
+    // The interpolated frame goes only with the video, commands and getters keep the last released one
+    TelemetryDataFrame videoTelemetryDataFrame;
+    if (_delayTelemetryDataFrames->frameAt(arrivalTimeMs, videoTelemetryDataFrame))
+    {
+        CameraTelemetryDataFrame cameraDataFrame;
+        if ((_useCamTelemetryUDP || (_commandTransports == CommandTransports::Serial)) &&
+            _delayCameraTelemetryDataFrames->frameAt(arrivalTimeMs, cameraDataFrame))
+            cameraDataFrame.applyToTelemetryDataFrame(videoTelemetryDataFrame);
+        updateLinkValues(videoTelemetryDataFrame);
+    }
+    else
+    {
+        videoTelemetryDataFrame = _currentTelemetryDataFrame;
+    }
 
-    notifyDataReceived();
+    emit videoDataReceived(videoTelemetryDataFrame, frame);
 }
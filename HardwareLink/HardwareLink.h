@@ -17,11 +17,14 @@
 #include "HardwareLink/CommonCommandBuilder.h"
 #include "HardwareLink/TrackerHardwareLink.h"
 #include "HardwareLink/AntennaHardwareLink.h"
+#include "HardwareLink/UdpBatchReceiver.h"
 #include "ApplicationSettings.h"
 #include "Common/CommonUtils.h"
 #include "Common/BinaryContent.h"
 #include "DelayLine.h"
 
+namespace protocolName { class protocol; }
+
 const int OPTYCAL_SYSTEM_1   = 1;
 const int OPTYCAL_SYSTEM_2   = 2;
 const int OPTYCAL_SYSTEM_3   = 3;
@@ -33,9 +36,9 @@ private:
     bool _opened;
     AnimusLicenseState _licenseState;
 
-    QUdpSocket _udpUAVTelemetrySocket;
-    QUdpSocket _udpCamTelemetrySocket;
-    QUdpSocket _udpExtTelemetrySocket;
+    UdpBatchReceiver *_udpUAVTelemetryReceiver;
+    UdpBatchReceiver *_udpCamTelemetryReceiver;
+    UdpBatchReceiver *_udpExtTelemetryReceiver;
     QUdpSocket _udpCommandSocket;
     QSerialPort _serialCommandPort;
 
@@ -47,6 +50,9 @@ private:
     CommonCommandBuilder *_commandBuilder;
     ExternalDataConsoleNotificator *_externalDataConsoleNotificator;
 
+    // Camera telemetry decoder, a frame may be split between reads
+    protocolName::protocol *_protocolMUSV;
+
     quint32 _telemetryDataFormat; // TelemetryDataFormat
     quint32 _commandTransports; // CommandTransports
 
@@ -56,6 +62,7 @@ private:
     quint32 _udpCamTelemetryPort;
     bool _useExtTelemetryUDP;
     quint32 _udpExtTelemetryPort;
+    bool _useBatchUDPReceiving;
 
     QHostAddress _udpCommandAddress;
     quint32 _udpCommandPort;
@@ -74,7 +81,6 @@ private:
     QElapsedTimer _sessionTime;
     //quint32 _lastUpdatedTelemetryFrameNumber;
 
-    QImage _videoFrame;
 
     EmulatorTelemetryDataFrame _emulatorTelemetryDataFrame;
     ExtendedTelemetryDataFrame _extendedTelemetryDataFrame;
@@ -115,7 +121,8 @@ private:
     TelemetryDelayLine *_delayTelemetryDataFrames;
     TelemetryDataFrame _currentTelemetryDataFrame;
 
-    void notifyDataReceived();
+    bool updateCurrentTelemetryDataFrame();
+    void updateLinkValues(TelemetryDataFrame &telemetryDataFrame);
 
     void timerEvent(QTimerEvent *event);
 
@@ -128,10 +135,10 @@ private:
     void updateAntennaValues(TelemetryDataFrame &telemetryDataFrame);
     void updateTelemetryValues(TelemetryDataFrame &telemetryDataFrame);
 
-    void processNewCameraTelemetryDataFrame(const QByteArray &rawData);
+    void processNewCameraTelemetryDataFrame(const QByteArray &rawData, qint64 timeMs);
 
-    bool processTelemetryPendingDatagramsV4();
-    void processTelemetryPendingDatagramsUnknownFormat();
+    bool processTelemetryDatagramV4(const UdpDatagram &datagram);
+    void processTelemetryDatagramUnknownFormat(const UdpDatagram &datagram);
 public:
     explicit HardwareLink(QObject *parent);
     ~HardwareLink();
@@ -177,22 +184,26 @@ public slots:
     void onTracerModeChanged(const AutomaticTracerMode tracerMode);
     void onEmulatorTelemetryDataFrame(const EmulatorTelemetryDataFrame &emulatorTelemetryDataFrame);
 private slots:
-    void processUAVTelemetryPendingDatagrams();
-    void processCamTelemetryPendingDatagrams();
-    void processExtTelemetryPendingDatagrams();
+    void processUAVTelemetryDatagrams(const UdpDatagramBatch &datagrams);
+    void processCamTelemetryDatagrams(const UdpDatagramBatch &datagrams);
+    void processExtTelemetryDatagrams(const UdpDatagramBatch &datagrams);
     void readSerialPortMUSVData();
-    virtual void videoFrameReceivedInternal(const QImage &frame, quint32 videoConnectionId);
+    virtual void videoFrameReceivedInternal(const QImage &frame, quint32 videoConnectionId, qint64 arrivalTimeMs);
     void doActivateCatapult();
 
     void onTelemetryDelayLineDequeue(const TelemetryDataFrame &value);
     void onCameraTelemetryDelayLineDequeue(const CameraTelemetryDataFrame &value);
 
     void doOnCommandSent(const BinaryContent &commandContent, const QString &commandDescription);
+    bool telemetryDiagnosticsEnabled();
+    void notifyTelemetryReceived(const QByteArray &rawData);
 signals:
-    void dataReceived(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame);
+    // Telemetry ticks don't carry the video, frames carry the telemetry of their own moment
+    void telemetryDataReceived(const TelemetryDataFrame &telemetryFrame);
+    void videoDataReceived(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame);
     void onHardwareLinkStateChanged();
     void onClientCommandSent(const DataExchangePackage &clientCommand);
-    void onTelemetryReceived(const QString &telemetryHEX);
+    void onTelemetryReceived(const QByteArray &rawData);
 };
 
 #endif // HARDWARELINK_H
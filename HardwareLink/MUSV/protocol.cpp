@@ -1,4 +1,5 @@
 #include "protocol.h"
+#include <cstring>
 #include "QString"
 #include "QMessageBox"
 #include "QDebug"
@@ -6,6 +7,8 @@ using namespace protocolName;
 
 protocol::protocol()
 {
+    frameSize = 0;
+
     data.Encoders[0] = 0;
     data.Encoders[1] = 0;
     data.Encoders[2] = 0;
@@ -296,250 +299,278 @@ void protocol::ValueToArray(u_int16_t value, char* array, u_int8_t* sum)
 
 float protocol::ByteToFloat(u_int8_t index)
 {
+    // Values are big-endian
+    u_int8_t bytes[4] = {frame[index + 3], frame[index + 2], frame[index + 1], frame[index]};
     float value;
-    u_int8_t temp;
-    temp = array[index];
-    array[index] = array[index+3];
-    array[index+3] = temp;
-    temp = array[index+1];
-    array[index+1] = array[index+2];
-    array[index+2] = temp;
-
-    memcpy(&value, array.data()+index, 4);
+    memcpy(&value, bytes, 4);
     return value;
 }
 
-void protocol::SetData(QByteArray arr)
+void protocol::SetData(const QByteArray &arr)
 {
-    array += arr;
+    // Every byte is appended once, the frame is checked only when its length byte or its last byte arrives
+    for (int i = 0; i < arr.size(); ++i)
+    {
+        u_int8_t value = (u_int8_t)arr[i];
+        if (frameSize == 0 && !IsHead(value))
+        {
+            ++statistics.skippedBytes;
+            continue;
+        }
+
+        frame[frameSize++] = value;
+        if (frameSize == 2 || frameSize == frame[1])
+            DecodeBuffered(0);
+    }
 }
 
-void protocol::DecodingData()
+void protocol::DecodeBuffered(int start)
 {
-    int newIndex = -1;
-    int lastIndex;
-    do
+    for (;;)
     {
-        lastIndex = newIndex;
-        newIndex = FindNextHead(lastIndex+1);
-        if (newIndex >= 0)
+        // After a false head the real one can be inside the buffered bytes
+        int head = start;
+        while (head < frameSize && !IsHead(frame[head]))
+            ++head;
+        if (head > 0)
         {
-            u_int8_t dataLength = (u_int8_t)array[newIndex + 1];
-
-            if(CheckSum(newIndex) == true)
-            {
-
-                switch(array[newIndex])
-                {
-                case MUSV_IN_ANGLES:
-                    if (dataLength != 15) break;
-                    data.angles.roll = ByteToFloat(newIndex+2);
-                    data.angles.pitch = ByteToFloat(newIndex+6);
-                    data.angles.yaw = ByteToFloat(newIndex+10);
-                    data.newAngles = true;
-                    break;
-                case MUSV_IN_ENCODERS:
-                    if (dataLength != 15) break;
-                    data.Encoders[0] = ByteToFloat(newIndex+2);
-                    data.Encoders[1] = ByteToFloat(newIndex+6);
-                    data.Encoders[2] = ByteToFloat(newIndex+10);
-                    data.newEncoders = true;
-                    break;
-                case MUSV_IN_LD_T_D:
-                    if (dataLength != 11) break;
-                    data.LdTemperature = ByteToFloat(newIndex+2);
-                    data.LdDistance = ByteToFloat(newIndex+6);
-                    data.newLd = true;
-                    break;
-                case MUSV_IN_OTHER:
-                    if (dataLength != 15) break;
-                    data.ZoomAll = array[newIndex + 2];
-                    data.ZoomO = array[newIndex + 3];
-                    data.ZoomD = array[newIndex + 4];
-                    data.newOther = true;
-                    break;
-                case MSG_TYPE_OUT_BINS:
-                    for (int i = 0; i < 3; ++i) {
-                        data.Accel[i]  = ByteToFloat(newIndex+2+i*4);
-                        data.Gyro[i]  = ByteToFloat(newIndex+14+i*4);
-                        data.Mag[i]  = ByteToFloat(newIndex+26+i*4);
-                    }
-                    data.Temp =  ByteToFloat(newIndex+38);
-                    data.Time =  ByteToFloat(newIndex+42);
-                    data.newBins = true;
-                    break;
-                case MUSV_IN_SERVICE:
-                    switch(array[newIndex+2])
-                    {
-                    //Roll
-                    case MUSV_SERVICE_PID_ROLL_Kp:
-                        data.pid.roll.Kp = ByteToFloat(newIndex+3);
-                        data.pidFlag.roll.Kp = true;
-                        data.newPid.roll = true;
-                        break;
-                    case MUSV_SERVICE_PID_ROLL_Lp:
-                        data.pid.roll.Lp = ByteToFloat(newIndex+3);
-                        data.pidFlag.roll.Lp = true;
-                        data.newPid.roll = true;
-                        break;
-                    case MUSV_SERVICE_PID_ROLL_Ki:
-                        data.pid.roll.Ki = ByteToFloat(newIndex+3);
-                        data.pidFlag.roll.Ki = true;
-                        data.newPid.roll = true;
-                        break;
-                    case MUSV_SERVICE_PID_ROLL_Li:
-                        data.pid.roll.Li = ByteToFloat(newIndex+3);
-                        data.pidFlag.roll.Li = true;
-                        data.newPid.roll = true;
-                        break;
-                    case MUSV_SERVICE_PID_ROLL_Kd:
-                        data.pid.roll.Kd = ByteToFloat(newIndex+3);
-                        data.pidFlag.roll.Kd = true;
-                        data.newPid.roll = true;
-                        break;
-                    case MUSV_SERVICE_PID_ROLL_Ld:
-                        data.pid.roll.Ld = ByteToFloat(newIndex+3);
-                        data.pidFlag.roll.Ld = true;
-                        data.newPid.roll = true;
-                        break;
-                    case MUSV_SERVICE_PID_ROLL_L:
-                        data.pid.roll.L = ByteToFloat(newIndex+3);
-                        data.pidFlag.roll.L = true;
-                        data.newPid.roll = true;
-                        break;
-                        //Pitch
-                    case MUSV_SERVICE_PID_PITCH_Kp:
-                        data.pid.pitch.Kp = ByteToFloat(newIndex+3);
-                        data.pidFlag.pitch.Kp = true;
-                        data.newPid.pitch = true;
-                        break;
-                    case MUSV_SERVICE_PID_PITCH_Lp:
-                        data.pid.pitch.Lp = ByteToFloat(newIndex+3);
-                        data.pidFlag.pitch.Lp = true;
-                        data.newPid.pitch = true;
-                        break;
-                    case MUSV_SERVICE_PID_PITCH_Ki:
-                        data.pid.pitch.Ki = ByteToFloat(newIndex+3);
-                        data.pidFlag.pitch.Ki = true;
-                        data.newPid.pitch = true;
-                        break;
-                    case MUSV_SERVICE_PID_PITCH_Li:
-                        data.pid.pitch.Li = ByteToFloat(newIndex+3);
-                        data.pidFlag.pitch.Li = true;
-                        data.newPid.pitch = true;
-                        break;
-                    case MUSV_SERVICE_PID_PITCH_Kd:
-                        data.pid.pitch.Kd = ByteToFloat(newIndex+3);
-                        data.pidFlag.pitch.Kd = true;
-                        data.newPid.pitch = true;
-                        break;
-                    case MUSV_SERVICE_PID_PITCH_Ld:
-                        data.pid.pitch.Ld = ByteToFloat(newIndex+3);
-                        data.pidFlag.pitch.Ld = true;
-                        data.newPid.pitch = true;
-                        break;
-                    case MUSV_SERVICE_PID_PITCH_L:
-                        data.pid.pitch.L = ByteToFloat(newIndex+3);
-                        data.pidFlag.pitch.L = true;
-                        data.newPid.pitch = true;
-                        break;
-                        //Yaw
-                    case MUSV_SERVICE_PID_YAW_Kp:
-                        data.pid.yaw.Kp = ByteToFloat(newIndex+3);
-                        data.pidFlag.yaw.Kp = true;
-                        data.newPid.yaw = true;
-                        break;
-                    case MUSV_SERVICE_PID_YAW_Lp:
-                        data.pid.yaw.Lp = ByteToFloat(newIndex+3);
-                        data.pidFlag.yaw.Lp = true;
-                        data.newPid.yaw = true;
-                        break;
-                    case MUSV_SERVICE_PID_YAW_Ki:
-                        data.pid.yaw.Ki = ByteToFloat(newIndex+3);
-                        data.pidFlag.yaw.Ki = true;
-                        data.newPid.yaw = true;
-                        break;
-                    case MUSV_SERVICE_PID_YAW_Li:
-                        data.pid.yaw.Li = ByteToFloat(newIndex+3);
-                        data.pidFlag.yaw.Li = true;
-                        data.newPid.yaw = true;
-                        break;
-                    case MUSV_SERVICE_PID_YAW_Kd:
-                        data.pid.yaw.Kd = ByteToFloat(newIndex+3);
-                        data.pidFlag.yaw.Kd = true;
-                        data.newPid.yaw = true;
-                        break;
-                    case MUSV_SERVICE_PID_YAW_Ld:
-                        data.pid.yaw.Ld = ByteToFloat(newIndex+3);
-                        data.pidFlag.yaw.Ld = true;
-                        data.newPid.yaw = true;
-                        break;
-                    case MUSV_SERVICE_PID_YAW_L:
-                        data.pid.yaw.L = ByteToFloat(newIndex+3);
-                        data.pidFlag.yaw.L = true;
-                        data.newPid.yaw = true;
-                        break;
-                    case MUSV_SERVICE_CALIB_DATA:
-                        for (int i = 0; i < 9; i++) {
-                            *(data.MTrans+i) = ByteToFloat(newIndex+3+i*4);
-                        }
-                        for (int i = 0; i < 3; i++) {
-                            *(data.MBias+i) = ByteToFloat(newIndex+39+i*4);
-                        }
-                        data.newCalib = true;
-                        break;
-                    default:
-                        break;
-                    }
-                    break;
-                default:
-                    break;
-                }
-                array.remove(0, newIndex + array[newIndex + 1]-1);
-                newIndex = 0;
-            }
+            statistics.skippedBytes += head - start;
+            frameSize -= head;
+            memmove(frame, frame + head, frameSize);
+        }
+        if (frameSize < 2)
+            return;
+
+        u_int8_t frameLength = frame[1];
+        if (!IsValidLength(frame[0], frameLength))
+        {
+            ++statistics.framingErrors;
+            start = 1;
+            continue;
+        }
+        if (frameSize < frameLength)
+            return;
+
+        if (CheckSum())
+        {
+            DecodeFrame();
+            ++statistics.frames;
+            start = frameLength;
+        }
+        else
+        {
+            ++statistics.checksumErrors;
+            start = 1;
         }
-    } while(newIndex >= 0);
+    }
 }
 
-int protocol::FindNextHead(int startIndex)
+void protocol::DecodeFrame()
 {
-    int i = startIndex;
-    if(i > array.size())
-        return -1;
-    while(i < array.size())
+    switch(frame[0])
     {
-        switch(array[i])
+    case MUSV_IN_ANGLES:
+        data.angles.roll = ByteToFloat(2);
+        data.angles.pitch = ByteToFloat(6);
+        data.angles.yaw = ByteToFloat(10);
+        data.newAngles = true;
+        break;
+    case MUSV_IN_ENCODERS:
+        data.Encoders[0] = ByteToFloat(2);
+        data.Encoders[1] = ByteToFloat(6);
+        data.Encoders[2] = ByteToFloat(10);
+        data.newEncoders = true;
+        break;
+    case MUSV_IN_LD_T_D:
+        data.LdTemperature = ByteToFloat(2);
+        data.LdDistance = ByteToFloat(6);
+        data.newLd = true;
+        break;
+    case MUSV_IN_OTHER:
+        data.ZoomAll = frame[2];
+        data.ZoomO = frame[3];
+        data.ZoomD = frame[4];
+        data.newOther = true;
+        break;
+    case MSG_TYPE_OUT_BINS:
+        for (int i = 0; i < 3; ++i) {
+            data.Accel[i]  = ByteToFloat(2+i*4);
+            data.Gyro[i]  = ByteToFloat(14+i*4);
+            data.Mag[i]  = ByteToFloat(26+i*4);
+        }
+        data.Temp =  ByteToFloat(38);
+        data.Time =  ByteToFloat(42);
+        data.newBins = true;
+        break;
+    case MUSV_IN_SERVICE:
+        switch(frame[2])
         {
-        case MUSV_IN_ANGLES:
-        case MUSV_IN_SERVICE:
-        case MUSV_IN_OTHER:
-        case MSG_TYPE_OUT_BINS:
-        case MUSV_IN_ENCODERS:
-        case MUSV_IN_LD_T_D:
-            return i;
+        //Roll
+        case MUSV_SERVICE_PID_ROLL_Kp:
+            data.pid.roll.Kp = ByteToFloat(3);
+            data.pidFlag.roll.Kp = true;
+            data.newPid.roll = true;
+            break;
+        case MUSV_SERVICE_PID_ROLL_Lp:
+            data.pid.roll.Lp = ByteToFloat(3);
+            data.pidFlag.roll.Lp = true;
+            data.newPid.roll = true;
+            break;
+        case MUSV_SERVICE_PID_ROLL_Ki:
+            data.pid.roll.Ki = ByteToFloat(3);
+            data.pidFlag.roll.Ki = true;
+            data.newPid.roll = true;
+            break;
+        case MUSV_SERVICE_PID_ROLL_Li:
+            data.pid.roll.Li = ByteToFloat(3);
+            data.pidFlag.roll.Li = true;
+            data.newPid.roll = true;
+            break;
+        case MUSV_SERVICE_PID_ROLL_Kd:
+            data.pid.roll.Kd = ByteToFloat(3);
+            data.pidFlag.roll.Kd = true;
+            data.newPid.roll = true;
+            break;
+        case MUSV_SERVICE_PID_ROLL_Ld:
+            data.pid.roll.Ld = ByteToFloat(3);
+            data.pidFlag.roll.Ld = true;
+            data.newPid.roll = true;
+            break;
+        case MUSV_SERVICE_PID_ROLL_L:
+            data.pid.roll.L = ByteToFloat(3);
+            data.pidFlag.roll.L = true;
+            data.newPid.roll = true;
+            break;
+            //Pitch
+        case MUSV_SERVICE_PID_PITCH_Kp:
+            data.pid.pitch.Kp = ByteToFloat(3);
+            data.pidFlag.pitch.Kp = true;
+            data.newPid.pitch = true;
+            break;
+        case MUSV_SERVICE_PID_PITCH_Lp:
+            data.pid.pitch.Lp = ByteToFloat(3);
+            data.pidFlag.pitch.Lp = true;
+            data.newPid.pitch = true;
+            break;
+        case MUSV_SERVICE_PID_PITCH_Ki:
+            data.pid.pitch.Ki = ByteToFloat(3);
+            data.pidFlag.pitch.Ki = true;
+            data.newPid.pitch = true;
+            break;
+        case MUSV_SERVICE_PID_PITCH_Li:
+            data.pid.pitch.Li = ByteToFloat(3);
+            data.pidFlag.pitch.Li = true;
+            data.newPid.pitch = true;
+            break;
+        case MUSV_SERVICE_PID_PITCH_Kd:
+            data.pid.pitch.Kd = ByteToFloat(3);
+            data.pidFlag.pitch.Kd = true;
+            data.newPid.pitch = true;
+            break;
+        case MUSV_SERVICE_PID_PITCH_Ld:
+            data.pid.pitch.Ld = ByteToFloat(3);
+            data.pidFlag.pitch.Ld = true;
+            data.newPid.pitch = true;
+            break;
+        case MUSV_SERVICE_PID_PITCH_L:
+            data.pid.pitch.L = ByteToFloat(3);
+            data.pidFlag.pitch.L = true;
+            data.newPid.pitch = true;
+            break;
+            //Yaw
+        case MUSV_SERVICE_PID_YAW_Kp:
+            data.pid.yaw.Kp = ByteToFloat(3);
+            data.pidFlag.yaw.Kp = true;
+            data.newPid.yaw = true;
+            break;
+        case MUSV_SERVICE_PID_YAW_Lp:
+            data.pid.yaw.Lp = ByteToFloat(3);
+            data.pidFlag.yaw.Lp = true;
+            data.newPid.yaw = true;
+            break;
+        case MUSV_SERVICE_PID_YAW_Ki:
+            data.pid.yaw.Ki = ByteToFloat(3);
+            data.pidFlag.yaw.Ki = true;
+            data.newPid.yaw = true;
+            break;
+        case MUSV_SERVICE_PID_YAW_Li:
+            data.pid.yaw.Li = ByteToFloat(3);
+            data.pidFlag.yaw.Li = true;
+            data.newPid.yaw = true;
+            break;
+        case MUSV_SERVICE_PID_YAW_Kd:
+            data.pid.yaw.Kd = ByteToFloat(3);
+            data.pidFlag.yaw.Kd = true;
+            data.newPid.yaw = true;
+            break;
+        case MUSV_SERVICE_PID_YAW_Ld:
+            data.pid.yaw.Ld = ByteToFloat(3);
+            data.pidFlag.yaw.Ld = true;
+            data.newPid.yaw = true;
+            break;
+        case MUSV_SERVICE_PID_YAW_L:
+            data.pid.yaw.L = ByteToFloat(3);
+            data.pidFlag.yaw.L = true;
+            data.newPid.yaw = true;
+            break;
+        case MUSV_SERVICE_CALIB_DATA:
+            for (int i = 0; i < 9; i++) {
+                *(data.MTrans+i) = ByteToFloat(3+i*4);
+            }
+            for (int i = 0; i < 3; i++) {
+                *(data.MBias+i) = ByteToFloat(39+i*4);
+            }
+            data.newCalib = true;
             break;
         default:
-            ++i;
             break;
         }
+        break;
+    default:
+        break;
     }
-    return -1;
 }
 
-bool protocol::CheckSum(u_int16_t index)
+bool protocol::IsHead(u_int8_t value)
 {
-    u_int8_t checkSum = 0;
-    u_int16_t i;
-    for(i = index; i < index+array[index+1]-1; ++i)
+    switch(value)
     {
-        if(i == array.size())
-            break;
-        checkSum += (u_int8_t) array[i];
+    case MUSV_IN_ANGLES:
+    case MUSV_IN_SERVICE:
+    case MUSV_IN_OTHER:
+    case MSG_TYPE_OUT_BINS:
+    case MUSV_IN_ENCODERS:
+    case MUSV_IN_LD_T_D:
+        return true;
+    default:
+        return false;
     }
-    if(checkSum == (u_int8_t)array[i])
+}
+
+bool protocol::IsValidLength(u_int8_t type, u_int8_t length)
+{
+    switch(type)
     {
-        return true;
+    case MUSV_IN_ANGLES:
+    case MUSV_IN_ENCODERS:
+    case MUSV_IN_OTHER:
+        return length == 15;
+    case MUSV_IN_LD_T_D:
+        return length == 11;
+    case MSG_TYPE_OUT_BINS:
+        return length == 47;
+    case MUSV_IN_SERVICE:
+        return length == 8 || length == 52;  // PID coefficient or calibration data
+    default:
+        return false;
     }
-    return false;
+}
+
+bool protocol::CheckSum()
+{
+    u_int8_t frameLength = frame[1];
+    u_int8_t checkSum = 0;
+    for (int i = 0; i < frameLength - 1; ++i)
+        checkSum += frame[i];
+    return checkSum == frame[frameLength - 1];
 }
@@ -171,21 +171,35 @@ struct InputData
     bool newCalib;
 };
 
+struct DecoderStatistics
+{
+    uint32_t frames = 0;
+    uint32_t skippedBytes = 0;      // bytes outside of frames
+    uint32_t framingErrors = 0;     // known head with a wrong length
+    uint32_t checksumErrors = 0;
+};
+
 typedef uint8_t u_int8_t;
 typedef uint16_t u_int16_t;
 
 class protocol
 {
-    QByteArray array;
+    // Partial frame, the length byte limits frames to 255 bytes
+    u_int8_t frame[256];
+    int frameSize;
     InputData data;
+    DecoderStatistics statistics;
 
 private:
     float ConvertValue(QString str, bool* ok);
     void ValueToArray(float value, char* array, u_int8_t* sum);
     void ValueToArray(u_int16_t value, char* array, u_int8_t* sum);
     float ByteToFloat(u_int8_t index);
-    bool CheckSum(u_int16_t index);
-    int FindNextHead(int startIndex);
+    bool CheckSum();
+    static bool IsHead(u_int8_t value);
+    static bool IsValidLength(u_int8_t type, u_int8_t length);
+    void DecodeBuffered(int start);
+    void DecodeFrame();
 
 public:
     protocol();
@@ -202,9 +216,10 @@ public:
     QByteArray GenerateMessage(u_int8_t typeMessage, u_int8_t typeReg);
     QByteArray GenerateMagTransform(float* Trans, float * Bias);
 
-    void DecodingData();
-    void SetData(QByteArray arr);
+    // Decodes the stream as it arrives, a frame may be split between calls
+    void SetData(const QByteArray &arr);
     InputData* GetData() {return &data;}
+    const DecoderStatistics &GetStatistics() const {return statistics;}
 };
 
 }
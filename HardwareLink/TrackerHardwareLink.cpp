@@ -6,7 +6,7 @@
 
 void TrackerHardwareLink::sendTrackerCommand(const BinaryContent &commandContent, const QString &commandDescription)
 {
-    EnterProc("TrackerHardwareLink::sendCommand");
+    EnterProcStart("TrackerHardwareLink::sendCommand");
 
     if (commandContent.size() == 0)
         return;
@@ -94,20 +94,21 @@ TrackerHardwareLink::TrackerHardwareLink(QObject *parent) : QObject(parent)
     _trackerCommandUDPAddress = QHostAddress(applicationSettings.TrackerCommandUDPAddress.value());
 
     _trackerTelemetryUDPPort = applicationSettings.TrackerTelemetryUDPPort;
+    _useBatchUDPReceiving = applicationSettings.UseBatchUDPReceiving;
 
-    connect(&_udpTrackerTelemetrySocket, &QUdpSocket::readyRead, this, &TrackerHardwareLink::processTelemetryPendingDatagrams);
+    _udpTrackerTelemetryReceiver = new UdpBatchReceiver(this);
+    connect(_udpTrackerTelemetryReceiver, &UdpBatchReceiver::datagramsReceived, this, &TrackerHardwareLink::processTelemetryDatagrams);
 }
 
 void TrackerHardwareLink::open()
 {
-    _udpTrackerTelemetrySocket.bind(_trackerTelemetryUDPPort, QUdpSocket::DefaultForPlatform);
-    _udpTrackerTelemetrySocket.setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 10000);
+    _udpTrackerTelemetryReceiver->open(QHostAddress::Any, _trackerTelemetryUDPPort, false, _useBatchUDPReceiving);
 }
 
 void TrackerHardwareLink::close()
 {
     _udpTrackerCommandSocket.close();
-    _udpTrackerTelemetrySocket.close();
+    _udpTrackerTelemetryReceiver->close();
 }
 
 void TrackerHardwareLink::lockTarget(const QPoint &targetCenter)
@@ -174,16 +175,10 @@ void TrackerHardwareLink::setTargetSize(int targetSize)
     sendTrackerCommand(commandY, descriptionY);
 }
 
-void TrackerHardwareLink::processTelemetryPendingDatagrams()
+void TrackerHardwareLink::processTelemetryDatagrams(const UdpDatagramBatch &datagrams)
 {
-    while (_udpTrackerTelemetrySocket.hasPendingDatagrams())
-    {
-        quint64 dataSize = _udpTrackerTelemetrySocket.pendingDatagramSize();
-
-        QByteArray telemetryData(dataSize, 0);
-        _udpTrackerTelemetrySocket.readDatagram((char*)telemetryData.data(), dataSize);
-        decodeTrackerData((const uint8_t*)telemetryData.data(), dataSize);
-    }
+    for (const UdpDatagram &datagram : datagrams)
+        decodeTrackerData((const uint8_t*)datagram.Data.constData(), datagram.Data.size());
 }
 
 int32_t TrackerHardwareLink::decodeTrackerData(const uint8_t *data, const uint32_t dataSize)
@@ -5,6 +5,7 @@
 #include <QUdpSocket>
 #include <QHostAddress>
 #include "Common/BinaryContent.h"
+#include "HardwareLink/UdpBatchReceiver.h"
 
 class TrackerHardwareLink : public QObject
 {
@@ -14,8 +15,9 @@ class TrackerHardwareLink : public QObject
     QHostAddress _trackerCommandUDPAddress;
     quint32 _trackerCommandUDPPort;
 
-    QUdpSocket _udpTrackerTelemetrySocket;
+    UdpBatchReceiver *_udpTrackerTelemetryReceiver;
     quint32 _trackerTelemetryUDPPort;
+    bool _useBatchUDPReceiving;
 
     int32_t _trackingRectangleCenterX;			// Tracking rectangle horizontal center position.
     int32_t _trackingRectangleCenterY;			// Tracking rectangle vertical center position.
@@ -70,7 +72,7 @@ public:
     int32_t trackingRectangleHeight() const;
     uint8_t trackingState() const;
 private slots:
-    void processTelemetryPendingDatagrams();
+    void processTelemetryDatagrams(const UdpDatagramBatch &datagrams);
 signals:
     void onTrackerCommandSent(const BinaryContent &commandContent, const QString &commandDescription);
 };
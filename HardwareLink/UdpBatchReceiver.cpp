@@ -0,0 +1,275 @@
+#include "UdpBatchReceiver.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QDebug>
+#include "EnterProc.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <unistd.h>
+#include <time.h>
+#include <cstring>
+#endif
+
+constexpr int UDP_RECEIVE_BUFFER_SIZE = 4 * 1024 * 1024;
+constexpr int UDP_BATCH_SIZE = 64;
+constexpr int UDP_MAX_DATAGRAM_SIZE = 8192;
+constexpr int UDP_POLL_TIMEOUT_MS = 100;       // the thread checks the quit flag at least so often
+constexpr int UDP_MAX_BATCHES_PER_WAKEUP = 16; // a flood is emitted in parts, the consumer is not starved
+constexpr int UDP_TRUNCATION_WARNING_INTERVAL_MS = 1000;
+
+UdpBatchReceiverThread::UdpBatchReceiverThread(QObject *parent, int socket, const UdpDatagramDecoder &decoder): QThread(parent)
+{
+    setObjectName("UdpBatchReceiverThread");
+    _socket = socket;
+    _decoder = decoder;
+    _quit = 0;
+    _droppedDatagrams = 0;
+    _truncatedDatagrams = 0;
+}
+
+UdpBatchReceiverThread::~UdpBatchReceiverThread()
+{
+    stop();
+}
+
+void UdpBatchReceiverThread::stop()
+{
+    _quit = 1;
+    wait();
+}
+
+quint32 UdpBatchReceiverThread::droppedDatagrams() const
+{
+    return _droppedDatagrams.loadRelaxed();
+}
+
+quint32 UdpBatchReceiverThread::truncatedDatagrams() const
+{
+    return _truncatedDatagrams.loadRelaxed();
+}
+
+void UdpBatchReceiverThread::run()
+{
+#ifdef Q_OS_LINUX
+    QByteArray buffer(UDP_BATCH_SIZE * UDP_MAX_DATAGRAM_SIZE, Qt::Uninitialized);
+    const size_t controlSize = CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(quint32));
+    QByteArray controls(UDP_BATCH_SIZE * controlSize, Qt::Uninitialized);
+    mmsghdr messages[UDP_BATCH_SIZE];
+    iovec vectors[UDP_BATCH_SIZE];
+
+    // Truncated datagrams are reported once per interval, a misconfigured sender does not flood the log
+    QElapsedTimer truncationWarningTimer;
+    quint32 reportedTruncatedDatagrams = 0;
+
+    while (!_quit.loadRelaxed())
+    {
+        pollfd pollDescriptor = {_socket, POLLIN, 0};
+        if (poll(&pollDescriptor, 1, UDP_POLL_TIMEOUT_MS) <= 0)
+            continue;
+
+        // The socket is drained up to the limit, the receiver gets the burst at once and the rest after the next poll
+        UdpDatagramBatch datagrams;
+        int count;
+        int batchCount = 0;
+        do
+        {
+            for (int i = 0; i < UDP_BATCH_SIZE; i++)
+            {
+                vectors[i].iov_base = buffer.data() + i * UDP_MAX_DATAGRAM_SIZE;
+                vectors[i].iov_len = UDP_MAX_DATAGRAM_SIZE;
+                memset(&messages[i], 0, sizeof(mmsghdr));
+                messages[i].msg_hdr.msg_iov = &vectors[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+                messages[i].msg_hdr.msg_control = controls.data() + i * controlSize;
+                messages[i].msg_hdr.msg_controllen = controlSize;
+            }
+
+            count = recvmmsg(_socket, messages, UDP_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+            for (int i = 0; i < count; i++)
+            {
+                UdpDatagram datagram;
+                datagram.ArrivalTimeNs = 0;
+
+                for (cmsghdr *control = CMSG_FIRSTHDR(&messages[i].msg_hdr); control != nullptr;
+                     control = CMSG_NXTHDR(&messages[i].msg_hdr, control))
+                {
+                    if (control->cmsg_level != SOL_SOCKET)
+                        continue;
+                    if (control->cmsg_type == SCM_TIMESTAMPNS)
+                    {
+                        timespec arrivalTime;
+                        memcpy(&arrivalTime, CMSG_DATA(control), sizeof(arrivalTime));
+                        datagram.ArrivalTimeNs = arrivalTime.tv_sec * Q_INT64_C(1000000000) + arrivalTime.tv_nsec;
+                    }
+                    else if (control->cmsg_type == SO_RXQ_OVFL)
+                    {
+                        // Total count of datagrams dropped by the socket before this one
+                        quint32 droppedDatagrams;
+                        memcpy(&droppedDatagrams, CMSG_DATA(control), sizeof(droppedDatagrams));
+                        _droppedDatagrams.storeRelaxed(droppedDatagrams);
+                    }
+                }
+
+                if ((messages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0)
+                {
+                    _truncatedDatagrams.fetchAndAddRelaxed(1);
+                    continue;
+                }
+
+                if (datagram.ArrivalTimeNs == 0)
+                {
+                    timespec currentTime;
+                    clock_gettime(CLOCK_REALTIME, &currentTime);
+                    datagram.ArrivalTimeNs = currentTime.tv_sec * Q_INT64_C(1000000000) + currentTime.tv_nsec;
+                }
+                datagram.Data = QByteArray(static_cast<const char *>(vectors[i].iov_base), messages[i].msg_len);
+                if (_decoder)
+                    _decoder(datagram);
+                datagrams.append(datagram);
+            }
+        } while (count == UDP_BATCH_SIZE && ++batchCount < UDP_MAX_BATCHES_PER_WAKEUP && !_quit.loadRelaxed());
+
+        quint32 truncatedDatagrams = _truncatedDatagrams.loadRelaxed();
+        if (truncatedDatagrams != reportedTruncatedDatagrams &&
+            (!truncationWarningTimer.isValid() || truncationWarningTimer.elapsed() >= UDP_TRUNCATION_WARNING_INTERVAL_MS))
+        {
+            qWarning() << truncatedDatagrams - reportedTruncatedDatagrams << "UDP datagrams are truncated to"
+                       << UDP_MAX_DATAGRAM_SIZE << "bytes and skipped";
+            reportedTruncatedDatagrams = truncatedDatagrams;
+            truncationWarningTimer.start();
+        }
+
+        if (!datagrams.isEmpty())
+            emit datagramsReceived(datagrams);
+    }
+#endif
+}
+
+//------------------------------------------------------------------
+
+UdpBatchReceiver::UdpBatchReceiver(QObject *parent): QObject(parent)
+{
+    qRegisterMetaType<UdpDatagramBatch>();
+
+    _thread = nullptr;
+    _socket = -1;
+    connect(&_udpSocket, &QUdpSocket::readyRead, this, &UdpBatchReceiver::readPendingDatagrams);
+}
+
+UdpBatchReceiver::~UdpBatchReceiver()
+{
+    close();
+}
+
+void UdpBatchReceiver::setDecoder(const UdpDatagramDecoder &decoder)
+{
+    _decoder = decoder;
+}
+
+bool UdpBatchReceiver::open(const QHostAddress &address, quint16 port, bool shareAddress, bool useIOThread)
+{
+    close();
+
+    if (useIOThread)
+    {
+        if (openNative(address, port, shareAddress))
+            return true;
+        qWarning() << "UDP I/O thread is not available for port" << port << ", the event loop receives it";
+    }
+
+    auto bindMode = shareAddress ? QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint : QUdpSocket::DefaultForPlatform;
+    if (!_udpSocket.bind(address, port, bindMode))
+        return false;
+    _udpSocket.setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, UDP_RECEIVE_BUFFER_SIZE);
+    return true;
+}
+
+bool UdpBatchReceiver::openNative(const QHostAddress &address, quint16 port, bool shareAddress)
+{
+#ifdef Q_OS_LINUX
+    int socketDescriptor = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (socketDescriptor < 0)
+        return false;
+
+    int enable = 1;
+    int bufferSize = UDP_RECEIVE_BUFFER_SIZE;
+    if (shareAddress)
+        setsockopt(socketDescriptor, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    setsockopt(socketDescriptor, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    setsockopt(socketDescriptor, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+    setsockopt(socketDescriptor, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable));
+
+    sockaddr_in socketAddress;
+    memset(&socketAddress, 0, sizeof(socketAddress));
+    socketAddress.sin_family = AF_INET;
+    socketAddress.sin_port = htons(port);
+    socketAddress.sin_addr.s_addr = htonl(address.toIPv4Address());
+    if (::bind(socketDescriptor, reinterpret_cast<sockaddr *>(&socketAddress), sizeof(socketAddress)) < 0)
+    {
+        ::close(socketDescriptor);
+        return false;
+    }
+
+    _socket = socketDescriptor;
+    _thread = new UdpBatchReceiverThread(this, _socket, _decoder);
+    connect(_thread, &UdpBatchReceiverThread::datagramsReceived, this, &UdpBatchReceiver::datagramsReceived);
+    _thread->start(QThread::HighPriority);
+    return true;
+#else
+    Q_UNUSED(address)
+    Q_UNUSED(port)
+    Q_UNUSED(shareAddress)
+    return false;
+#endif
+}
+
+void UdpBatchReceiver::close()
+{
+    _udpSocket.close();
+
+    if (_thread != nullptr)
+    {
+        _thread->stop();
+        delete _thread;
+        _thread = nullptr;
+    }
+
+#ifdef Q_OS_LINUX
+    if (_socket >= 0)
+        ::close(_socket);
+#endif
+    _socket = -1;
+}
+
+quint32 UdpBatchReceiver::droppedDatagrams() const
+{
+    return _thread != nullptr ? _thread->droppedDatagrams() : 0;
+}
+
+quint32 UdpBatchReceiver::truncatedDatagrams() const
+{
+    return _thread != nullptr ? _thread->truncatedDatagrams() : 0;
+}
+
+void UdpBatchReceiver::readPendingDatagrams()
+{
+    EnterProcStart("UdpBatchReceiver::readPendingDatagrams");
+
+    UdpDatagramBatch datagrams;
+    while (_udpSocket.hasPendingDatagrams())
+    {
+        UdpDatagram datagram;
+        datagram.Data.resize(qMax<qint64>(0, _udpSocket.pendingDatagramSize()));
+        _udpSocket.readDatagram(datagram.Data.data(), datagram.Data.size());
+        datagram.ArrivalTimeNs = QDateTime::currentMSecsSinceEpoch() * 1000000;
+        if (_decoder)
+            _decoder(datagram);
+        datagrams.append(datagram);
+    }
+
+    if (!datagrams.isEmpty())
+        emit datagramsReceived(datagrams);
+}
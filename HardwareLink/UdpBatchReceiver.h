@@ -0,0 +1,80 @@
+#ifndef UDPBATCHRECEIVER_H
+#define UDPBATCHRECEIVER_H
+
+#include <QObject>
+#include <QThread>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QByteArray>
+#include <QVector>
+#include <QVariant>
+#include <QAtomicInteger>
+#include <functional>
+
+struct UdpDatagram final
+{
+    QByteArray Data;
+    qint64 ArrivalTimeNs;   // since the epoch, kernel time of the arrival when it is known
+    QVariant Value;         // set by the receiver decoder, invalid when it is not decoded
+};
+
+typedef QVector<UdpDatagram> UdpDatagramBatch;
+
+// Decodes a datagram on the receiving thread, it must not touch the state of the consumer
+typedef std::function<void(UdpDatagram &datagram)> UdpDatagramDecoder;
+
+// Drains the socket by recvmmsg and sleeps in poll between bursts (Linux only)
+class UdpBatchReceiverThread final : public QThread
+{
+    Q_OBJECT
+
+    int _socket;
+    UdpDatagramDecoder _decoder;
+    QAtomicInt _quit;
+    QAtomicInteger<quint32> _droppedDatagrams;
+    QAtomicInteger<quint32> _truncatedDatagrams;
+protected:
+    void run() override;
+public:
+    UdpBatchReceiverThread(QObject *parent, int socket, const UdpDatagramDecoder &decoder);
+    ~UdpBatchReceiverThread();
+
+    void stop();
+    quint32 droppedDatagrams() const;
+    quint32 truncatedDatagrams() const;
+signals:
+    void datagramsReceived(const UdpDatagramBatch &datagrams);
+};
+
+// Receives datagrams of a port in batches.
+// The I/O thread keeps the event loop out of the receiving, it gives kernel arrival times and the socket drop counter.
+// Without it the QUdpSocket is drained on every readyRead.
+// The decoder runs on the I/O thread too, the event loop gets decoded datagrams
+class UdpBatchReceiver final : public QObject
+{
+    Q_OBJECT
+
+    QUdpSocket _udpSocket;
+    UdpBatchReceiverThread *_thread;
+    int _socket;
+    UdpDatagramDecoder _decoder;
+
+    bool openNative(const QHostAddress &address, quint16 port, bool shareAddress);
+private slots:
+    void readPendingDatagrams();
+public:
+    explicit UdpBatchReceiver(QObject *parent);
+    ~UdpBatchReceiver();
+
+    void setDecoder(const UdpDatagramDecoder &decoder);   // before open
+    bool open(const QHostAddress &address, quint16 port, bool shareAddress, bool useIOThread);
+    void close();
+    quint32 droppedDatagrams() const;
+    quint32 truncatedDatagrams() const;
+signals:
+    void datagramsReceived(const UdpDatagramBatch &datagrams);
+};
+
+Q_DECLARE_METATYPE(UdpDatagramBatch)
+
+#endif // UDPBATCHRECEIVER_H
@@ -216,7 +216,7 @@ SimpleVideoLink::~SimpleVideoLink()
 
 }
 
-void SimpleVideoLink::videoFrameReceivedInternal(const QImage &frame, quint32 videoConnectionId)
+void SimpleVideoLink::videoFrameReceivedInternal(const QImage &frame, quint32 videoConnectionId, qint64 arrivalTimeMs)
 {
     emit videoFrameReceived(frame);
 }
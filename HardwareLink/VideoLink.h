@@ -32,7 +32,8 @@ public:
     quint32 activeVideoConnectionId();
     CamAssemblyPreferences *camAssemblyPreferences();
 private slots:
-    virtual void videoFrameReceivedInternal(const QImage &frame, quint32 videoConnectionId) = 0;
+    // arrivalTimeMs is the time of getDelayLineTimeMs() when the frame is received by the video source
+    virtual void videoFrameReceivedInternal(const QImage &frame, quint32 videoConnectionId, qint64 arrivalTimeMs) = 0;
     void usbCameraError(QCamera::Error value);
 };
 
@@ -43,7 +44,7 @@ public:
     explicit SimpleVideoLink(QObject *parent);
     ~SimpleVideoLink();
 private slots:
-    void videoFrameReceivedInternal(const QImage &frame, quint32 videoConnectionId);
+    void videoFrameReceivedInternal(const QImage &frame, quint32 videoConnectionId, qint64 arrivalTimeMs);
 signals:
     void videoFrameReceived(const QImage &frame);
 };
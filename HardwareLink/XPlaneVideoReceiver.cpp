@@ -2,6 +2,7 @@
 #include <QDebug>
 #include "lz4.h"
 #include "EnterProc.h"
+#include "HardwareLink/DelayLine.h"
 
 XPlaneVideoReceiver::XPlaneVideoReceiver(QObject *parent, quint32 videoConnectionId, bool verticalMirror, QHostAddress addr, quint16 udpPort) : QObject(parent)
 {
@@ -26,10 +27,10 @@ XPlaneVideoReceiver::~XPlaneVideoReceiver()
     delete _thread;
 }
 
-void XPlaneVideoReceiver::frameAvailableInternal(const QImage & frame)
+void XPlaneVideoReceiver::frameAvailableInternal(const QImage & frame, qint64 arrivalTimeMs)
 {
     EnterProcStart("XPlaneVideoReceiver::frameAvailableInternal");
-    emit frameAvailable(frame, _videoConnectionId);
+    emit frameAvailable(frame, _videoConnectionId, arrivalTimeMs);
 }
 
 XPlaneVideoReceiverWorker::XPlaneVideoReceiverWorker(QObject *parent, bool verticalMirror, QHostAddress addr, quint16 port): QObject(parent)
@@ -38,7 +39,10 @@ XPlaneVideoReceiverWorker::XPlaneVideoReceiverWorker(QObject *parent, bool verti
     _address = addr;
     _port = port;
     _tcpSocket = nullptr;
+    _reconnectionTimer = nullptr;
     _compressedData = nullptr;
+    _compressedDataLength = 0;
+    _imageData = nullptr;
 }
 
 XPlaneVideoReceiverWorker::~XPlaneVideoReceiverWorker()
@@ -49,15 +53,15 @@ XPlaneVideoReceiverWorker::~XPlaneVideoReceiverWorker()
     if (_tcpSocket != nullptr)
         _tcpSocket->close();
 
-    delete _compressedData;
-    delete _imageData;
+    delete[] _compressedData;
+    delete[] _imageData;
 }
 
 void XPlaneVideoReceiverWorker::startProcessing()
 {
-    _compressedDataLength = LZ4_compressBound(XPLANE_IMAGE_DATA_SIZE);
+    _compressedDataLength = LZ4_compressBound(XPLANE_MAX_IMAGE_DATA_SIZE);
     _compressedData = new quint8[_compressedDataLength];
-    _imageData = new quint8[XPLANE_IMAGE_DATA_SIZE];
+    _imageData = new quint8[XPLANE_MAX_IMAGE_DATA_SIZE];
 
     _tcpSocket = new QTcpSocket(this);
     _tcpSocket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 4000000);
@@ -73,52 +77,115 @@ void XPlaneVideoReceiverWorker::startProcessing()
     _tcpSocket->connectToHost(_address, _port, QIODevice::ReadOnly);
 }
 
-#pragma pack(1)
-struct XPLANE_PACKET {
-    quint32 frameId;
-    quint32 frameTotalSize;
-    quint16 framePartNo;
-    quint8  frameData[XPLANE_PACKET_CHUNKSIZE];
-};
-#pragma pack()
-
 void XPlaneVideoReceiverWorker::readVideoData()
 {
-    XPLANE_PACKET* udpPacket;
-
-    do {
-        _tcpBuffer.append(_tcpSocket->readAll());
-
-        while (static_cast<quint32>(_tcpBuffer.size()) >= sizeof(XPLANE_PACKET))
+    // Packets are read straight from the socket's own ring buffer, the chunk goes directly to its place in the frame
+    XPLANE_PACKET_HEADER header;
+    qint64 arrivalTimeMs = getDelayLineTimeMs();
+    while (_tcpSocket->bytesAvailable() >= XPLANE_PACKET_SIZE)
+    {
+        _tcpSocket->read(reinterpret_cast<char*>(&header), sizeof(header));
+
+        int frameTotalSize = static_cast<int>(header.frameTotalSize);
+        int chunkDataOffset = header.framePartNo * XPLANE_PACKET_CHUNKSIZE;
+        int chunkDataSize = qMin(frameTotalSize - chunkDataOffset, XPLANE_PACKET_CHUNKSIZE);
+
+        if (frameTotalSize <= 0 || frameTotalSize > _compressedDataLength || chunkDataSize <= 0)
         {
-            udpPacket = reinterpret_cast<XPLANE_PACKET*>(_tcpBuffer.data());
-
-            int framePartCount = static_cast<int>(std::ceil(static_cast<float>(udpPacket->frameTotalSize) / XPLANE_PACKET_CHUNKSIZE));
-            bool isLastChunk = (udpPacket->framePartNo + 1) >= framePartCount;
-
-            int chunkDataOffset = udpPacket->framePartNo * XPLANE_PACKET_CHUNKSIZE;
-            int chunkDataSize = isLastChunk ? udpPacket->frameTotalSize % XPLANE_PACKET_CHUNKSIZE : XPLANE_PACKET_CHUNKSIZE;
-
-            if ((chunkDataOffset + chunkDataSize) < _compressedDataLength)
-                memcpy(_compressedData + chunkDataOffset, udpPacket->frameData, static_cast<size_t>(chunkDataSize));
+            _tcpSocket->skip(XPLANE_PACKET_CHUNKSIZE);
+            continue;
+        }
 
-            if (isLastChunk)
-            {
-                LZ4_decompress_safe(reinterpret_cast<char*>(_compressedData), reinterpret_cast<char*>(_imageData),
-                                    static_cast<int>(udpPacket->frameTotalSize), XPLANE_IMAGE_DATA_SIZE);
+        _tcpSocket->read(reinterpret_cast<char*>(_compressedData + chunkDataOffset), chunkDataSize);
+        if (chunkDataSize < XPLANE_PACKET_CHUNKSIZE)
+            _tcpSocket->skip(XPLANE_PACKET_CHUNKSIZE - chunkDataSize);
 
-                QImage resultImage{_imageData, XPLANE_IMAGE_WIDTH, XPLANE_IMAGE_HEIGHT, QImage::Format_ARGB32};
-                QImage rgb32Image = resultImage.convertToFormat(QImage::Format_RGB32);
+        bool isLastChunk = chunkDataOffset + chunkDataSize >= frameTotalSize;
+        if (isLastChunk)
+            decodeFrame(frameTotalSize, arrivalTimeMs);
+    }
+}
 
-                if (_verticalMirror)
-                    rgb32Image = rgb32Image.mirrored(false, true);
+const QSize XPlaneVideoReceiverWorker::frameSizeForDataSize(int dataSize)
+{
+    static const QSize knownFrameSizes[] = {
+        QSize(720, 576), QSize(640, 480), QSize(768, 576), QSize(800, 600), QSize(1024, 768),
+        QSize(1280, 720), QSize(1280, 1024), QSize(1920, 1080)
+    };
+
+    for (auto frameSize : knownFrameSizes)
+        if (frameSize.width() * frameSize.height() * XPLANE_IMAGE_BPP == dataSize)
+            return frameSize;
+    return QSize();
+}
 
-                emit workerFrameAvailable(rgb32Image);
-            };
+int XPlaneVideoReceiverWorker::pooledFrameIndex(const QSize &frameSize)
+{
+    // A frame is free when nobody except the pool holds it
+    for (int i = 0; i < _framePool.count(); i++)
+        if (_framePool[i].size() == frameSize && _framePool[i].isDetached())
+            return i;
+
+    QImage frame(frameSize, QImage::Format_RGB32);
+    if (_framePool.count() < XPLANE_FRAME_POOL_SIZE)
+    {
+        _framePool.append(frame);
+        return _framePool.count() - 1;
+    }
+
+    // All frames are still in use, the oldest one stays with its receivers
+    _framePool.removeFirst();
+    _framePool.append(frame);
+    return _framePool.count() - 1;
+}
 
-            _tcpBuffer.remove(0, sizeof(XPLANE_PACKET));
+void XPlaneVideoReceiverWorker::decodeFrame(int compressedDataSize, qint64 arrivalTimeMs)
+{
+    auto compressedData = reinterpret_cast<const char*>(_compressedData);
+
+    // Usually the frame size does not change, the frame is decompressed directly into the pooled frame
+    if (!_verticalMirror && _frameSize.isValid())
+    {
+        int frameIndex = pooledFrameIndex(_frameSize);
+        QImage &frame = _framePool[frameIndex];
+        int frameDataSize = static_cast<int>(frame.sizeInBytes());
+        int dataSize = LZ4_decompress_safe(compressedData, reinterpret_cast<char*>(frame.bits()),
+                                           compressedDataSize, frameDataSize);
+        if (dataSize == frameDataSize)
+        {
+            auto pixels = reinterpret_cast<quint32*>(frame.bits());
+            for (int i = 0; i < frameDataSize / XPLANE_IMAGE_BPP; i++)
+                pixels[i] |= 0xFF000000;
+            emit workerFrameAvailable(frame, arrivalTimeMs);
+            return;
         }
-    } while (_tcpSocket->bytesAvailable() > 0);
+    }
+
+    int dataSize = LZ4_decompress_safe(compressedData, reinterpret_cast<char*>(_imageData),
+                                       compressedDataSize, XPLANE_MAX_IMAGE_DATA_SIZE);
+    QSize frameSize = frameSizeForDataSize(dataSize);
+    if (!frameSize.isValid())
+    {
+        if (_frameSize.isValid() || dataSize <= 0)
+            qDebug() << "XPlane Video frame with unsupported size dropped: " << dataSize;
+        _frameSize = QSize();
+        return;
+    }
+    _frameSize = frameSize;
+
+    // BGRA to RGB32 conversion and mirroring are done in one pass
+    QImage &frame = _framePool[pooledFrameIndex(frameSize)];
+    int width = frameSize.width();
+    int height = frameSize.height();
+    for (int y = 0; y < height; y++)
+    {
+        auto source = reinterpret_cast<const quint32*>(_imageData) + y * width;
+        auto target = reinterpret_cast<quint32*>(frame.scanLine(_verticalMirror ? height - 1 - y : y));
+        for (int x = 0; x < width; x++)
+            target[x] = source[x] | 0xFF000000;
+    }
+
+    emit workerFrameAvailable(frame, arrivalTimeMs);
 }
 
 void XPlaneVideoReceiverWorker::socketStateChanged(QAbstractSocket::SocketState socketState)
@@ -144,5 +211,4 @@ void XPlaneVideoReceiverWorker::socketConnected()
 void XPlaneVideoReceiverWorker::socketDisconnected()
 {
     qDebug() << "XPlane Video Socket disconnected";
-    _tcpBuffer.clear();
 }
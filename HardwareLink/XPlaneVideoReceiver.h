@@ -8,29 +8,48 @@
 #include <QImage>
 #include <QHostAddress>
 #include <QTimer>
+#include <QVector>
 
-const int XPLANE_PACKET_CHUNKSIZE = 1400;
-const int XPLANE_IMAGE_WIDTH      =  720;
-const int XPLANE_IMAGE_HEIGHT     =  576;
-const int XPLANE_IMAGE_BPP        =    4;
-const int XPLANE_IMAGE_DATA_SIZE  = XPLANE_IMAGE_WIDTH * XPLANE_IMAGE_HEIGHT * XPLANE_IMAGE_BPP;
-const int RECONNECTION_DELAY      = 5000;
+const int XPLANE_PACKET_CHUNKSIZE    = 1400;
+const int XPLANE_IMAGE_BPP           =    4;
+// Largest supported frame is 1920x1080, the frame size is detected from the decompressed data size
+const int XPLANE_MAX_IMAGE_DATA_SIZE = 1920 * 1080 * XPLANE_IMAGE_BPP;
+const int XPLANE_FRAME_POOL_SIZE     =    4;
+const int RECONNECTION_DELAY         = 5000;
+
+#pragma pack(push, 1)
+struct XPLANE_PACKET_HEADER {
+    quint32 frameId;
+    quint32 frameTotalSize;
+    quint16 framePartNo;
+};
+#pragma pack(pop)
+
+// Every packet carries a whole chunk, the last chunk of a frame is padded
+const int XPLANE_PACKET_SIZE = sizeof(XPLANE_PACKET_HEADER) + XPLANE_PACKET_CHUNKSIZE;
 
 class XPlaneVideoReceiverWorker final : public QObject
 {
     Q_OBJECT
 
     QTcpSocket * _tcpSocket;
-    QByteArray _tcpBuffer;
     QTimer * _reconnectionTimer;
 
     quint8 * _compressedData;
     qint32 _compressedDataLength;
     quint8 * _imageData;
 
+    // Frames are reused as soon as the receivers release them
+    QVector<QImage> _framePool;
+    QSize _frameSize;
+
     bool _verticalMirror;
     QHostAddress _address;
     quint16 _port;
+
+    static const QSize frameSizeForDataSize(int dataSize);
+    int pooledFrameIndex(const QSize &frameSize);
+    void decodeFrame(int compressedDataSize, qint64 arrivalTimeMs);
 public:
     explicit XPlaneVideoReceiverWorker(QObject *parent, bool verticalMirror, QHostAddress addr, quint16 port);
     ~XPlaneVideoReceiverWorker();
@@ -43,7 +62,7 @@ public slots:
     void socketConnected();
     void socketDisconnected();
 signals:
-    void workerFrameAvailable(const QImage &frame);
+    void workerFrameAvailable(const QImage &frame, qint64 arrivalTimeMs);
 };
 
 class XPlaneVideoReceiver final : public QObject
@@ -55,9 +74,10 @@ public:
     explicit XPlaneVideoReceiver(QObject *parent, quint32 videoConnectionId, bool verticalMirror, QHostAddress addr, quint16 port);
     ~XPlaneVideoReceiver();
 private slots:
-    void frameAvailableInternal(const QImage &frame);
+    void frameAvailableInternal(const QImage &frame, qint64 arrivalTimeMs);
 signals:
-    void frameAvailable(const QImage &frame, quint32 videoConnectionId);
+    // arrivalTimeMs is the time of getDelayLineTimeMs() when the last packet of the frame is received
+    void frameAvailable(const QImage &frame, quint32 videoConnectionId, qint64 arrivalTimeMs);
 };
 
 #endif // XPLANEVIDEORECEIVER_H
@@ -3,6 +3,10 @@
 #include <chrono>
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
 #include "CorrelationVideoTracker.h"
 
 #define register
@@ -24,6 +28,150 @@
 #define SKO_MULTIPLICATOR 1.0f		/// Multiplicator for deviation surface.
 #define MASK_ADD_VALUE 4			/// Adding value to mask.
 #define MIN_CORR_VALUE 0.4f			/// Minimum correlation value due finding frame_ID.
+#define FFT_BUTTERFLY_COST 20.0		/// Cost of FFT butterfly in vectorized products of spatial correlation, measured.
+
+
+
+/**
+ * @brief Products of the correlation inner loop. Integer arithmetic, so every implementation gives the same result.
+ * The implementation is selected once by CPU features.
+*/
+namespace
+{
+	int32_t WindowPatternProduct_scalar(const int32_t* window, const int32_t* pattern, int32_t count)
+	{
+		int32_t result = 0;
+		for (int32_t t = 0; t < count; ++t)
+			result += window[t] * pattern[t];
+		return result;
+	}
+
+	uint32_t WindowMaskProduct_scalar(const uint32_t* window, const uint8_t* mask, int32_t count)
+	{
+		uint32_t result = 0;
+		for (int32_t t = 0; t < count; ++t)
+			result += window[t] * (uint32_t)mask[t];
+		return result;
+	}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CVT_X86_SIMD
+
+	__attribute__((target("sse4.1")))
+	inline int32_t HorizontalSum_sse41(__m128i sum)
+	{
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtsi128_si32(sum);
+	}
+
+	__attribute__((target("sse4.1")))
+	int32_t WindowPatternProduct_sse41(const int32_t* window, const int32_t* pattern, int32_t count)
+	{
+		__m128i sum = _mm_setzero_si128();
+		int32_t t = 0;
+		for (; t + 4 <= count; t += 4)
+		{
+			__m128i w = _mm_loadu_si128((const __m128i*)(window + t));
+			__m128i p = _mm_loadu_si128((const __m128i*)(pattern + t));
+			sum = _mm_add_epi32(sum, _mm_mullo_epi32(w, p));
+		}
+		int32_t result = HorizontalSum_sse41(sum);
+		for (; t < count; ++t)
+			result += window[t] * pattern[t];
+		return result;
+	}
+
+	__attribute__((target("sse4.1")))
+	uint32_t WindowMaskProduct_sse41(const uint32_t* window, const uint8_t* mask, int32_t count)
+	{
+		__m128i sum = _mm_setzero_si128();
+		int32_t t = 0;
+		for (; t + 4 <= count; t += 4)
+		{
+			__m128i w = _mm_loadu_si128((const __m128i*)(window + t));
+			int32_t maskBytes;
+			memcpy(&maskBytes, mask + t, sizeof(maskBytes));
+			__m128i m = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(maskBytes));
+			sum = _mm_add_epi32(sum, _mm_mullo_epi32(w, m));
+		}
+		uint32_t result = (uint32_t)HorizontalSum_sse41(sum);
+		for (; t < count; ++t)
+			result += window[t] * (uint32_t)mask[t];
+		return result;
+	}
+
+	__attribute__((target("avx2")))
+	inline int32_t HorizontalSum_avx2(__m256i sum)
+	{
+		__m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+		half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtsi128_si32(half);
+	}
+
+	__attribute__((target("avx2")))
+	int32_t WindowPatternProduct_avx2(const int32_t* window, const int32_t* pattern, int32_t count)
+	{
+		__m256i sum = _mm256_setzero_si256();
+		int32_t t = 0;
+		for (; t + 8 <= count; t += 8)
+		{
+			__m256i w = _mm256_loadu_si256((const __m256i*)(window + t));
+			__m256i p = _mm256_loadu_si256((const __m256i*)(pattern + t));
+			sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(w, p));
+		}
+		int32_t result = HorizontalSum_avx2(sum);
+		for (; t < count; ++t)
+			result += window[t] * pattern[t];
+		return result;
+	}
+
+	__attribute__((target("avx2")))
+	uint32_t WindowMaskProduct_avx2(const uint32_t* window, const uint8_t* mask, int32_t count)
+	{
+		__m256i sum = _mm256_setzero_si256();
+		int32_t t = 0;
+		for (; t + 8 <= count; t += 8)
+		{
+			__m256i w = _mm256_loadu_si256((const __m256i*)(window + t));
+			__m256i m = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(mask + t)));
+			sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(w, m));
+		}
+		uint32_t result = (uint32_t)HorizontalSum_avx2(sum);
+		for (; t < count; ++t)
+			result += window[t] * (uint32_t)mask[t];
+		return result;
+	}
+#endif
+
+	struct CorrelationProducts
+	{
+		int32_t(*windowPattern)(const int32_t* window, const int32_t* pattern, int32_t count);
+		uint32_t(*windowMask)(const uint32_t* window, const uint8_t* mask, int32_t count);
+
+		CorrelationProducts() :
+			windowPattern(WindowPatternProduct_scalar),
+			windowMask(WindowMaskProduct_scalar)
+		{
+#ifdef CVT_X86_SIMD
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx2"))
+			{
+				windowPattern = WindowPatternProduct_avx2;
+				windowMask = WindowMaskProduct_avx2;
+			}
+			else if (__builtin_cpu_supports("sse4.1"))
+			{
+				windowPattern = WindowPatternProduct_sse41;
+				windowMask = WindowMaskProduct_sse41;
+			}
+#endif
+		}
+	};
+
+	const CorrelationProducts correlationProducts;
+}
 
 
 
@@ -38,6 +186,8 @@ vtracker::CorrelationVideoTracker::CorrelationVideoTracker() :
 	deviationSurface(nullptr),
 	correlationSurface(nullptr),
 	frameBuffer(nullptr),
+	frameBufferData(nullptr),
+	descriptorBuffer(nullptr),
 	Xcorrect(0.0f),
 	Ycorrect(0.0f),
 	XCovariance(0.0f),
@@ -68,6 +218,7 @@ vtracker::CorrelationVideoTracker::CorrelationVideoTracker() :
 	trackerData.trackingRectangleHeight = CVT_DEFAULT_TRACKING_RECTANGLE_HEIGHT;
 	trackerData.probabilityAdaptiveThreshold = 0.0f;
 	trackerData.numThreads = 0;
+	trackerData.correlationMethod = CVT_DEFAULT_CORRELATION_METHOD;
 
 	// Allocate memory.
 	frameBuffer = nullptr;
@@ -104,6 +255,9 @@ vtracker::CorrelationVideoTracker::CorrelationVideoTracker() :
 
 	chislSurface = new int32_t[CVT_MAXIMUM_CORRELATION_SURFACE_WIDTH * CVT_MAXIMUM_CORRELATION_SURFACE_HEIGHT];
 	memset(chislSurface, 0, CVT_MAXIMUM_CORRELATION_SURFACE_WIDTH * CVT_MAXIMUM_CORRELATION_SURFACE_HEIGHT * sizeof(int32_t));
+
+	descriptorBuffer = new uint8_t[(CVT_MAXIMUM_TRACKING_RECTANGLE_WIDTH / 8) * (CVT_MAXIMUM_TRACKING_RECTANGLE_HEIGHT / 8)];
+	memset(descriptorBuffer, 0, (CVT_MAXIMUM_TRACKING_RECTANGLE_WIDTH / 8) * (CVT_MAXIMUM_TRACKING_RECTANGLE_HEIGHT / 8));
 }
 
 
@@ -122,6 +276,27 @@ vtracker::CorrelationVideoTracker::~CorrelationVideoTracker()
 	delete[] deviationSurface;
 	delete[] correlationSurface;
 	delete[] chislSurface;
+	delete[] descriptorBuffer;
+	ReleaseFrameBuffer();
+}
+
+
+void vtracker::CorrelationVideoTracker::ReleaseFrameBuffer()
+{
+	delete[] frameBuffer;
+	frameBuffer = nullptr;
+	delete[] frameBufferData;
+	frameBufferData = nullptr;
+}
+
+
+void vtracker::CorrelationVideoTracker::AllocateFrameBuffer()
+{
+	// Frame slots are empty until frames are added.
+	ReleaseFrameBuffer();
+	frameBuffer = new const uint8_t * [trackerData.frameBufferSize];
+	for (int32_t i = 0; i < trackerData.frameBufferSize; ++i)
+		frameBuffer[i] = nullptr;
 }
 
 
@@ -204,24 +379,15 @@ bool vtracker::CorrelationVideoTracker::SetProperty(CorrelationVideoTrackerPrope
 		// Reset tracker.
 		Reset();
 
-		// Delete frame buffer.
-		if (frameBuffer != nullptr)
-			for (int32_t i = 0; i < trackerData.frameBufferSize; ++i)
-				delete[] frameBuffer[i];
-		delete[] frameBuffer;
-		frameBuffer = nullptr;
-
 		// Set new frame buffer size.
 		trackerData.frameBufferSize = (uint32_t)propertyValue;
 		trackerData.bufferFrameID = 0;
 
 		// Allocate memory.
 		if (trackerData.frameWidth > 0 && trackerData.frameHeight > 0)
-		{
-			frameBuffer = new uint8_t * [trackerData.frameBufferSize];
-			for (int32_t i = 0; i < trackerData.frameBufferSize; ++i)
-				frameBuffer[i] = new uint8_t[(size_t)trackerData.frameWidth * (size_t)trackerData.frameHeight];
-		}		
+			AllocateFrameBuffer();
+		else
+			ReleaseFrameBuffer();
 
 		return true;	
 	}
@@ -420,6 +586,20 @@ bool vtracker::CorrelationVideoTracker::SetProperty(CorrelationVideoTrackerPrope
 		return true;
 	}
 
+	case CorrelationVideoTrackerProperty::CORRELATION_METHOD:
+	{
+		// Check property value.
+		if ((int32_t)propertyValue != CVT_CORRELATION_METHOD_AUTO &&
+			(int32_t)propertyValue != CVT_CORRELATION_METHOD_SPATIAL &&
+			(int32_t)propertyValue != CVT_CORRELATION_METHOD_FREQUENCY)
+			return false;
+
+		// Set prpperty value.
+		trackerData.correlationMethod = (int32_t)propertyValue;
+
+		return true;
+	}
+
 	default:
 		return false;
 	}
@@ -484,6 +664,9 @@ double vtracker::CorrelationVideoTracker::GetProperty(CorrelationVideoTrackerPro
 	case CorrelationVideoTrackerProperty::NUM_THREADS:
 		return (double)trackerData.numThreads;
 
+	case CorrelationVideoTrackerProperty::CORRELATION_METHOD:
+		return (double)trackerData.correlationMethod;
+
 	default:
 		return -1.0;
 	}
@@ -675,6 +858,13 @@ bool vtracker::CorrelationVideoTracker::Capture(
 		}
 	}
 	
+	// Check frame presence.
+	if (frameBuffer == nullptr || frameBuffer[trackerData.trackerFrameID] == nullptr)
+	{
+		Reset();
+		return false;
+	}
+
 	// Check object precense.
 	if (trackerData.pixelDeviationThreshold > 0.0f)
 	{
@@ -759,7 +949,7 @@ bool vtracker::CorrelationVideoTracker::Capture(
 }
 
 
-bool vtracker::CorrelationVideoTracker::CheckObjectPresence(uint8_t* frameData, const int32_t objectCenterX, const int32_t objectCenterY)
+bool vtracker::CorrelationVideoTracker::CheckObjectPresence(const uint8_t* frameData, const int32_t objectCenterX, const int32_t objectCenterY)
 {
 	// Check pixel deviation threshold.
 	if (trackerData.pixelDeviationThreshold == 0)
@@ -997,37 +1187,83 @@ bool vtracker::CorrelationVideoTracker::ProcessFrame(uint8_t* frame_mono8, int32
 	std::lock_guard<std::mutex> globalLock(accessManageMutex);
 
 	// Check frame buffer initialization.
-	if (trackerData.frameWidth != width || trackerData.frameHeight != height)
-	{
-		// Reset
-		Reset();
+	if (!PrepareFrameBuffer(width, height))
+		return false;
 
-		trackerData.frameWidth = width;
-		trackerData.frameHeight = height;
+	// Copied frames are stored in own memory, it is allocated once.
+	size_t size = (size_t)width * (size_t)height;
+	if (frameBufferData == nullptr)
+		frameBufferData = new uint8_t[size * (size_t)trackerData.frameBufferSize];
 
-		// Delete frame buffer.
-		if (frameBuffer != nullptr)
-			for (int32_t i = 0; i < trackerData.frameBufferSize; ++i)
-				delete[] frameBuffer[i];
-		delete[] frameBuffer;
-		frameBuffer = nullptr;
+	++trackerData.bufferFrameID;
+	if (trackerData.bufferFrameID >= trackerData.frameBufferSize)
+		trackerData.bufferFrameID = 0;
+	uint8_t* frameData = frameBufferData + size * (size_t)trackerData.bufferFrameID;
+	memcpy(frameData, frame_mono8, size);
+	frameBuffer[trackerData.bufferFrameID] = frameData;
 
-		// Allocate memory.
-		frameBuffer = new uint8_t * [trackerData.frameBufferSize];
-		for (int32_t i = 0; i < trackerData.frameBufferSize; ++i)
-			frameBuffer[i] = new uint8_t[(size_t)trackerData.frameWidth * (size_t)trackerData.frameHeight];
+	return ProcessBufferedFrames(startTime, timeoutMs);
+}
 
-		// Reset frame ID.
+
+bool vtracker::CorrelationVideoTracker::ProcessFrameReference(const uint8_t* frame_mono8, int32_t width, int32_t height, const uint32_t timeoutMs)
+{
+	// Check input frame data.
+	if (width == 0 || height == 0)
+		return false;
+
+	// Remember time.
+	std::chrono::time_point<std::chrono::system_clock> startTime = std::chrono::system_clock::now();
+
+	// Global lock.
+	std::lock_guard<std::mutex> globalLock(accessManageMutex);
+
+	// Check frame buffer initialization.
+	if (!PrepareFrameBuffer(width, height))
+		return false;
+
+	// Own memory is not used any more.
+	if (frameBufferData != nullptr)
+	{
+		AllocateFrameBuffer();
 		trackerData.bufferFrameID = trackerData.frameBufferSize - 1;
+		Reset();
 	}
 
-	// Copy frame data to frame buffer.
-	uint32_t size = width * height;
 	++trackerData.bufferFrameID;
 	if (trackerData.bufferFrameID >= trackerData.frameBufferSize)
 		trackerData.bufferFrameID = 0;
-	memcpy(frameBuffer[trackerData.bufferFrameID], frame_mono8, size);
+	frameBuffer[trackerData.bufferFrameID] = frame_mono8;
+
+	return ProcessBufferedFrames(startTime, timeoutMs);
+}
+
+
+bool vtracker::CorrelationVideoTracker::PrepareFrameBuffer(int32_t width, int32_t height)
+{
+	if (trackerData.frameWidth == width && trackerData.frameHeight == height && frameBuffer != nullptr)
+		return true;
+
+	// Reset
+	Reset();
+
+	trackerData.frameWidth = width;
+	trackerData.frameHeight = height;
+
+	// Allocate memory.
+	AllocateFrameBuffer();
 
+	// Reset frame ID.
+	trackerData.bufferFrameID = trackerData.frameBufferSize - 1;
+
+	return frameBuffer != nullptr;
+}
+
+
+bool vtracker::CorrelationVideoTracker::ProcessBufferedFrames(
+	const std::chrono::time_point<std::chrono::system_clock>& startTime,
+	const uint32_t timeoutMs)
+{
 	// Check tracker mode.
 	if (trackerData.mode == CVT_FREE_MODE_INDEX)
 		return true;
@@ -1040,8 +1276,8 @@ bool vtracker::CorrelationVideoTracker::ProcessFrame(uint8_t* frame_mono8, int32
 		if (trackerData.trackerFrameID >= trackerData.frameBufferSize)
 			trackerData.trackerFrameID = 0;
 
-		// Calculate correlation surface.
-		if (trackerData.numThreads == 1)
+		// Calculate correlation surface. Frequency domain is calculated after the single thread preparation.
+		if (trackerData.numThreads == 1 || UseFrequencyDomainCorrelation())
 			CalculateCorrelationSurface();
 		else
 			CalculateCorrelationSurface_omp();
@@ -1498,12 +1734,12 @@ inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface()
 	register int32_t wind_h = corr_h + strobe_h - 1;
 	register int32_t strobe_x0 = (max_strobe_w - strobe_w) / 2;
 	register int32_t strobe_y0 = (max_strobe_h - strobe_h) / 2;
-	register int32_t strobe_x1 = strobe_x0 + strobe_w;
-	register int32_t strobe_y1 = strobe_y0 + strobe_h;
 	if (strobe_w % 2 != 0)
 		strobe_x0 = strobe_x0 + 1;
 	if (strobe_h % 2 != 0)
 		strobe_y0 = strobe_y0 + 1;
+	register int32_t strobe_x1 = strobe_x0 + strobe_w;
+	register int32_t strobe_y1 = strobe_y0 + strobe_h;
 	register int32_t pat_med = 0;
 	register int32_t part_med = 0;
 	register uint32_t pat_znam = 0;
@@ -1536,7 +1772,7 @@ inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface()
 	register uint8_t* p_prev_strobe = trackingRectangleImage[1 - trackingRectangleIndex];
 	register int32_t* p_razn_pattern = differencePattern;
 	register int32_t* tmp_p_razn_pattern = nullptr;
-	register uint8_t* p_frame = frameBuffer[trackerData.trackerFrameID];
+	register const uint8_t* p_frame = frameBuffer[trackerData.trackerFrameID];
 	register uint8_t* p_reduced_mask = reducedMask;
 	register uint8_t* tmp_p_reduced_mask = nullptr;
 	register uint8_t* p_full_mask = fullMask;
@@ -1706,6 +1942,13 @@ inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface()
 	}
 	
 
+	// Calculate whole surface at once if it is cheaper.
+	if (UseFrequencyDomainCorrelation())
+	{
+		CalculateCorrelationSurfaceFFT(strobe_x0, strobe_y0, corr_x0, corr_y0, corr_x1, corr_y1, pat_znam);
+		return;
+	}
+
 	// Calculate correlation.
 	for (int32_t i = corr_y0; i < corr_y1; i = i + CORR_STEP)
 	{
@@ -1716,10 +1959,7 @@ inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface()
 			{
 				tmp_p_razn_pattern = &p_razn_pattern[k * max_strobe_w + strobe_x0];
 				tmp_p_razn_window = &p_razn_window[(i + k - strobe_y0) * wind_w + j];
-				for (int32_t t = strobe_x0; t < strobe_x1; ++t)
-				{
-					chisl += (*tmp_p_razn_window++) * (*tmp_p_razn_pattern++);
-				}
+				chisl += correlationProducts.windowPattern(tmp_p_razn_window, tmp_p_razn_pattern, strobe_x1 - strobe_x0);
 			}
 
 			if (chisl < 0)
@@ -1733,10 +1973,7 @@ inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface()
 			{
 				tmp_p_double_razn_window = &p_double_razn_window[(i + k - strobe_y0) * wind_w + j];
 				tmp_p_reduced_mask = &p_reduced_mask[k * max_strobe_w + strobe_x0];
-				for (int32_t t = strobe_x0; t < strobe_x1; ++t)
-				{
-					part_znam += (*tmp_p_double_razn_window++) * (uint32_t)(*tmp_p_reduced_mask++);
-				}
+				part_znam += correlationProducts.windowMask(tmp_p_double_razn_window, tmp_p_reduced_mask, strobe_x1 - strobe_x0);
 			}
 			part_znam = (uint32_t)sqrt(part_znam);
 
@@ -1825,10 +2062,7 @@ inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface()
 					{
 						tmp_p_razn_pattern = &p_razn_pattern[k * max_strobe_w + strobe_x0];
 						tmp_p_razn_window = &p_razn_window[(i + k - strobe_y0) * wind_w + j];
-						for (int32_t t = strobe_x0; t < strobe_x1; ++t)
-						{
-							chisl += (*tmp_p_razn_window++) * (*tmp_p_razn_pattern++);
-						}
+						chisl += correlationProducts.windowPattern(tmp_p_razn_window, tmp_p_razn_pattern, strobe_x1 - strobe_x0);
 					}
 
 					if (chisl < 0)
@@ -1842,10 +2076,7 @@ inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface()
 					{
 						tmp_p_double_razn_window = &p_double_razn_window[(i + k - strobe_y0) * wind_w + j];
 						tmp_p_reduced_mask = &p_reduced_mask[k * max_strobe_w + strobe_x0];
-						for (int32_t t = strobe_x0; t < strobe_x1; ++t)
-						{
-							part_znam += (*tmp_p_double_razn_window++) * (uint32_t)(*tmp_p_reduced_mask++);
-						}
+						part_znam += correlationProducts.windowMask(tmp_p_double_razn_window, tmp_p_reduced_mask, strobe_x1 - strobe_x0);
 					}
 					part_znam = (uint32_t)sqrt(part_znam);
 
@@ -1867,12 +2098,162 @@ inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface()
 }
 
 
+/**
+ * @brief Multiplies spectrum by conjugated spectrum, that gives spectrum of cross-correlation.
+*/
+static void MultiplyByConjugate(std::complex<double>* spectrum, const std::complex<double>* conjugated, int32_t size)
+{
+	for (int32_t i = 0; i < size; ++i)
+	{
+		double a_re = spectrum[i].real();
+		double a_im = spectrum[i].imag();
+		double b_re = conjugated[i].real();
+		double b_im = conjugated[i].imag();
+		spectrum[i] = std::complex<double>(a_re * b_re + a_im * b_im, a_im * b_re - a_re * b_im);
+	}
+}
+
+
+bool vtracker::CorrelationVideoTracker::UseFrequencyDomainCorrelation() const
+{
+	// Check method.
+	if (trackerData.correlationMethod == CVT_CORRELATION_METHOD_SPATIAL)
+		return false;
+	if (trackerData.correlationMethod == CVT_CORRELATION_METHOD_FREQUENCY)
+		return true;
+
+	// Spatial method: coarse grid and refinement around two maximums, two products per position.
+	double strobe_size = (double)trackerData.trackingRectangleWidth * (double)trackerData.trackingRectangleHeight;
+	double coarse_positions =
+		(double)((trackerData.correlationSurfaceWidth + CORR_STEP - 1) / CORR_STEP) *
+		(double)((trackerData.correlationSurfaceHeight + CORR_STEP - 1) / CORR_STEP);
+	double refinement_positions = 2.0 * (2 * LOCAL_MAX_BORDER + 1) * (2 * LOCAL_MAX_BORDER + 1);
+	double spatial_cost = 2.0 * strobe_size * (coarse_positions + refinement_positions);
+	if (trackerData.numThreads > 1)
+		spatial_cost = spatial_cost / (double)trackerData.numThreads;
+
+	// Frequency method: six real transforms of padded window in one thread, n * log2(n) / 4 butterflies each.
+	double transform_w = (double)RealFFT2D::GetTransformSize(trackerData.correlationSurfaceWidth + trackerData.trackingRectangleWidth - 1);
+	double transform_h = (double)RealFFT2D::GetTransformSize(trackerData.correlationSurfaceHeight + trackerData.trackingRectangleHeight - 1);
+	double transform_size = transform_w * transform_h;
+	double frequency_cost = FFT_BUTTERFLY_COST * 6.0 * transform_size * log2(transform_size) / 4.0;
+
+	return frequency_cost < spatial_cost;
+}
+
+
+void vtracker::CorrelationVideoTracker::CalculateCorrelationSurfaceFFT(
+	int32_t strobe_x0, int32_t strobe_y0,
+	int32_t corr_x0, int32_t corr_y0, int32_t corr_x1, int32_t corr_y1,
+	uint32_t pat_znam)
+{
+	// Init variables.
+	int32_t max_strobe_w = CVT_MAXIMUM_TRACKING_RECTANGLE_WIDTH;
+	int32_t corr_w = trackerData.correlationSurfaceWidth;
+	int32_t corr_h = trackerData.correlationSurfaceHeight;
+	int32_t strobe_w = trackerData.trackingRectangleWidth;
+	int32_t strobe_h = trackerData.trackingRectangleHeight;
+	int32_t wind_w = corr_w + strobe_w - 1;
+	int32_t wind_h = corr_h + strobe_h - 1;
+	int32_t wind_x1 = corr_x1 + strobe_w - 1;
+	int32_t wind_y1 = corr_y1 + strobe_h - 1;
+
+	// Window is padded with zeros, so correlation in valid area is not wrapped.
+	correlationFFT.Init(RealFFT2D::GetTransformSize(wind_w), RealFFT2D::GetTransformSize(wind_h));
+	int32_t fft_w = correlationFFT.GetWidth();
+	int32_t fft_h = correlationFFT.GetHeight();
+	int32_t spectrum_size = correlationFFT.GetSpectrumWidth() * fft_h;
+	fftImage.resize(fft_w * fft_h);
+	fftSpectrum[0].resize(spectrum_size);
+	fftSpectrum[1].resize(spectrum_size);
+	double* p_image = fftImage.data();
+	std::complex<double>* p_window_spectrum = fftSpectrum[0].data();
+	std::complex<double>* p_pattern_spectrum = fftSpectrum[1].data();
+
+	// Numerator: difference window correlated with difference pattern. Zero rows at the end are not transformed.
+	std::fill(p_image, p_image + wind_y1 * fft_w, 0.0);
+	for (int32_t i = corr_y0; i < wind_y1; ++i)
+		for (int32_t j = corr_x0; j < wind_x1; ++j)
+			p_image[i * fft_w + j] = (double)differenceWindow[i * wind_w + j];
+	correlationFFT.Forward(p_image, p_window_spectrum, wind_y1);
+
+	std::fill(p_image, p_image + strobe_h * fft_w, 0.0);
+	for (int32_t k = 0; k < strobe_h; ++k)
+		for (int32_t t = 0; t < strobe_w; ++t)
+			p_image[k * fft_w + t] = (double)differencePattern[(k + strobe_y0) * max_strobe_w + t + strobe_x0];
+	correlationFFT.Forward(p_image, p_pattern_spectrum, strobe_h);
+
+	MultiplyByConjugate(p_window_spectrum, p_pattern_spectrum, spectrum_size);
+	correlationFFT.Inverse(p_window_spectrum, p_image, corr_y1);
+
+	// Sums are integer, rounding gives the same values as direct calculation.
+	for (int32_t i = 0; i < corr_h; ++i)
+	{
+		for (int32_t j = 0; j < corr_w; ++j)
+		{
+			if (i < corr_y0 || i >= corr_y1 || j < corr_x0 || j >= corr_x1)
+				chislSurface[i * corr_w + j] = 0;
+			else
+				chislSurface[i * corr_w + j] = (int32_t)llround(p_image[i * fft_w + j]);
+		}
+	}
+
+	// Denominator: doubled difference window correlated with reduced mask.
+	std::fill(p_image, p_image + wind_y1 * fft_w, 0.0);
+	for (int32_t i = corr_y0; i < wind_y1; ++i)
+		for (int32_t j = corr_x0; j < wind_x1; ++j)
+			p_image[i * fft_w + j] = (double)doubledDifferenceWindow[i * wind_w + j];
+	correlationFFT.Forward(p_image, p_window_spectrum, wind_y1);
+
+	std::fill(p_image, p_image + strobe_h * fft_w, 0.0);
+	for (int32_t k = 0; k < strobe_h; ++k)
+		for (int32_t t = 0; t < strobe_w; ++t)
+			p_image[k * fft_w + t] = (double)reducedMask[(k + strobe_y0) * max_strobe_w + t + strobe_x0];
+	correlationFFT.Forward(p_image, p_pattern_spectrum, strobe_h);
+
+	MultiplyByConjugate(p_window_spectrum, p_pattern_spectrum, spectrum_size);
+	correlationFFT.Inverse(p_window_spectrum, p_image, corr_y1);
+
+	// Calculate correlation surface.
+	int32_t chisl = 0;
+	uint32_t part_znam = 0;
+	float corr_k = 0.0f;
+	for (int32_t i = corr_y0; i < corr_y1; ++i)
+	{
+		for (int32_t j = corr_x0; j < corr_x1; ++j)
+		{
+			chisl = chislSurface[i * corr_w + j];
+			if (chisl < 0)
+			{
+				chislSurface[i * corr_w + j] = 0;
+				continue;
+			}
+
+			part_znam = (uint32_t)llround(p_image[i * fft_w + j]);
+			part_znam = (uint32_t)sqrt(part_znam);
+
+			if (part_znam != 0 && pat_znam != 0)
+				corr_k = (float)chisl / (float)(part_znam * pat_znam);
+			else
+				corr_k = 0.0f;
+
+			correlationSurface[i * corr_w + j] =
+				corr_k * expf(-(((float)j - Xcorrect) * ((float)j - Xcorrect)) / (8.0f * XCovariance)) *
+				expf(-(((float)i - Ycorrect) * ((float)i - Ycorrect)) / (8.0f * YCovariance));
+		}
+	}
+}
+
+
 inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface_omp()
 {
-	// Calculate num threads.
-	if (trackerData.numThreads > 0)
+	// Calculate num threads. Per thread sums below are limited by CVT_MAXIMUM_NUM_THREADS.
+	int32_t ompNumThreads = trackerData.numThreads;
+	if (ompNumThreads <= 0)
 	{
-		omp_set_num_threads(trackerData.numThreads);
+		ompNumThreads = omp_get_max_threads();
+		if (ompNumThreads > CVT_MAXIMUM_NUM_THREADS)
+			ompNumThreads = CVT_MAXIMUM_NUM_THREADS;
 	}
 
 	// Common variables.
@@ -1897,7 +2278,7 @@ inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface_omp()
 	localCorrMax[0] = 0.0f;
 	localCorrMax[1] = 0.0f;
 
-#pragma omp parallel
+#pragma omp parallel num_threads(ompNumThreads)
 	{
 		// Get num threads and thread num.
 		register int32_t thread_num = omp_get_thread_num();
@@ -1952,7 +2333,7 @@ inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface_omp()
 		register uint8_t* p_prev_strobe = trackingRectangleImage[1 - trackingRectangleIndex];
 		register int32_t* p_razn_pattern = differencePattern;
 		register int32_t* tmp_p_razn_pattern = nullptr;
-		register uint8_t* p_frame = frameBuffer[trackerData.trackerFrameID];
+		register const uint8_t* p_frame = frameBuffer[trackerData.trackerFrameID];
 		register uint8_t* p_reduced_mask = reducedMask;
 		register uint8_t* tmp_p_reduced_mask = nullptr;
 		register uint8_t* p_full_mask = fullMask;
@@ -2151,13 +2532,9 @@ inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface_omp()
 #pragma omp barrier
 
 		// Calculate correlation.
-		corr_h0 = corr_y0 + ((corr_y1 - corr_y0) * thread_num) / num_threads;
-		corr_h1 = corr_y0 + ((corr_y1 - corr_y0) * (thread_num + 1)) / num_threads;
-		for (int32_t i = corr_h0; i < corr_h1; ++i)
+		// Rows of the coarse grid are interleaved between threads for even load.
+		for (int32_t i = corr_y0 + thread_num * CORR_STEP; i < corr_y1; i = i + num_threads * CORR_STEP)
 		{
-			if ((i - corr_y0) % CORR_STEP != 0)
-				continue;
-
 			for (int32_t j = corr_x0; j < corr_x1; j = j + CORR_STEP)
 			{
 				chisl = 0;
@@ -2165,10 +2542,7 @@ inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface_omp()
 				{
 					tmp_p_razn_pattern = &p_razn_pattern[k * max_strobe_w + strobe_x0];
 					tmp_p_razn_window = &p_razn_window[(i + k - strobe_y0) * wind_w + j];
-					for (int32_t t = strobe_x0; t < strobe_x1; ++t)
-					{
-						chisl += (*tmp_p_razn_window++) * (*tmp_p_razn_pattern++);
-					}
+					chisl += correlationProducts.windowPattern(tmp_p_razn_window, tmp_p_razn_pattern, strobe_x1 - strobe_x0);
 				}
 
 				if (chisl < 0)
@@ -2182,10 +2556,7 @@ inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface_omp()
 				{
 					tmp_p_double_razn_window = &p_double_razn_window[(i + k - strobe_y0) * wind_w + j];
 					tmp_p_reduced_mask = &p_reduced_mask[k * max_strobe_w + strobe_x0];
-					for (int32_t t = strobe_x0; t < strobe_x1; ++t)
-					{
-						part_znam += (*tmp_p_double_razn_window++) * (uint32_t)(*tmp_p_reduced_mask++);
-					}
+					part_znam += correlationProducts.windowMask(tmp_p_double_razn_window, tmp_p_reduced_mask, strobe_x1 - strobe_x0);
 				}
 				part_znam = (uint32_t)sqrt(part_znam);
 
@@ -2276,10 +2647,7 @@ inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface_omp()
 						{
 							tmp_p_razn_pattern = &p_razn_pattern[k * max_strobe_w + strobe_x0];
 							tmp_p_razn_window = &p_razn_window[(i + k - strobe_y0) * wind_w + j];
-							for (int32_t t = strobe_x0; t < strobe_x1; ++t)
-							{
-								chisl += (*tmp_p_razn_window++) * (*tmp_p_razn_pattern++);
-							}
+							chisl += correlationProducts.windowPattern(tmp_p_razn_window, tmp_p_razn_pattern, strobe_x1 - strobe_x0);
 						}
 
 						if (chisl < 0)
@@ -2293,10 +2661,7 @@ inline void vtracker::CorrelationVideoTracker::CalculateCorrelationSurface_omp()
 						{
 							tmp_p_double_razn_window = &p_double_razn_window[(i + k - strobe_y0) * wind_w + j];
 							tmp_p_reduced_mask = &p_reduced_mask[k * max_strobe_w + strobe_x0];
-							for (int32_t t = strobe_x0; t < strobe_x1; ++t)
-							{
-								part_znam += (*tmp_p_double_razn_window++) * (uint32_t)(*tmp_p_reduced_mask++);
-							}
+							part_znam += correlationProducts.windowMask(tmp_p_double_razn_window, tmp_p_reduced_mask, strobe_x1 - strobe_x0);
 						}
 						part_znam = (uint32_t)sqrt(part_znam);
 
@@ -2324,21 +2689,37 @@ inline int32_t vtracker::CorrelationVideoTracker::FindFrameID(
 	const int32_t y,
 	const uint8_t* descriptor)
 {
-	// Allocate memory for descriptors.
 	int32_t width = trackerData.frameWidth;
 	int32_t height = trackerData.frameHeight;
 	int32_t descriptor_width = CVT_MAXIMUM_TRACKING_RECTANGLE_WIDTH / 8;
 	int32_t descriptor_height = CVT_MAXIMUM_TRACKING_RECTANGLE_HEIGHT / 8;
-	uint8_t** descriptors;
-	descriptors = new uint8_t *[trackerData.frameBufferSize];
-	for (int32_t i = 0; i < trackerData.frameBufferSize; ++i)
-		descriptors[i] = new uint8_t[(size_t)descriptor_width * (size_t)descriptor_height];
 
-	// Calculate descriptors.
+	// Calculate medium value of input descriptor.
+	int32_t pat_med = 0;
+	for (int32_t i = 0; i < descriptor_height; ++i)
+		for (int32_t j = 0; j < descriptor_width; ++j)
+			pat_med += (int32_t)descriptor[i * descriptor_width + j];
+	pat_med = pat_med / (descriptor_width * descriptor_height);
+
+	// Calculate znam value of input descriptor.
+	int32_t pat_znam = 0;
+	for (int32_t i = 0; i < descriptor_height; ++i)
+		for (int32_t j = 0; j < descriptor_width; ++j)
+			pat_znam += ((int32_t)descriptor[i * descriptor_width + j] - pat_med) * ((int32_t)descriptor[i * descriptor_width + j] - pat_med);
+	pat_znam = (int32_t)sqrt((double)pat_znam);
+
+	// Find appropriate frame. Descriptor of every frame is calculated into the same preallocated buffer.
 	int32_t frame_x0 = x - CVT_MAXIMUM_TRACKING_RECTANGLE_WIDTH / 2;
 	int32_t frame_y0 = y - CVT_MAXIMUM_TRACKING_RECTANGLE_HEIGHT / 2;
+	int32_t frame_ID = 0;
+	double max_corr = 0.0f;
 	for (int32_t n = 0; n < trackerData.frameBufferSize; ++n)
 	{
+		// Skip empty frame slots.
+		if (frameBuffer[n] == nullptr)
+			continue;
+
+		// Calculate frame descriptor.
 		for (int32_t i = 0; i < descriptor_height; ++i)
 		{
 			for (int32_t j = 0; j < descriptor_width; ++j)
@@ -2348,7 +2729,7 @@ inline int32_t vtracker::CorrelationVideoTracker::FindFrameID(
 					frame_x0 + j * 8 < 0 ||
 					frame_x0 + j * 8 + 8 > width)
 				{
-					descriptors[n][i * descriptor_width + j] = 0;
+					descriptorBuffer[i * descriptor_width + j] = 0;
 				}
 				else
 				{
@@ -2358,50 +2739,30 @@ inline int32_t vtracker::CorrelationVideoTracker::FindFrameID(
 							medium_value += frameBuffer[n][k * width + t];
 					medium_value = medium_value / 64;
 
-					descriptors[n][i * descriptor_width + j] = (uint8_t)medium_value;
+					descriptorBuffer[i * descriptor_width + j] = (uint8_t)medium_value;
 				}
 			}
 		}
-	}
-
-	// Calculate medium value of input descriptor.
-	int32_t pat_med = 0;
-	for (int32_t i = 0; i < descriptor_height; ++i)
-		for (int32_t j = 0; j < descriptor_width; ++j)
-			pat_med += (int32_t)descriptor[i * descriptor_width + j];
-	pat_med = pat_med / (descriptor_width * descriptor_height);
 
-	// Calculate znam value of input descriptor.
-	int32_t pat_znam = 0;
-	for (int32_t i = 0; i < descriptor_height; ++i)
-		for (int32_t j = 0; j < descriptor_width; ++j)
-			pat_znam += ((int32_t)descriptor[i * descriptor_width + j] - pat_med) * ((int32_t)descriptor[i * descriptor_width + j] - pat_med);
-	pat_znam = (int32_t)sqrt((double)pat_znam);
-
-	// Find appropriate frame.
-	int32_t frame_ID = 0;
-	double max_corr = 0.0f;
-	for (int32_t n = 0; n < trackerData.frameBufferSize; ++n)
-	{
 		// Calculate medium value of frame descriptor.
 		int32_t part_med = 0;
 		for (int32_t i = 0; i < descriptor_height; ++i)
 			for (int32_t j = 0; j < descriptor_width; ++j)
-				part_med += (int32_t)descriptors[n][i * descriptor_width + j];
+				part_med += (int32_t)descriptorBuffer[i * descriptor_width + j];
 		part_med = part_med / (descriptor_width * descriptor_height);
 
 		// Calculate znam value of frame descriptor.
 		int32_t part_znam = 0;
 		for (int32_t i = 0; i < descriptor_height; ++i)
 			for (int32_t j = 0; j < descriptor_width; ++j)
-				part_znam += ((int32_t)descriptors[n][i * descriptor_width + j] - part_med) * ((int32_t)descriptors[n][i * descriptor_width + j] - part_med);
+				part_znam += ((int32_t)descriptorBuffer[i * descriptor_width + j] - part_med) * ((int32_t)descriptorBuffer[i * descriptor_width + j] - part_med);
 		part_znam = (int32_t)sqrt((double)part_znam);
 
 		// Calculate chisl value.
 		int32_t chisl = 0;
 		for (int32_t i = 0; i < descriptor_height; ++i)
 			for (int32_t j = 0; j < descriptor_width; ++j)
-				chisl += ((int32_t)descriptor[i * descriptor_width + j] - pat_med) * ((int32_t)descriptors[n][i * descriptor_width + j] - part_med);
+				chisl += ((int32_t)descriptor[i * descriptor_width + j] - pat_med) * ((int32_t)descriptorBuffer[i * descriptor_width + j] - part_med);
 
 		// Calculate correlation value.
 		float corr_k = 0.0f;
@@ -2416,11 +2777,6 @@ inline int32_t vtracker::CorrelationVideoTracker::FindFrameID(
 		}
 	}
 
-	// Free memory.
-	for (int32_t i = 0; i < trackerData.frameBufferSize; ++i)
-		delete[] descriptors[i];
-	delete[] descriptors;
-
 	// Check correlation value.
 	if (max_corr < MIN_CORR_VALUE)
 		return -1;
@@ -1,6 +1,8 @@
 #pragma once
 #include <mutex>
+#include <chrono>
 #include "CorrelationVideoTrackerDataStructures.h"
+#include "RealFFT2D.h"
 
 namespace vtracker
 {
@@ -46,6 +48,17 @@ namespace vtracker
 		*/
 		bool ProcessFrame(uint8_t *frame_mono8, int32_t width, int32_t height, const uint32_t timeoutMs = 0);
 
+		/**
+		 * @brief Method to process frame without copying it to the frame buffer.
+		 * @param frame_mono8 Pointer to frame data in mono8 (GRAYSCALE) format. The data must stay valid
+		 * until FRAME_BUFFER_SIZE newer frames have been processed.
+		 * @param width Width of frame.
+		 * @param height Height of frame.
+		 * @param timeoutMs Time (milliseconds) during which calculations must be performed.
+		 * @return TRUE if at least one frame has been processed or FALSE.
+		*/
+		bool ProcessFrameReference(const uint8_t *frame_mono8, int32_t width, int32_t height, const uint32_t timeoutMs = 0);
+
 		/**
 		 * @brief Method to perform command.
 		 * @param commandID ID of command.
@@ -80,7 +93,9 @@ namespace vtracker
 
 	private:
 
-		uint8_t** frameBuffer;							/// Frame buffer.
+		const uint8_t** frameBuffer;					/// Frame buffer, pointers to frames.
+		uint8_t* frameBufferData;						/// Memory of copied frames.
+		uint8_t* descriptorBuffer;						/// Frame descriptor to find frame ID.
 		uint8_t* patternImage;							/// Patter image.
 		int32_t* differencePattern;						/// Difference pattern image.
 		uint8_t* reducedMask;							/// Reduced mask surface.
@@ -101,6 +116,9 @@ namespace vtracker
 		CorrelationVideoTrackerResultData trackerData;	/// Result data structure of video tracker.
 		std::mutex accessManageMutex;					/// Mutex to manage access to class methos from different threads.
 		int32_t last_chisl_value;						/// Service variable.
+		RealFFT2D correlationFFT;						/// FFT to calculate correlation surface in frequency domain.
+		std::vector<double> fftImage;					/// Image memory of frequency domain correlation.
+		std::vector<std::complex<double>> fftSpectrum[2];	/// Spectrum memory of frequency domain correlation.
 
 
 		/**
@@ -124,6 +142,34 @@ namespace vtracker
 		*/
 		void Reset();
 
+		/**
+		 * @brief Method to allocate empty frame buffer of current size.
+		*/
+		void AllocateFrameBuffer();
+
+		/**
+		 * @brief Method to release frame buffer.
+		*/
+		void ReleaseFrameBuffer();
+
+		/**
+		 * @brief Method to check frame buffer initialization for the frame size.
+		 * @param width Width of frame.
+		 * @param height Height of frame.
+		 * @return TRUE if frame buffer is ready or FALSE.
+		*/
+		bool PrepareFrameBuffer(int32_t width, int32_t height);
+
+		/**
+		 * @brief Method to calculate tracking for frames in frame buffer.
+		 * @param startTime Time of the beginning of frame processing.
+		 * @param timeoutMs Time (milliseconds) during which calculations must be performed.
+		 * @return TRUE if frames have been processed or FALSE.
+		*/
+		bool ProcessBufferedFrames(
+			const std::chrono::time_point<std::chrono::system_clock>& startTime,
+			const uint32_t timeoutMs);
+
 		/**
 		 * @brief Method to check reset criteria.
 		 * @return TRUE if algorithm shoukd be reset or FALSE.
@@ -155,7 +201,7 @@ namespace vtracker
 		 * @param objectCenterY Vertical position of object center to check.
 		 * @return TRUE if some object is present under the capture rectangle or FALSE.
 		*/
-		bool CheckObjectPresence(uint8_t* frameData, const int32_t objectCenterX, const int32_t objectCenterY);
+		bool CheckObjectPresence(const uint8_t* frameData, const int32_t objectCenterX, const int32_t objectCenterY);
 
 		/**
 		 * @brief Method to set tracking rectangle size automatically.
@@ -193,6 +239,27 @@ namespace vtracker
 		*/
 		inline void CalculateCorrelationSurface_omp();
 
+		/**
+		 * @brief Method to check if correlation surface should be calculated in frequency domain.
+		 * @return TRUE if FFT is selected by property or it needs less computations for current sizes.
+		*/
+		bool UseFrequencyDomainCorrelation() const;
+
+		/**
+		 * @brief Method to calculate whole correlation surface by FFT. Difference window, pattern and masks must be prepared.
+		 * @param strobe_x0 Horizontal position of tracking rectangle in pattern.
+		 * @param strobe_y0 Vertical position of tracking rectangle in pattern.
+		 * @param corr_x0 Left border of valid area of correlation surface.
+		 * @param corr_y0 Top border of valid area of correlation surface.
+		 * @param corr_x1 Right border (excluded) of valid area of correlation surface.
+		 * @param corr_y1 Bottom border (excluded) of valid area of correlation surface.
+		 * @param pat_znam Pattern part of correlation denominator.
+		*/
+		void CalculateCorrelationSurfaceFFT(
+			int32_t strobe_x0, int32_t strobe_y0,
+			int32_t corr_x0, int32_t corr_y0, int32_t corr_x1, int32_t corr_y1,
+			uint32_t pat_znam);
+
 		/**
 		 * @brief Method to analize correlation surface.
 		*/
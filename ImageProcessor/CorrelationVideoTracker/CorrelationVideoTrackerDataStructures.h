@@ -47,6 +47,7 @@ Default values for video tracker parameters.
 #define CVT_DEFAULT_CORRELATION_SURFACE_HEIGHT 250		/// Default correlation surface width.
 #define	CVT_DEFAULT_LOST_MODE_OPTION 0					/// Default LOST mode option.
 #define CVT_DEFAULT_MAXIMUM_NUM_FRAMES_IN_LOST_MODE 256	/// Default maximum number of frames in LOST mode to reset algorithm.
+#define CVT_DEFAULT_CORRELATION_METHOD 0				/// Default method to calculate correlation surface.
 #define CVT_MAXIMUM_NUM_THREADS 8						/// Maximum number of threads.
 
 
@@ -60,6 +61,14 @@ Video tracker modes indexes value.
 #define CVT_STATIC_MODE_INDEX 4		/// STATIC mode index.
 
 
+/*
+Correlation surface calculation methods.
+*/
+#define CVT_CORRELATION_METHOD_AUTO 0		/// Method with less computations is selected for current sizes.
+#define CVT_CORRELATION_METHOD_SPATIAL 1	/// Direct calculation in coarse grid with refinement around maximums.
+#define CVT_CORRELATION_METHOD_FREQUENCY 2	/// Calculation of whole surface by FFT. Same values, but the maximum missed by the coarse grid is found too.
+
+
 	/**
 	 * @brief Enum of video tracker command IDs.
 	*/
@@ -95,7 +104,8 @@ Video tracker modes indexes value.
 		CORRELATION_SURFACE_HEIGHT = 14,		// Height of correlation surface.
 		LOST_MODE_OPTION = 15,					// LOST mode option.
 		MAXIMUM_NUM_FRAMES_IN_LOST_MODE = 16,	// Maximum number of frames in LOST mode to reset algorithm.
-		NUM_THREADS = 17						// Number of threads.
+		NUM_THREADS = 17,						// Number of threads.
+		CORRELATION_METHOD = 18					// Method to calculate correlation surface.
 	};
 
 
@@ -138,6 +148,7 @@ Video tracker modes indexes value.
 		int32_t searchWindowCenterX;				// Horizontal position of search window center.
 		int32_t searchWindowCenterY;				// Vertical position of search window center.
 		int32_t numThreads;							// Number of threads to calculate.
+		int32_t correlationMethod;					// Method to calculate correlation surface.
 		float trackingRectangleCenterFX;			// Subpixel horithontal position of tracking rectangle center.
 		float trackingRectangleCenterFY;			// Subpixel vertical position of tracking rectangle center.
 		float horizontalObjectValocity;				// Horizontal velocity of object on video frames ( pixel/frame ).
@@ -181,6 +192,7 @@ Video tracker modes indexes value.
 		bool searchWindowCenterX;
 		bool searchWindowCenterY;
 		bool numThreads;
+		bool correlationMethod;
 		bool trackingRectangleCenterFX;
 		bool trackingRectangleCenterFY;
 		bool horizontalObjectValocity;
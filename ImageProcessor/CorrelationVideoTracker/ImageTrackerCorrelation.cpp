@@ -1,5 +1,6 @@
 #include "ImageTrackerCorrelation.h"
 #include <QDebug>
+#include <QThread>
 
 using namespace std;
 using namespace vtracker;
@@ -9,6 +10,7 @@ ImageTrackerCorrelation::ImageTrackerCorrelation() : ImageTracker()
 {
     _correlationTracker = nullptr;
     _targetSize = 20;
+    _frameIndex = 0;
 }
 
 ImageTrackerCorrelation::~ImageTrackerCorrelation()
@@ -16,17 +18,32 @@ ImageTrackerCorrelation::~ImageTrackerCorrelation()
     delete _correlationTracker;
 }
 
-QRect ImageTrackerCorrelation::doProcessFrame(uint8_t *frame_mono8, int32_t width, int32_t height)
+QRect ImageTrackerCorrelation::doProcessFrame(const QImage &frame)
 {
     if (_correlationTracker == nullptr)
     {
         _correlationTracker = new CorrelationVideoTracker();
-        _correlationTracker->SetProperty(CorrelationVideoTrackerProperty::NUM_THREADS, 1);
+        // Half of the cores are left for video decoding and UI, the tiled surface is used starting from 2 threads
+        int threadCount = qBound(1, QThread::idealThreadCount() / 2, CVT_MAXIMUM_NUM_THREADS);
+        _correlationTracker->SetProperty(CorrelationVideoTrackerProperty::NUM_THREADS, threadCount);
         _correlationTracker->ExecuteCommand(vtracker::CorrelationVideoTrackerCommand::RESET);
         setTargetSize(_targetSize);
+
+        _frames.resize(static_cast<int>(_correlationTracker->GetProperty(CorrelationVideoTrackerProperty::FRAME_BUFFER_SIZE)));
+        _frameIndex = 0;
     };
 
-    _correlationTracker->ProcessFrame(frame_mono8, width, height);
+    // The frame is kept as long as it is in the tracker's frame buffer, lines must have no padding for that
+    if (frame.bytesPerLine() == frame.width() && !_frames.isEmpty())
+    {
+        _frames[_frameIndex] = frame;
+        _frameIndex = (_frameIndex + 1) % _frames.count();
+        _correlationTracker->ProcessFrameReference(frame.constBits(), frame.width(), frame.height());
+    }
+    else
+    {
+        _correlationTracker->ProcessFrame(const_cast<uint8_t *>(frame.constBits()), frame.width(), frame.height());
+    }
 
     CorrelationVideoTrackerResultData trackerData = _correlationTracker->GetTrackerResultData();
     if (trackerData.mode == CVT_TRACKING_MODE_INDEX)
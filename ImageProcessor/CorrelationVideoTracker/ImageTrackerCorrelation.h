@@ -3,6 +3,7 @@
 
 #include <QPoint>
 #include <QRect>
+#include <QVector>
 #include "Common/CommonData.h"
 #include "ImageProcessor/CorrelationVideoTracker/CorrelationVideoTracker.h"
 #include "ImageProcessor/ImageTracker.h"
@@ -12,12 +13,16 @@ class ImageTrackerCorrelation : public ImageTracker
 private:
     vtracker::CorrelationVideoTracker *_correlationTracker;
     int _targetSize;
+
+    // Tracker's frame buffer points to these frames instead of copying them
+    QVector<QImage> _frames;
+    int _frameIndex;
 public:
     explicit ImageTrackerCorrelation();
     virtual ~ImageTrackerCorrelation();
 
 
-    virtual QRect doProcessFrame(uint8_t* frame_mono8, int32_t width, int32_t height);
+    virtual QRect doProcessFrame(const QImage &frame);
     virtual void lockTarget(const QPoint &targetCenter);
     virtual void unlockTarget();
     virtual void setTargetSize(int size);
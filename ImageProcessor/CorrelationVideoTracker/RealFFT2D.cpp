@@ -0,0 +1,203 @@
+#include <cmath>
+#include <algorithm>
+#include "RealFFT2D.h"
+
+
+
+vtracker::RealFFT2D::RealFFT2D() :
+	width(0),
+	height(0)
+{
+
+}
+
+
+int32_t vtracker::RealFFT2D::GetTransformSize(int32_t size)
+{
+	int32_t result = 2;
+	while (result < size)
+		result = result * 2;
+	return result;
+}
+
+
+bool vtracker::RealFFT2D::Init(int32_t width, int32_t height)
+{
+	// Check size. Rows are transformed in pairs, so height can't be less than 2.
+	if (width < 2 || height < 2 || (width & (width - 1)) != 0 || (height & (height - 1)) != 0)
+		return false;
+
+	if (this->width == width && this->height == height)
+		return true;
+
+	this->width = width;
+	this->height = height;
+	InitTwiddles(rowTwiddles, width);
+	InitTwiddles(columnTwiddles, height);
+	rowBuffer.resize(width);
+
+	return true;
+}
+
+
+void vtracker::RealFFT2D::InitTwiddles(std::vector<std::complex<double>>& twiddles, int32_t size)
+{
+	const double pi = 3.14159265358979323846;
+	twiddles.resize(size / 2);
+	for (int32_t k = 0; k < size / 2; ++k)
+		twiddles[k] = std::polar(1.0, -2.0 * pi * (double)k / (double)size);
+}
+
+
+void vtracker::RealFFT2D::Transform(std::complex<double>* data, const std::complex<double>* twiddles, int32_t size, bool inverse)
+{
+	// Bit reversal permutation.
+	for (int32_t i = 1, j = 0; i < size; ++i)
+	{
+		int32_t bit = size >> 1;
+		for (; (j & bit) != 0; bit = bit >> 1)
+			j = j ^ bit;
+		j = j ^ bit;
+		if (i < j)
+			std::swap(data[i], data[j]);
+	}
+
+	// Butterflies.
+	for (int32_t length = 2; length <= size; length = length * 2)
+	{
+		int32_t half = length / 2;
+		int32_t step = size / length;
+		for (int32_t i = 0; i < size; i = i + length)
+		{
+			for (int32_t j = 0; j < half; ++j)
+			{
+				// Product is written out, std::complex multiplication checks for infinities.
+				double w_re = twiddles[j * step].real();
+				double w_im = inverse ? -twiddles[j * step].imag() : twiddles[j * step].imag();
+				double x_re = data[i + j + half].real();
+				double x_im = data[i + j + half].imag();
+				std::complex<double> u = data[i + j];
+				std::complex<double> v(x_re * w_re - x_im * w_im, x_re * w_im + x_im * w_re);
+				data[i + j] = u + v;
+				data[i + j + half] = u - v;
+			}
+		}
+	}
+}
+
+
+void vtracker::RealFFT2D::TransformColumns(std::complex<double>* spectrum, bool inverse)
+{
+	// Columns are transformed together, butterflies combine whole rows.
+	int32_t spectrum_w = GetSpectrumWidth();
+	for (int32_t i = 1, j = 0; i < height; ++i)
+	{
+		int32_t bit = height >> 1;
+		for (; (j & bit) != 0; bit = bit >> 1)
+			j = j ^ bit;
+		j = j ^ bit;
+		if (i < j)
+			std::swap_ranges(&spectrum[i * spectrum_w], &spectrum[(i + 1) * spectrum_w], &spectrum[j * spectrum_w]);
+	}
+
+	for (int32_t length = 2; length <= height; length = length * 2)
+	{
+		int32_t half = length / 2;
+		int32_t step = height / length;
+		for (int32_t i = 0; i < height; i = i + length)
+		{
+			for (int32_t j = 0; j < half; ++j)
+			{
+				double w_re = columnTwiddles[j * step].real();
+				double w_im = inverse ? -columnTwiddles[j * step].imag() : columnTwiddles[j * step].imag();
+				std::complex<double>* first = &spectrum[(i + j) * spectrum_w];
+				std::complex<double>* second = &spectrum[(i + j + half) * spectrum_w];
+				for (int32_t k = 0; k < spectrum_w; ++k)
+				{
+					double x_re = second[k].real();
+					double x_im = second[k].imag();
+					std::complex<double> u = first[k];
+					std::complex<double> v(x_re * w_re - x_im * w_im, x_re * w_im + x_im * w_re);
+					first[k] = u + v;
+					second[k] = u - v;
+				}
+			}
+		}
+	}
+}
+
+
+void vtracker::RealFFT2D::Forward(const double* image, std::complex<double>* spectrum, int32_t rows)
+{
+	int32_t spectrum_w = GetSpectrumWidth();
+	std::complex<double>* row = rowBuffer.data();
+
+	// Spectra of zero rows are zero.
+	if (rows < 0 || rows > height)
+		rows = height;
+	int32_t spectrum_rows = rows + rows % 2;
+	std::fill(&spectrum[spectrum_rows * spectrum_w], &spectrum[height * spectrum_w], std::complex<double>(0.0, 0.0));
+
+	// Two real rows are transformed by one complex transform and separated by symmetry.
+	// The pair of the last odd row is zero, the image row after it is not read.
+	for (int32_t i = 0; i < spectrum_rows; i = i + 2)
+	{
+		const double* first = &image[i * width];
+		if (i + 1 < rows)
+		{
+			const double* second = &image[(i + 1) * width];
+			for (int32_t j = 0; j < width; ++j)
+				row[j] = std::complex<double>(first[j], second[j]);
+		}
+		else
+		{
+			for (int32_t j = 0; j < width; ++j)
+				row[j] = std::complex<double>(first[j], 0.0);
+		}
+
+		Transform(row, rowTwiddles.data(), width, false);
+
+		for (int32_t k = 0; k < spectrum_w; ++k)
+		{
+			std::complex<double> z = row[k];
+			std::complex<double> zc = std::conj(row[(width - k) & (width - 1)]);
+			spectrum[i * spectrum_w + k] = (z + zc) * 0.5;
+			spectrum[(i + 1) * spectrum_w + k] = (z - zc) * std::complex<double>(0.0, -0.5);
+		}
+	}
+
+	TransformColumns(spectrum, false);
+}
+
+
+void vtracker::RealFFT2D::Inverse(std::complex<double>* spectrum, double* image, int32_t rows)
+{
+	int32_t spectrum_w = GetSpectrumWidth();
+	std::complex<double>* row = rowBuffer.data();
+	double scale = 1.0 / ((double)width * (double)height);
+
+	if (rows < 0 || rows > height)
+		rows = height;
+
+	TransformColumns(spectrum, true);
+
+	// Rows are spectra of real rows now. Two of them are restored by one complex transform.
+	const std::complex<double> imaginaryUnit(0.0, 1.0);
+	for (int32_t i = 0; i < rows; i = i + 2)
+	{
+		const std::complex<double>* first = &spectrum[i * spectrum_w];
+		const std::complex<double>* second = &spectrum[(i + 1) * spectrum_w];
+		for (int32_t k = 0; k < spectrum_w; ++k)
+			row[k] = first[k] + imaginaryUnit * second[k];
+		for (int32_t k = spectrum_w; k < width; ++k)
+			row[k] = std::conj(first[width - k]) + imaginaryUnit * std::conj(second[width - k]);
+
+		Transform(row, rowTwiddles.data(), width, true);
+
+		for (int32_t j = 0; j < width; ++j)
+		{
+			image[i * width + j] = row[j].real() * scale;
+			image[(i + 1) * width + j] = row[j].imag() * scale;
+		}
+	}
+}
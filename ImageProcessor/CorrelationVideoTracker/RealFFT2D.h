@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <complex>
+#include <vector>
+
+
+namespace vtracker
+{
+	/**
+	 * @brief Two-dimensional FFT of real images. Sizes are powers of two.
+	 * The spectrum keeps only the non-redundant half: height rows of (width / 2 + 1) values.
+	*/
+	class RealFFT2D
+	{
+	public:
+
+		/**
+		 * @brief Class constructor.
+		*/
+		RealFFT2D();
+
+		/**
+		 * @brief Method to prepare transform of the size. Tables are kept if the size is not changed.
+		 * @param width Width of image, power of two not less than 2.
+		 * @param height Height of image, power of two not less than 2.
+		 * @return TRUE if the size is supported or FALSE.
+		*/
+		bool Init(int32_t width, int32_t height);
+
+		/**
+		 * @brief Method to get width of image.
+		 * @return Width of image.
+		*/
+		int32_t GetWidth() const { return width; }
+
+		/**
+		 * @brief Method to get height of image.
+		 * @return Height of image.
+		*/
+		int32_t GetHeight() const { return height; }
+
+		/**
+		 * @brief Method to get width of spectrum.
+		 * @return Number of values in spectrum row.
+		*/
+		int32_t GetSpectrumWidth() const { return width / 2 + 1; }
+
+		/**
+		 * @brief Method to calculate spectrum of image.
+		 * @param image Image data, width * height values.
+		 * @param spectrum Spectrum data, height * GetSpectrumWidth() values.
+		 * @param rows Number of first image rows with data, other rows are zero and not read. -1 for all rows.
+		*/
+		void Forward(const double* image, std::complex<double>* spectrum, int32_t rows = -1);
+
+		/**
+		 * @brief Method to restore image from spectrum. The result is scaled, Inverse(Forward(x)) equals x.
+		 * @param spectrum Spectrum data, is used as work memory.
+		 * @param image Image data.
+		 * @param rows Number of first image rows to restore. -1 for all rows.
+		*/
+		void Inverse(std::complex<double>* spectrum, double* image, int32_t rows = -1);
+
+		/**
+		 * @brief Method to get size of transform for data size.
+		 * @param size Size of data.
+		 * @return Nearest power of two not less than size.
+		*/
+		static int32_t GetTransformSize(int32_t size);
+
+	private:
+
+		int32_t width;								/// Width of image.
+		int32_t height;								/// Height of image.
+		std::vector<std::complex<double>> rowTwiddles;		/// Twiddle factors of row transform.
+		std::vector<std::complex<double>> columnTwiddles;	/// Twiddle factors of column transform.
+		std::vector<std::complex<double>> rowBuffer;		/// Work memory of row transform.
+
+		/**
+		 * @brief Method to calculate complex FFT in place.
+		 * @param data Data to transform.
+		 * @param twiddles Twiddle factors of the size.
+		 * @param size Size of data, power of two.
+		 * @param inverse TRUE for inverse transform (without scaling).
+		*/
+		static void Transform(std::complex<double>* data, const std::complex<double>* twiddles, int32_t size, bool inverse);
+
+		/**
+		 * @brief Method to calculate complex FFT of all spectrum columns in place.
+		 * @param spectrum Spectrum data.
+		 * @param inverse TRUE for inverse transform (without scaling).
+		*/
+		void TransformColumns(std::complex<double>* spectrum, bool inverse);
+
+		/**
+		 * @brief Method to calculate twiddle factors.
+		 * @param twiddles Twiddle factors.
+		 * @param size Size of transform.
+		*/
+		static void InitTwiddles(std::vector<std::complex<double>>& twiddles, int32_t size);
+	};
+}
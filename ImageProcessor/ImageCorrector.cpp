@@ -1,34 +1,251 @@
 #include "ImageCorrector.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+#include "EnterProc.h"
+
+// Correction of RGB32 lines. Integer arithmetic, so every implementation gives the same result.
+// The implementation is selected once by CPU features
+namespace
+{
+    // Corrected byte of every pixel byte already shifted to its place in RGB32 pixel
+    struct CorrectionTables
+    {
+        uint32_t blue[256];
+        uint32_t green[256];
+        uint32_t red[256];
+    };
+
+    constexpr uint32_t ALPHA_MASK = 0xff000000;
+    // x / 3 == (x * 21846) >> 16 for the sum of three bytes
+    constexpr uint32_t DIVIDE_BY_3_MULTIPLIER = 21846;
+
+    // qGray(): (red * 11 + green * 16 + blue * 5) / 32
+    inline uint8_t GrayOfRgb32(uint32_t pixel)
+    {
+        return (((pixel >> 16) & 0xff) * 11 + ((pixel >> 8) & 0xff) * 16 + (pixel & 0xff) * 5) >> 5;
+    }
+
+    inline uint32_t CorrectRgb32Pixel(uint32_t pixel, const CorrectionTables &tables, bool grayscale)
+    {
+        uint32_t blue = tables.blue[pixel & 0xff];
+        uint32_t green = tables.green[(pixel >> 8) & 0xff];
+        uint32_t red = tables.red[(pixel >> 16) & 0xff];
+        if (grayscale)
+        {
+            uint32_t average = ((blue + (green >> 8) + (red >> 16)) * DIVIDE_BY_3_MULTIPLIER) >> 16;
+            return ALPHA_MASK | average * 0x010101;
+        }
+        return ALPHA_MASK | red | green | blue;
+    }
+
+    void CorrectRgb32Line_scalar(const uint32_t *source, uint32_t *result, uint8_t *gray, int width,
+                                 const CorrectionTables &tables, bool grayscale)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            uint32_t pixel = CorrectRgb32Pixel(source[x], tables, grayscale);
+            result[x] = pixel;
+            if (gray != nullptr)
+                gray[x] = GrayOfRgb32(pixel);
+        }
+    }
+
+    void GrayOfRgb32Line_scalar(const uint32_t *source, uint8_t *gray, int width)
+    {
+        for (int x = 0; x < width; x++)
+            gray[x] = GrayOfRgb32(source[x]);
+    }
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IMAGE_CORRECTOR_X86_SIMD
+
+    // Gray of 4 pixels in the low bytes of 32-bit lanes
+    __attribute__((target("sse2")))
+    inline __m128i GrayOfRgb32_sse2(__m128i pixels)
+    {
+        const __m128i byteMask = _mm_set1_epi32(0xff);
+        // blue and red are summed in 16-bit halves: blue * 5 + red * 11, green * 16 separately
+        __m128i blueRed = _mm_and_si128(pixels, _mm_set1_epi32(0x00ff00ff));
+        __m128i blueRedSum = _mm_madd_epi16(blueRed, _mm_set1_epi32(0x000b0005));
+        __m128i green = _mm_and_si128(_mm_srli_epi32(pixels, 8), byteMask);
+        return _mm_srli_epi32(_mm_add_epi32(blueRedSum, _mm_slli_epi32(green, 4)), 5);
+    }
+
+    __attribute__((target("sse2")))
+    void GrayOfRgb32Line_sse2(const uint32_t *source, uint8_t *gray, int width)
+    {
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i gray0 = GrayOfRgb32_sse2(_mm_loadu_si128((const __m128i *)(source + x)));
+            __m128i gray1 = GrayOfRgb32_sse2(_mm_loadu_si128((const __m128i *)(source + x + 4)));
+            __m128i gray2 = GrayOfRgb32_sse2(_mm_loadu_si128((const __m128i *)(source + x + 8)));
+            __m128i gray3 = GrayOfRgb32_sse2(_mm_loadu_si128((const __m128i *)(source + x + 12)));
+            __m128i gray01 = _mm_packs_epi32(gray0, gray1);
+            __m128i gray23 = _mm_packs_epi32(gray2, gray3);
+            _mm_storeu_si128((__m128i *)(gray + x), _mm_packus_epi16(gray01, gray23));
+        }
+        for (; x < width; x++)
+            gray[x] = GrayOfRgb32(source[x]);
+    }
+
+    // Gray of 8 pixels in the low bytes of 32-bit lanes
+    __attribute__((target("avx2")))
+    inline __m256i GrayOfRgb32_avx2(__m256i pixels)
+    {
+        const __m256i byteMask = _mm256_set1_epi32(0xff);
+        __m256i blueRed = _mm256_and_si256(pixels, _mm256_set1_epi32(0x00ff00ff));
+        __m256i blueRedSum = _mm256_madd_epi16(blueRed, _mm256_set1_epi32(0x000b0005));
+        __m256i green = _mm256_and_si256(_mm256_srli_epi32(pixels, 8), byteMask);
+        return _mm256_srli_epi32(_mm256_add_epi32(blueRedSum, _mm256_slli_epi32(green, 4)), 5);
+    }
+
+    // Low bytes of 32-bit lanes of a and b as 16 consecutive bytes
+    __attribute__((target("avx2")))
+    inline __m128i PackLowBytes_avx2(__m256i a, __m256i b)
+    {
+        __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+        return _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+    }
+
+    __attribute__((target("avx2")))
+    void GrayOfRgb32Line_avx2(const uint32_t *source, uint8_t *gray, int width)
+    {
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            __m256i gray0 = GrayOfRgb32_avx2(_mm256_loadu_si256((const __m256i *)(source + x)));
+            __m256i gray1 = GrayOfRgb32_avx2(_mm256_loadu_si256((const __m256i *)(source + x + 8)));
+            _mm_storeu_si128((__m128i *)(gray + x), PackLowBytes_avx2(gray0, gray1));
+        }
+        for (; x < width; x++)
+            gray[x] = GrayOfRgb32(source[x]);
+    }
+
+    // Table lookups are made by gathers from the 32-bit tables
+    __attribute__((target("avx2")))
+    inline __m256i CorrectRgb32_avx2(__m256i pixels, const CorrectionTables &tables, bool grayscale)
+    {
+        const __m256i byteMask = _mm256_set1_epi32(0xff);
+        __m256i blue = _mm256_i32gather_epi32((const int *)tables.blue, _mm256_and_si256(pixels, byteMask), 4);
+        __m256i green = _mm256_i32gather_epi32((const int *)tables.green,
+                                               _mm256_and_si256(_mm256_srli_epi32(pixels, 8), byteMask), 4);
+        __m256i red = _mm256_i32gather_epi32((const int *)tables.red,
+                                             _mm256_and_si256(_mm256_srli_epi32(pixels, 16), byteMask), 4);
+        if (grayscale)
+        {
+            __m256i sum = _mm256_add_epi32(_mm256_add_epi32(blue, _mm256_srli_epi32(green, 8)), _mm256_srli_epi32(red, 16));
+            __m256i average = _mm256_srli_epi32(_mm256_mullo_epi32(sum, _mm256_set1_epi32(DIVIDE_BY_3_MULTIPLIER)), 16);
+            return _mm256_or_si256(_mm256_set1_epi32(ALPHA_MASK), _mm256_mullo_epi32(average, _mm256_set1_epi32(0x010101)));
+        }
+        return _mm256_or_si256(_mm256_set1_epi32(ALPHA_MASK), _mm256_or_si256(_mm256_or_si256(red, green), blue));
+    }
+
+    __attribute__((target("avx2")))
+    void CorrectRgb32Line_avx2(const uint32_t *source, uint32_t *result, uint8_t *gray, int width,
+                               const CorrectionTables &tables, bool grayscale)
+    {
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            __m256i pixels0 = CorrectRgb32_avx2(_mm256_loadu_si256((const __m256i *)(source + x)), tables, grayscale);
+            __m256i pixels1 = CorrectRgb32_avx2(_mm256_loadu_si256((const __m256i *)(source + x + 8)), tables, grayscale);
+            _mm256_storeu_si256((__m256i *)(result + x), pixels0);
+            _mm256_storeu_si256((__m256i *)(result + x + 8), pixels1);
+            if (gray != nullptr)
+                _mm_storeu_si128((__m128i *)(gray + x), PackLowBytes_avx2(GrayOfRgb32_avx2(pixels0), GrayOfRgb32_avx2(pixels1)));
+        }
+        CorrectRgb32Line_scalar(source + x, result + x, gray != nullptr ? gray + x : nullptr, width - x, tables, grayscale);
+    }
+#endif
+
+    struct CorrectionKernels
+    {
+        void(*correctRgb32Line)(const uint32_t *source, uint32_t *result, uint8_t *gray, int width,
+                                const CorrectionTables &tables, bool grayscale);
+        void(*grayOfRgb32Line)(const uint32_t *source, uint8_t *gray, int width);
+
+        explicit CorrectionKernels(bool vectorized) :
+            correctRgb32Line(CorrectRgb32Line_scalar),
+            grayOfRgb32Line(GrayOfRgb32Line_scalar)
+        {
+#ifdef IMAGE_CORRECTOR_X86_SIMD
+            if (!vectorized)
+                return;
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+            {
+                correctRgb32Line = CorrectRgb32Line_avx2;
+                grayOfRgb32Line = GrayOfRgb32Line_avx2;
+            }
+            else if (__builtin_cpu_supports("sse2"))
+                grayOfRgb32Line = GrayOfRgb32Line_sse2;
+#endif
+        }
+    };
+
+    const CorrectionKernels scalarKernels(false);
+    const CorrectionKernels vectorizedKernels(true);
+}
+
+//---------------------------------------------------------------------------------------
 
 ImageCorrector::ImageCorrector()
 {
     _brightness = 0;
     _contrast = 0;
+    _gamma = 0;
     _grayscale = false;
+    _vectorized = true;
 }
 
-void contrastFilter(unsigned char *imageData, size_t dataSize, int fixContrast, int fixBrightness) // contrast (256 - normal)
+inline bool isRgb32Format(QImage::Format format)
+{
+    return format == QImage::Format_RGB32 || format == QImage::Format_ARGB32 || format == QImage::Format_ARGB32_Premultiplied;
+}
+
+// Middle brightness of the frame, the same weights are used for bytes of RGB32 pixel (blue, green, red)
+int calculateMidBright(const QImage &frame)
 {
-    //b g r 255
-    unsigned char buf[256];
     quint64 midBright = 0;
-    for (size_t i = 0; i < dataSize; i += 4)
-        midBright += imageData[i] * 77 + imageData[i + 1] * 150 + imageData[i + 2] * 29;
-    midBright /= (256 * dataSize / 4);
-    for (int i = 0; i < 256; i++)
+    const int width = frame.width();
+    const int height = frame.height();
+    if (width == 0 || height == 0)
+        return 0;
+
+    if (frame.format() == QImage::Format_Grayscale8)
     {
-        int a = (((i - midBright) * fixContrast) >> 8) + midBright + fixBrightness;
-        buf[i] = qBound(0, a, 255);
+        for (int y = 0; y < height; y++)
+        {
+            const uchar *line = frame.constScanLine(y);
+            for (int x = 0; x < width; x++)
+                midBright += line[x];
+        }
+        return midBright / ((quint64)width * height);
     }
-    for (size_t i = 0; i < dataSize; i += 4)
+
+    //b g r 255
+    for (int y = 0; y < height; y++)
     {
-        imageData[i + 0] = buf[imageData[i + 0]];
-        imageData[i + 1] = buf[imageData[i + 1]];
-        imageData[i + 2] = buf[imageData[i + 2]];
-        imageData[i + 3] = 255;
+        const QRgb *line = reinterpret_cast<const QRgb *>(frame.constScanLine(y));
+        for (int x = 0; x < width; x++)
+            midBright += qBlue(line[x]) * 77 + qGreen(line[x]) * 150 + qRed(line[x]) * 29;
     }
+    return midBright / (256 * (quint64)width * height);
 }
 
+void fillContrastTable(uchar *table, int midBright, int fixContrast, int fixBrightness) // contrast (256 - normal)
+{
+    for (int i = 0; i < 256; i++)
+    {
+        int a = (((i - midBright) * fixContrast) >> 8) + midBright + fixBrightness;
+        table[i] = qBound(0, a, 255);
+    }
+}
 
 unsigned char AddDoubleToByte(unsigned char bt, double d)
 {
@@ -44,69 +261,132 @@ unsigned char AddDoubleToByte(unsigned char bt, double d)
     return result;
 }
 
+// https://habr.com/ru/post/268115/
 void fillGammaExpo(unsigned char *lut, int step)
 {
     for (int i = 0; i < 256; i++)
         lut[i] = AddDoubleToByte(i, std::sin(i * 0.01255) * step * 10);
 }
 
-// https://habr.com/ru/post/268115/
-void gammaFilter(unsigned char *imageData, size_t dataSize, float K)
+bool ImageCorrector::fillCorrectionTables(const QImage &frame, uchar tables[3][256]) const
 {
-    if (imageData == nullptr)
-        return;
-
-    uchar lutR[256];
-    uchar lutG[256];
-    uchar lutB[256];
-    fillGammaExpo(lutR, -K * 2);
-    fillGammaExpo(lutG, K);
-    fillGammaExpo(lutB, K);
-
-    for (size_t i = 0; i < dataSize; i += 4)
+    uchar contrastTable[256];
+    bool needContrast = (_contrast != 0 || _brightness != 0);
+    if (needContrast)
+    {
+        int fixContrast = _contrast * 255 + 255;
+        int fixBrightness = 255 * _brightness;
+        fillContrastTable(contrastTable, calculateMidBright(frame), fixContrast, fixBrightness);
+    }
+    else
     {
-        imageData[i + 0] = lutR[imageData[i + 0]];
-        imageData[i + 1] = lutG[imageData[i + 1]];
-        imageData[i + 2] = lutB[imageData[i + 2]];
-        imageData[i + 3] = 255;
+        for (int i = 0; i < 256; i++)
+            contrastTable[i] = i;
     }
-}
 
-void convertToGrayscale(unsigned char *imageData, size_t dataSize)
-{
-    for (size_t i = 0; i < dataSize; i += 4)
+    bool needGamma = (_gamma != 0);
+    if (needGamma)
     {
-        int avgColor = (imageData[i + 0] + imageData[i + 1] + imageData[i + 2]) / 3;
-        imageData[i + 0] = avgColor;
-        imageData[i + 1] = avgColor;
-        imageData[i + 2] = avgColor;
-        imageData[i + 3] = 255;
+        float fixGamma = _gamma * 10;
+        uchar gammaTables[3][256];
+        fillGammaExpo(gammaTables[0], -fixGamma * 2);
+        fillGammaExpo(gammaTables[1], fixGamma);
+        fillGammaExpo(gammaTables[2], fixGamma);
+        for (int channel = 0; channel < 3; channel++)
+            for (int i = 0; i < 256; i++)
+                tables[channel][i] = gammaTables[channel][contrastTable[i]];
     }
+    else
+    {
+        for (int channel = 0; channel < 3; channel++)
+            memcpy(tables[channel], contrastTable, sizeof(contrastTable));
+    }
+
+    return needContrast || needGamma;
 }
 
-QImage ImageCorrector::ProcessFrame(const QImage &frame)
+// All corrections are made in a single pass over the frame in its own format
+QImage ImageCorrector::ProcessFrame(const QImage &frame, QImage *grayscaleFrame)
 {
-    QImage result = frame.convertToFormat(QImage::Format_RGB32);
-    Q_ASSERT(result.format() == QImage::Format_RGB32);
+    EnterProcStart("ImageCorrector::ProcessFrame");
+
+    QImage source = frame;
+    if (source.format() != QImage::Format_Grayscale8 && !isRgb32Format(source.format()))
+        source = frame.convertToFormat(QImage::Format_RGB32);
+
+    const CorrectionKernels &kernels = _vectorized ? vectorizedKernels : scalarKernels;
 
-    if (_contrast != 0 || _brightness != 0)
+    uchar tables[3][256];
+    bool needCorrection = fillCorrectionTables(source, tables);
+
+    const int width = source.width();
+    const int height = source.height();
+
+    if (grayscaleFrame != nullptr && (grayscaleFrame->size() != source.size() || grayscaleFrame->format() != QImage::Format_Grayscale8))
+        *grayscaleFrame = QImage(width, height, QImage::Format_Grayscale8);
+
+    if (!needCorrection && !_grayscale && source.format() == QImage::Format_RGB32)
     {
-        int fixContrast = _contrast * 255 + 255;
-        int fixBrightness = 255 * _brightness;
-        contrastFilter(result.bits(), result.sizeInBytes(), fixContrast, fixBrightness);
+        if (grayscaleFrame != nullptr)
+        {
+            for (int y = 0; y < height; y++)
+                kernels.grayOfRgb32Line(reinterpret_cast<const uint32_t *>(source.constScanLine(y)), grayscaleFrame->scanLine(y), width);
+        }
+        return source;
     }
 
-    if (_gamma != 0)
+    CorrectionTables correctionTables;
+    for (int i = 0; i < 256; i++)
     {
-        float fixGamma = _gamma * 10;
-        gammaFilter(result.bits(), result.sizeInBytes(), fixGamma);
+        correctionTables.blue[i] = tables[0][i];
+        correctionTables.green[i] = (uint32_t)tables[1][i] << 8;
+        correctionTables.red[i] = (uint32_t)tables[2][i] << 16;
+    }
+
+    QImage result(width, height, QImage::Format_RGB32);
+
+    if (source.format() == QImage::Format_Grayscale8)
+    {
+        // Every gray level gives the same pixel, so the whole correction is a single table lookup
+        QRgb rgbTable[256];
+        uchar grayTable[256];
+        for (int i = 0; i < 256; i++)
+        {
+            rgbTable[i] = CorrectRgb32Pixel(qRgb(i, i, i), correctionTables, _grayscale);
+            grayTable[i] = GrayOfRgb32(rgbTable[i]);
+        }
+
+        for (int y = 0; y < height; y++)
+        {
+            const uchar *sourceLine = source.constScanLine(y);
+            QRgb *resultLine = reinterpret_cast<QRgb *>(result.scanLine(y));
+            for (int x = 0; x < width; x++)
+                resultLine[x] = rgbTable[sourceLine[x]];
+            if (grayscaleFrame != nullptr)
+            {
+                uchar *grayscaleLine = grayscaleFrame->scanLine(y);
+                for (int x = 0; x < width; x++)
+                    grayscaleLine[x] = grayTable[sourceLine[x]];
+            }
+        }
+        return result;
     }
 
-    if (_grayscale)
-        convertToGrayscale(result.bits(), result.sizeInBytes());
+    for (int y = 0; y < height; y++)
+    {
+        const uint32_t *sourceLine = reinterpret_cast<const uint32_t *>(source.constScanLine(y));
+        uint32_t *resultLine = reinterpret_cast<uint32_t *>(result.scanLine(y));
+        uchar *grayscaleLine = grayscaleFrame != nullptr ? grayscaleFrame->scanLine(y) : nullptr;
+        kernels.correctRgb32Line(sourceLine, resultLine, grayscaleLine, width, correctionTables, _grayscale);
+    }
     return result;
 }
 
+void ImageCorrector::setVectorized(bool vectorized)
+{
+    _vectorized = vectorized;
+}
+
 void ImageCorrector::setTuneImageSettings(qreal brightness, qreal contrast, qreal gamma, bool grayscale)
 {
     _brightness = brightness;
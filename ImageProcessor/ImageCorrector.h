@@ -9,9 +9,17 @@ class ImageCorrector final
     qreal _brightness; // -1 ... 0 ... +1
     qreal _contrast;   // -1 ... 0 ... +1
     qreal _gamma;   // -1 ... 0 ... +1
+    bool _vectorized;
+
+    // Combined contrast and gamma tables for every byte of RGB32 pixel (blue, green, red)
+    bool fillCorrectionTables(const QImage &frame, uchar tables[3][256]) const;
 public:
     ImageCorrector();
-    QImage ProcessFrame(const QImage &frame);
+    // Result is RGB32, grayscaleFrame (if any) receives Grayscale8 plane of the result made in the same pass.
+    // Memory of grayscaleFrame is reused when it has the frame size and is not shared
+    QImage ProcessFrame(const QImage &frame, QImage *grayscaleFrame = nullptr);
+    // SIMD lines are used when CPU supports them, the scalar ones give the same result
+    void setVectorized(bool vectorized);
     void setTuneImageSettings(qreal brightness, qreal contrast, qreal gamma, bool grayscale);
     void getTuneImageSettings(qreal &brightness, qreal &contrast, qreal &gamma, bool &grayscale);
 };
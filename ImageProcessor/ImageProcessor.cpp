@@ -1,10 +1,16 @@
 #include "ImageProcessor.h"
 #include "ImageProcessor/CorrelationVideoTracker/ImageTrackerCorrelation.h"
+#include <QPainter>
+#include "EnterProc.h"
 
-ImageProcessor::ImageProcessor(QObject *parent, CoordinateCalculator *coordinateCalculator, bool verticalMirror, ObjectTrackerTypeEnum trackerType) : QObject(parent),
+// Smaller rotations are not compensated, rotating the frame costs more than they are visible
+constexpr double STABILIZATION_MINIMAL_ROTATION = 0.5;
+
+ImageProcessor::ImageProcessor(QObject *parent, CoordinateCalculator *coordinateCalculator, bool verticalMirror, ObjectTrackerTypeEnum trackerType,
+                               int maxQueuedVideoFrameCount, VideoFrameDropPolicy dropPolicy) : QObject(parent),
     _coordinateCalculator(coordinateCalculator)
 {    
-    _procThread = new ImageProcessorThread(nullptr, verticalMirror, trackerType);
+    _procThread = new ImageProcessorThread(nullptr, verticalMirror, trackerType, maxQueuedVideoFrameCount, dropPolicy);
 
     connect(_procThread, &ImageProcessorThread::dataProcessedInThread, this, &ImageProcessor::dataProcessedInThread);
 }
@@ -19,6 +25,17 @@ void ImageProcessor::processDataAsync(const TelemetryDataFrame &telemetryFrame,
     _procThread->processData(telemetryFrame, videoFrame);
 }
 
+void ImageProcessor::processTelemetry(const TelemetryDataFrame &telemetryFrame)
+{
+    EnterProcStart("ImageProcessor::processTelemetry");
+
+    TelemetryDataFrame frame = telemetryFrame;
+    _procThread->applyLastVideoResults(frame);
+    _coordinateCalculator->processTelemetryDataFrame(&frame);
+
+    emit onTelemetryProcessed(frame);
+}
+
 void ImageProcessor::lockTarget(const QPoint &targetCenter)
 {    
     _procThread->lockTarget(targetCenter);
@@ -39,6 +56,11 @@ void ImageProcessor::setStabilizationType(StabilizationType stabType)
     _procThread->setStabilizationType(stabType);
 }
 
+void ImageProcessor::setStabilizationEnabled(bool enabled)
+{
+    _procThread->setStabilizationEnabled(enabled);
+}
+
 void ImageProcessor::setTuneImageSettings(qreal brightness, qreal contrast, qreal gamma, bool grayscale)
 {
     _procThread->setTuneImageSettings(brightness, contrast, gamma, grayscale);
@@ -49,6 +71,11 @@ void ImageProcessor::getTuneImageSettings(qreal &brightness, qreal &contrast, qr
     _procThread->getTuneImageSettings(brightness, contrast, gamma, grayscale);
 }
 
+const ImageProcessorStatistics ImageProcessor::statistics()
+{
+    return _procThread->statistics();
+}
+
 void ImageProcessor::dataProcessedInThread(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame)
 {    
     TelemetryDataFrame frame = telemetryFrame;
@@ -57,15 +84,21 @@ void ImageProcessor::dataProcessedInThread(const TelemetryDataFrame &telemetryFr
     emit onDataProcessed(frame, videoFrame);
 }
 
-ImageProcessorThread::ImageProcessorThread(QObject *parent, bool verticalMirror, ObjectTrackerTypeEnum trackerType): QThread(parent)
+ImageProcessorThread::ImageProcessorThread(QObject *parent, bool verticalMirror, ObjectTrackerTypeEnum trackerType,
+                                           int maxQueuedVideoFrameCount, VideoFrameDropPolicy dropPolicy): QThread(parent)
 {
+    setObjectName("ImageProcessorThread");
     _quit = false;
-    _videoFrames = new QQueue<QImage>();
-    _telemetryFrames = new QQueue<TelemetryDataFrame>();
+    _queuedVideoFrameCount = 0;
+    _maxQueuedVideoFrameCount = qMax(1, maxQueuedVideoFrameCount);
+    _dropPolicy = dropPolicy;
+    _clock.start();
     _imageCorrector = new ImageCorrector();
     _imageStabilazation = new ImageStabilazation(verticalMirror);
 
     _stabilizationType = StabilizationType::StabilizationByFrame;
+    _stabilizationEnabled = false;
+    _lastVideoTelemetryFrame.clear();
 
     switch (trackerType)
     {
@@ -82,87 +115,269 @@ ImageProcessorThread::ImageProcessorThread(QObject *parent, bool verticalMirror,
 
 ImageProcessorThread::~ImageProcessorThread()
 {
+    _mutex.lock();
     _quit = true;
     _waitCondition.wakeOne();
+    _queueSpaceCondition.wakeAll();
+    _mutex.unlock();
     wait();
-    delete _videoFrames;
-    delete _telemetryFrames;
     delete _imageCorrector;
     delete _imageStabilazation;
     if ( _imageTracker != nullptr)
         delete _imageTracker;
 }
 
+QImage *ImageProcessorThread::takeGrayscaleFrame(const QSize &size)
+{
+    for (int i = 0; i < _grayscaleFrames.count(); i++)
+        if (_grayscaleFrames[i].isDetached() && _grayscaleFrames[i].size() == size)
+            return &_grayscaleFrames[i];
+
+    // Frames of the previous size are not needed any more
+    for (int i = _grayscaleFrames.count() - 1; i >= 0; i--)
+        if (_grayscaleFrames[i].isDetached() && _grayscaleFrames[i].size() != size)
+            _grayscaleFrames.removeAt(i);
+
+    // The pool grows until it covers the tracker's frame buffer
+    _grayscaleFrames.append(QImage(size, QImage::Format_Grayscale8));
+    return &_grayscaleFrames.last();
+}
+
+void ImageProcessorThread::processVideoFrame(TelemetryDataFrame &telemetryFrame, QImage &videoFrame)
+{
+    EnterProcStart("ImageProcessorThread::processVideoFrame");
+
+    // Grayscale plane for the tracker is made by the corrector in the same pass
+    QImage *gsImage = _imageTracker != nullptr ? takeGrayscaleFrame(videoFrame.size()) : nullptr;
+    videoFrame = _imageCorrector->ProcessFrame(videoFrame, gsImage);
+
+    // Motion is estimated from the tracker's plane when there is one, it is cheaper to sample.
+    // Without stabilization it is not estimated, the next enabled frame starts from zero correction
+    FrameShift2D correctionFrameShift = {.X = 0, .Y = 0, .A = 0};
+    if (_stabilizationEnabled)
+    {
+        _imageStabilazation->ProcessFrame(gsImage != nullptr ? *gsImage : videoFrame);
+        correctionFrameShift = _imageStabilazation->getLastFrameCorrectionShift();
+
+        quint32 stabilizationTimeUs = _imageStabilazation->lastFrameTimeNs() / 1000;
+        _mutex.lock();
+        _statistics.LastStabilizationTimeUs = stabilizationTimeUs;
+        _statistics.MaxStabilizationTimeUs = qMax(_statistics.MaxStabilizationTimeUs, stabilizationTimeUs);
+        _statistics.OverBudgetStabilizationFrames = _imageStabilazation->overBudgetFrameCount();
+        _mutex.unlock();
+    }
+    else
+        _imageStabilazation->Reset();
+
+    if (_imageTracker != nullptr)
+    {
+        EnterProcStart("ImageProcessorThread::trackTarget");
+        QRect targetRect = _imageTracker->doProcessFrame(*gsImage);
+
+        telemetryFrame.TrackedTargetState = targetRect.width() > 0 ? 1 : 0;
+
+        if (telemetryFrame.TrackedTargetState > 0)
+        {
+            telemetryFrame.TrackedTargetCenterX = targetRect.center().x();
+            telemetryFrame.TrackedTargetCenterY = targetRect.center().y();
+            telemetryFrame.TrackedTargetRectWidth = targetRect.width();
+            telemetryFrame.TrackedTargetRectHeight = targetRect.height();
+        }
+        else
+        {
+            telemetryFrame.TrackedTargetCenterX = 0;
+            telemetryFrame.TrackedTargetCenterY = 0;
+            telemetryFrame.TrackedTargetRectWidth = 0;
+            telemetryFrame.TrackedTargetRectHeight = 0;
+        }
+    }
+
+    if ((_stabilizationType == StabilizationType::StabilizationByTarget) && telemetryFrame.targetIsVisible())
+    {
+        telemetryFrame.StabilizedCenterX = telemetryFrame.TrackedTargetCenterX;
+        telemetryFrame.StabilizedCenterY = telemetryFrame.TrackedTargetCenterY;
+        telemetryFrame.StabilizedRotationAngle = 0;
+    }
+    else
+    {
+        telemetryFrame.StabilizedCenterX = videoFrame.width() / 2 + correctionFrameShift.X;
+        telemetryFrame.StabilizedCenterY = videoFrame.height() / 2 + correctionFrameShift.Y;
+        telemetryFrame.StabilizedRotationAngle = correctionFrameShift.A;
+    }
+
+    applyStabilization(telemetryFrame, videoFrame);
+}
+
+void ImageProcessorThread::applyStabilization(TelemetryDataFrame &telemetryFrame, QImage &videoFrame)
+{
+    QTransform outputTransform;
+    if (_stabilizationEnabled && qAbs(telemetryFrame.StabilizedRotationAngle) >= STABILIZATION_MINIMAL_ROTATION)
+    {
+        EnterProcStart("ImageProcessorThread::applyStabilization");
+
+        QPointF center(telemetryFrame.StabilizedCenterX, telemetryFrame.StabilizedCenterY);
+        outputTransform.translate(center.x(), center.y());
+        outputTransform.rotate(-telemetryFrame.StabilizedRotationAngle);
+        outputTransform.translate(-center.x(), -center.y());
+
+        // The previous output frame is reused when the display has released it
+        if (!_stabilizedFrame.isDetached() || _stabilizedFrame.size() != videoFrame.size() || _stabilizedFrame.format() != videoFrame.format())
+            _stabilizedFrame = QImage(videoFrame.size(), videoFrame.format());
+        _stabilizedFrame.fill(Qt::black);
+
+        QPainter painter(&_stabilizedFrame);
+        painter.setTransform(outputTransform);
+        painter.drawImage(0, 0, videoFrame);
+        painter.end();
+        videoFrame = _stabilizedFrame;
+
+        if (telemetryFrame.TrackedTargetState > 0)
+        {
+            QPointF targetCenter = outputTransform.map(QPointF(telemetryFrame.TrackedTargetCenterX, telemetryFrame.TrackedTargetCenterY));
+            telemetryFrame.TrackedTargetCenterX = targetCenter.x();
+            telemetryFrame.TrackedTargetCenterY = targetCenter.y();
+        }
+    }
+
+    _mutex.lock();
+    _outputTransform = outputTransform;
+    _mutex.unlock();
+}
+
 void ImageProcessorThread::run()
 {
     while (!_quit)
     {
         _mutex.lock();
-        if (_videoFrames->isEmpty())
+        if (_frames.isEmpty())
             _waitCondition.wait(&_mutex);
-        if (_videoFrames->isEmpty())
+        if (_frames.isEmpty())
         {
             _mutex.unlock();
             break;
         }
 
-        QImage videoFrame = _videoFrames->dequeue();
-        TelemetryDataFrame telemetryFrame = _telemetryFrames->dequeue();
+        QueuedFrame queuedFrame = _frames.dequeue();
+        if (!queuedFrame.Video.isNull())
+        {
+            _queuedVideoFrameCount--;
+            _queueSpaceCondition.wakeOne();
+        }
+        _statistics.QueueDepth = _queuedVideoFrameCount;
+
+        _mutex.unlock();
+
+        TelemetryDataFrame &telemetryFrame = queuedFrame.Telemetry;
+        QImage &videoFrame = queuedFrame.Video;
 
+        if (!queuedFrame.VideoDropped)
+        {
+            processVideoFrame(telemetryFrame, videoFrame);
+
+            quint32 frameDelayMs = _clock.elapsed() - queuedFrame.ReceiveTimeMs;
+            _mutex.lock();
+            _lastVideoFrame = videoFrame;
+            _lastVideoTelemetryFrame = telemetryFrame;
+            _statistics.ProcessedVideoFrames++;
+            _statistics.LastFrameDelayMs = frameDelayMs;
+            _statistics.MaxFrameDelayMs = qMax(_statistics.MaxFrameDelayMs, frameDelayMs);
+            _mutex.unlock();
+        }
+        else
+        {
+            // The video keeps the same frame count as the telemetry, so the last processed frame is repeated
+            // with its results
+            _mutex.lock();
+            applyLastVideoResultsLocked(telemetryFrame);
+            _mutex.unlock();
+            videoFrame = _lastVideoFrame;
+        }
+
+        _mutex.lock();
+        telemetryFrame.VideoProcessingQueueDepth = _statistics.QueueDepth;
+        telemetryFrame.VideoProcessingDelayMs = _statistics.LastFrameDelayMs;
+        telemetryFrame.DroppedVideoFrameCount = _statistics.DroppedVideoFrames;
         _mutex.unlock();
 
-        if ( !videoFrame.isNull() )
+        // Nothing to show until the first frame is processed
+        if (!videoFrame.isNull())
+            emit dataProcessedInThread(telemetryFrame, videoFrame);
+    }
+}
+
+void ImageProcessorThread::applyLastVideoResults(TelemetryDataFrame &telemetryFrame)
+{
+    QMutexLocker locker(&_mutex);
+    applyLastVideoResultsLocked(telemetryFrame);
+    telemetryFrame.VideoProcessingQueueDepth = _statistics.QueueDepth;
+    telemetryFrame.VideoProcessingDelayMs = _statistics.LastFrameDelayMs;
+    telemetryFrame.DroppedVideoFrameCount = _statistics.DroppedVideoFrames;
+}
+
+void ImageProcessorThread::applyLastVideoResultsLocked(TelemetryDataFrame &telemetryFrame)
+{
+    // Without the tracker the target comes from the telemetry itself
+    if (_imageTracker != nullptr)
+    {
+        telemetryFrame.TrackedTargetState = _lastVideoTelemetryFrame.TrackedTargetState;
+        telemetryFrame.TrackedTargetCenterX = _lastVideoTelemetryFrame.TrackedTargetCenterX;
+        telemetryFrame.TrackedTargetCenterY = _lastVideoTelemetryFrame.TrackedTargetCenterY;
+        telemetryFrame.TrackedTargetRectWidth = _lastVideoTelemetryFrame.TrackedTargetRectWidth;
+        telemetryFrame.TrackedTargetRectHeight = _lastVideoTelemetryFrame.TrackedTargetRectHeight;
+    }
+    telemetryFrame.StabilizedCenterX = _lastVideoTelemetryFrame.StabilizedCenterX;
+    telemetryFrame.StabilizedCenterY = _lastVideoTelemetryFrame.StabilizedCenterY;
+    telemetryFrame.StabilizedRotationAngle = _lastVideoTelemetryFrame.StabilizedRotationAngle;
+}
+
+void ImageProcessorThread::dropOldestQueuedVideoFrame()
+{
+    for (auto &queuedFrame : _frames)
+    {
+        if (!queuedFrame.Video.isNull())
         {
-            videoFrame = _imageCorrector->ProcessFrame(videoFrame);
-
-            _imageStabilazation->ProcessFrame(videoFrame);
-            FrameShift2D correctionFrameShift = _imageStabilazation->getLastFrameCorrectionShift();
-
-            if (_imageTracker != nullptr)
-            {
-                QImage gsImage = videoFrame.convertToFormat(QImage::Format_Grayscale8);
-                QRect targetRect = _imageTracker->doProcessFrame((uint8_t *)gsImage.constBits(), gsImage.width(), gsImage.height());
-
-                telemetryFrame.TrackedTargetState = targetRect.width() > 0 ? 1 : 0;
-
-                if (telemetryFrame.TrackedTargetState > 0)
-                {
-                    telemetryFrame.TrackedTargetCenterX = targetRect.center().x();
-                    telemetryFrame.TrackedTargetCenterY = targetRect.center().y();
-                    telemetryFrame.TrackedTargetRectWidth = targetRect.width();
-                    telemetryFrame.TrackedTargetRectHeight = targetRect.height();
-                }
-                else
-                {
-                    telemetryFrame.TrackedTargetCenterX = 0;
-                    telemetryFrame.TrackedTargetCenterY = 0;
-                    telemetryFrame.TrackedTargetRectWidth = 0;
-                    telemetryFrame.TrackedTargetRectHeight = 0;
-                }
-            }
-
-            if ((_stabilizationType == StabilizationType::StabilizationByTarget) && telemetryFrame.targetIsVisible())
-            {
-                telemetryFrame.StabilizedCenterX = telemetryFrame.TrackedTargetCenterX;
-                telemetryFrame.StabilizedCenterY = telemetryFrame.TrackedTargetCenterY;
-                telemetryFrame.StabilizedRotationAngle = 0;
-            }
-            else
-            {
-                telemetryFrame.StabilizedCenterX = videoFrame.width() / 2 + correctionFrameShift.X;
-                telemetryFrame.StabilizedCenterY = videoFrame.height() / 2 + correctionFrameShift.Y;
-                telemetryFrame.StabilizedRotationAngle = correctionFrameShift.A;
-            }
+            queuedFrame.Video = QImage();
+            queuedFrame.VideoDropped = true;
+            _queuedVideoFrameCount--;
+            _statistics.DroppedVideoFrames++;
+            return;
         }
-        emit dataProcessedInThread(telemetryFrame, videoFrame);
     }
 }
 
 void ImageProcessorThread::processData(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame)
 {
+    if (videoFrame.isNull())
+        return;
+
     _mutex.lock();
-    _videoFrames->enqueue(videoFrame);
-    _telemetryFrames->enqueue(telemetryFrame);
+
+    switch (_dropPolicy)
+    {
+    case VideoFrameDropPolicy::KeepLatestVideoFrame:
+        while (_queuedVideoFrameCount > 0)
+            dropOldestQueuedVideoFrame();
+        break;
+    case VideoFrameDropPolicy::BlockVideoReceiving:
+        while (_queuedVideoFrameCount >= _maxQueuedVideoFrameCount && !_quit && isRunning())
+            _queueSpaceCondition.wait(&_mutex);
+        break;
+    default:
+        while (_queuedVideoFrameCount >= _maxQueuedVideoFrameCount)
+            dropOldestQueuedVideoFrame();
+    }
+    _queuedVideoFrameCount++;
+
+    QueuedFrame queuedFrame;
+    queuedFrame.Telemetry = telemetryFrame;
+    queuedFrame.Video = videoFrame;
+    queuedFrame.ReceiveTimeMs = _clock.elapsed();
+    queuedFrame.VideoDropped = false;
+    _frames.enqueue(queuedFrame);
+
+    _statistics.QueueDepth = _queuedVideoFrameCount;
+    _statistics.MaxQueueDepth = qMax(_statistics.MaxQueueDepth, (quint32)_queuedVideoFrameCount);
+
     _mutex.unlock();
     if (!isRunning())
         start();
@@ -175,7 +390,7 @@ void ImageProcessorThread::lockTarget(const QPoint &targetCenter)
     if (_imageTracker != nullptr)
     {
         _mutex.lock();
-        _imageTracker->lockTarget(targetCenter);
+        _imageTracker->lockTarget(_outputTransform.inverted().map(targetCenter));
         _mutex.unlock();
     }
 }
@@ -205,6 +420,11 @@ void ImageProcessorThread::setStabilizationType(StabilizationType stabType)
     _stabilizationType = stabType;
 }
 
+void ImageProcessorThread::setStabilizationEnabled(bool enabled)
+{
+    _stabilizationEnabled = enabled;
+}
+
 void ImageProcessorThread::setTuneImageSettings(qreal brightness, qreal contrast, qreal gamma, bool grayscale)
 {
     _mutex.lock();
@@ -218,3 +438,9 @@ void ImageProcessorThread::getTuneImageSettings(qreal &brightness, qreal &contra
     _imageCorrector->getTuneImageSettings(brightness, contrast, gamma, grayscale);
     _mutex.unlock();
 }
+
+const ImageProcessorStatistics ImageProcessorThread::statistics()
+{
+    QMutexLocker locker(&_mutex);
+    return _statistics;
+}
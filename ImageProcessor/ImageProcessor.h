@@ -4,11 +4,15 @@
 #include <QObject>
 #include <QThread>
 #include <QQueue>
+#include <QVector>
 #include <QImage>
 #include <QMutex>
 #include <QWaitCondition>
+#include <QElapsedTimer>
 #include <QPointF>
 #include <QRectF>
+#include <QTransform>
+#include <atomic>
 #include "Common/CommonData.h"
 #include "ImageCorrector.h"
 #include "ImageStabilazation.h"
@@ -16,34 +20,93 @@
 #include "CoordinateCalculator.h"
 #include "ImageProcessor/ImageTracker.h"
 
+struct ImageProcessorStatistics final
+{
+    quint32 QueueDepth;             // video frames waiting for processing
+    quint32 MaxQueueDepth;
+    quint64 ProcessedVideoFrames;
+    quint64 DroppedVideoFrames;
+    quint32 LastFrameDelayMs;       // from receiving of the video frame to the end of its processing
+    quint32 MaxFrameDelayMs;
+    quint32 LastStabilizationTimeUs;    // motion estimation of the video frame, it is kept under a fixed budget
+    quint32 MaxStabilizationTimeUs;
+    quint64 OverBudgetStabilizationFrames;
+
+    ImageProcessorStatistics()
+    {
+        memset(this, 0, sizeof(ImageProcessorStatistics));
+    }
+};
+
 class ImageProcessorThread final: public QThread
 {
     Q_OBJECT
 
-    QQueue<QImage> *_videoFrames;
-    QQueue<TelemetryDataFrame> *_telemetryFrames;
+    struct QueuedFrame
+    {
+        TelemetryDataFrame Telemetry;
+        QImage Video;
+        qint64 ReceiveTimeMs;
+        bool VideoDropped;      // telemetry of the dropped video frame, it is never dropped itself
+    };
+
+    // Video frames are limited by _maxQueuedVideoFrameCount, telemetry of the dropped ones stays in the queue
+    QQueue<QueuedFrame> _frames;
+    int _queuedVideoFrameCount;
+    int _maxQueuedVideoFrameCount;
+    VideoFrameDropPolicy _dropPolicy;
+    QElapsedTimer _clock;
+    ImageProcessorStatistics _statistics;
+
     QMutex _mutex;
     bool _quit;
     QWaitCondition _waitCondition;
+    QWaitCondition _queueSpaceCondition;
+
+    // Dropped video frames are replaced by the last processed one with its tracking results.
+    // The results are read by telemetry ticks in the caller's thread under _mutex
+    QImage _lastVideoFrame;
+    TelemetryDataFrame _lastVideoTelemetryFrame;
+
+    // Set from the GUI thread
+    std::atomic<StabilizationType> _stabilizationType;
+    std::atomic<bool> _stabilizationEnabled;
 
-    StabilizationType _stabilizationType;
+    // Stabilizing rotation of the output frame, it is applied here once instead of every repaint of the display.
+    // Target coordinates are published in the output frame and locked ones are mapped back by the inverted transform
+    QTransform _outputTransform;
+    QImage _stabilizedFrame;
 
     ImageCorrector *_imageCorrector;
     ImageStabilazation  *_imageStabilazation;
     ImageTracker *_imageTracker;
+
+    // Grayscale frames for the tracker, a frame is reused when the tracker does not reference it any more
+    QVector<QImage> _grayscaleFrames;
+
+    QImage *takeGrayscaleFrame(const QSize &size);
+    void dropOldestQueuedVideoFrame();
+    void processVideoFrame(TelemetryDataFrame &telemetryFrame, QImage &videoFrame);
+    void applyStabilization(TelemetryDataFrame &telemetryFrame, QImage &videoFrame);
+    void applyLastVideoResultsLocked(TelemetryDataFrame &telemetryFrame);
 public:
-    ImageProcessorThread(QObject *parent, bool verticalMirror, ObjectTrackerTypeEnum trackerType);
+    ImageProcessorThread(QObject *parent, bool verticalMirror, ObjectTrackerTypeEnum trackerType,
+                         int maxQueuedVideoFrameCount, VideoFrameDropPolicy dropPolicy);
     ~ImageProcessorThread();
 
     void run();
 
     void processData(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame);
+    // Telemetry ticks don't wait behind the video frames, they get the results of the last processed frame
+    void applyLastVideoResults(TelemetryDataFrame &telemetryFrame);
     void lockTarget(const QPoint &targetCenter);
     void unlockTarget();
     void setTargetSize(int targetSize);
     void setStabilizationType(StabilizationType stabType);
+    void setStabilizationEnabled(bool enabled);
     void setTuneImageSettings(qreal brightness, qreal contrast, qreal gamma, bool grayscale);
     void getTuneImageSettings(qreal &brightness, qreal &contrast, qreal &gamma, bool &grayscale);
+    const ImageProcessorStatistics statistics();
 signals:
     void dataProcessedInThread(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame);
 };
@@ -56,19 +119,25 @@ class ImageProcessor final: public QObject
 
     CoordinateCalculator *_coordinateCalculator;
 public:
-    explicit ImageProcessor(QObject *parent, CoordinateCalculator *coordinateCalculator, bool verticalMirror, ObjectTrackerTypeEnum trackerType);
+    explicit ImageProcessor(QObject *parent, CoordinateCalculator *coordinateCalculator, bool verticalMirror, ObjectTrackerTypeEnum trackerType,
+                            int maxQueuedVideoFrameCount, VideoFrameDropPolicy dropPolicy);
     ~ImageProcessor();
 
     void processDataAsync(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame);
+    // Telemetry ticks are processed at once in the calling thread, they never enter the video queue
+    void processTelemetry(const TelemetryDataFrame &telemetryFrame);
     void setTuneImageSettings(qreal brightness, qreal contrast, qreal gamma, bool grayscale);
     void getTuneImageSettings(qreal &brightness, qreal &contrast, qreal &gamma, bool &grayscale);
+    const ImageProcessorStatistics statistics();
 signals:
     void onDataProcessed(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame);
+    void onTelemetryProcessed(const TelemetryDataFrame &telemetryFrame);
 public slots:
     void lockTarget(const QPoint &targetCenter);
     void unlockTarget();
     void setTargetSize(int targetSize);
     void setStabilizationType(StabilizationType stabType);
+    void setStabilizationEnabled(bool enabled);
 private slots:
     void dataProcessedInThread(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame);
 };
@@ -1,25 +1,37 @@
 #include "ImageStabilazation.h"
 #include <QtGlobal>
+#include <QtMath>
 #include <QDebug>
+#include "EnterProc.h"
 
 using namespace std;
 
-#define CORNER_RETRACK_FRAMES 30
-#define EXPECTED_POINTS_COUNT 10
-#define MAXIMAL_POINTS_COUNT 20
-#define MINIMAL_DISTANCE_BETWEEN_POINTS 50
 #define MAXIMAL_FRAME_WIDTH 720.0
 #define MAXIMAL_OFFSET_COMPENSATION MAXIMAL_FRAME_WIDTH / 4
 #define MAXIMAL_ROTATION_COMPENSATION 20
 #define FILTER_UPDATE_K 0.9
 
+#define PYRAMID_BASE_WIDTH 320          // width of the finer pyramid level, the frame is downscaled by an integer factor
+#define COARSE_BLOCK_WIDTH 128          // block of the coarse level, it covers most of the level
+#define COARSE_BLOCK_HEIGHT 64
+#define FINE_BLOCK_SIZE 64              // four blocks of the finer level at the quadrant centers
+#define MINIMAL_CORRELATION_PEAK 0.08   // weaker peaks are noise or a scene change
+#define MINIMAL_ROTATION_BLOCKS 3
+#define TIME_BUDGET_NS 4000000          // 4 ms per frame, the block refinement is skipped when the budget is spent
+
 ImageStabilazation::ImageStabilazation(bool verticalMirror) :
     _filterX(-MAXIMAL_OFFSET_COMPENSATION,   +MAXIMAL_OFFSET_COMPENSATION,   FILTER_UPDATE_K),
     _filterY(-MAXIMAL_OFFSET_COMPENSATION,   +MAXIMAL_OFFSET_COMPENSATION,   FILTER_UPDATE_K),
     _filterA(-MAXIMAL_ROTATION_COMPENSATION, +MAXIMAL_ROTATION_COMPENSATION, FILTER_UPDATE_K),
-    _verticalMirror(verticalMirror)
+    _verticalMirror(verticalMirror),
+    _coarseCorrelator(COARSE_BLOCK_WIDTH, COARSE_BLOCK_HEIGHT),
+    _blockCorrelator(FINE_BLOCK_SIZE, FINE_BLOCK_SIZE)
 {
     _frameNumber = 0;
+    _scale = 1;
+    _currentLevels = 0;
+    _lastFrameTimeNs = 0;
+    _overBudgetFrameCount = 0;
 
     _correctionShift = {.X = 0, .Y = 0, .A = 0};
     _lastShift = {.X = 0, .Y = 0, .A = 0};
@@ -30,10 +42,182 @@ ImageStabilazation::~ImageStabilazation(void)
 
 }
 
+void ImageStabilazation::buildPyramid(const QImage &sourceFrame, QImage levels[2])
+{
+    // Every block of the finer level is averaged by a few samples, so the cost does not depend on the frame size
+    int width = sourceFrame.width() / _scale;
+    int height = sourceFrame.height() / _scale;
+    int step = qMax(1, _scale / 2);
+    int sampleCount = ((_scale + step - 1) / step) * ((_scale + step - 1) / step);
+
+    if (levels[0].size() != QSize(width, height))
+        levels[0] = QImage(width, height, QImage::Format_Grayscale8);
+    if (levels[1].size() != QSize(width / 2, height / 2))
+        levels[1] = QImage(width / 2, height / 2, QImage::Format_Grayscale8);
+
+    bool isGrayscale = sourceFrame.format() == QImage::Format_Grayscale8;
+    for (int y = 0; y < height; y++)
+    {
+        uchar *target = levels[0].scanLine(y);
+        for (int x = 0; x < width; x++)
+        {
+            int sum = 0;
+            for (int sy = 0; sy < _scale; sy += step)
+            {
+                const uchar *sourceLine = sourceFrame.constScanLine(y * _scale + sy);
+                if (isGrayscale)
+                {
+                    for (int sx = 0; sx < _scale; sx += step)
+                        sum += sourceLine[x * _scale + sx];
+                }
+                else
+                {
+                    auto pixels = reinterpret_cast<const QRgb *>(sourceLine);
+                    for (int sx = 0; sx < _scale; sx += step)
+                    {
+                        QRgb pixel = pixels[x * _scale + sx];
+                        sum += (qRed(pixel) * 77 + qGreen(pixel) * 150 + qBlue(pixel) * 29) >> 8;
+                    }
+                }
+            }
+            target[x] = static_cast<uchar>(sum / sampleCount);
+        }
+    }
+
+    for (int y = 0; y < levels[1].height(); y++)
+    {
+        const uchar *first = levels[0].constScanLine(2 * y);
+        const uchar *second = levels[0].constScanLine(2 * y + 1);
+        uchar *target = levels[1].scanLine(y);
+        for (int x = 0; x < levels[1].width(); x++)
+            target[x] = static_cast<uchar>((first[2 * x] + first[2 * x + 1] + second[2 * x] + second[2 * x + 1]) / 4);
+    }
+}
+
+bool ImageStabilazation::estimateShift(const QImage levels[2], const QImage previousLevels[2], FrameShift2D &shift)
+{
+    // Coarse translation of the whole frame
+    QSize coarseSize = levels[1].size();
+    QPoint coarseTopLeft((coarseSize.width() - _coarseCorrelator.width()) / 2, (coarseSize.height() - _coarseCorrelator.height()) / 2);
+    QPointF coarseShift;
+    double peak;
+    if (!_coarseCorrelator.correlate(previousLevels[1], coarseTopLeft, levels[1], coarseTopLeft, coarseShift, peak) ||
+            peak < MINIMAL_CORRELATION_PEAK)
+        return false;
+
+    shift.X = coarseShift.x() * 2 * _scale;
+    shift.Y = coarseShift.y() * 2 * _scale;
+    shift.A = 0;
+
+    if (_timer.nsecsElapsed() > TIME_BUDGET_NS / 2)
+        return true;
+
+    // Blocks of the finer level are searched around the coarse shift, rotation is fitted to their shifts
+    QSize size = levels[0].size();
+    QPointF center(size.width() / 2.0, size.height() / 2.0);
+    QPoint predictedShift = (coarseShift * 2).toPoint();
+    int blockSize = _blockCorrelator.width();
+
+    QPointF blockCenters[4], blockShifts[4];
+    int blockCount = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        QPoint blockCenter(size.width() * (i % 2 == 0 ? 1 : 3) / 4, size.height() * (i < 2 ? 1 : 3) / 4);
+        QPoint previousTopLeft = blockCenter - QPoint(blockSize / 2, blockSize / 2);
+        QPoint currentTopLeft = previousTopLeft + predictedShift;
+        currentTopLeft.setX(qBound(0, currentTopLeft.x(), size.width() - blockSize));
+        currentTopLeft.setY(qBound(0, currentTopLeft.y(), size.height() - blockSize));
+
+        QPointF blockShift;
+        if (_blockCorrelator.correlate(previousLevels[0], previousTopLeft, levels[0], currentTopLeft, blockShift, peak) &&
+                peak >= MINIMAL_CORRELATION_PEAK)
+        {
+            blockCenters[blockCount] = QPointF(blockCenter) - center;
+            blockShifts[blockCount] = blockShift + (currentTopLeft - previousTopLeft);
+            blockCount++;
+        }
+    }
+
+    if (blockCount == 0)
+        return true;
+
+    QPointF translation;
+    for (int i = 0; i < blockCount; i++)
+        translation += blockShifts[i];
+    translation /= blockCount;
+    shift.X = translation.x() * _scale;
+    shift.Y = translation.y() * _scale;
+
+    if (blockCount >= MINIMAL_ROTATION_BLOCKS)
+    {
+        // Small rotation around the center: shift = translation + angle * (-y, x)
+        double moment = 0, inertia = 0;
+        for (int i = 0; i < blockCount; i++)
+        {
+            QPointF residual = blockShifts[i] - translation;
+            moment += blockCenters[i].x() * residual.y() - blockCenters[i].y() * residual.x();
+            inertia += QPointF::dotProduct(blockCenters[i], blockCenters[i]);
+        }
+        if (inertia > 0)
+            shift.A = qRadiansToDegrees(moment / inertia);
+    }
+
+    return true;
+}
+
 void ImageStabilazation::ProcessFrame(const QImage &sourceFrame)
-{  
+{
+    EnterProcStart("ImageStabilazation::ProcessFrame");
+    _timer.start();
+
+    int scale = qMax(1, sourceFrame.width() / PYRAMID_BASE_WIDTH);
+    int previousLevels = _currentLevels;
+    bool canCompare = _frameNumber > 0 && scale == _scale && !_levels[previousLevels][0].isNull();
+    _scale = scale;
+
+    _currentLevels = 1 - _currentLevels;
+    buildPyramid(sourceFrame, _levels[_currentLevels]);
+
+    // Levels must contain the blocks
+    canCompare = canCompare &&
+            _levels[previousLevels][0].size() == _levels[_currentLevels][0].size() &&
+            _levels[_currentLevels][1].width() >= _coarseCorrelator.width() &&
+            _levels[_currentLevels][1].height() >= _coarseCorrelator.height() &&
+            _levels[_currentLevels][0].width() >= 2 * _blockCorrelator.width() &&
+            _levels[_currentLevels][0].height() >= 2 * _blockCorrelator.height();
+
+    FrameShift2D shift = {.X = 0, .Y = 0, .A = 0};
+    if (canCompare)
+        estimateShift(_levels[_currentLevels], _levels[previousLevels], shift);
+    else
+    {
+        _filterX.reset();
+        _filterY.reset();
+        _filterA.reset();
+    }
+
+    // Correction follows the accumulated motion and returns to the frame center when the motion stops
+    _lastShift = shift;
+    _correctionShift.X = _filterX.process(shift.X);
+    _correctionShift.Y = _filterY.process(shift.Y);
+    _correctionShift.A = _filterA.process(shift.A);
 
     _frameNumber++;
+
+    _lastFrameTimeNs = _timer.nsecsElapsed();
+    if (_lastFrameTimeNs > TIME_BUDGET_NS)
+        _overBudgetFrameCount++;
+}
+
+void ImageStabilazation::Reset()
+{
+    _frameNumber = 0;
+    _filterX.reset();
+    _filterY.reset();
+    _filterA.reset();
+    _correctionShift = {.X = 0, .Y = 0, .A = 0};
+    _lastShift = {.X = 0, .Y = 0, .A = 0};
+    _lastFrameTimeNs = 0;
 }
 
 FrameShift2D ImageStabilazation::getLastFrameCorrectionShift() const
@@ -46,6 +230,118 @@ FrameShift2D ImageStabilazation::getLastFrameShift() const
     return _lastShift;
 }
 
+qint64 ImageStabilazation::timeBudgetNs()
+{
+    return TIME_BUDGET_NS;
+}
+
+qint64 ImageStabilazation::lastFrameTimeNs() const
+{
+    return _lastFrameTimeNs;
+}
+
+quint64 ImageStabilazation::overBudgetFrameCount() const
+{
+    return _overBudgetFrameCount;
+}
+
+//------------------------------------------------------------------
+
+PhaseCorrelator::PhaseCorrelator(int width, int height)
+{
+    _width = width;
+    _height = height;
+    _fft.Init(width, height);
+    _image.resize(width * height);
+    _previousSpectrum.resize(_fft.GetSpectrumWidth() * height);
+    _currentSpectrum.resize(_fft.GetSpectrumWidth() * height);
+
+    // Hann window suppresses the block borders
+    _window.resize(width * height);
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            _window[y * width + x] = (0.5 - 0.5 * qCos(2 * M_PI * x / width)) * (0.5 - 0.5 * qCos(2 * M_PI * y / height));
+}
+
+int PhaseCorrelator::width() const
+{
+    return _width;
+}
+
+int PhaseCorrelator::height() const
+{
+    return _height;
+}
+
+void PhaseCorrelator::transformBlock(const QImage &image, const QPoint &topLeft, std::complex<double> *spectrum)
+{
+    double mean = 0;
+    for (int y = 0; y < _height; y++)
+    {
+        const uchar *line = image.constScanLine(topLeft.y() + y) + topLeft.x();
+        for (int x = 0; x < _width; x++)
+            mean += line[x];
+    }
+    mean /= _width * _height;
+
+    for (int y = 0; y < _height; y++)
+    {
+        const uchar *line = image.constScanLine(topLeft.y() + y) + topLeft.x();
+        for (int x = 0; x < _width; x++)
+            _image[y * _width + x] = (line[x] - mean) * _window[y * _width + x];
+    }
+
+    _fft.Forward(_image.constData(), spectrum);
+}
+
+bool PhaseCorrelator::correlate(const QImage &previous, const QPoint &previousTopLeft, const QImage &current, const QPoint &currentTopLeft,
+                                QPointF &shift, double &peak)
+{
+    transformBlock(previous, previousTopLeft, _previousSpectrum.data());
+    transformBlock(current, currentTopLeft, _currentSpectrum.data());
+
+    // Normalized cross power spectrum, its inverse is a peak at the shift
+    for (size_t i = 0; i < _currentSpectrum.size(); i++)
+    {
+        const std::complex<double> a = _currentSpectrum[i];
+        const std::complex<double> b = _previousSpectrum[i];
+        std::complex<double> product(a.real() * b.real() + a.imag() * b.imag(), a.imag() * b.real() - a.real() * b.imag());
+        double magnitude = std::abs(product);
+        _currentSpectrum[i] = magnitude > 1e-9 ? product / magnitude : std::complex<double>(0, 0);
+    }
+    _fft.Inverse(_currentSpectrum.data(), _image.data());
+
+    int peakIndex = 0;
+    for (int i = 1; i < _image.count(); i++)
+        if (_image[i] > _image[peakIndex])
+            peakIndex = i;
+    peak = _image[peakIndex];
+    if (peak <= 0)
+        return false;
+
+    // Parabolic subpixel position, indices above the half are negative shifts
+    int peakX = peakIndex % _width;
+    int peakY = peakIndex / _width;
+    auto value = [this](int x, int y)
+    {
+        return _image[((y + _height) % _height) * _width + (x + _width) % _width];
+    };
+    auto subpixel = [](double left, double center, double right)
+    {
+        double denominator = left - 2 * center + right;
+        return qAbs(denominator) > 1e-12 ? qBound(-0.5, 0.5 * (left - right) / denominator, 0.5) : 0.0;
+    };
+    double dx = subpixel(value(peakX - 1, peakY), peak, value(peakX + 1, peakY));
+    double dy = subpixel(value(peakX, peakY - 1), peak, value(peakX, peakY + 1));
+
+    if (peakX >= _width / 2)
+        peakX -= _width;
+    if (peakY >= _height / 2)
+        peakY -= _height;
+    shift = QPointF(peakX + dx, peakY + dy);
+    return true;
+}
+
 //------------------------------------------------------------------
 
 FloatFilter::FloatFilter(double minValue, double maxValue, double k)
@@ -62,3 +358,8 @@ double FloatFilter::process(double value)
     _sum = _sum * _k + value;
     return _sum;
 }
+
+void FloatFilter::reset()
+{
+    _sum = 0;
+}
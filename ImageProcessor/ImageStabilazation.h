@@ -2,7 +2,14 @@
 #define IMAGESTABILAZATION_H
 
 #include <QPoint>
+#include <QPointF>
+#include <QImage>
+#include <QVector>
+#include <QElapsedTimer>
+#include <vector>
+#include <complex>
 #include "Common/CommonData.h"
+#include "ImageProcessor/CorrelationVideoTracker/RealFFT2D.h"
 
 class FloatFilter final
 {
@@ -11,8 +18,32 @@ class FloatFilter final
 public:
     FloatFilter(double minValue, double maxValue, double k);
     double process(double value);
+    void reset();
 };
 
+// Phase correlation of equally sized blocks of two Grayscale8 images
+class PhaseCorrelator final
+{
+    int _width, _height;
+    vtracker::RealFFT2D _fft;
+    QVector<double> _window;
+    QVector<double> _image;
+    std::vector<std::complex<double>> _previousSpectrum, _currentSpectrum;
+
+    void transformBlock(const QImage &image, const QPoint &topLeft, std::complex<double> *spectrum);
+public:
+    // Sizes are powers of two
+    PhaseCorrelator(int width, int height);
+
+    int width() const;
+    int height() const;
+    // Shift of the current block content relative to the previous block, peak is the confidence 0...1
+    bool correlate(const QImage &previous, const QPoint &previousTopLeft, const QImage &current, const QPoint &currentTopLeft,
+                   QPointF &shift, double &peak);
+};
+
+// Global motion between consecutive frames by phase correlation on a downscaled grayscale pyramid:
+// translation on the coarse level, then translation and rotation from four blocks of the finer level
 class ImageStabilazation final
 {
 private:
@@ -21,13 +52,35 @@ private:
     FrameShift2D _lastShift, _correctionShift;
 
     bool _verticalMirror;
+
+    // Pyramid of the previous and the current frames, level 0 is the finer one
+    int _scale;
+    QImage _levels[2][2];
+    int _currentLevels;
+
+    PhaseCorrelator _coarseCorrelator;
+    PhaseCorrelator _blockCorrelator;
+    QElapsedTimer _timer;
+    qint64 _lastFrameTimeNs;
+    quint64 _overBudgetFrameCount;
+
+    void buildPyramid(const QImage &sourceFrame, QImage levels[2]);
+    bool estimateShift(const QImage levels[2], const QImage previousLevels[2], FrameShift2D &shift);
 public:
     ImageStabilazation(bool verticalMirror);
     ~ImageStabilazation();
 
+    // Frame is RGB32 or Grayscale8
     void ProcessFrame(const QImage &sourceFrame);
+    // Next frame is not compared with the previous one, the correction returns to zero
+    void Reset();
     FrameShift2D getLastFrameCorrectionShift() const;
     FrameShift2D getLastFrameShift() const;
+
+    // Time of the last ProcessFrame and count of frames that exceeded the per-frame budget
+    static qint64 timeBudgetNs();
+    qint64 lastFrameTimeNs() const;
+    quint64 overBudgetFrameCount() const;
 };
 
 #endif // IMAGESTABILAZATION_H
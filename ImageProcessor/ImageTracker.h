@@ -3,6 +3,7 @@
 
 #include <QPoint>
 #include <QRect>
+#include <QImage>
 #include "Common/CommonData.h"
 
 class ImageTracker
@@ -10,7 +11,8 @@ class ImageTracker
 public:
     ImageTracker();
     virtual ~ImageTracker();
-    virtual QRect doProcessFrame(uint8_t* frame_mono8, int32_t width, int32_t height) = 0;
+    // Frame is Grayscale8, tracker may keep references to the previous frames
+    virtual QRect doProcessFrame(const QImage &frame) = 0;
     virtual void lockTarget(const QPoint &targetCenter) = 0;
     virtual void unlockTarget() = 0;
     virtual void setTargetSize(int size) = 0;
@@ -30,7 +30,7 @@ ArealObjectContainer::~ArealObjectContainer()
 void ArealObjectContainer::timerEvent(QTimerEvent *event)
 {
     Q_UNUSED(event)
-    EnterProc("ArealObjectContainer::timerEvent");
+    EnterProcStart("ArealObjectContainer::timerEvent");
     saveAllArealObjects();
 }
 
@@ -42,7 +42,7 @@ ArealObjectContainer &ArealObjectContainer::Instance()
 
 ArealObject *ArealObjectContainer::createNewArealObject()
 {
-    EnterProc("ArealObjectContainer::createNewArealObject");
+    EnterProcStart("ArealObjectContainer::createNewArealObject");
 
     auto arealObject = addArealObjectToList(QUuid::createUuid().toString(), tr("New Zone"), true,
                                             QColor(255, 0, 0, 30), "");
@@ -66,7 +66,7 @@ ArealObject *ArealObjectContainer::createNewArealObject()
 
 void ArealObjectContainer::deleteArealObject(ArealObject *arealObject)
 {
-    EnterProc("ArealObjectContainer::deleteArealObject");
+    EnterProcStart("ArealObjectContainer::deleteArealObject");
 
     double deletedDT = GetCurrentDateTimeForDB();
     QSqlQuery updateQuery(_arealObjectDatabase);
@@ -85,7 +85,7 @@ void ArealObjectContainer::deleteArealObject(ArealObject *arealObject)
 
 const QList<ArealObject *> *ArealObjectContainer::getArealObjects()
 {
-    EnterProc("ArealObjectContainer::getArealObjects");
+    EnterProcStart("ArealObjectContainer::getArealObjects");
 
     loadArealObjectList();
     return &_arealObjects;
@@ -93,7 +93,7 @@ const QList<ArealObject *> *ArealObjectContainer::getArealObjects()
 
 ArealObject *ArealObjectContainer::getArealObjectByGUID(const QString &GUID)
 {
-    EnterProc("ArealObjectContainer::getArealObjectByGUID");
+    EnterProcStart("ArealObjectContainer::getArealObjectByGUID");
     loadArealObjectList();
     foreach (auto arealObject, _arealObjects)
         if (arealObject->GUID() == GUID)
@@ -106,7 +106,7 @@ void ArealObjectContainer::loadArealObjectList()
     if (_arealObjectLoaded)
         return;
 
-    EnterProc("ArealObjectContainer::loadArealObjectList");
+    EnterProcStart("ArealObjectContainer::loadArealObjectList");
 
     _arealObjectLoaded = true;
 
@@ -139,7 +139,7 @@ ArealObject *ArealObjectContainer::addArealObjectToList(const QString &GUID, con
 
 void ArealObjectContainer::saveArealObject(ArealObject *arealObject)
 {
-    EnterProc("ArealObjectContainer::saveArealObject");
+    EnterProcStart("ArealObjectContainer::saveArealObject");
 
     QSqlQuery updateQuery(_arealObjectDatabase);
     updateQuery.prepare("UPDATE ArealObjects SET Description = ?, IsVisible = ?, Color = ?, ArealPointsText = ? WHERE GUID = ?");
@@ -159,7 +159,7 @@ void ArealObjectContainer::saveArealObject(ArealObject *arealObject)
 
 void ArealObjectContainer::saveAllArealObjects()
 {
-    EnterProc("ArealObjectContainer::saveAllArealObjects");
+    EnterProcStart("ArealObjectContainer::saveAllArealObjects");
     foreach (auto arealObject, _arealObjects)
         if (arealObject->_dirty)
             saveArealObject(arealObject);
@@ -4,7 +4,7 @@
 #include "Common/CommonUtils.h"
 #include "EnterProc.h"
 
-void ArtillerySpotter::processDataExchange(const QString &contentHEX, const QString &description, DataExchangePackageDirection direction)
+void ArtillerySpotter::processDataExchange(const QByteArray &content, const QString &description, DataExchangePackageDirection direction)
 {
     EnterProcStart("ArtillerySpotter::processDataExchange");
 
@@ -12,11 +12,11 @@ void ArtillerySpotter::processDataExchange(const QString &contentHEX, const QStr
     dataPackage.SessionTimeMs = _telemetryDataFrame.SessionTimeMs;
     dataPackage.VideoFrameNumber = _telemetryDataFrame.VideoFrameNumber;
     dataPackage.TelemetryFrameNumber = _telemetryDataFrame.TelemetryFrameNumber;
-    dataPackage.ContentHEX = contentHEX;
+    dataPackage.Content = content;
     dataPackage.Description = description;
     emit onArtillerySpotterDataExchange(dataPackage, direction);
 
-    qInfo() << description << contentHEX;
+    qInfo() << description << content.toHex();
 }
 
 void ArtillerySpotter::timerEvent(QTimerEvent *event)
@@ -117,7 +117,7 @@ void ArtillerySpotter::sendMarkers(const QList<MapMarker *> *markers)
 
     if (_tcpSocket.state() != QAbstractSocket::ConnectedState)
     {
-        processDataExchange("", "Send Markers. Unable to send message. No connection.", DataExchangePackageDirection::Outgoing);
+        processDataExchange(QByteArray(), "Send Markers. Unable to send message. No connection.", DataExchangePackageDirection::Outgoing);
         emit onMessageExchangeInformation(tr("Unable to send message. No connection."), true);
         return;
     }
@@ -168,7 +168,7 @@ void ArtillerySpotter::sendMarkers(const QList<MapMarker *> *markers)
 
     _sentMessages.insert(header.messageId, header.codeMessage);
 
-    processDataExchange(messageContent.toHex(), "Send Markers", DataExchangePackageDirection::Outgoing);
+    processDataExchange(messageContent.toByteArray(), "Send Markers", DataExchangePackageDirection::Outgoing);
     emit onMessageExchangeInformation(tr("Targets information sent successfully (# %1)").arg(header.messageId), false);
 }
 
@@ -178,7 +178,7 @@ void ArtillerySpotter::sendWeather(const QVector<WeatherDataItem> *weatherDataCo
 
     if (_tcpSocket.state() != QAbstractSocket::ConnectedState)
     {
-        processDataExchange("", "Send Weather. Unable to send message. No connection.", DataExchangePackageDirection::Outgoing);
+        processDataExchange(QByteArray(), "Send Weather. Unable to send message. No connection.", DataExchangePackageDirection::Outgoing);
         emit onMessageExchangeInformation(tr("Unable to send message. No connection."), true);
         return;
     }
@@ -223,7 +223,7 @@ void ArtillerySpotter::sendWeather(const QVector<WeatherDataItem> *weatherDataCo
 
     _sentMessages.insert(header.messageId, header.codeMessage);
 
-    processDataExchange(messageContent.toHex(), "Send Weather", DataExchangePackageDirection::Outgoing);
+    processDataExchange(messageContent.toByteArray(), "Send Weather", DataExchangePackageDirection::Outgoing);
     emit onMessageExchangeInformation(tr("Weather information sent successfully (# %1)").arg(header.messageId), false);
 }
 
@@ -244,7 +244,7 @@ void ArtillerySpotter::readSocketData()
             BinaryContent messageContent;
             messageContent.clear();
             messageContent.appendData((const char *)receiptData, sizeof(ReceiptData));
-            processDataExchange(messageContent.toHex(), "Receipt Data", DataExchangePackageDirection::Outgoing);
+            processDataExchange(messageContent.toByteArray(), "Receipt Data", DataExchangePackageDirection::Outgoing);
 
             if (receiptData->errorCode == 0)
                 emit onMessageExchangeInformation(tr("Information received successfully (# %1)").arg(receiptData->messageId), false);
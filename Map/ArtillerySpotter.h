@@ -27,7 +27,7 @@ class ArtillerySpotter : public QObject
 
     TelemetryDataFrame _telemetryDataFrame;
 
-    void processDataExchange(const QString &contentHEX, const QString &description, DataExchangePackageDirection direction);
+    void processDataExchange(const QByteArray &content, const QString &description, DataExchangePackageDirection direction);
 protected:
     void timerEvent(QTimerEvent *event); // reconnect to socket
 public:
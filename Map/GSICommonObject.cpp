@@ -20,7 +20,7 @@ void GSICommonObject::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
 
 QVariant GSICommonObject::itemChange(QGraphicsItem::GraphicsItemChange change, const QVariant &value)
 {
-    EnterProc("QMarkerItem::itemChange");
+    EnterProcStart("QMarkerItem::itemChange");
 
     if (change == ItemPositionHasChanged)
     {
@@ -80,7 +80,7 @@ MapMarker *GSICommonObject::getMapMarker()
 
 GSICommonObject::GSICommonObject(MapMarker *mapMarker, QGraphicsItem *parent) : QGraphicsPixmapItem(parent)
 {
-    EnterProc("QMarkerItem::QMarkerItem");
+    EnterProcStart("QMarkerItem::QMarkerItem");
 
     _mapMarker = mapMarker;
 
@@ -0,0 +1,240 @@
+#include "GSITrajectory.h"
+#include <QStyleOptionGraphicsItem>
+#include <QPair>
+#include "MapGraphicsScene.h"
+#include "EnterProc.h"
+
+constexpr int TRAJECTORY_CHUNK_POINTS = 1024;
+constexpr int TRAJECTORY_LOD_LEVELS = 9;
+constexpr double TRAJECTORY_LOD_BASE_TOLERANCE = 1.0 / 512.0;  // half a pixel at the scene scale, scene units
+constexpr double TRAJECTORY_TOLERANCE_PIXELS = 0.5;
+
+// Each level is two zoom levels coarser than the previous one
+inline double levelTolerance(int level)
+{
+    return TRAJECTORY_LOD_BASE_TOLERANCE * (1 << (2 * level));
+}
+
+inline QRectF extendedRect(const QRectF &rect, const QPointF &point)
+{
+    return QRectF(QPointF(qMin(rect.left(), point.x()), qMin(rect.top(), point.y())),
+                  QPointF(qMax(rect.right(), point.x()), qMax(rect.bottom(), point.y())));
+}
+
+// QRectF::intersects() ignores the degenerated rects of straight segments
+inline bool isRectsOverlapped(const QRectF &rect1, const QRectF &rect2)
+{
+    return rect1.left() <= rect2.right() && rect2.left() <= rect1.right() &&
+           rect1.top() <= rect2.bottom() && rect2.top() <= rect1.bottom();
+}
+
+GSITrajectory::GSITrajectory(QGraphicsScene *scene, const QPen &pen) : QGraphicsItem(nullptr)
+{
+    _pen = pen;
+    _pointCount = 0;
+    _isDirty = false;
+
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+    setZValue(DEFAULT_TRAJECTORY_Z_ORDER);
+    scene->addItem(this);
+}
+
+GSITrajectory::~GSITrajectory()
+{
+
+}
+
+QVector<quint16> GSITrajectory::simplifyChunk(const Chunk &chunk, double tolerance)
+{
+    int count = chunk.Points.count();
+    QVector<bool> keepPoints(count, false);
+    keepPoints[0] = true;
+    keepPoints[count - 1] = true;
+
+    double tolerance2 = tolerance * tolerance;
+    QVector<QPair<int, int>> ranges;
+    ranges.append(qMakePair(0, count - 1));
+    while (!ranges.isEmpty())
+    {
+        auto range = ranges.takeLast();
+        const ChunkPoint &start = chunk.Points[range.first];
+        const ChunkPoint &end = chunk.Points[range.second];
+        double segmentX = end.X - start.X;
+        double segmentY = end.Y - start.Y;
+        double segmentLength2 = segmentX * segmentX + segmentY * segmentY;
+
+        double maxDistance2 = 0;
+        int maxDistanceIndex = -1;
+        for (int i = range.first + 1; i < range.second; i++)
+        {
+            // distance to the segment, the loops around a target go back over the segment ends
+            double dx = chunk.Points[i].X - start.X;
+            double dy = chunk.Points[i].Y - start.Y;
+            if (segmentLength2 > 0)
+            {
+                double t = qBound(0.0, (dx * segmentX + dy * segmentY) / segmentLength2, 1.0);
+                dx -= t * segmentX;
+                dy -= t * segmentY;
+            }
+            double distance2 = dx * dx + dy * dy;
+            if (distance2 > maxDistance2)
+            {
+                maxDistance2 = distance2;
+                maxDistanceIndex = i;
+            }
+        }
+
+        if (maxDistanceIndex > 0 && maxDistance2 > tolerance2)
+        {
+            keepPoints[maxDistanceIndex] = true;
+            ranges.append(qMakePair(range.first, maxDistanceIndex));
+            ranges.append(qMakePair(maxDistanceIndex, range.second));
+        }
+    }
+
+    QVector<quint16> indexes;
+    for (int i = 0; i < count; i++)
+        if (keepPoints[i])
+            indexes.append(i);
+    return indexes;
+}
+
+void GSITrajectory::buildChunkLevels(Chunk &chunk)
+{
+    EnterProcStart("GSITrajectory::buildChunkLevels");
+
+    chunk.Levels.clear();
+    for (int level = 0; level < TRAJECTORY_LOD_LEVELS; level++)
+    {
+        chunk.Levels.append(simplifyChunk(chunk, levelTolerance(level)));
+        if (chunk.Levels.last().count() <= 2)
+            break;
+    }
+    chunk.Levels.squeeze();
+}
+
+void GSITrajectory::addPoint(const QPointF &point)
+{
+    if (_chunks.isEmpty() || _chunks.last().Points.count() >= TRAJECTORY_CHUNK_POINTS)
+    {
+        Chunk newChunk;
+        newChunk.Points.reserve(TRAJECTORY_CHUNK_POINTS);
+        if (_chunks.isEmpty())
+        {
+            newChunk.Origin = point;
+            newChunk.Bounds = QRectF(point, point);
+        }
+        else
+        {
+            // the full chunk is not changed anymore, the next one starts from its last point
+            Chunk &prevChunk = _chunks.last();
+            buildChunkLevels(prevChunk);
+            newChunk.Origin = prevChunk.point(prevChunk.Points.count() - 1);
+            newChunk.Bounds = QRectF(newChunk.Origin, newChunk.Origin);
+            newChunk.Points.append({0, 0});
+        }
+        _chunks.append(newChunk);
+    }
+
+    Chunk &chunk = _chunks.last();
+    QPointF prevPoint = chunk.Points.isEmpty() ? point : chunk.point(chunk.Points.count() - 1);
+    chunk.Points.append({float(point.x() - chunk.Origin.x()), float(point.y() - chunk.Origin.y())});
+    chunk.Bounds = extendedRect(chunk.Bounds, point);
+
+    _pointsRect = _pointCount == 0 ? QRectF(point, point) : extendedRect(_pointsRect, point);
+    _pointCount++;
+
+    QRectF segmentRect = QRectF(prevPoint, point).normalized();
+    _dirtyRect = _isDirty ? _dirtyRect.united(segmentRect) : segmentRect;
+    _isDirty = true;
+}
+
+void GSITrajectory::refresh()
+{
+    if (!_isDirty)
+        return;
+
+    double margin = qMax<double>(_pen.widthF(), 1);
+    auto boundingRect = _pointsRect.adjusted(-margin, -margin, margin, margin);
+    if (boundingRect != _boundingRect)
+    {
+        prepareGeometryChange();
+        _boundingRect = boundingRect;
+    }
+    update(_dirtyRect.adjusted(-margin, -margin, margin, margin));
+    _isDirty = false;
+}
+
+void GSITrajectory::clear()
+{
+    prepareGeometryChange();
+    _chunks.clear();
+    _pointCount = 0;
+    _pointsRect = QRectF();
+    _boundingRect = QRectF();
+    _isDirty = false;
+}
+
+int GSITrajectory::pointCount() const
+{
+    return _pointCount;
+}
+
+QRectF GSITrajectory::boundingRect() const
+{
+    return _boundingRect;
+}
+
+void GSITrajectory::drawChunk(QPainter *painter, const Chunk &chunk, double tolerance)
+{
+    _polyline.resize(0);
+
+    int pointCount = chunk.Points.count();
+    if (chunk.Bounds.width() <= tolerance && chunk.Bounds.height() <= tolerance)
+    {
+        // the whole chunk is within a pixel
+        _polyline.append(chunk.point(0));
+        _polyline.append(chunk.point(pointCount - 1));
+    }
+    else
+    {
+        int level = -1;
+        while (level + 1 < chunk.Levels.count() && levelTolerance(level + 1) <= tolerance)
+            level++;
+
+        if (level < 0)
+        {
+            for (int i = 0; i < pointCount; i++)
+                _polyline.append(chunk.point(i));
+        }
+        else
+        {
+            foreach (auto index, chunk.Levels[level])
+                _polyline.append(chunk.point(index));
+        }
+    }
+
+    painter->drawPolyline(_polyline.constData(), _polyline.count());
+}
+
+void GSITrajectory::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget)
+    EnterProcStart("GSITrajectory::paint");
+
+    double levelOfDetail = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    if (levelOfDetail <= 0)
+        return;
+
+    // tolerance and the cosmetic pen width in scene units
+    double tolerance = TRAJECTORY_TOLERANCE_PIXELS / levelOfDetail;
+    double margin = (_pen.widthF() + 1) / levelOfDetail;
+
+    painter->setPen(_pen);
+    painter->setBrush(Qt::NoBrush);
+
+    const QRectF &exposedRect = option->exposedRect;
+    foreach (const auto &chunk, _chunks)
+        if (isRectsOverlapped(chunk.Bounds.adjusted(-margin, -margin, margin, margin), exposedRect))
+            drawChunk(painter, chunk, tolerance);
+}
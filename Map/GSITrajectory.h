@@ -0,0 +1,60 @@
+#ifndef GSITRAJECTORY_H
+#define GSITRAJECTORY_H
+
+#include <QGraphicsItem>
+#include <QGraphicsScene>
+#include <QPainter>
+#include <QPen>
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+
+// Flight trajectory split into chunks of consecutive points. Points are stored as float offsets from the chunk origin,
+// full chunks keep Douglas-Peucker simplifications for the zoom bands. Only the chunks in the exposed rect are drawn,
+// with the level matching the current scale, so the repaint cost does not grow with the trajectory length
+class GSITrajectory final : public QGraphicsItem
+{
+    struct ChunkPoint final
+    {
+        float X, Y;
+    };
+
+    struct Chunk final
+    {
+        QPointF Origin;
+        QVector<ChunkPoint> Points;
+        QRectF Bounds;
+        QVector<QVector<quint16>> Levels;   // indexes of the simplified points, coarser levels last
+
+        QPointF point(int index) const
+        {
+            return QPointF(Origin.x() + Points[index].X, Origin.y() + Points[index].Y);
+        }
+    };
+
+    QPen _pen;
+    QVector<Chunk> _chunks;
+    int _pointCount;
+    QRectF _pointsRect;     // grows with the points
+    QRectF _boundingRect;   // published to the scene on refresh
+    QRectF _dirtyRect;      // of the points added since the last refresh
+    bool _isDirty;
+    QVector<QPointF> _polyline;
+
+    static QVector<quint16> simplifyChunk(const Chunk &chunk, double tolerance);
+    static void buildChunkLevels(Chunk &chunk);
+    void drawChunk(QPainter *painter, const Chunk &chunk, double tolerance);
+public:
+    GSITrajectory(QGraphicsScene *scene, const QPen &pen);
+    ~GSITrajectory();
+
+    void addPoint(const QPointF &point);
+    void refresh();
+    void clear();
+    int pointCount() const;
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+};
+
+#endif // GSITRAJECTORY_H
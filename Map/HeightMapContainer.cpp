@@ -1,22 +1,51 @@
 #include "HeightMapContainer.h"
 #include <QQuaternion>
 #include <QVector3D>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QSaveFile>
 #include "Common/CommonUtils.h"
 
 quint32 HeightMapContainer::_heightDatabaseCounter = 0;
 
-HeightMapTile::HeightMapTile()
+constexpr qint64 SRTM1_TILE_SIZE = (qint64)HeightMapTile::ROW_COUNT * HeightMapTile::COL_COUNT * sizeof(qint16);
+
+inline quint64 heightMapTileKey(int tileX, int tileY, HeightMapSource sourceId)
+{
+    return ((quint64)(quint8)sourceId << 32) | ((quint64)(quint16)tileX << 16) | (quint16)tileY;
+}
+
+HeightMapTile::HeightMapTile(const QString &fileName) : file(fileName)
+{
+    heights = nullptr;
+    if (file.open(QIODevice::ReadOnly) && file.size() >= SRTM1_TILE_SIZE)
+        heights = reinterpret_cast<const qint16 *>(file.map(0, SRTM1_TILE_SIZE));
+}
+
+HeightMapTile::HeightMapTile(const QByteArray &tileData) : data(tileData)
 {
-    x = -1;
-    y = -1;
-    lastUsing = 0;
+    heights = data.size() >= SRTM1_TILE_SIZE ? reinterpret_cast<const qint16 *>(data.constData()) : nullptr;
 }
 
 HeightMapTile::~HeightMapTile()
 {
+    if (heights != nullptr && file.isOpen())
+        file.unmap(reinterpret_cast<uchar *>(const_cast<qint16 *>(heights)));
+}
+
+bool HeightMapTile::isValid() const
+{
+    return heights != nullptr;
+}
+
+qint16 HeightMapTile::height(int row, int col) const
+{
+    return heights[row * COL_COUNT + col];
 }
 
-HeightMapContainer::HeightMapContainer(QObject *parent, const QString &dbHeightMapFile) : QObject(parent)
+HeightMapContainer::HeightMapContainer(QObject *parent, const QString &dbHeightMapFile) : QObject(parent),
+    _tiles(TILE_CACHE_SIZE_MB * 1024 * 1024)
 {    
     _heightTileDatabase =  QSqlDatabase::addDatabase("QSQLITE", QString("HeightDatabase%1").arg(_heightDatabaseCounter++));
     _heightTileDatabase.setDatabaseName(dbHeightMapFile);
@@ -28,79 +57,169 @@ HeightMapContainer::HeightMapContainer(QObject *parent, const QString &dbHeightM
     _selectQuery->prepare("SELECT tile FROM HeightMap WHERE x=? AND y=? AND sourceId=?");
     LOG_SQL_ERROR(_selectQuery);
 
-    _lastTileIndex = 0;
+    QFileInfo databaseInfo(dbHeightMapFile);
+    QString tileCacheRootFolder = databaseInfo.absolutePath() + "/" + databaseInfo.completeBaseName() + "Tiles";
+    _tileCacheFolder = QString("%1/%2_%3").arg(tileCacheRootFolder)
+            .arg(databaseInfo.size()).arg(databaseInfo.lastModified().toSecsSinceEpoch());
+    // Tiles of the replaced databases are not used anymore, the cache never exceeds the database size
+    if (makeDir(_tileCacheFolder))
+        removeStaleTileCaches(tileCacheRootFolder);
 }
 
 HeightMapContainer::~HeightMapContainer()
 {
+    _tiles.clear();
     delete _selectQuery;
 }
 
-bool HeightMapContainer::GetHeight(double gps_lat, double gps_lon, double &height)
+const QString HeightMapContainer::tileFileName(int tileX, int tileY, HeightMapSource sourceId) const
 {
-    return GetHeightSRTM1(gps_lat, gps_lon, height);
+    return QString("%1/%2_%3_%4.hgt").arg(_tileCacheFolder).arg(sourceId).arg(tileX).arg(tileY);
 }
 
-bool HeightMapContainer::GetHeightSRTM1(double gps_lat, double gps_lon, double &height)
+const QByteArray HeightMapContainer::readTile(int tileX, int tileY, HeightMapSource sourceId)
 {
-    height = 0;
+    _selectQuery->addBindValue(tileX);
+    _selectQuery->addBindValue(tileY);
+    _selectQuery->addBindValue(sourceId);
+
+    _selectQuery->exec();
+    LOG_SQL_ERROR(_selectQuery);
+
+    QByteArray tileData;
+    if (_selectQuery->next())
+        tileData = _selectQuery->value(0).toByteArray();
+    _selectQuery->finish();
 
-    HeightMapTile * resultTile = nullptr;
-    HeightMapTile * obsoleteTile = nullptr;
+    return tileData;
+}
 
-    int tileX = (int)gps_lat;
-    int tileY = (int)gps_lon;
+bool HeightMapContainer::saveTile(const QString &fileName, const QByteArray &tileData)
+{
+    // Other containers can extract the same tile, the file appears only when it is complete
+    QSaveFile tileFile(fileName);
+    if (!tileFile.open(QIODevice::WriteOnly))
+        return false;
+    tileFile.write(tileData);
+    return tileFile.commit();
+}
 
-    //Try to search tile in cache
-    for (int i = 0; i < TILE_BUFFER_SIZE; i++)
+void HeightMapContainer::removeStaleTileCaches(const QString &tileCacheRootFolder)
+{
+    // Tiles of the former flat layout are removed too
+    const QString currentCacheName = QFileInfo(_tileCacheFolder).fileName();
+    const auto entries = QDir(tileCacheRootFolder).entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+    foreach (auto entry, entries)
     {
-        HeightMapTile * tile = &_tiles[i];
-        if (obsoleteTile == nullptr)
-            obsoleteTile = tile;
-        else if (tile->lastUsing < obsoleteTile->lastUsing)
-            obsoleteTile = tile;
-        if ((tile->x == tileX) && (tile->y == tileY) && (tile->sourceId == SRTM1))
-        {
-            resultTile = tile;
-            break;
-        }
+        if (entry.fileName() == currentCacheName)
+            continue;
+        bool isRemoved = entry.isDir() ? QDir(entry.absoluteFilePath()).removeRecursively() : QFile::remove(entry.absoluteFilePath());
+        if (!isRemoved)
+            qWarning() << "Unable to remove stale height map tiles:" << entry.absoluteFilePath();
     }
+}
+
+const HeightMapTile *HeightMapContainer::getTile(int tileX, int tileY, HeightMapSource sourceId)
+{
+    quint64 key = heightMapTileKey(tileX, tileY, sourceId);
+    HeightMapTile *tile = _tiles.object(key);
+    if (tile != nullptr)
+        return tile->isValid() ? tile : nullptr;
 
-    if (resultTile == nullptr)
+    QString fileName = tileFileName(tileX, tileY, sourceId);
+    if (!QFile::exists(fileName))
     {
-        _selectQuery->addBindValue(tileX);
-        _selectQuery->addBindValue(tileY);
-        _selectQuery->addBindValue(SRTM1);
+        QByteArray tileData = readTile(tileX, tileY, sourceId);
+        // Tile cache can be read-only, the tile is decoded in memory then
+        if (tileData.size() >= SRTM1_TILE_SIZE && !saveTile(fileName, tileData))
+            tile = new HeightMapTile(tileData);
+    }
 
-        _selectQuery->exec();
-        LOG_SQL_ERROR(_selectQuery);
+    // Missing tiles are cached too, so the database is not queried for every point outside of the map
+    if (tile == nullptr)
+        tile = new HeightMapTile(fileName);
+    qint64 cost = tile->isValid() ? SRTM1_TILE_SIZE : 1;
+    if (!_tiles.insert(key, tile, cost))
+        return nullptr;
+    return tile->isValid() ? tile : nullptr;
+}
 
-        while (_selectQuery->next())
-        {
-            resultTile = obsoleteTile;
+bool HeightMapContainer::GetHeight(double gps_lat, double gps_lon, double &height)
+{
+    height = 0;
+    const HeightMapTile *tile = getTile((int)gps_lat, (int)gps_lon, SRTM1);
+    if (tile == nullptr)
+        return false;
+    return GetHeightSRTM1(tile, gps_lat, gps_lon, height);
+}
+
+int HeightMapContainer::GetHeights(const QVector<WorldGPSCoord> &coords, QVector<double> &heights)
+{
+    heights.resize(coords.count());
 
-            resultTile->x = tileX;
-            resultTile->y = tileY;
-            resultTile->sourceId = SRTM1;
-            resultTile->tileData = _selectQuery->value(0).toByteArray();
+    int foundCount = 0;
+    int lastTileX = 0, lastTileY = 0;
+    const HeightMapTile *lastTile = nullptr;
+    bool hasLastTile = false;
+
+    for (int i = 0; i < coords.count(); i++)
+    {
+        const WorldGPSCoord &coord = coords[i];
+        heights[i] = INCORRECT_COORDINATE;
+        if (coord.isIncorrect())
+            continue;
+
+        // Neighbour points are mostly in the same tile
+        int tileX = (int)coord.lat;
+        int tileY = (int)coord.lon;
+        if (!hasLastTile || tileX != lastTileX || tileY != lastTileY)
+        {
+            lastTile = getTile(tileX, tileY, SRTM1);
+            lastTileX = tileX;
+            lastTileY = tileY;
+            hasLastTile = true;
         }
 
-        if (resultTile == nullptr)
-            return false;
+        double height;
+        if (lastTile != nullptr && GetHeightSRTM1(lastTile, coord.lat, coord.lon, height))
+        {
+            heights[i] = height;
+            foundCount++;
+        }
     }
+    return foundCount;
+}
 
-    resultTile->lastUsing = _usingCounter;
+bool HeightMapContainer::GetHeightSRTM1(const HeightMapTile *tile, double gps_lat, double gps_lon, double &height) const
+{
+    const int TileRowCount = HeightMapTile::ROW_COUNT;
+    const int TileColCount = HeightMapTile::COL_COUNT;
 
-    const int TileRowCount = 3601;
-    const int TileColCount = 1801;
+    double rowPos = qBound(0.0, (1 - (gps_lat - trunc(gps_lat))) * (TileRowCount - 1), double(TileRowCount - 1));
+    double colPos = qBound(0.0, (gps_lon - trunc(gps_lon)) * (TileColCount - 1), double(TileColCount - 1));
 
-    int i = int((1 - (gps_lat - trunc(gps_lat))) * (TileRowCount - 1));
-    int j = int((gps_lon - trunc(gps_lon)) * (TileColCount - 1));
+    int i = qMin(int(rowPos), TileRowCount - 2);
+    int j = qMin(int(colPos), TileColCount - 2);
+    double di = rowPos - i;
+    double dj = colPos - j;
 
-    short * heightData = (short*)resultTile->tileData.constData();
-    short heightInPos = heightData[i * TileColCount + j];
+    qint16 h00 = tile->height(i, j);
+    qint16 h01 = tile->height(i, j + 1);
+    qint16 h10 = tile->height(i + 1, j);
+    qint16 h11 = tile->height(i + 1, j + 1);
 
-    height = heightInPos;
+    if (h00 == HeightMapTile::VOID_HEIGHT || h01 == HeightMapTile::VOID_HEIGHT ||
+        h10 == HeightMapTile::VOID_HEIGHT || h11 == HeightMapTile::VOID_HEIGHT)
+    {
+        // Bilinear interpolation is not possible near voids, use the nearest point
+        qint16 heightInPos = tile->height(int(rowPos), int(colPos));
+        if (heightInPos == HeightMapTile::VOID_HEIGHT)
+            return false;
+        height = heightInPos;
+        return true;
+    }
 
+    height = (h00 * (1 - dj) + h01 * dj) * (1 - di) +
+             (h10 * (1 - dj) + h11 * dj) * di;
     return true;
 }
@@ -2,6 +2,9 @@
 #include <QObject>
 #include <QSqlDatabase>
 #include <QSqlQuery>
+#include <QFile>
+#include <QCache>
+#include <QVector>
 #include "Common/CommonData.h"
 #include "CamPreferences.h"
 #include "TelemetryDataFrame.h"
@@ -13,15 +16,24 @@ enum HeightMapSource
     SRTM1 = 1
 };
 
+// Tile of heights mapped from the on-disk tile cache, unmapped on destruction.
+// When the cache can not be written the tile is kept in memory
 struct HeightMapTile final
 {
-    int x;
-    int y;
-    HeightMapSource sourceId;
-    unsigned long lastUsing;
-    QByteArray tileData;
-    HeightMapTile();
+    static const int ROW_COUNT = 3601;
+    static const int COL_COUNT = 1801;
+    static const qint16 VOID_HEIGHT = -32768;
+
+    QFile file;
+    QByteArray data;
+    const qint16 *heights;
+
+    HeightMapTile(const QString &fileName);
+    HeightMapTile(const QByteArray &tileData);
     ~HeightMapTile();
+
+    bool isValid() const;
+    qint16 height(int row, int col) const;
 };
 
 class HeightMapContainer final : public QObject
@@ -33,15 +45,27 @@ private:
     QSqlDatabase _heightTileDatabase;
     QSqlQuery * _selectQuery;
 
-    static const int TILE_BUFFER_SIZE = 10;
-    unsigned long _usingCounter;
-    HeightMapTile _tiles[TILE_BUFFER_SIZE];
-    int _lastTileIndex;
+    // Raw tiles extracted from the database, they are mapped into memory instead of being loaded into the heap.
+    // Folder name contains size and time of the database, so a replaced database gets a new cache
+    QString _tileCacheFolder;
+    // Key is tile number, cost is tile size in bytes
+    QCache<quint64, HeightMapTile> _tiles;
 
-    bool GetHeightSRTM1(double gps_lat, double gps_lon, double &height);
+    const QString tileFileName(int tileX, int tileY, HeightMapSource sourceId) const;
+    const QByteArray readTile(int tileX, int tileY, HeightMapSource sourceId);
+    bool saveTile(const QString &fileName, const QByteArray &tileData);
+    void removeStaleTileCaches(const QString &tileCacheRootFolder);
+    const HeightMapTile *getTile(int tileX, int tileY, HeightMapSource sourceId);
+
+    bool GetHeightSRTM1(const HeightMapTile *tile, double gps_lat, double gps_lon, double &height) const;
 public:
+    static const int TILE_CACHE_SIZE_MB = 256;
+
     explicit HeightMapContainer(QObject *parent, const QString &dbHeightMapFile);
     ~HeightMapContainer();
 
     bool GetHeight(double gps_lat, double gps_lon, double &height);
+    // Heights of the coordinates, the tile is looked up once for the neighbour points in it.
+    // Incorrect coordinates and coordinates without height data get INCORRECT_COORDINATE. Returns number of found heights
+    int GetHeights(const QVector<WorldGPSCoord> &coords, QVector<double> &heights);
 };
@@ -163,7 +163,7 @@ QAction *MapGraphicsScene::createCoordSystemActions(GlobalCoordSystem coordSyste
 
 void MapGraphicsScene::initMainMenu()
 {
-    EnterProc("MapGraphicsScene::initMainMenu");
+    EnterProcStart("MapGraphicsScene::initMainMenu");
 
     auto parentWidget = (QWidget*)this->parent();
     _mainMenu = new QMenu(parentWidget);
@@ -275,8 +275,7 @@ void MapGraphicsScene::initMainMenu()
     _acShowUAVPath = CommonWidgetUtils::createCheckableMenuSingleAction(tr("Show UAV Path"), true, submenuLegend);
     connect(_acShowUAVPath, &QAction::triggered, this, [=](bool checked)
     {
-        foreach(auto item, _allTrajectoryPathItems)
-            item->setVisible(checked);
+        _trajectory->setVisible(checked);
     });
 
     auto acClearUAVPath = CommonWidgetUtils::createMenuAction(tr("Clear UAV Path"), submenuLegend);
@@ -320,7 +319,7 @@ void MapGraphicsScene::setViewCenterXY(double x, double y)
 MapGraphicsScene::MapGraphicsScene(QObject *parent) :
     QGraphicsScene(parent)
 {    
-    EnterProc("MapGraphicsScene::MapGraphicsScene");
+    EnterProcStart("MapGraphicsScene::MapGraphicsScene");
 
     MarkerStorage& markerStorage = MarkerStorage::Instance();
     connect(&markerStorage, &MarkerStorage::onMapMarkerDeleted, this, &MapGraphicsScene::onMapMarkerDeleted);
@@ -332,6 +331,7 @@ MapGraphicsScene::MapGraphicsScene(QObject *parent) :
     _mapTileContainer = new MapTileContainer(this, applicationSettings.getMapDatabaseFiles(), applicationSettings.DatabaseMapDownloadCashe, applicationSettings.DatabaseHeightMap);
     _mapTileContainer->setCoordSystem(applicationSettings.UIPresentationCoordSystem);
     _mapTileContainer->setTileReceivingMode(TileReceivingMode(applicationSettings.TileReceivingMode.value()));
+    _mapTileContainer->setTileServerURL(applicationSettings.TileServerURL);
     _mapTileContainer->setMapBaseSourceId(MapBaseTileSource(applicationSettings.LastUsedMapBaseSourceId.value()));
     _mapTileContainer->setMapHybridSourceId(MapHybridTileSource(applicationSettings.LastUsedMapHybridSourceId.value()));
     connect(_mapTileContainer, &MapTileContainer::contentUpdated, this, &MapGraphicsScene::onMapContentUpdated, Qt::ConnectionType::QueuedConnection);
@@ -341,10 +341,10 @@ MapGraphicsScene::MapGraphicsScene(QObject *parent) :
     _visiblePathPointsDistance2 = 1.0 / 256.0 * applicationSettings.VisiblePathPointsPixelDistance.value();
     _visiblePathPointsDistance2 = _visiblePathPointsDistance2 * _visiblePathPointsDistance2;
 
-    _trajectoryPointsCount = 0;
     _trajectoryPen.setWidth(applicationSettings.TrajectoryPathLineWidth);
     _trajectoryPen.setColor(applicationSettings.TrajectoryPathLineColor);
     _trajectoryPen.setCosmetic(true);
+    _trajectory = new GSITrajectory(this, _trajectoryPen);
 
     // init UAV marker
     _uavMarker = new GSIUAVMarker(this);
@@ -377,7 +377,7 @@ MapGraphicsScene::~MapGraphicsScene()
 
 void MapGraphicsScene::drawBackground(QPainter *painter, const QRectF &rect)
 {
-    EnterProc("MapGraphicsScene::drawBackground");
+    EnterProcStart("MapGraphicsScene::drawBackground");
 
     auto coord = getSceneCoord(rect.center());
 
@@ -431,33 +431,13 @@ void MapGraphicsScene::addTrajectoryPoint(const WorldGPSCoord &pointCoords, bool
 {
     auto point = ConvertGPS2GoogleXY(pointCoords, DEFAULT_GOOGLE_SCALE_FOR_SCENE);
 
-    if (_trajectoryPointsCount == 0)
+    double dx = _prevPoint.x() - point.x();
+    double dy = _prevPoint.y() - point.y();
+
+    if (_trajectory->pointCount() == 0 || dx * dx + dy * dy >= _visiblePathPointsDistance2)
     {
-        _trajectoryPoints = new QPainterPath();
-        _trajectoryPathItem = this->addPath(*_trajectoryPoints, _trajectoryPen);
-        _allTrajectoryPathItems.append(_trajectoryPathItem);
-        _trajectoryPathItem->setZValue(DEFAULT_TRAJECTORY_Z_ORDER);
-        _trajectoryPoints->moveTo(point);
+        _trajectory->addPoint(point);
         _prevPoint = point;
-        _trajectoryPointsCount++;
-    }
-    else
-    {
-        double dx = _prevPoint.x() - point.x();
-        double dy = _prevPoint.y() - point.y();
-
-        if (dx * dx + dy * dy >= _visiblePathPointsDistance2)
-        {
-            _trajectoryPoints->lineTo(point);
-            _prevPoint = point;
-            _trajectoryPointsCount++;
-        }
-        if (_trajectoryPointsCount == 10000)
-        {
-            refreshTrajectoryOnMap();
-            _trajectoryPointsCount = 0;
-            addTrajectoryPoint(pointCoords, false);
-        }
     }
 
     if (immediateShow)
@@ -466,23 +446,17 @@ void MapGraphicsScene::addTrajectoryPoint(const WorldGPSCoord &pointCoords, bool
 
 void MapGraphicsScene::refreshTrajectoryOnMap()
 {
-    if (_trajectoryPointsCount > 0)
-        _trajectoryPathItem->setPath(*_trajectoryPoints);
+    _trajectory->refresh();
 }
 
 void MapGraphicsScene::clearTrajectory()
 {
-    foreach(auto item, _allTrajectoryPathItems)
-        this->removeItem(item);
-
-    _allTrajectoryPathItems.clear();
-    _trajectoryPointsCount = 0;
-    _trajectoryPathItem = nullptr;
+    _trajectory->clear();
 }
 
 void MapGraphicsScene::processTelemetry(const TelemetryDataFrame &telemetryFrame)
 {
-    EnterProc("MapGraphicsScene::processTelemetry");
+    EnterProcStart("MapGraphicsScene::processTelemetry");
 
     _telemetryFrame = telemetryFrame;
 
@@ -520,7 +494,7 @@ void MapGraphicsScene::showArealObjects(bool visible)
 
 void MapGraphicsScene::setViewCenter(const WorldGPSCoord &coord)
 {
-    EnterProc("MapGraphicsScene::setViewCenter");
+    EnterProcStart("MapGraphicsScene::setViewCenter");
     double x, y;
     ConvertGPS2GoogleXY(coord, DEFAULT_GOOGLE_SCALE_FOR_SCENE, x, y);
     setViewCenterXY(x, y);
@@ -553,7 +527,7 @@ void MapGraphicsScene::addMapMarkerToScene(MapMarker *mapMarker)
 
 void MapGraphicsScene::loadMapMarkers()
 {
-    EnterProc("MapGraphicsScene::loadMapMarkers");
+    EnterProcStart("MapGraphicsScene::loadMapMarkers");
     MarkerStorage& markerStorage = MarkerStorage::Instance();
     QList<MapMarker *> mapMarkers =  *(markerStorage.getMapMarkers());
     foreach (auto mapMarker, mapMarkers)
@@ -562,7 +536,7 @@ void MapGraphicsScene::loadMapMarkers()
 
 void MapGraphicsScene::loadArealObjects()
 {
-    EnterProc("MapGraphicsScene::loadArealObjects");
+    EnterProcStart("MapGraphicsScene::loadArealObjects");
     ArealObjectContainer& objectContainer = ArealObjectContainer::Instance();
     auto arealObjects = *(objectContainer.getArealObjects());
 
@@ -583,7 +557,7 @@ void MapGraphicsScene::loadArealObjects()
 
 void MapGraphicsScene::deleteSelectedMarkers()
 {
-    EnterProc("MapGraphicsScene::deleteSelectedMarkers");
+    EnterProcStart("MapGraphicsScene::deleteSelectedMarkers");
     auto selectedItems = this->selectedItems(); // get list of selected items
 
     if (selectedItems.count() == 0)
@@ -604,7 +578,7 @@ void MapGraphicsScene::deleteSelectedMarkers()
 
 void MapGraphicsScene::addNewMarker(const QPointF &posOnScene, const QString &markerTemplateGUID)
 {
-    EnterProc("MapGraphicsScene::addNewMarker");
+    EnterProcStart("MapGraphicsScene::addNewMarker");
 
     WorldGPSCoord coord = getSceneCoord(posOnScene);
     addNewMarker(coord, markerTemplateGUID);
@@ -612,7 +586,7 @@ void MapGraphicsScene::addNewMarker(const QPointF &posOnScene, const QString &ma
 
 void MapGraphicsScene::addNewMarker(const WorldGPSCoord &coord, const QString &markerTemplateGUID)
 {
-    EnterProc("MapGraphicsScene::addNewMarker");
+    EnterProcStart("MapGraphicsScene::addNewMarker");
     MarkerStorage& markerStorage = MarkerStorage::Instance();
     markerStorage.createNewMarker(markerTemplateGUID, coord);
 }
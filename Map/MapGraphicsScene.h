@@ -13,6 +13,7 @@
 #include "GSIUAVMarker.h"
 #include "GSIAntennaMarker.h"
 #include "GSITrackedObject.h"
+#include "GSITrajectory.h"
 #include "MapTileContainer.h"
 #include "MarkerStorage.h"
 
@@ -38,12 +39,9 @@ private:
     TelemetryDataFrame _telemetryFrame;
     int _scale;
     QPen _trajectoryPen;
-    QPainterPath *_trajectoryPoints;
-    int _trajectoryPointsCount;
     QPointF _prevPoint;
     qreal _visiblePathPointsDistance2;
-    QGraphicsPathItem  *_trajectoryPathItem;
-    QVector<QGraphicsPathItem  *> _allTrajectoryPathItems;
+    GSITrajectory *_trajectory;
     QVector<QGraphicsPolygonItem *> _allArealObjectItems;
     QVector<GSICommonObject*> _allMarkerItems;
 
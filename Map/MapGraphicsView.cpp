@@ -11,7 +11,7 @@ MapGraphicsScene *MapGraphicsView::mapScene()
 
 void MapGraphicsView::wheelEvent(QWheelEvent *event)
 {
-    EnterProc("MapGraphicsView::wheelEvent");
+    EnterProcStart("MapGraphicsView::wheelEvent");
 
     auto angleDalta = event->angleDelta();
 
@@ -46,7 +46,7 @@ void MapGraphicsView::mouseReleaseEvent(QMouseEvent *event)
 
 void MapGraphicsView::keyPressEvent(QKeyEvent *event)
 {
-    EnterProc("MapGraphicsView::keyPressEvent");
+    EnterProcStart("MapGraphicsView::keyPressEvent");
 
     auto scene = mapScene();
 
@@ -99,7 +99,7 @@ void MapGraphicsView::dragMoveEvent(QDragMoveEvent *event)
 
 void MapGraphicsView::dropEvent(QDropEvent *event)
 {
-    EnterProc("MapGraphicsView::dropEvent");
+    EnterProcStart("MapGraphicsView::dropEvent");
 
     if (event->mimeData()->hasFormat(MarkerTemplateMIMEFormat))
     {
@@ -117,7 +117,7 @@ void MapGraphicsView::dropEvent(QDropEvent *event)
 
 void MapGraphicsView::loadMapMarkers()
 {
-    EnterProc("MapGraphicsView::loadMapMarkers");
+    EnterProcStart("MapGraphicsView::loadMapMarkers");
 
     mapScene()->loadMapMarkers();
 }
@@ -129,7 +129,7 @@ void MapGraphicsView::loadArealObjects()
 
 MapGraphicsView::MapGraphicsView(QWidget * parent) : QGraphicsView(parent)
 {
-    EnterProc("MapGraphicsView::MapGraphicsView");
+    EnterProcStart("MapGraphicsView::MapGraphicsView");
 
     this->setRenderHint(QPainter::Antialiasing, false);
     this->setDragMode(QGraphicsView::ScrollHandDrag);
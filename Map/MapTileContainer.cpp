@@ -5,19 +5,20 @@
 #include <QSqlError>
 #include "EnterProc.h"
 #include "Common/CommonUtils.h"
+#include "Map/MapTilePack.h"
 
 quint32 TileDatabaseConnection::_databaseCounter = 0;
 
-const int UPPER_TILE_HASH_SIZE = 120;
-const int LOWER_TILE_HASH_SIZE = (UPPER_TILE_HASH_SIZE * 70) / 100;
-const int USING_TILE_HISTORY_DEPTH = 6;
-const int UNCOMMITED_TILES_MAX_COUNT = 50;
+const int TILE_CACHE_SIZE_MB = 128;
+const int MAX_TILE_UPSCALE_LEVEL = 6; // placeholder is made from 4x4 pixels at most
+const int UNSAVED_TILES_MAX_COUNT = 50;
+const int UNSAVED_TILES_MAX_DELAY_MS = 1000;
 
 void ConvertGoogleXY2GPS_2D(int scale, double x, double y, WorldGPSCoord &coord);
 
 void MapTileContainer::createTileDatabaseConnections(const QList<QString> &mapDatabaseFiles, const QString &downloadCasheDatabaseFile)
 {
-    EnterProc("MapTileContainer::createTileDatabaseConnections");
+    EnterProcStart("MapTileContainer::createTileDatabaseConnections");
 
 
     qInfo() << "Begin Create Tile Database Connections";
@@ -54,16 +55,16 @@ void MapTileContainer::createTileDatabaseConnections(const QList<QString> &mapDa
     else
         _downloadCasheDatabaseConnection = nullptr;
 
-    _lastSuccessfulConnection = nullptr;
-
     qInfo() << "End Create Tile Database Connections";
 }
 
 MapTileContainer::MapTileContainer(QObject *parent, const QList<QString> &mapDatabaseFiles, const QString &downloadCasheDatabaseFile, const QString &heightMapFile) : QObject(parent),
     _mapTileDownloader(this),
+    _mapTileLoader(this),
+    _tileCache(TILE_CACHE_SIZE_MB * 1024 * 1024),
     _heightMapContainer(this, heightMapFile)
 {
-    EnterProc("MapTileContainer::MapTileContainer");
+    EnterProcStart("MapTileContainer::MapTileContainer");
 
     qInfo() << "Begin Init Map Tile Container";
 
@@ -72,13 +73,19 @@ MapTileContainer::MapTileContainer(QObject *parent, const QList<QString> &mapDat
     _coordFormat = DegreeMinutesSecondsF; //todo move to settings
     _coordSystem = WGS84;
 
-    _usingCounter = 1;
     _mapBaseId = NoBaseTile;
     _mapHybridId = NoHybridTile;
     _scale = 12;
 
     connect(this, &MapTileContainer::needTile, &_mapTileDownloader, &MapTileDownloader::needTile, Qt::ConnectionType::QueuedConnection);
     connect(&_mapTileDownloader, &MapTileDownloader::tileReceived, this, &MapTileContainer::tileReceived, Qt::ConnectionType::QueuedConnection);
+    connect(&_mapTileLoader, &MapTileLoader::tileLoaded, this, &MapTileContainer::tileLoaded, Qt::ConnectionType::QueuedConnection);
+    connect(&_mapTileLoader, &MapTileLoader::tileDecoded, this, &MapTileContainer::tileDecoded, Qt::ConnectionType::QueuedConnection);
+    connect(&_mapTileDownloader, &MapTileDownloader::tileDropped, this, &MapTileContainer::tileDropped, Qt::ConnectionType::QueuedConnection);
+
+    _saveTilesTimer.setSingleShot(true);
+    _saveTilesTimer.setInterval(UNSAVED_TILES_MAX_DELAY_MS);
+    connect(&_saveTilesTimer, &QTimer::timeout, this, &MapTileContainer::saveDownloadedTiles);
 
     fillSourceInfos();
 
@@ -99,17 +106,13 @@ MapTileContainer::MapTileContainer(QObject *parent, const QList<QString> &mapDat
 
 MapTileContainer::~MapTileContainer()
 {
+    saveDownloadedTiles();
+
     delete _noTileImageBlack;
     delete _noTileImageTransparent;
     //delete _geoCoder;
 
-    auto i = _tileHash.begin();
-    while (i != _tileHash.end())
-    {
-        MapTile *tile = i.value();
-        i = _tileHash.erase(i);
-        delete tile;
-    }
+    _tileCache.clear();
 }
 
 void MapTileContainer::setImageCenterGPS(const WorldGPSCoord &screenCenter)
@@ -165,6 +168,16 @@ void MapTileContainer::setTileReceivingMode(TileReceivingMode mode)
     _tileReceivingMode = mode;
 }
 
+bool MapTileContainer::isNetworkReceivingMode() const
+{
+    return _tileReceivingMode == NetworkOnly || _tileReceivingMode == DatabaseAndNetwork;
+}
+
+void MapTileContainer::setTileServerURL(const QString &url)
+{
+    _mapTileDownloader.setTileServerURL(url);
+}
+
 void MapTileContainer::setMapBaseSourceId(MapBaseTileSource sourceId)
 {
     if (_mapBaseId == sourceId)
@@ -189,148 +202,220 @@ MapHybridTileSource MapTileContainer::getMapHybridSourceId() const
     return _mapHybridId;
 }
 
-void MapTileContainer::clenupTileHash()
+const QStringList MapTileContainer::getTileDatabaseFiles(int sourceId) const
 {
-    int tileHashSize = _tileHash.size();
-    if (tileHashSize > UPPER_TILE_HASH_SIZE)
+    QStringList databaseFiles;
+
+    if (_tileReceivingMode == DatabaseOnly || _tileReceivingMode == DatabaseAndNetwork)
     {
-        auto i = _tileHash.begin();
-        while ((i != _tileHash.end()) && (tileHashSize > LOWER_TILE_HASH_SIZE))
+        auto sourceInfo = _sourceInfos.value(sourceId);
+        if (sourceInfo != nullptr)
         {
-            MapTile *tile = i.value();
-            if (tile->lastUsing < _usingCounter - USING_TILE_HISTORY_DEPTH)
-            {
-                i = _tileHash.erase(i);
-                delete tile;
-                tileHashSize--;
-            }
-            else
-                ++i;
+            foreach (auto connection, *(sourceInfo->dbConnections()))
+                databaseFiles.append(connection->getFileName());
         }
     }
+    else if (_downloadCasheDatabaseConnection != nullptr)
+        databaseFiles.append(_downloadCasheDatabaseConnection->getFileName());
+
+    return databaseFiles;
 }
 
-QPixmap * MapTileContainer::getTileImage(int tileX, int tileY, int scale, int sourceId)
+QPixmap *MapTileContainer::createUpscaledTileImage(int tileX, int tileY, int scale, int sourceId)
 {
-    EnterProc("MapTileContainer::getTileImage");
+    if (isHybridTileSource(sourceId) || sourceId == MapBaseTileSource::KMLMap)
+        return nullptr;
 
-    MapTileHashValue tileHashValue = MapTile::calculateMapTileHash(sourceId, scale, tileX, tileY);
+    // Nearest upper tile which is already in the cache
+    for (int level = 1; level <= MAX_TILE_UPSCALE_LEVEL && scale - level >= MIN_ZOOM_VALUE; level++)
+    {
+        MapTileHashValue upperTileHashValue = MapTile::calculateMapTileHash(sourceId, scale - level, tileX >> level, tileY >> level);
+        MapTile *upperTile = _tileCache.object(upperTileHashValue);
+        if (upperTile == nullptr || !upperTile->deleteImageOnDestroy)
+            continue;
 
-    MapTile *tile = _tileHash.value(tileHashValue, nullptr);
-    if (tile != nullptr)
+        int tilesPerUpperTile = 1 << level;
+        int partWidth = TILE_WIDTH / tilesPerUpperTile;
+        int partHeight = TILE_HEIGHT / tilesPerUpperTile;
+        QRect partRect((tileX % tilesPerUpperTile) * partWidth, (tileY % tilesPerUpperTile) * partHeight, partWidth, partHeight);
+
+        auto resultTileImage = new QPixmap(TILE_WIDTH, TILE_HEIGHT);
+        QPainter painter;
+        painter.begin(resultTileImage);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.drawPixmap(QRect(0, 0, TILE_WIDTH, TILE_HEIGHT), *upperTile->image, partRect);
+        painter.end();
+        return resultTileImage;
+    }
+
+    return nullptr;
+}
+
+MapTile *MapTileContainer::storeMissingTile(int tileX, int tileY, int scale, int sourceId, bool isLoaded)
+{
+    QPixmap *resultTileImage = createUpscaledTileImage(tileX, tileY, scale, sourceId);
+
+    bool deleteImageOnDestroy = true;
+    if (resultTileImage == nullptr)
     {
-        if (tile->isEqual(sourceId, scale, tileX, tileY))
-        {
-            tile->lastUsing = _usingCounter;
-            return tile->image;
-        }
+        if (isHybridTileSource(sourceId))
+            resultTileImage = _noTileImageTransparent;
         else
-        {
-            _tileHash.remove(tileHashValue);
-            delete tile;
-        }
+            resultTileImage = _noTileImageBlack;
+        deleteImageOnDestroy = false;
     }
 
-    //Need Loading. Try to load tile from database
-    QPixmap * resultTileImage = nullptr;
+    auto tile = new MapTile(resultTileImage, deleteImageOnDestroy, isLoaded);
+    MapTileHashValue tileHashValue = MapTile::calculateMapTileHash(sourceId, scale, tileX, tileY);
+    _tileCache.insert(tileHashValue, tile, tile->cost());
+    return tile;
+}
 
-    //try to find cuccessful connection from presented in list
-    if (_tileReceivingMode == DatabaseOnly || _tileReceivingMode == DatabaseAndNetwork)
+void MapTileContainer::prefetchTile(int tileX, int tileY, int scale, int sourceId)
+{
+    int tileCount = 1 << scale;
+    if (tileX < 0 || tileY < 0 || tileX >= tileCount || tileY >= tileCount)
+        return;
+
+    MapTileHashValue tileHashValue = MapTile::calculateMapTileHash(sourceId, scale, tileX, tileY);
+    if (_tileCache.contains(tileHashValue))
     {
+        // The prefetch download is kept while the tile is around the visible area
+        if (isNetworkReceivingMode())
+            _mapTileDownloader.touchTile(tileHashValue);
+        return;
+    }
 
-        if (_lastSuccessfulConnection != nullptr)
-            resultTileImage = _lastSuccessfulConnection->getTileData(tileX, tileY, scale, sourceId);
-        if (resultTileImage == nullptr)
+    QStringList databaseFiles = getTileDatabaseFiles(sourceId);
+    if (databaseFiles.isEmpty())
+    {
+        if (isNetworkReceivingMode())
         {
-            auto sourceInfo = _sourceInfos.value(sourceId);
-            auto sourceConnections = *(sourceInfo->dbConnections());
-            foreach (auto connection, sourceConnections)
-            {
-                if (_lastSuccessfulConnection == connection)
-                    continue;
-
-                resultTileImage = connection->getTileData(tileX, tileY, scale, sourceId);
-                if (resultTileImage != nullptr)
-                {
-                    _lastSuccessfulConnection = connection;
-                    break; //foreach
-                }
-            }
+            // The placeholder is not loaded, so the tile is requested as visible when it is drawn
+            emit needTile(sourceId, scale, tileX, tileY, true);
+            storeMissingTile(tileX, tileY, scale, sourceId, false);
         }
+        return;
     }
-    else if (_downloadCasheDatabaseConnection != nullptr)
-        resultTileImage = _downloadCasheDatabaseConnection->getTileData(tileX, tileY, scale, sourceId);
 
+    if (_mapTileLoader.requestTile(tileHashValue, sourceId, scale, tileX, tileY, databaseFiles))
+        _prefetchTiles.insert(tileHashValue);
+}
 
-    //try to download tile
-    if ( (_tileReceivingMode == NetworkOnly || _tileReceivingMode == DatabaseAndNetwork) && (resultTileImage == nullptr) )
-        emit needTile(sourceId, scale, tileX, tileY);
+const QPixmap MapTileContainer::getTileImage(int tileX, int tileY, int scale, int sourceId)
+{
+    EnterProcStart("MapTileContainer::getTileImage");
 
-    //try to make tile from other scales
-    bool isHybridTile = isHybridTileSource(sourceId);
+    MapTileHashValue tileHashValue = MapTile::calculateMapTileHash(sourceId, scale, tileX, tileY);
+    _prefetchTiles.remove(tileHashValue);
+    // The download is kept while the tile is visible
+    if (isNetworkReceivingMode())
+        _mapTileDownloader.touchTile(tileHashValue);
 
-    if ((resultTileImage == nullptr) && (!isHybridTile) && (sourceId != MapBaseTileSource::KMLMap))
+    MapTile *tile = _tileCache.object(tileHashValue);
+    if (tile != nullptr && tile->isLoaded)
     {
-        if (scale > MIN_ZOOM_VALUE)
+        // Missing tile without upper tile in the cache, it can appear later
+        if (!tile->deleteImageOnDestroy)
         {
-            QPixmap * upperImage = getTileImage(tileX / 2, tileY / 2, scale - 1, sourceId);
-            if (upperImage != nullptr)
+            QPixmap *upscaledImage = createUpscaledTileImage(tileX, tileY, scale, sourceId);
+            if (upscaledImage != nullptr)
             {
-                QPixmap scaledImage = upperImage->scaled(TILE_WIDTH * 2, TILE_HEIGHT * 2, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-                int tilePosOnUpperX = (tileX % 2) * TILE_WIDTH;
-                int tilePosOnUpperY = (tileY % 2) * TILE_HEIGHT;
-                resultTileImage = new QPixmap(TILE_WIDTH, TILE_HEIGHT);
-                QPainter painter;
-                painter.begin(resultTileImage);
-                painter.drawPixmap(0, 0, scaledImage, tilePosOnUpperX, tilePosOnUpperY, TILE_WIDTH, TILE_HEIGHT);
-                painter.end();
+                tile = new MapTile(upscaledImage, true, true);
+                _tileCache.insert(tileHashValue, tile, tile->cost());
             }
         }
+        return *tile->image;
     }
 
-    bool deleteImageOnDestroy = true;
-    if (resultTileImage == nullptr)
+    //Need Loading. Tile is read and decoded by the loader, the placeholder is shown meanwhile
+    QStringList databaseFiles = getTileDatabaseFiles(sourceId);
+    if (databaseFiles.isEmpty())
     {
-        if (isHybridTile)
-            resultTileImage = _noTileImageTransparent;
-        else
-            resultTileImage = _noTileImageBlack;
-        deleteImageOnDestroy = false;
+        if (isNetworkReceivingMode())
+            emit needTile(sourceId, scale, tileX, tileY, false);
+        tile = storeMissingTile(tileX, tileY, scale, sourceId, true);
+        return *tile->image;
     }
 
-    MapTile *resultTile = new MapTile(sourceId, scale, tileX, tileY, resultTileImage, deleteImageOnDestroy);
-    resultTile->lastUsing = _usingCounter;
-    _tileHash.insert(tileHashValue, resultTile);
+    _mapTileLoader.requestTile(tileHashValue, sourceId, scale, tileX, tileY, databaseFiles);
 
-    return resultTile->image;
+    if (tile != nullptr)
+        return *tile->image;
+
+    QPixmap *placeholderImage = createUpscaledTileImage(tileX, tileY, scale, sourceId);
+    if (placeholderImage == nullptr)
+        return isHybridTileSource(sourceId) ? *_noTileImageTransparent : *_noTileImageBlack;
+
+    tile = new MapTile(placeholderImage, true, false);
+    _tileCache.insert(tileHashValue, tile, tile->cost());
+    return *placeholderImage;
 }
 
-void MapTileContainer::tileReceived(int sourceId, int scale, int x, int y, const QByteArray &tileImageRawData)
+void MapTileContainer::tileLoaded(int sourceId, int scale, int x, int y, const QImage &tileImage)
 {
-    QPixmap *tileImage = new QPixmap();
-    if (!tileImage->loadFromData(tileImageRawData))
-        return;
+    bool isPrefetch = _prefetchTiles.remove(MapTile::calculateMapTileHash(sourceId, scale, x, y));
 
-    MapTileHashValue tileHashValue = MapTile::calculateMapTileHash(sourceId, scale, x, y);
+    if (tileImage.isNull())
+    {
+        //try to download tile, the prefetched one is requested as visible when it is drawn
+        bool isDownloading = isNetworkReceivingMode();
+        if (isDownloading)
+            emit needTile(sourceId, scale, x, y, isPrefetch);
+        storeMissingTile(x, y, scale, sourceId, !(isDownloading && isPrefetch));
+    }
+    else
+    {
+        auto tile = new MapTile(new QPixmap(QPixmap::fromImage(tileImage)), true, true);
+        _tileCache.insert(MapTile::calculateMapTileHash(sourceId, scale, x, y), tile, tile->cost());
+    }
 
-    MapTile *tile = _tileHash.value(tileHashValue, nullptr);
-    if (tile != nullptr)
-        if (tile->isEqual(sourceId, scale, x, y))
-        {
-            _tileHash.remove(tileHashValue);
-            delete tile;
-        }
+    emit contentUpdated();
+}
 
-    tile = new MapTile(sourceId, scale, x, y, tileImage, true);
-    tile->lastUsing = _usingCounter;
-    _tileHash.insert(tileHashValue, tile);
+void MapTileContainer::tileDecoded(int sourceId, int scale, int x, int y, const QImage &tileImage, const QByteArray &tileImageRawData)
+{
+    // Damaged and unknown downloads are neither shown nor saved
+    if (tileImage.isNull())
+        return;
+
+    auto tile = new MapTile(new QPixmap(QPixmap::fromImage(tileImage)), true, true);
+    _tileCache.insert(MapTile::calculateMapTileHash(sourceId, scale, x, y), tile, tile->cost());
 
     if (_downloadCasheDatabaseConnection != nullptr)
-        _downloadCasheDatabaseConnection->saveTile(sourceId, scale, x, y, tileImageRawData);
+    {
+        _unsavedTiles.append({sourceId, scale, x, y, tileImageRawData});
+        if (_unsavedTiles.count() >= UNSAVED_TILES_MAX_COUNT)
+            saveDownloadedTiles();
+        else if (!_saveTilesTimer.isActive())
+            _saveTilesTimer.start();
+    }
 
     emit contentUpdated();
 }
 
+void MapTileContainer::tileDropped(int sourceId, int scale, int x, int y)
+{
+    // The placeholder is removed, so the tile is requested again when it is visible or prefetched
+    _tileCache.remove(MapTile::calculateMapTileHash(sourceId, scale, x, y));
+}
+
+void MapTileContainer::saveDownloadedTiles()
+{
+    _saveTilesTimer.stop();
+    if (_unsavedTiles.isEmpty() || _downloadCasheDatabaseConnection == nullptr)
+        return;
+
+    _downloadCasheDatabaseConnection->saveTiles(_unsavedTiles);
+    _unsavedTiles.clear();
+}
+
+void MapTileContainer::tileReceived(int sourceId, int scale, int x, int y, const QByteArray &tileImageRawData)
+{
+    // Validated and decoded by the loader threads, saved after decoding
+    _mapTileLoader.decodeTile(sourceId, scale, x, y, tileImageRawData);
+}
+
 // http://habrahabr.ru/post/233809/
 // http://wiki.openstreetmap.org/wiki/Slippy_map_tilenames
 void ConvertGPS2GoogleXY(WorldGPSCoord coord, int scale, double &x, double &y)
@@ -414,7 +499,6 @@ void MapTileContainer::drawTileLayerInternal(QPainter *imagePainter, int sourceI
     int tileY = (int)floor(centerY);
     int offsetX = (int)floor((centerX - tileX) * TILE_WIDTH);
     int offsetY = (int)floor((centerY - tileY) * TILE_HEIGHT);
-    _usingCounter++;
 
     int fromTileX = (int)ceil((double)tileX - (imageWidth / 2 - offsetX) / TILE_WIDTH - 1);
     int toTileX = (int)ceil((double)tileX + (imageWidth / 2 + offsetX) / TILE_WIDTH + 0);
@@ -436,11 +520,8 @@ void MapTileContainer::drawTileLayerInternal(QPainter *imagePainter, int sourceI
             if ((posY < -TILE_HEIGHT) || (posY >= imageHeight))
                 continue;
 
-            QPixmap * tileImage = getTileImage(i, j, scale, sourceId);
-            if (tileImage == nullptr)
-                tileImage = _noTileImageBlack;
-
-            imagePainter->drawPixmap(posX, posY, *tileImage);
+            const QPixmap tileImage = getTileImage(i, j, scale, sourceId);
+            imagePainter->drawPixmap(posX, posY, tileImage);
 
             if (drawTileNumber)
             {
@@ -452,6 +533,18 @@ void MapTileContainer::drawTileLayerInternal(QPainter *imagePainter, int sourceI
             }
         }  // for j
     } // for i
+
+    // Ring of tiles around the visible ones is loaded in advance for panning
+    for (int i = fromTileX - 1; i <= toTileX + 1; i++)
+    {
+        prefetchTile(i, fromTileY - 1, scale, sourceId);
+        prefetchTile(i, toTileY + 1, scale, sourceId);
+    }
+    for (int j = fromTileY; j <= toTileY; j++)
+    {
+        prefetchTile(fromTileX - 1, j, scale, sourceId);
+        prefetchTile(toTileX + 1, j, scale, sourceId);
+    }
 }
 
 
@@ -735,19 +828,21 @@ void MapTileContainer::fillSourceInfos()
 
 void MapTileContainer::getMapImageInternal(QPainter * imagePainter, const LegendPresentationParam &legendPresentationParam)
 {
-    EnterProc("MapTileContainer::GetMapImageInternal");
+    EnterProcStart("MapTileContainer::GetMapImageInternal");
 
     bool worldMatrixEnabled = imagePainter->worldMatrixEnabled();
 
     imagePainter->setWorldMatrixEnabled(false);
 
+    // Tiles that are out of sight since the previous drawing are not loaded or downloaded
+    _mapTileLoader.beginRequests();
+    _mapTileDownloader.beginRequests();
+
     drawTileLayer(imagePainter, _mapBaseId, legendPresentationParam.drawBaseTileNumber);
 
     if (_mapHybridId != NoHybridTile)
         drawTileLayer(imagePainter, _mapHybridId, false);
 
-    clenupTileHash();
-
     if (legendPresentationParam.drawLegend)
         drawLegend(imagePainter);
     if (legendPresentationParam.drawParallelsMeridians)
@@ -860,7 +955,7 @@ void MapTileContainer::convertGoogleXY2GPS(int scale, double x, double y, WorldG
 
 void TileDatabaseConnection::connectToDatabase()
 {
-    EnterProc("TileDatabaseConnection::connectToDatabase");
+    EnterProcStart("TileDatabaseConnection::connectToDatabase");
 
     qInfo() << "Connect to Database: " << _fileName;
 
@@ -882,10 +977,6 @@ void TileDatabaseConnection::connectToDatabase()
     EXEC_SQL(_tileDatabase, "CREATE INDEX IF NOT EXISTS TILE_SCALE_X_Y_SourceID ON MapTile (x, y, scale, sourceId)");
     //EXEC_SQL(_tileDatabase, "CREATE UNIQUE INDEX IF NOT EXISTS TILE_SCALE_X_Y_SourceID ON MapTile (x, y, scale, sourceId)");
 
-    _selectTileQuery = new QSqlQuery(_tileDatabase);
-    _selectTileQuery->prepare("SELECT tile, format FROM MapTile WHERE x=? AND y=? AND scale=? AND sourceId=?");
-    LOG_SQL_ERROR(_selectTileQuery);
-
 
     _insertTileQuery = new QSqlQuery(_tileDatabase);
     _insertTileQuery->prepare("INSERT INTO MapTile (x, y, scale, sourceId, format, autogenerated, datetime, signature, tile) " \
@@ -900,7 +991,7 @@ void TileDatabaseConnection::connectToDatabase()
 
 void TileDatabaseConnection::connectToKMLDatabase()
 {
-    EnterProc("TileDatabaseConnection::connectToKMLDatabase");
+    EnterProcStart("TileDatabaseConnection::connectToKMLDatabase");
 
     qInfo() << "Connect to KML Database: " << _fileName;
 
@@ -914,10 +1005,6 @@ void TileDatabaseConnection::connectToKMLDatabase()
 
     EXEC_SQL(_tileDatabase, "PRAGMA journal_mode = MEMORY");
 
-    _selectTileQuery = new QSqlQuery(_tileDatabase);
-    _selectTileQuery->prepare("SELECT image, 2 FROM Tiles WHERE x=? AND y=? AND z=? AND 11 = ?");
-    LOG_SQL_ERROR(_selectTileQuery);
-
     _insertTileQuery = nullptr;
 
     _supportedSources.clear();
@@ -927,9 +1014,22 @@ void TileDatabaseConnection::connectToKMLDatabase()
     LOG_SQL_ERROR(_tileDatabase);
 }
 
+void TileDatabaseConnection::connectToTilePack()
+{
+    EnterProcStart("TileDatabaseConnection::connectToTilePack");
+
+    qInfo() << "Connect to Tile Pack: " << _fileName;
+
+    // Tiles of the pack are read by the tile loader, the connection only tells the sources
+    _insertTileQuery = nullptr;
+
+    MapTilePack tilePack(_fileName);
+    _supportedSources = tilePack.sources();
+}
+
 void TileDatabaseConnection::processMapTileSources()
 {
-    EnterProc("TileDatabaseConnection::processMapTileSources");
+    EnterProcStart("TileDatabaseConnection::processMapTileSources");
 
     QSqlQuery sqlQuery = EXEC_SQL(_tileDatabase, "SELECT COUNT (*) FROM MapTileSources");
     if (sqlQuery.isSelect() && sqlQuery.next())
@@ -950,68 +1050,49 @@ void TileDatabaseConnection::processMapTileSources()
 
 TileDatabaseConnection::TileDatabaseConnection(QObject *parent, const QString &fileName) : QObject(parent)
 {
-    EnterProc("TileDatabaseConnection::TileDatabaseConnection");
+    EnterProcStart("TileDatabaseConnection::TileDatabaseConnection");
     _fileName = fileName;
-    _uncommitedTilesCount = 0;
     if (fileName.endsWith(".kml", Qt::CaseInsensitive))
         connectToKMLDatabase();
+    else if (MapTilePack::isTilePackFile(fileName))
+        connectToTilePack();
     else
         connectToDatabase();
 }
 
 TileDatabaseConnection::~TileDatabaseConnection()
 {
+    if (!_tileDatabase.isValid())
+        return;
+
     _tileDatabase.commit();
     LOG_SQL_ERROR(_tileDatabase);
-
-    delete _selectTileQuery;
 }
 
-QPixmap * TileDatabaseConnection::getTileData(int x, int y, int scale, int sourceId)
+bool TileDatabaseConnection::createUniqueTileIndex(const QSqlDatabase &database)
 {
-    EnterProc("TileDatabaseConnection::getTileData");
-    QPixmap * resultTileImage = nullptr;
-
-
-    if (sourceId == MapBaseTileSource::KMLMap)
-    {
-        _selectTileQuery->addBindValue(x);
-        _selectTileQuery->addBindValue(y);
-        _selectTileQuery->addBindValue(17 - scale);
-        _selectTileQuery->addBindValue(sourceId);
-    }
-    else
-    {
-        _selectTileQuery->addBindValue(x);
-        _selectTileQuery->addBindValue(y);
-        _selectTileQuery->addBindValue(scale);
-        _selectTileQuery->addBindValue(sourceId);
-    }
-
-
-    _selectTileQuery->exec();
-    LOG_SQL_ERROR(_selectTileQuery);
+    QSqlQuery query(database);
 
-    while (_selectTileQuery->next())
-    {
-        int pos = 0;
-
-        QByteArray imageBytes = _selectTileQuery->value(pos++).toByteArray();
-        int tileFormat = _selectTileQuery->value(pos++).toInt();
+    bool indexExists = false;
+    bool indexIsUnique = false;
+    if (query.exec("PRAGMA index_list(MapTile)"))
+        while (query.next())
+            if (query.value("name").toString() == "TILE_SCALE_X_Y_SourceID")
+            {
+                indexExists = true;
+                indexIsUnique = query.value("unique").toInt() != 0;
+            }
+    if (indexIsUnique)
+        return true;
 
-        if (tileFormat == MapTileImageFormat::ImageJPEG)
-        {
-            resultTileImage = new QPixmap();
-            resultTileImage->loadFromData(imageBytes, "JPEG");
-        }
-        else if (tileFormat == MapTileImageFormat::ImagePNG)
-        {
-            resultTileImage = new QPixmap();
-            resultTileImage->loadFromData(imageBytes, "PNG");
-        }
-    }
+    if (indexExists)
+        query.exec("DROP INDEX TILE_SCALE_X_Y_SourceID");
+    query.exec("DELETE FROM MapTile WHERE rowid NOT IN (SELECT MAX(rowid) FROM MapTile GROUP BY x, y, scale, sourceId)");
+    if (query.exec("CREATE UNIQUE INDEX TILE_SCALE_X_Y_SourceID ON MapTile (x, y, scale, sourceId)"))
+        return true;
 
-    return resultTileImage;
+    qWarning() << "Unique tile index failed:" << database.databaseName() << query.lastError().text();
+    return false;
 }
 
 QSet<int> &TileDatabaseConnection::getSupportedSources()
@@ -1024,62 +1105,53 @@ QString TileDatabaseConnection::getFileName()
     return _fileName;
 }
 
-void TileDatabaseConnection::saveTile(int sourceId, int scale, int x, int y, const QByteArray &tileImageRawData)
+void TileDatabaseConnection::saveTiles(const QList<DownloadedMapTile> &tiles)
 {
-    EnterProc("TileDatabaseConnection::saveTile");
-
-    int format;
+    EnterProcStart("TileDatabaseConnection::saveTiles");
 
-    if (tileImageRawData.startsWith("\x89\x50\x4E\x47\x0D\x0A\x1A\x0A"))
-        format = MapTileImageFormat::ImagePNG;
-    else if (tileImageRawData.startsWith("\xFF\xD8\xFF"))
-        format = MapTileImageFormat::ImageJPEG;
-    else
-    {
-        qDebug() << "Incorrect tile format: " << sourceId << scale << x << y;
+    if (_insertTileQuery == nullptr)
         return;
-    }
 
     bool autogenerated = false;
     double datetime = GetCurrentDateTimeForDB();
     int signature = 0;
 
-    _insertTileQuery->addBindValue(x);
-    _insertTileQuery->addBindValue(y);
-    _insertTileQuery->addBindValue(scale);
-    _insertTileQuery->addBindValue(sourceId);
-    _insertTileQuery->addBindValue(format);
-    _insertTileQuery->addBindValue(autogenerated);
-    _insertTileQuery->addBindValue(datetime);
-    _insertTileQuery->addBindValue(signature);
-    _insertTileQuery->addBindValue(tileImageRawData);
-
-    _insertTileQuery->exec();
-    LOG_SQL_ERROR(_insertTileQuery);
-
-    _uncommitedTilesCount++;
-
-    if (_uncommitedTilesCount >= UNCOMMITED_TILES_MAX_COUNT)
+    foreach (auto tile, tiles)
     {
-        _tileDatabase.commit();
-        LOG_SQL_ERROR(_tileDatabase);
-        _tileDatabase.transaction();
-        LOG_SQL_ERROR(_tileDatabase);
-        _uncommitedTilesCount = 0;
+        int format = MapTileLoader::tileImageFormat(tile.rawData);
+        if (format == 0)
+        {
+            qDebug() << "Incorrect tile format: " << tile.sourceId << tile.scale << tile.x << tile.y;
+            continue;
+        }
+
+        _insertTileQuery->addBindValue(tile.x);
+        _insertTileQuery->addBindValue(tile.y);
+        _insertTileQuery->addBindValue(tile.scale);
+        _insertTileQuery->addBindValue(tile.sourceId);
+        _insertTileQuery->addBindValue(format);
+        _insertTileQuery->addBindValue(autogenerated);
+        _insertTileQuery->addBindValue(datetime);
+        _insertTileQuery->addBindValue(signature);
+        _insertTileQuery->addBindValue(tile.rawData);
+
+        _insertTileQuery->exec();
+        LOG_SQL_ERROR(_insertTileQuery);
     }
+
+    _tileDatabase.commit();
+    LOG_SQL_ERROR(_tileDatabase);
+    _tileDatabase.transaction();
+    LOG_SQL_ERROR(_tileDatabase);
 }
 
 //-----------------------------------------------------------
 
-MapTile::MapTile(int tileSourceId, int tileScale, int tileX, int tileY, QPixmap *tileImage, bool deleteTileImageOnDestroy)
+MapTile::MapTile(QPixmap *tileImage, bool deleteTileImageOnDestroy, bool tileLoaded)
 {
-    x = tileX;
-    y = tileY;
-    scale = tileScale;
-    lastUsing = 0;
     image = tileImage;
-    sourceId = tileSourceId;
     deleteImageOnDestroy = deleteTileImageOnDestroy;
+    isLoaded = tileLoaded;
 }
 
 MapTile::~MapTile()
@@ -1088,18 +1160,20 @@ MapTile::~MapTile()
         delete image;
 }
 
-bool MapTile::isEqual(int tileSourceId, int tileScale, int tileX, int tileY)
+int MapTile::cost() const
 {
-    return (scale == tileScale) && (x == tileX) && (y == tileY) && (sourceId == tileSourceId);
+    if (!deleteImageOnDestroy)
+        return 1;
+    return image->width() * image->height() * qMax(1, image->depth() / 8);
 }
 
 MapTileHashValue MapTile::calculateMapTileHash(int sourceId, int scale, int x, int y)
 {
     MapTileHashValue value =
-        (sourceId & 0x000000FF) |       //0..7
-        ((scale & 0x0000001F) << 8) |   //8..12
-        ((x & 0x000003FF) << 13)|       //13..22
-        ((y & 0x000001FF) << 23);       //23..31
+        ((MapTileHashValue)sourceId & 0x00000000000000FF) |         //0..7
+        (((MapTileHashValue)scale & 0x000000000000001F) << 8) |     //8..12
+        (((MapTileHashValue)x & 0x0000000001FFFFFF) << 13) |        //13..37
+        (((MapTileHashValue)y & 0x0000000001FFFFFF) << 38);         //38..62
     return value;
 }
 
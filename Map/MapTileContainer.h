@@ -9,9 +9,12 @@
 #include <QPixmap>
 #include <QMultiMap>
 #include <QPointF>
+#include <QCache>
+#include <QTimer>
 #include "Common/CommonData.h"
 #include "Map/HeightMapContainer.h"
 #include "Map/MapTileDownloader.h"
+#include "Map/MapTileLoader.h"
 #include "Constants.h"
 
 // http://wiki.openstreetmap.org/wiki/Slippy_map_tilenames
@@ -26,7 +29,7 @@
 //http://habrahabr.ru/post/223449/ - формат файла SQLite
 // http://do.gendocs.ru/docs/index-80251.html - Номенклатура, бланковка, разграфка топографических карт
 
-#define MapTileHashValue quint32
+#define MapTileHashValue quint64
 
 constexpr int MIN_ZOOM_VALUE =  6;
 constexpr int MAX_ZOOM_VALUE = 20;
@@ -54,14 +57,14 @@ enum MapHybridTileSource
     GoogleHybrid    = 8
 };
 
+struct DownloadedMapTile final
+{
+    int sourceId, scale, x, y;
+    QByteArray rawData;
+};
+
 class TileDatabaseConnection final : public QObject
 {
-private:
-    enum MapTileImageFormat
-    {
-        ImageJPEG = 1,
-        ImagePNG = 2
-    };
 private:
     Q_OBJECT
 
@@ -70,20 +73,23 @@ private:
     QSet<int> _supportedSources;
     QString _fileName;
     QSqlDatabase _tileDatabase;
-    QSqlQuery *_selectTileQuery;
     QSqlQuery *_insertTileQuery;
-    quint32 _uncommitedTilesCount;
 
     void connectToDatabase();
     void connectToKMLDatabase();
+    void connectToTilePack();
     void processMapTileSources();
 public:
     TileDatabaseConnection(QObject *parent, const QString &fileName);
     ~TileDatabaseConnection();
-    QPixmap *getTileData(int x, int y, int scale, int sourceId);
     QSet<int> &getSupportedSources();
     QString getFileName();
-    void saveTile(int sourceId, int scale, int x, int y, const QByteArray &tileImageRawData);
+    // Tiles are written in one transaction
+    void saveTiles(const QList<DownloadedMapTile> &tiles);
+
+    // The map keeps a plain TILE_SCALE_X_Y_SourceID index, imports and exports need it unique to replace or skip tiles.
+    // The plain index is rebuilt, of the duplicated tiles the last written stays
+    static bool createUniqueTileIndex(const QSqlDatabase &database);
 };
 
 
@@ -107,18 +113,12 @@ public:
 
 struct MapTile final
 {
-private:
-    int x;
-    int y;
-    int scale;
-    int sourceId;
-    bool deleteImageOnDestroy;
-public:
-    unsigned long lastUsing;
     QPixmap *image;
-    MapTile(int tileSourceId, int tileScale, int tileX, int tileY, QPixmap *tileImage, bool deleteTileImageOnDestroy);
+    bool deleteImageOnDestroy;
+    bool isLoaded;  // false while the tile is loading and its image is a placeholder
+    MapTile(QPixmap *tileImage, bool deleteTileImageOnDestroy, bool tileLoaded);
     ~MapTile();
-    bool isEqual(int tileSourceId, int tileScale, int tileX, int tileY);
+    int cost() const;
     static MapTileHashValue calculateMapTileHash(int sourceId, int scale, int x, int y);
 };
 
@@ -136,16 +136,20 @@ private:
     QMap<int, MapTileSourceInfo *> _sourceInfos;
 
     TileDatabaseConnection *_downloadCasheDatabaseConnection;
-    TileDatabaseConnection *_lastSuccessfulConnection;
 
     MapTileDownloader _mapTileDownloader;
+    MapTileLoader _mapTileLoader;
 
     QPixmap * _noTileImageBlack;
     QPixmap * _noTileImageTransparent;
 
-    unsigned long _usingCounter;
+    // Key is tile hash, cost is image size in bytes
+    QCache<MapTileHashValue, MapTile> _tileCache;
+    QSet<MapTileHashValue> _prefetchTiles;          // loading around the visible area
 
-    QHash<MapTileHashValue, MapTile*> _tileHash;
+    // Downloaded tiles are written to the download cache in batches
+    QList<DownloadedMapTile> _unsavedTiles;
+    QTimer _saveTilesTimer;
     TileReceivingMode _tileReceivingMode;
 
     int _lastTileIndex;
@@ -159,8 +163,12 @@ private:
 
     void setImageCenterGPS(const WorldGPSCoord &screenCenter);
 
-    QPixmap *getTileImage(int tileX, int tileY, int scale, int sourceId);
-    void clenupTileHash();
+    const QPixmap getTileImage(int tileX, int tileY, int scale, int sourceId);
+    const QStringList getTileDatabaseFiles(int sourceId) const;
+    QPixmap *createUpscaledTileImage(int tileX, int tileY, int scale, int sourceId);
+    MapTile *storeMissingTile(int tileX, int tileY, int scale, int sourceId, bool isLoaded);
+    void prefetchTile(int tileX, int tileY, int scale, int sourceId);
+    bool isNetworkReceivingMode() const;
 
     int calculateScaleMaxWidth(double resolution, QString &middleLabelText, QString &maxLabelText);
 
@@ -177,10 +185,14 @@ private:
 
     WorldGPSCoord convertScreenXY2GPS_2D(int screenCenterDx, int screenCenterDy) const;
 signals:
-    void needTile(int sourceId, int scale, int x, int y);
+    void needTile(int sourceId, int scale, int x, int y, bool isPrefetch);
     void contentUpdated();
 private slots:
     void tileReceived(int sourceId, int scale, int x, int y, const QByteArray &tileImageRawData);
+    void tileLoaded(int sourceId, int scale, int x, int y, const QImage &tileImage);
+    void tileDecoded(int sourceId, int scale, int x, int y, const QImage &tileImage, const QByteArray &tileImageRawData);
+    void tileDropped(int sourceId, int scale, int x, int y);
+    void saveDownloadedTiles();
 protected:
     HeightMapContainer  _heightMapContainer;
     virtual void getMapImageInternal(QPainter *imagePainter, const LegendPresentationParam &legendPresentationParam);
@@ -195,6 +207,7 @@ public:
     void setCoordSystem(GlobalCoordSystem coordSystem);
     GlobalCoordSystem getCoordSystem() const;
     void setTileReceivingMode(TileReceivingMode mode);
+    void setTileServerURL(const QString &url);
 
 
     void getMapImage(QPainter *painter, const LegendPresentationParam &legendPresentationParam);
@@ -1,11 +1,20 @@
 #include "MapTileDownloader.h"
 #include <QNetworkRequest>
+#include <QTimer>
+#include <QDebug>
 #include "Map/MapTileContainer.h"
 #include "Common/CommonUtils.h"
 
+constexpr int DOWNLOAD_MAX_ATTEMPTS = 3;
+constexpr int DOWNLOAD_RETRY_BASE_DELAY_MS = 500;   // doubled on every attempt
+constexpr int DOWNLOAD_TRANSFER_TIMEOUT_MS = 15000;
+
 MapTileDownloader::MapTileDownloader(QObject *parent) : QObject(parent),
     _accessManager(this),
-    _totalDownloads(0)
+    _requestPass(0),
+    _totalDownloads(0),
+    _successDownloads(0),
+    _droppedDownloads(0)
 {
     connect(&_accessManager, &QNetworkAccessManager::finished, this, &MapTileDownloader::tileDownloaded, Qt::ConnectionType::QueuedConnection);
     _supportedSources << WikiMap << YandexSatellite << YandexMap << YandexHybrid << BingSatellite << GoogleHybrid << GoogleSatellite;
@@ -16,6 +25,11 @@ QSet<int> &MapTileDownloader::getSupportedSources()
     return _supportedSources;
 }
 
+void MapTileDownloader::setTileServerURL(const QString &url)
+{
+    _tileServerURL = url.trimmed();
+}
+
 int fakeRandom(int base, int low, int high) // fake random is used to duplicate the same url for repeated tile requrest
 {
     return (base % ((high + 1) - low) + low);
@@ -43,8 +57,17 @@ QString TileXYToQuadKey(int tileX, int tileY, int levelOfDetail)
     return quadKey;
 }
 
-void MapTileDownloader::needTile(int sourceId, int scale, int x, int y)
+const QString MapTileDownloader::tileURL(int sourceId, int scale, int x, int y) const
 {
+    if (!_tileServerURL.isEmpty())
+    {
+        return QString(_tileServerURL)
+                .replace("{source}", QString::number(sourceId))
+                .replace("{z}", QString::number(scale))
+                .replace("{x}", QString::number(x))
+                .replace("{y}", QString::number(y));
+    }
+
     QString url;
     int base = x + y + scale + sourceId;
 
@@ -128,31 +151,188 @@ void MapTileDownloader::needTile(int sourceId, int scale, int x, int y)
     }
     }
 
-    if (!url.isEmpty() && !_downloads.contains(url))
+    // https://wiki.openstreetmap.org/wiki/Tile_servers
+    // url = "http://a.tile.openstreetmap.fr/hot/4/5/5.png";
+    return url;
+}
+
+void MapTileDownloader::beginRequests()
+{
+    _requestPass++;
+
+    // Tiles that were neither drawn nor prefetched during the last pass are not downloaded anymore
+    QList<QNetworkReply *> staleReplies;
+    for (auto i = _activeReplies.constBegin(); i != _activeReplies.constEnd(); ++i)
+        if (isStale(_downloads[i.value()]))
+            staleReplies.append(i.key());
+
+    QSet<int> sourceIds;
+    foreach (auto networkReply, staleReplies)
+    {
+        quint64 tileKey = _activeReplies.take(networkReply);
+        int sourceId = _downloads[tileKey].tile.sourceId;
+        _sourceQueues[sourceId].activeCount--;
+        sourceIds.insert(sourceId);
+        dropDownload(tileKey);
+        networkReply->abort();
+    }
+
+    foreach (int sourceId, sourceIds)
+        startDownloads(sourceId);
+}
+
+void MapTileDownloader::touchTile(quint64 tileKey)
+{
+    auto i = _downloads.find(tileKey);
+    if (i != _downloads.end())
+        i->requestPass = _requestPass;
+}
+
+bool MapTileDownloader::isStale(const TileDownload &download) const
+{
+    return download.requestPass + 1 < _requestPass;
+}
+
+void MapTileDownloader::dropDownload(quint64 tileKey)
+{
+    const TileDownload &download = _downloads[tileKey];
+    _droppedDownloads++;
+    emit tileDropped(download.tile.sourceId, download.tile.scale, download.tile.x, download.tile.y);
+    _downloads.remove(tileKey);
+}
+
+void MapTileDownloader::needTile(int sourceId, int scale, int x, int y, bool isPrefetch)
+{
+    quint64 tileKey = MapTile::calculateMapTileHash(sourceId, scale, x, y);
+
+    auto i = _downloads.find(tileKey);
+    if (i != _downloads.end())
     {
-        TileAttributes tileAttr = {sourceId, x, y, scale};
-        _downloads.insert(url, tileAttr);
+        i->requestPass = _requestPass;
 
-        QNetworkRequest request(url);
-        _accessManager.get(request);
+        // Prefetched tile became visible, it goes before the other prefetched tiles
+        if (i->isPrefetch && !isPrefetch)
+        {
+            i->isPrefetch = false;
+            SourceQueue &queue = _sourceQueues[sourceId];
+            if (queue.prefetchTiles.removeOne(tileKey))
+                queue.visibleTiles.append(tileKey);
+        }
+        return;
+    }
+
+    QString url = tileURL(sourceId, scale, x, y);
+    if (url.isEmpty())
+        return;
+
+    TileDownload download = {{sourceId, x, y, scale}, url, isPrefetch, 0, _requestPass, false};
+    _downloads.insert(tileKey, download);
+    enqueueDownload(tileKey, false);
+    startDownloads(sourceId);
+}
+
+void MapTileDownloader::enqueueDownload(quint64 tileKey, bool toFront)
+{
+    const TileDownload &download = _downloads[tileKey];
+    SourceQueue &queue = _sourceQueues[download.tile.sourceId];
+    QList<quint64> &tiles = download.isPrefetch ? queue.prefetchTiles : queue.visibleTiles;
+    if (toFront)
+        tiles.prepend(tileKey);
+    else
+        tiles.append(tileKey);
+}
+
+bool MapTileDownloader::takeNextDownload(SourceQueue &queue, quint64 &tileKey)
+{
+    for (QList<quint64> *tiles : {&queue.visibleTiles, &queue.prefetchTiles})
+    {
+        while (!tiles->isEmpty())
+        {
+            tileKey = tiles->takeFirst();
+            if (!isStale(_downloads[tileKey]))
+                return true;
+
+            // Out of sight since the last pass, the tile is requested again when it is visible or prefetched
+            dropDownload(tileKey);
+        }
+    }
+
+    return false;
+}
+
+void MapTileDownloader::startDownloads(int sourceId)
+{
+    SourceQueue &queue = _sourceQueues[sourceId];
+
+    quint64 tileKey;
+    while (queue.activeCount < MAX_SOURCE_CONCURRENCY && takeNextDownload(queue, tileKey))
+    {
+        TileDownload &download = _downloads[tileKey];
+        download.isActive = true;
+        download.attempt++;
+        queue.activeCount++;
+
+        QNetworkRequest request(download.url);
+        request.setTransferTimeout(DOWNLOAD_TRANSFER_TIMEOUT_MS);
+        if (download.isPrefetch)
+            request.setPriority(QNetworkRequest::LowPriority);
+        _activeReplies.insert(_accessManager.get(request), tileKey);
     }
-    // https://wiki.openstreetmap.org/wiki/Tile_servers
-    // url = "http://a.tile.openstreetmap.fr/hot/4/5/5.png";
 }
 
 void MapTileDownloader::tileDownloaded(QNetworkReply *networkReply)
 {
+    networkReply->deleteLater();
+
+    // Aborted as stale, the tile can be requested again already
+    auto reply = _activeReplies.find(networkReply);
+    if (reply == _activeReplies.end())
+        return;
+
     _totalDownloads++;
+    quint64 tileKey = reply.value();
+    _activeReplies.erase(reply);
+    auto i = _downloads.find(tileKey);
+    if (i == _downloads.end())
+        return;
+
+    TileDownload &download = i.value();
+    download.isActive = false;
+    int sourceId = download.tile.sourceId;
+    _sourceQueues[sourceId].activeCount--;
 
-    QString url = networkReply->request().url().toString();
-    if (_downloads.contains(url))
+    int httpStatus = networkReply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    auto error = networkReply->error();
+    if (error == QNetworkReply::NoError)
     {
-        TileAttributes tileAttr = _downloads[url];
-        _downloads.remove(url);
+        _successDownloads++;
         QByteArray data = networkReply->readAll();
-
-        emit tileReceived(tileAttr.sourceId, tileAttr.scale, tileAttr.x, tileAttr.y, data);
+        emit tileReceived(download.tile.sourceId, download.tile.scale, download.tile.x, download.tile.y, data);
+        _downloads.erase(i);
+    }
+    else
+    {
+        // Missing tiles are not repeated, overloaded and unreachable servers are. Stale downloads are aborted after
+        // they are taken from the active replies, so a canceled reply here ran into the transfer timeout
+        bool isTransient = httpStatus == 429 || httpStatus >= 500 ||
+                (httpStatus == 0 && error != QNetworkReply::ContentNotFoundError);
+        if (isTransient && download.attempt < DOWNLOAD_MAX_ATTEMPTS)
+        {
+            int delayMs = DOWNLOAD_RETRY_BASE_DELAY_MS << (download.attempt - 1);
+            QTimer::singleShot(delayMs, this, [this, tileKey, sourceId]()
+            {
+                if (!_downloads.contains(tileKey))
+                    return;
+                enqueueDownload(tileKey, true);
+                startDownloads(sourceId);
+            });
+        }
+        else
+        {
+            qDebug() << "Tile download failed:" << download.url << httpStatus << networkReply->errorString();
+            _downloads.erase(i);
+        }
     }
 
-    networkReply->deleteLater();
+    startDownloads(sourceId);
 }
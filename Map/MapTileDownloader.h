@@ -5,7 +5,8 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QPixmap>
-#include <QMap>
+#include <QHash>
+#include <QList>
 #include <QSet>
 
 struct TileAttributes
@@ -13,22 +14,65 @@ struct TileAttributes
     int sourceId, x, y, scale;
 };
 
+// Downloads are scheduled per source with limited concurrency: visible tiles first, then prefetched ones.
+// Tiles that were neither drawn nor prefetched during the last drawing pass are dropped before downloading
+// and their active downloads are aborted, failed downloads are repeated with backoff
 class MapTileDownloader final : public QObject
 {
     Q_OBJECT
 private:
+    struct TileDownload final
+    {
+        TileAttributes tile;
+        QString url;
+        bool isPrefetch;
+        int attempt;
+        quint32 requestPass;    // the last drawing pass when the tile was visible or prefetched
+        bool isActive;
+    };
+
+    struct SourceQueue final
+    {
+        QList<quint64> visibleTiles;
+        QList<quint64> prefetchTiles;
+        int activeCount;
+
+        SourceQueue() : activeCount(0) {}
+    };
+
     QNetworkAccessManager _accessManager;
-    QMap<QString, TileAttributes> _downloads;
-    quint32 _totalDownloads, _successDownloads;
+    QHash<quint64, TileDownload> _downloads;        // queued, active and waiting for a retry
+    QHash<int, SourceQueue> _sourceQueues;
+    QHash<QNetworkReply *, quint64> _activeReplies;
+    quint32 _requestPass;
+    QString _tileServerURL;
+    quint32 _totalDownloads, _successDownloads, _droppedDownloads;
 
     QSet<int> _supportedSources;
+
+    const QString tileURL(int sourceId, int scale, int x, int y) const;
+    bool isStale(const TileDownload &download) const;
+    void dropDownload(quint64 tileKey);
+    bool takeNextDownload(SourceQueue &queue, quint64 &tileKey);
+    void startDownloads(int sourceId);
+    void enqueueDownload(quint64 tileKey, bool toFront);
 public:
+    static const int MAX_SOURCE_CONCURRENCY = 4;
+
     explicit MapTileDownloader(QObject *parent);
     QSet<int> &getSupportedSources();
+
+    // Template like http://127.0.0.1:8090/{source}/{z}/{x}/{y} replaces the URLs of all sources
+    void setTileServerURL(const QString &url);
+
+    void beginRequests();
+    void touchTile(quint64 tileKey);
 signals:
     void tileReceived(int sourceId, int scale, int x, int y, const QByteArray &tileImageRawData);
+    // Visible or prefetched tile went out of sight before it was downloaded
+    void tileDropped(int sourceId, int scale, int x, int y);
 public slots:
-    void needTile(int sourceId, int scale, int x, int y);
+    void needTile(int sourceId, int scale, int x, int y, bool isPrefetch);
 private slots:
     void tileDownloaded(QNetworkReply* networkReply);
 };
@@ -144,6 +144,7 @@ MapTileExportDialog::MapTileExportDialog(QWidget *parent, MapTileContainer *mapT
     connect(_progressDlg, &QProgressDialog::canceled, &_mapTilesExporter, &MapTilesExporter::cancelExport);
 
     connect(&_mapTilesExporter, &MapTilesExporter::exportProcessChanged, this, &MapTileExportDialog::onExportProcessChanged);
+    connect(&_mapTilesExporter, &MapTilesExporter::exportStatisticsChanged, this, &MapTileExportDialog::onExportStatisticsChanged);
     connect(&_mapTilesExporter, &MapTilesExporter::exportProcessEnded, this, &MapTileExportDialog::onExportProcessEnded);
 
     initWidgets();
@@ -222,6 +223,13 @@ void MapTileExportDialog::onExportProcessChanged(double processedPrecent)
     _progressDlg->setValue(ceil(processedPrecent));
 }
 
+void MapTileExportDialog::onExportStatisticsChanged(qint64 exportedTiles, qint64 exportedBytes)
+{
+    _progressDlg->setLabelText(QString(tr("Exported %1 tiles, %2 MB"))
+                               .arg(exportedTiles)
+                               .arg(exportedBytes / (1024.0 * 1024.0), 0, 'f', 1));
+}
+
 void MapTileExportDialog::onExportProcessEnded()
 {
     _progressDlg->close();
@@ -260,5 +268,6 @@ void MapTileExportDialog::runExport()
 
     _exportButton->setEnabled(false);
     _progressDlg->reset();
+    _progressDlg->setLabelText(tr("Export in progress..."));
     _mapTilesExporter.RunExport(targetDatabaseFileName);
 }
@@ -46,6 +46,7 @@ private slots:
     void onRightBottomCoordSelectorChanged(const WorldGPSCoord &gpsCoord, const QString &description);
 
     void onExportProcessChanged(double processedPrecent);
+    void onExportStatisticsChanged(qint64 exportedTiles, qint64 exportedBytes);
     void onExportProcessEnded();
 };
 
@@ -0,0 +1,200 @@
+#include "MapTileLoader.h"
+#include <QThread>
+#include <QMutexLocker>
+#include <QDebug>
+#include "Common/CommonUtils.h"
+
+const int LOADER_MAX_THREAD_COUNT = 4;
+const int LOADER_DATABASE_BUSY_TIMEOUT_MS = 1000;
+
+MapTileReaderConnections::~MapTileReaderConnections()
+{
+    QStringList connectionNames;
+    foreach (auto connection, _connections)
+    {
+        delete connection.selectTileQuery;
+        connectionNames.append(connection.name);
+    }
+    _connections.clear();
+
+    foreach (auto connectionName, connectionNames)
+        QSqlDatabase::removeDatabase(connectionName);
+}
+
+QSqlQuery *MapTileReaderConnections::selectTileQuery(const QString &fileName)
+{
+    auto i = _connections.constFind(fileName);
+    if (i != _connections.constEnd())
+        return i->selectTileQuery;
+
+    Connection connection;
+    connection.name = QString("TileReader_%1_%2").arg((quintptr)QThread::currentThreadId()).arg(_connections.count());
+
+    QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connection.name);
+    database.setDatabaseName(fileName);
+    database.setConnectOptions(QString("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=%1").arg(LOADER_DATABASE_BUSY_TIMEOUT_MS));
+    if (!database.open())
+        qWarning() << "Unable to open map database" << fileName << "for reading";
+
+    connection.selectTileQuery = new QSqlQuery(database);
+    if (fileName.endsWith(".kml", Qt::CaseInsensitive))
+        connection.selectTileQuery->prepare("SELECT image, 2 FROM Tiles WHERE x=? AND y=? AND z=? AND 11 = ?");
+    else
+        connection.selectTileQuery->prepare("SELECT tile, format FROM MapTile WHERE x=? AND y=? AND scale=? AND sourceId=?");
+
+    _connections.insert(fileName, connection);
+    return connection.selectTileQuery;
+}
+
+//-----------------------------------------------------------
+
+MapTileLoader::MapTileLoader(QObject *parent) : QObject(parent)
+{
+    _threadPool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, LOADER_MAX_THREAD_COUNT));
+    // Database connections belong to the loader threads, they are kept until the loader is destroyed
+    _threadPool.setExpiryTimeout(-1);
+}
+
+MapTileLoader::~MapTileLoader()
+{
+    {
+        QMutexLocker locker(&_requestsMutex);
+        _queuedTiles.clear();
+        _staleTiles.clear();
+    }
+    _threadPool.clear();
+    _threadPool.waitForDone();
+
+    qDeleteAll(_tilePacks);
+    _tilePacks.clear();
+}
+
+void MapTileLoader::beginRequests()
+{
+    QMutexLocker locker(&_requestsMutex);
+    _staleTiles = _queuedTiles;
+    _queuedTiles.clear();
+}
+
+bool MapTileLoader::requestTile(quint64 tileKey, int sourceId, int scale, int x, int y, const QStringList &databaseFiles)
+{
+    QMutexLocker locker(&_requestsMutex);
+
+    if (_queuedTiles.contains(tileKey) || _loadingTiles.contains(tileKey))
+        return false;
+
+    // The loading job from the previous pass is still queued
+    if (_staleTiles.remove(tileKey))
+    {
+        _queuedTiles.insert(tileKey);
+        return false;
+    }
+
+    _queuedTiles.insert(tileKey);
+    _threadPool.start([this, tileKey, sourceId, scale, x, y, databaseFiles]()
+    {
+        if (takeQueuedTile(tileKey))
+            loadTile(tileKey, sourceId, scale, x, y, databaseFiles);
+    });
+    return true;
+}
+
+bool MapTileLoader::takeQueuedTile(quint64 tileKey)
+{
+    QMutexLocker locker(&_requestsMutex);
+
+    bool isRequested = _queuedTiles.remove(tileKey);
+    _staleTiles.remove(tileKey);
+    if (isRequested)
+        _loadingTiles.insert(tileKey);
+    return isRequested;
+}
+
+MapTilePack *MapTileLoader::tilePack(const QString &fileName)
+{
+    QMutexLocker locker(&_tilePacksMutex);
+
+    auto i = _tilePacks.constFind(fileName);
+    if (i != _tilePacks.constEnd())
+        return i.value();
+
+    auto pack = new MapTilePack(fileName);
+    _tilePacks.insert(fileName, pack);
+    return pack;
+}
+
+void MapTileLoader::loadTile(quint64 tileKey, int sourceId, int scale, int x, int y, const QStringList &databaseFiles)
+{
+    if (!_readerConnections.hasLocalData())
+        _readerConnections.setLocalData(new MapTileReaderConnections());
+    MapTileReaderConnections *connections = _readerConnections.localData();
+
+    QImage tileImage;
+    foreach (auto fileName, databaseFiles)
+    {
+        if (MapTilePack::isTilePackFile(fileName))
+        {
+            QByteArray tileImageRawData;
+            int tileFormat;
+            if (tilePack(fileName)->findTile(sourceId, scale, x, y, tileImageRawData, tileFormat))
+                tileImage = decodeTileImage(tileImageRawData, tileFormat);
+
+            if (!tileImage.isNull())
+                break;
+            continue;
+        }
+
+        QSqlQuery *selectTileQuery = connections->selectTileQuery(fileName);
+
+        bool isKML = fileName.endsWith(".kml", Qt::CaseInsensitive);
+        selectTileQuery->addBindValue(x);
+        selectTileQuery->addBindValue(y);
+        selectTileQuery->addBindValue(isKML ? 17 - scale : scale);
+        selectTileQuery->addBindValue(sourceId);
+
+        selectTileQuery->exec();
+        LOG_SQL_ERROR(selectTileQuery);
+
+        while (tileImage.isNull() && selectTileQuery->next())
+            tileImage = decodeTileImage(selectTileQuery->value(0).toByteArray(), selectTileQuery->value(1).toInt());
+        selectTileQuery->finish();
+
+        if (!tileImage.isNull())
+            break;
+    }
+
+    {
+        QMutexLocker locker(&_requestsMutex);
+        _loadingTiles.remove(tileKey);
+    }
+
+    emit tileLoaded(sourceId, scale, x, y, tileImage);
+}
+
+void MapTileLoader::decodeTile(int sourceId, int scale, int x, int y, const QByteArray &tileImageRawData)
+{
+    _threadPool.start([this, sourceId, scale, x, y, tileImageRawData]()
+    {
+        QImage tileImage = decodeTileImage(tileImageRawData, tileImageFormat(tileImageRawData));
+        emit tileDecoded(sourceId, scale, x, y, tileImage, tileImageRawData);
+    });
+}
+
+const QImage MapTileLoader::decodeTileImage(const QByteArray &tileImageRawData, int tileFormat)
+{
+    QImage tileImage;
+    if (tileFormat == MapTileImageFormat::ImageJPEG)
+        tileImage.loadFromData(tileImageRawData, "JPEG");
+    else if (tileFormat == MapTileImageFormat::ImagePNG)
+        tileImage.loadFromData(tileImageRawData, "PNG");
+    return tileImage;
+}
+
+int MapTileLoader::tileImageFormat(const QByteArray &tileImageRawData)
+{
+    if (tileImageRawData.startsWith("\x89\x50\x4E\x47\x0D\x0A\x1A\x0A"))
+        return MapTileImageFormat::ImagePNG;
+    if (tileImageRawData.startsWith("\xFF\xD8\xFF"))
+        return MapTileImageFormat::ImageJPEG;
+    return 0;
+}
@@ -0,0 +1,76 @@
+#ifndef MAPTILELOADER_H
+#define MAPTILELOADER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QMutex>
+#include <QSet>
+#include <QHash>
+#include <QImage>
+#include <QStringList>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include "Map/MapTilePack.h"
+
+enum MapTileImageFormat
+{
+    ImageJPEG = 1,
+    ImagePNG = 2
+};
+
+// Read-only connections to the map databases owned by a single loader thread
+class MapTileReaderConnections final
+{
+    struct Connection
+    {
+        QString name;
+        QSqlQuery *selectTileQuery;
+    };
+    QHash<QString, Connection> _connections;
+public:
+    ~MapTileReaderConnections();
+    QSqlQuery *selectTileQuery(const QString &fileName);
+};
+
+// Reads tiles from the map databases and decodes them on a thread pool, so the GUI thread never waits for them.
+// Requests that were not repeated during the last drawing pass are dropped before loading.
+class MapTileLoader final : public QObject
+{
+    Q_OBJECT
+
+    QThreadStorage<MapTileReaderConnections *> _readerConnections;
+    QThreadPool _threadPool;
+
+    // Tile packs are mapped once and shared by the loader threads
+    QMutex _tilePacksMutex;
+    QHash<QString, MapTilePack *> _tilePacks;
+
+    QMutex _requestsMutex;
+    QSet<quint64> _queuedTiles;     // requested during the current drawing pass
+    QSet<quint64> _staleTiles;      // requested during the previous drawing pass only
+    QSet<quint64> _loadingTiles;
+
+    bool takeQueuedTile(quint64 tileKey);
+    MapTilePack *tilePack(const QString &fileName);
+    void loadTile(quint64 tileKey, int sourceId, int scale, int x, int y, const QStringList &databaseFiles);
+public:
+    explicit MapTileLoader(QObject *parent);
+    ~MapTileLoader();
+
+    void beginRequests();
+    // Files are searched in the given order. Returns false when the tile is already queued or loading
+    bool requestTile(quint64 tileKey, int sourceId, int scale, int x, int y, const QStringList &databaseFiles);
+    void decodeTile(int sourceId, int scale, int x, int y, const QByteArray &tileImageRawData);
+
+    static const QImage decodeTileImage(const QByteArray &tileImageRawData, int tileFormat);
+    // MapTileImageFormat by the data signature, 0 for unknown data
+    static int tileImageFormat(const QByteArray &tileImageRawData);
+signals:
+    // Null image means the tile was not found in any database
+    void tileLoaded(int sourceId, int scale, int x, int y, const QImage &tileImage);
+    // Null image means the data is not a valid tile
+    void tileDecoded(int sourceId, int scale, int x, int y, const QImage &tileImage, const QByteArray &tileImageRawData);
+};
+
+#endif // MAPTILELOADER_H
@@ -0,0 +1,341 @@
+#include "MapTilePack.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include "Common/CommonUtils.h"
+#include "MapTileContainer.h"
+
+constexpr char TILE_PACK_SIGNATURE[8] = {'A', 'N', 'M', 'S', 'T', 'P', 'K', '1'};
+constexpr quint32 TILE_PACK_VERSION = 1;
+constexpr int TILE_PACK_TRANSACTION_TILES = 20000;
+
+// Coordinates out of the key fields would be truncated to another tile
+static bool isTileKeyInRange(int sourceId, int scale, int x, int y)
+{
+    return sourceId >= 0 && sourceId <= 0xFFFF && scale >= 0 && scale <= 0xFF &&
+           x >= 0 && x <= 0xFFFFF && y >= 0 && y <= 0xFFFFF;
+}
+
+MapTilePack::MapTilePack(const QString &fileName) : _file(fileName)
+{
+    _data = nullptr;
+    _entries = nullptr;
+    _tileCount = 0;
+    _indexOffset = 0;
+
+    if (!openMapping())
+    {
+        qWarning() << "Unable to open tile pack" << fileName;
+        if (_data != nullptr)
+            _file.unmap(const_cast<uchar *>(_data));
+        _data = nullptr;
+        _entries = nullptr;
+        _tileCount = 0;
+        _file.close();
+    }
+}
+
+MapTilePack::~MapTilePack()
+{
+    if (_data != nullptr)
+        _file.unmap(const_cast<uchar *>(_data));
+    _file.close();
+}
+
+bool MapTilePack::openMapping()
+{
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    return false;
+#endif
+    if (!_file.open(QIODevice::ReadOnly))
+        return false;
+
+    qint64 fileSize = _file.size();
+    if (fileSize < static_cast<qint64>(sizeof(MapTilePackHeader)))
+        return false;
+
+    _data = _file.map(0, fileSize);
+    if (_data == nullptr)
+        return false;
+
+    MapTilePackHeader header;
+    memcpy(&header, _data, sizeof(header));
+    if (memcmp(header.Signature, TILE_PACK_SIGNATURE, sizeof(header.Signature)) != 0 || header.Version != TILE_PACK_VERSION)
+        return false;
+
+    quint64 indexSize = static_cast<quint64>(header.TileCount) * sizeof(MapTilePackEntry);
+    quint64 sourcesSize = static_cast<quint64>(header.SourceCount) * sizeof(quint32);
+    if (header.IndexOffset < sizeof(MapTilePackHeader) || header.IndexOffset + indexSize + sourcesSize > static_cast<quint64>(fileSize))
+        return false;
+
+    _indexOffset = header.IndexOffset;
+    _tileCount = header.TileCount;
+    _entries = reinterpret_cast<const MapTilePackEntry *>(_data + _indexOffset);
+
+    const uchar *sourceData = _data + _indexOffset + indexSize;
+    for (quint32 i = 0; i < header.SourceCount; i++)
+    {
+        quint32 sourceId;
+        memcpy(&sourceId, sourceData + i * sizeof(quint32), sizeof(sourceId));
+        _sources.insert(static_cast<int>(sourceId));
+    }
+
+    return true;
+}
+
+bool MapTilePack::isOpen() const
+{
+    return _data != nullptr;
+}
+
+quint32 MapTilePack::tileCount() const
+{
+    return _tileCount;
+}
+
+const QSet<int> &MapTilePack::sources() const
+{
+    return _sources;
+}
+
+bool MapTilePack::findTile(int sourceId, int scale, int x, int y, QByteArray &tileData, int &tileFormat) const
+{
+    if (_entries == nullptr || !_sources.contains(sourceId) || !isTileKeyInRange(sourceId, scale, x, y))
+        return false;
+
+    quint64 key = tileKey(sourceId, scale, x, y);
+    const MapTilePackEntry *end = _entries + _tileCount;
+    const MapTilePackEntry *entry = std::lower_bound(_entries, end, key, [](const MapTilePackEntry &tileEntry, quint64 value)
+    {
+        return tileEntry.Key < value;
+    });
+    if (entry == end || entry->Key != key || entry->Offset + entry->Size > _indexOffset)
+        return false;
+
+    tileData = QByteArray::fromRawData(reinterpret_cast<const char *>(_data + entry->Offset), static_cast<int>(entry->Size));
+    tileFormat = static_cast<int>(entry->Format);
+    return true;
+}
+
+quint64 MapTilePack::tileKey(int sourceId, int scale, int x, int y)
+{
+    // x and y have at most 20 bits up to the zoom 20
+    return (static_cast<quint64>(sourceId & 0xFFFF) << 48) |
+           (static_cast<quint64>(scale & 0xFF) << 40) |
+           (static_cast<quint64>(x & 0xFFFFF) << 20) |
+            static_cast<quint64>(y & 0xFFFFF);
+}
+
+bool MapTilePack::isTilePackFile(const QString &fileName)
+{
+    return fileName.endsWith(".tpk", Qt::CaseInsensitive);
+}
+
+bool MapTilePack::convertFromDatabase(const QString &databaseFileName, const QString &packFileName)
+{
+    struct SourceTile
+    {
+        quint64 Key;
+        qint64 RowId;
+        int Format;
+    };
+
+    qInfo() << "Tile Pack Conversion Started:" << databaseFileName << "->" << packFileName;
+
+    QString tempFileName = packFileName + ".tmp";
+    bool isConverted = false;
+    quint32 tileCount = 0;
+    {
+        QSqlDatabase sourceDatabase = QSqlDatabase::addDatabase("QSQLITE", "TilePackSourceDB");
+        sourceDatabase.setDatabaseName(databaseFileName);
+        sourceDatabase.setConnectOptions("QSQLITE_OPEN_READONLY");
+        if (sourceDatabase.open())
+        {
+            QVector<SourceTile> tiles;
+            QSet<int> sources;
+            QSqlQuery keyQuery(sourceDatabase);
+            keyQuery.setForwardOnly(true);
+            if (keyQuery.exec("SELECT rowid, sourceId, scale, x, y, format FROM MapTile WHERE scale > 0 AND x >= 0 AND y >= 0 ORDER BY rowid"))
+            {
+                while (keyQuery.next())
+                {
+                    int sourceId = keyQuery.value(1).toInt();
+                    int scale = keyQuery.value(2).toInt();
+                    int x = keyQuery.value(3).toInt();
+                    int y = keyQuery.value(4).toInt();
+                    if (!isTileKeyInRange(sourceId, scale, x, y))
+                        continue;
+                    SourceTile tile = {tileKey(sourceId, scale, x, y), keyQuery.value(0).toLongLong(), keyQuery.value(5).toInt()};
+                    tiles.append(tile);
+                    sources.insert(sourceId);
+                }
+            }
+            keyQuery.clear();
+
+            // Payloads are written in the key order, so the neighbour tiles are close in the file.
+            // The first written of the duplicated tiles is kept
+            std::stable_sort(tiles.begin(), tiles.end(), [](const SourceTile &tile1, const SourceTile &tile2)
+            {
+                return tile1.Key < tile2.Key;
+            });
+
+            QFile packFile(tempFileName);
+            if (packFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            {
+                MapTilePackHeader header;
+                memset(&header, 0, sizeof(header));
+                packFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+                QVector<MapTilePackEntry> entries;
+                entries.reserve(tiles.count());
+                quint64 offset = sizeof(header);
+
+                QSqlQuery tileQuery(sourceDatabase);
+                tileQuery.prepare("SELECT tile FROM MapTile WHERE rowid = ?");
+                foreach (const SourceTile &tile, tiles)
+                {
+                    if (!entries.isEmpty() && entries.last().Key == tile.Key)
+                        continue;
+
+                    tileQuery.bindValue(0, tile.RowId);
+                    if (!tileQuery.exec() || !tileQuery.next())
+                        continue;
+                    QByteArray tileData = tileQuery.value(0).toByteArray();
+                    tileQuery.finish();
+                    if (tileData.isEmpty())
+                        continue;
+
+                    packFile.write(tileData);
+                    MapTilePackEntry entry = {tile.Key, offset, static_cast<quint32>(tileData.size()), static_cast<quint32>(tile.Format)};
+                    entries.append(entry);
+                    offset += tileData.size();
+                }
+                tileQuery.clear();
+
+                // The index is aligned for the direct access from the mapping
+                quint64 padding = (8 - offset % 8) % 8;
+                packFile.write(QByteArray(static_cast<int>(padding), 0));
+                offset += padding;
+
+                QVector<quint32> sourceIds;
+                foreach (int sourceId, sources)
+                    sourceIds.append(static_cast<quint32>(sourceId));
+                std::sort(sourceIds.begin(), sourceIds.end());
+
+                packFile.write(reinterpret_cast<const char *>(entries.constData()), entries.count() * sizeof(MapTilePackEntry));
+                packFile.write(reinterpret_cast<const char *>(sourceIds.constData()), sourceIds.count() * sizeof(quint32));
+
+                memcpy(header.Signature, TILE_PACK_SIGNATURE, sizeof(header.Signature));
+                header.Version = TILE_PACK_VERSION;
+                header.TileCount = static_cast<quint32>(entries.count());
+                header.IndexOffset = offset;
+                header.SourceCount = static_cast<quint32>(sourceIds.count());
+                packFile.seek(0);
+                packFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+                tileCount = header.TileCount;
+                isConverted = packFile.error() == QFileDevice::NoError;
+                packFile.close();
+            }
+            sourceDatabase.close();
+        }
+        else
+        {
+            qWarning() << "Tile Pack Conversion Failed:" << sourceDatabase.lastError().text();
+        }
+    }
+    QSqlDatabase::removeDatabase("TilePackSourceDB");
+
+    if (isConverted)
+    {
+        QFile::remove(packFileName);
+        isConverted = QFile::rename(tempFileName, packFileName);
+    }
+    else
+    {
+        QFile::remove(tempFileName);
+    }
+
+    qInfo() << "Tile Pack Conversion Finished:" << isConverted << "," << tileCount << "tiles";
+    return isConverted;
+}
+
+bool MapTilePack::convertToDatabase(const QString &packFileName, const QString &databaseFileName)
+{
+    qInfo() << "Tile Pack Conversion Started:" << packFileName << "->" << databaseFileName;
+
+    MapTilePack tilePack(packFileName);
+    if (!tilePack.isOpen())
+        return false;
+
+    bool isConverted = false;
+    {
+        QSqlDatabase destinationDatabase = QSqlDatabase::addDatabase("QSQLITE", "TilePackDestDB");
+        destinationDatabase.setDatabaseName(databaseFileName);
+        if (destinationDatabase.open())
+        {
+            QSqlQuery destDBQuery(destinationDatabase);
+            destDBQuery.exec("PRAGMA journal_mode = MEMORY");
+            destDBQuery.exec("CREATE TABLE IF NOT EXISTS MapTile (x INTEGER, y INTEGER, scale INTEGER, sourceId INTEGER, format INTEGER, autogenerated INTEGER, datetime REAL, signature INTEGER, tile BLOB)");
+            destDBQuery.exec("CREATE TABLE IF NOT EXISTS MapTileSources (sourceId Integer)");
+
+            QSqlQuery insertQuery(destinationDatabase);
+            insertQuery.prepare("INSERT OR REPLACE INTO MapTile (x, y, scale, sourceId, format, autogenerated, datetime, signature, tile) " \
+                                "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)");
+
+            double datetime = GetCurrentDateTimeForDB();
+            isConverted = destinationDatabase.transaction();
+            for (quint32 i = 0; i < tilePack._tileCount && isConverted; i++)
+            {
+                const MapTilePackEntry &entry = tilePack._entries[i];
+                if (entry.Offset + entry.Size > tilePack._indexOffset)
+                    continue;
+
+                insertQuery.bindValue(0, static_cast<int>((entry.Key >> 20) & 0xFFFFF));
+                insertQuery.bindValue(1, static_cast<int>(entry.Key & 0xFFFFF));
+                insertQuery.bindValue(2, static_cast<int>((entry.Key >> 40) & 0xFF));
+                insertQuery.bindValue(3, static_cast<int>(entry.Key >> 48));
+                insertQuery.bindValue(4, static_cast<int>(entry.Format));
+                insertQuery.bindValue(5, 0);
+                insertQuery.bindValue(6, datetime);
+                insertQuery.bindValue(7, 0);
+                insertQuery.bindValue(8, QByteArray::fromRawData(reinterpret_cast<const char *>(tilePack._data + entry.Offset),
+                                                                 static_cast<int>(entry.Size)));
+                isConverted = insertQuery.exec();
+
+                if ((i + 1) % TILE_PACK_TRANSACTION_TILES == 0)
+                {
+                    destinationDatabase.commit();
+                    destinationDatabase.transaction();
+                }
+            }
+
+            foreach (int sourceId, tilePack._sources)
+                destDBQuery.exec(QString("INSERT INTO MapTileSources (sourceId) VALUES (%1)").arg(sourceId));
+            destinationDatabase.commit();
+
+            // Tiles of the pack replace the tiles already stored in the database
+            if (isConverted)
+                isConverted = TileDatabaseConnection::createUniqueTileIndex(destinationDatabase);
+            else
+                qWarning() << "Tile Pack Conversion Failed:" << insertQuery.lastError().text();
+
+            destDBQuery.clear();
+            insertQuery.clear();
+            destinationDatabase.close();
+        }
+        else
+        {
+            qWarning() << "Tile Pack Conversion Failed:" << destinationDatabase.lastError().text();
+        }
+    }
+    QSqlDatabase::removeDatabase("TilePackDestDB");
+
+    qInfo() << "Tile Pack Conversion Finished:" << isConverted << "," << tilePack.tileCount() << "tiles";
+    return isConverted;
+}
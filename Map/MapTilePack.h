@@ -0,0 +1,62 @@
+#ifndef MAPTILEPACK_H
+#define MAPTILEPACK_H
+
+#include <QFile>
+#include <QSet>
+#include <QString>
+#include <QByteArray>
+
+// Read-only tile pack (*.tpk), one file mapped into memory:
+//   header | tile payloads | index sorted by (sourceId, scale, x, y) | source ids
+// Tiles are found by binary search in the index, their encoded bytes are used from the mapping without copying.
+// The file is written in the host byte order, packs are made and used on little-endian machines only.
+
+#pragma pack(push, 1)
+struct MapTilePackHeader final
+{
+    char Signature[8];
+    quint32 Version;
+    quint32 TileCount;
+    quint64 IndexOffset;
+    quint32 SourceCount;
+    quint32 Reserved;
+};
+
+struct MapTilePackEntry final
+{
+    quint64 Key;
+    quint64 Offset;
+    quint32 Size;
+    quint32 Format;
+};
+#pragma pack(pop)
+
+class MapTilePack final
+{
+    QFile _file;
+    const uchar *_data;
+    const MapTilePackEntry *_entries;
+    quint32 _tileCount;
+    quint64 _indexOffset;
+    QSet<int> _sources;
+
+    bool openMapping();
+public:
+    explicit MapTilePack(const QString &fileName);
+    ~MapTilePack();
+
+    bool isOpen() const;
+    quint32 tileCount() const;
+    const QSet<int> &sources() const;
+    // Tile data refers to the mapped file and is valid while the pack exists
+    bool findTile(int sourceId, int scale, int x, int y, QByteArray &tileData, int &tileFormat) const;
+
+    static quint64 tileKey(int sourceId, int scale, int x, int y);
+    static bool isTilePackFile(const QString &fileName);
+
+    // Conversion from and to the MapTile table of the map databases
+    static bool convertFromDatabase(const QString &databaseFileName, const QString &packFileName);
+    static bool convertToDatabase(const QString &packFileName, const QString &databaseFileName);
+};
+
+#endif // MAPTILEPACK_H
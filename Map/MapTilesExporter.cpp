@@ -2,91 +2,312 @@
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QMultiMap>
 #include <QDebug>
 #include <QtConcurrentRun>
+#include <algorithm>
 #include "MapTileContainer.h"
+#include "MapTilePack.h"
 
-void MapTilesExporter::processExport(const QList<ExportTask> tasks, const QString destDB)
+constexpr int EXPORT_MAX_READ_THREADS = 4;
+constexpr int EXPORT_BATCH_TILES = 256;                         // tiles passed to the writer at once
+constexpr qint64 EXPORT_QUEUE_MAX_BYTES = 64 * 1024 * 1024;     // read tiles waiting for the writer
+constexpr int EXPORT_TRANSACTION_TILES = 20000;
+constexpr int EXPORT_PROGRESS_INTERVAL_MS = 250;
+
+qint64 MapTilesExporter::countTiles(const QList<ExportTask> &tasks)
 {
-    QSqlDatabase destinationDatabase = QSqlDatabase::addDatabase("QSQLITE", "DestDB");
-    destinationDatabase.setDatabaseName(destDB);
-    destinationDatabase.open();
-    QSqlQuery destDBQuery(destinationDatabase);
+    // The count is taken from the index, tile sizes are known only after reading
+    qint64 tileTotalCount = 0;
+    QMultiMap<QString, ExportTask> sourceDBTasks;
+    foreach (auto task, tasks)
+        if (!task.sourceDB.isEmpty())
+            sourceDBTasks.insert(task.sourceDB, task);
+
+    foreach (const QString &sourceDatabasePath, sourceDBTasks.uniqueKeys())
+    {
+        {
+            QSqlDatabase sourceDatabase = QSqlDatabase::addDatabase("QSQLITE", "ExportCountDB");
+            sourceDatabase.setDatabaseName(sourceDatabasePath);
+            sourceDatabase.setConnectOptions("QSQLITE_OPEN_READONLY");
+            if (sourceDatabase.open())
+            {
+                QSqlQuery countQuery(sourceDatabase);
+                countQuery.prepare("SELECT COUNT(*) FROM MapTile WHERE x>=? AND x<=? AND y>=? AND y<=? AND scale=? AND sourceId=?");
+                foreach (auto task, sourceDBTasks.values(sourceDatabasePath))
+                {
+                    countQuery.addBindValue(task.X1);
+                    countQuery.addBindValue(task.X2);
+                    countQuery.addBindValue(task.Y1);
+                    countQuery.addBindValue(task.Y2);
+                    countQuery.addBindValue(task.scale);
+                    countQuery.addBindValue(task.sourceId);
+                    if (countQuery.exec() && countQuery.next())
+                        tileTotalCount += countQuery.value(0).toLongLong();
+                }
+                countQuery.clear();
+                sourceDatabase.close();
+            }
+        }
+        QSqlDatabase::removeDatabase("ExportCountDB");
+    }
 
-    destDBQuery.exec("CREATE TABLE MapTile (x INTEGER, y INTEGER, scale INTEGER, sourceId INTEGER, format INTEGER, autogenerated INTEGER, datetime REAL, signature INTEGER, tile BLOB)");
-    //qDebug() << "SqLite error:" << destDBQuery.lastError().text() << ", SqLite error code:" << destDBQuery.lastError().number();
-    destDBQuery.exec("PRAGMA journal_mode = MEMORY");
+    return tileTotalCount;
+}
 
-    QSqlQuery copyQuery(destinationDatabase);
+void MapTilesExporter::enqueueBatch(TileBatch &batch)
+{
+    {
+        QMutexLocker locker(&_mutex);
+        while (_queuedBytes > 0 && _queuedBytes + batch.Bytes > EXPORT_QUEUE_MAX_BYTES)
+            _queueSpaceAvailable.wait(&_mutex);
 
-    QString prevSourceDatabasePath = "";
-    int processedCount = 0;
-    int tileTotalCount = 0;
-    foreach (auto task, tasks)
-        tileTotalCount += (task.X2 - task.X1) * (task.Y2 - task.Y1);
+        _queuedBytes += batch.Bytes;
+        _batches.enqueue(batch);
+        _batchAvailable.wakeOne();
+    }
 
-    foreach (auto task, tasks)
+    batch.Tiles.clear();
+    batch.Bytes = 0;
+}
+
+void MapTilesExporter::readTask(const ExportTask &task, int taskIndex)
+{
+    QString connectionName = QString("ExportSrcDB%1").arg(taskIndex);
     {
-        QString sourceDatabasePath = task.sourceDB;
+        QSqlDatabase sourceDatabase = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        sourceDatabase.setDatabaseName(task.sourceDB);
+        sourceDatabase.setConnectOptions("QSQLITE_OPEN_READONLY");
+        if (sourceDatabase.open())
+        {
+            QSqlQuery readQuery(sourceDatabase);
+            readQuery.setForwardOnly(true);
+            readQuery.prepare("SELECT x, y, format, autogenerated, datetime, signature, tile " \
+                              "FROM MapTile WHERE x>=? AND x<=? AND y>=? AND y<=? AND scale=? AND sourceId=? ORDER BY x, y");
+            readQuery.addBindValue(task.X1);
+            readQuery.addBindValue(task.X2);
+            readQuery.addBindValue(task.Y1);
+            readQuery.addBindValue(task.Y2);
+            readQuery.addBindValue(task.scale);
+            readQuery.addBindValue(task.sourceId);
 
-        if (sourceDatabasePath.isEmpty())
-            continue;
-        if (sourceDatabasePath != prevSourceDatabasePath)
+            TileBatch batch;
+            batch.Bytes = 0;
+            if (readQuery.exec())
+            {
+                while (!_cancelExecution.loadRelaxed() && readQuery.next())
+                {
+                    Tile tile = {readQuery.value(0).toInt(), readQuery.value(1).toInt(), task.scale, task.sourceId,
+                                 readQuery.value(2).toInt(), readQuery.value(3), readQuery.value(4), readQuery.value(5),
+                                 readQuery.value(6).toByteArray()};
+                    batch.Bytes += tile.Data.size();
+                    batch.Tiles.append(tile);
+
+                    if (batch.Tiles.count() >= EXPORT_BATCH_TILES)
+                        enqueueBatch(batch);
+                }
+            }
+            else
+            {
+                qWarning() << "Export Tiles Read Failed:" << task.sourceDB << readQuery.lastError().text();
+            }
+
+            if (!batch.Tiles.isEmpty())
+                enqueueBatch(batch);
+        }
+        else
         {
-            if (!prevSourceDatabasePath.isEmpty())
-                destDBQuery.exec("DETACH DATABASE SrcDB");
+            qWarning() << "Export Tiles Read Failed:" << task.sourceDB << sourceDatabase.lastError().text();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+
+    QMutexLocker locker(&_mutex);
+    _pendingTasks--;
+    _batchAvailable.wakeAll();
+}
+
+void MapTilesExporter::processExport(QList<ExportTask> tasks, const QString destDB)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Tasks of the same source database go together in key order
+    std::sort(tasks.begin(), tasks.end(), [](const ExportTask &task1, const ExportTask &task2)
+    {
+        if (task1.sourceDB != task2.sourceDB)
+            return task1.sourceDB < task2.sourceDB;
+        if (task1.X1 != task2.X1)
+            return task1.X1 < task2.X1;
+        return task1.Y1 < task2.Y1;
+    });
+
+    qint64 tileTotalCount = countTiles(tasks);
+    qint64 processedCount = 0;
+    qint64 exportedCount = 0;
+    qint64 exportedBytes = 0;
+    qint64 replacedCount = 0;
+    qDebug() << "Export Tiles Started:" << tasks.count() << "tasks," << tileTotalCount << "tiles";
+
+    {
+        QSqlDatabase destinationDatabase = QSqlDatabase::addDatabase("QSQLITE", "DestDB");
+        destinationDatabase.setDatabaseName(destDB);
+        destinationDatabase.open();
+        QSqlQuery destDBQuery(destinationDatabase);
 
-            destDBQuery.exec("ATTACH DATABASE '" + sourceDatabasePath + "' AS SrcDB");
+        destDBQuery.exec("CREATE TABLE IF NOT EXISTS MapTile (x INTEGER, y INTEGER, scale INTEGER, sourceId INTEGER, format INTEGER, autogenerated INTEGER, datetime REAL, signature INTEGER, tile BLOB)");
+        destDBQuery.exec("PRAGMA journal_mode = MEMORY");
+        destDBQuery.exec("PRAGMA cache_size = -65536");
+        // The index is built first, the tiles of overlapping tasks and source databases are inserted once
+        if (!TileDatabaseConnection::createUniqueTileIndex(destinationDatabase))
+            qWarning() << "Export Tiles Index Failed, duplicated tiles are kept";
 
-            copyQuery.prepare("INSERT INTO MapTile (x, y, scale, sourceId, format, autogenerated, datetime, signature, tile)" \
-                              "SELECT x, y, scale, sourceId, format, autogenerated, datetime, signature, tile " \
-                              "FROM SrcDB.MapTile WHERE x>=? AND x<=? AND y>=? AND y<=? AND scale=? AND sourceId=?");
-            qDebug() << "SqLite error:" << destDBQuery.lastError().text();
+        // Source databases are read in parallel, so a duplicated tile replaces the stored one only when it is newer,
+        // or has the same time and greater content: the exported copy does not depend on the reading order
+        QSqlQuery insertQuery(destinationDatabase);
+        insertQuery.prepare("INSERT OR IGNORE INTO MapTile (x, y, scale, sourceId, format, autogenerated, datetime, signature, tile) " \
+                            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)");
+        QSqlQuery replaceQuery(destinationDatabase);
+        replaceQuery.prepare("UPDATE MapTile SET format=?, autogenerated=?, datetime=?, signature=?, tile=? " \
+                             "WHERE x=? AND y=? AND scale=? AND sourceId=? AND " \
+                             "(IFNULL(?, 0) > IFNULL(datetime, 0) OR (IFNULL(?, 0) = IFNULL(datetime, 0) AND ? > tile))");
 
-            prevSourceDatabasePath = sourceDatabasePath;
+        _batches.clear();
+        _queuedBytes = 0;
+        _pendingTasks = 0;
+        for (int i = 0; i < tasks.count(); i++)
+        {
+            if (tasks[i].sourceDB.isEmpty())
+                continue;
+
+            _pendingTasks++;
+            ExportTask task = tasks[i];
+            _threadPool.start([this, task, i]()
+            {
+                readTask(task, i);
+            });
         }
 
-        if (_cancelExecution)
-            break;
+        destinationDatabase.transaction();
+        int transactionTileCount = 0;
+        qint64 lastProgressTimeMs = 0;
 
-        copyQuery.addBindValue(task.X1);
-        copyQuery.addBindValue(task.X2);
-        copyQuery.addBindValue(task.Y1);
-        copyQuery.addBindValue(task.Y2);
-        copyQuery.addBindValue(task.scale);
-        copyQuery.addBindValue(task.sourceId);
-        copyQuery.exec();
+        forever
+        {
+            TileBatch batch;
+            {
+                QMutexLocker locker(&_mutex);
+                while (_batches.isEmpty() && _pendingTasks > 0)
+                    _batchAvailable.wait(&_mutex);
+                if (_batches.isEmpty())
+                    break;
 
-        processedCount += (task.X2 - task.X1) * (task.Y2 - task.Y1);
-        emit exportProcessChanged(100.0 * processedCount / tileTotalCount);
-    }
+                batch = _batches.dequeue();
+                _queuedBytes -= batch.Bytes;
+                _queueSpaceAvailable.wakeAll();
+            }
 
-    destDBQuery.exec("DETACH DATABASE SrcDB");
+            // Readers stop on cancel, the read tiles are dropped
+            if (_cancelExecution.loadRelaxed())
+                continue;
 
-    destDBQuery.exec("CREATE UNIQUE INDEX TILE_SCALE_X_Y_SourceID ON MapTile (x, y, scale, sourceId)");
+            foreach (const Tile &tile, batch.Tiles)
+            {
+                insertQuery.bindValue(0, tile.X);
+                insertQuery.bindValue(1, tile.Y);
+                insertQuery.bindValue(2, tile.Scale);
+                insertQuery.bindValue(3, tile.SourceId);
+                insertQuery.bindValue(4, tile.Format);
+                insertQuery.bindValue(5, tile.Autogenerated);
+                insertQuery.bindValue(6, tile.DateTime);
+                insertQuery.bindValue(7, tile.Signature);
+                insertQuery.bindValue(8, tile.Data);
+                if (!insertQuery.exec())
+                    continue;
+                if (insertQuery.numRowsAffected() > 0)
+                {
+                    exportedCount++;
+                    exportedBytes += tile.Data.size();
+                    continue;
+                }
 
-    destDBQuery.clear();
-    destinationDatabase.close();
+                replaceQuery.bindValue(0, tile.Format);
+                replaceQuery.bindValue(1, tile.Autogenerated);
+                replaceQuery.bindValue(2, tile.DateTime);
+                replaceQuery.bindValue(3, tile.Signature);
+                replaceQuery.bindValue(4, tile.Data);
+                replaceQuery.bindValue(5, tile.X);
+                replaceQuery.bindValue(6, tile.Y);
+                replaceQuery.bindValue(7, tile.Scale);
+                replaceQuery.bindValue(8, tile.SourceId);
+                replaceQuery.bindValue(9, tile.DateTime);
+                replaceQuery.bindValue(10, tile.DateTime);
+                replaceQuery.bindValue(11, tile.Data);
+                if (replaceQuery.exec() && replaceQuery.numRowsAffected() > 0)
+                    replacedCount++;
+            }
+            processedCount += batch.Tiles.count();
+            transactionTileCount += batch.Tiles.count();
+
+            if (transactionTileCount >= EXPORT_TRANSACTION_TILES)
+            {
+                destinationDatabase.commit();
+                destinationDatabase.transaction();
+                transactionTileCount = 0;
+            }
+
+            qint64 elapsedMs = timer.elapsed();
+            if (elapsedMs - lastProgressTimeMs >= EXPORT_PROGRESS_INTERVAL_MS)
+            {
+                lastProgressTimeMs = elapsedMs;
+                if (tileTotalCount > 0)
+                    emit exportProcessChanged(qMin(100.0, 100.0 * processedCount / tileTotalCount));
+                emit exportStatisticsChanged(exportedCount, exportedBytes);
+            }
+        }
 
+        destinationDatabase.commit();
+        _threadPool.waitForDone();
+
+        destDBQuery.clear();
+        insertQuery.clear();
+        replaceQuery.clear();
+        destinationDatabase.close();
+    }
     QSqlDatabase::removeDatabase("DestDB");
 
+    qint64 durationMs = timer.elapsed();
+    qDebug() << "Export Tiles Finished:" << exportedCount << "tiles," << exportedBytes / (1024 * 1024) << "MB,"
+             << processedCount - exportedCount << "duplicates," << replacedCount << "replaced by newer,"
+             << (durationMs > 0 ? 1000.0 * exportedCount / durationMs : 0) << "tiles/s";
+
+    emit exportStatisticsChanged(exportedCount, exportedBytes);
     emit exportProcessEnded();
 }
 
 MapTilesExporter::MapTilesExporter(QObject *parent) : QObject(parent)
 {
-
+    _threadPool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), EXPORT_MAX_READ_THREADS));
+    _queuedBytes = 0;
+    _pendingTasks = 0;
 }
 
 MapTilesExporter::~MapTilesExporter()
 {
-
+    _cancelExecution.storeRelaxed(1);
+    _threadPool.waitForDone();
 }
 
 void MapTilesExporter::AddExportTask(int sourceId, int scale, const WorldGPSCoord &coord1, const WorldGPSCoord &coord2, QList<QString> &sourceDBFiles)
 {
     foreach (QString sourceDB, sourceDBFiles)
     {
+        // Tile packs are read-only copies of the map databases, tiles are exported from the databases
+        if (MapTilePack::isTilePackFile(sourceDB))
+            continue;
+
         double fx1, fy1, fx2, fy2;
         if (sourceId == YandexSatellite || sourceId == YandexMap || sourceId == YandexHybrid)
         {
@@ -113,7 +334,7 @@ void MapTilesExporter::AddExportTask(int sourceId, int scale, const WorldGPSCoor
             if (batchX > 1)
                 batchX = batchX / 2;
             if (batchY > 1)
-                batchY = batchX / 2;
+                batchY = batchY / 2;
         }
 
         for (int x = x1; x <= x2; x += batchX)
@@ -133,17 +354,17 @@ void MapTilesExporter::AddExportTask(int sourceId, int scale, const WorldGPSCoor
 
 void MapTilesExporter::RunExport(const QString &destDB)
 {
-    _cancelExecution = false;
+    _cancelExecution.storeRelaxed(0);
     QtConcurrent::run(&MapTilesExporter::processExport, this, _tasks, destDB);
 }
 
 void MapTilesExporter::clear()
 {
-    _cancelExecution = false;
+    _cancelExecution.storeRelaxed(0);
     _tasks.clear();
 }
 
 void MapTilesExporter::cancelExport()
 {
-    _cancelExecution = true;
+    _cancelExecution.storeRelaxed(1);
 }
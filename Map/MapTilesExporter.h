@@ -5,11 +5,21 @@
 #include <QProgressDialog>
 #include <QList>
 #include <QString>
+#include <QVariant>
+#include <QThreadPool>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QVector>
+#include <QAtomicInt>
 #include "Common/CommonData.h"
 
 // https://sqlite.org/c3ref/progress_handler.html - progress
 // http://www.sqlite.org/lang_attach.html - attach database
 
+// Tasks are read from the source databases on the thread pool in key order, the export thread writes them
+// to the destination database with the unique index built first. Of the duplicated tiles the newest one is kept,
+// the content decides between the tiles of the same time, so the result does not depend on the reading order
 class MapTilesExporter final : public QObject
 {
     Q_OBJECT
@@ -20,13 +30,35 @@ class MapTilesExporter final : public QObject
         QString sourceDB;
     };
 
-    bool _cancelExecution;
+    struct Tile final
+    {
+        int X, Y, Scale, SourceId, Format;
+        QVariant Autogenerated, DateTime, Signature;
+        QByteArray Data;
+    };
+
+    struct TileBatch final
+    {
+        QVector<Tile> Tiles;
+        qint64 Bytes;
+    };
+
+    QAtomicInt _cancelExecution;
     QList<ExportTask> _tasks;
 
+    QThreadPool _threadPool;
+    QMutex _mutex;
+    QWaitCondition _batchAvailable;
+    QWaitCondition _queueSpaceAvailable;
+    QQueue<TileBatch> _batches;
+    qint64 _queuedBytes;
+    int _pendingTasks;
 
-    void prepareProgressDialog(int tileTotalCount);
+    qint64 countTiles(const QList<ExportTask> &tasks);
+    void readTask(const ExportTask &task, int taskIndex);
+    void enqueueBatch(TileBatch &batch);
 public:
-    void processExport(const QList<ExportTask> tasks, const QString destDB);
+    void processExport(QList<ExportTask> tasks, const QString destDB);
 
     explicit MapTilesExporter(QObject *parent = nullptr);
     ~MapTilesExporter();
@@ -36,6 +68,7 @@ public:
     void clear();
 signals:
     void exportProcessChanged(double processedPrecent);
+    void exportStatisticsChanged(qint64 exportedTiles, qint64 exportedBytes);
     void exportProcessEnded();
 public slots:
     void cancelExport();
@@ -1,192 +1,325 @@
 #include "MapTilesImporter.h"
 #include <QDir>
+#include <QFile>
+#include <QSet>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QVariant>
+#include <QElapsedTimer>
 #include <QDebug>
+#include "MapTileContainer.h"
+
+constexpr int IMPORT_BATCH_TILES = 256;                         // tiles passed to the writer at once
+constexpr qint64 IMPORT_QUEUE_MAX_BYTES = 64 * 1024 * 1024;     // read tiles waiting for the writer
+constexpr int IMPORT_TRANSACTION_TILES = 20000;
+constexpr int IMPORT_PROGRESS_INTERVAL_MS = 2000;
 
 MapTilesImporter::MapTilesImporter(QObject *parent) : QObject(parent)
 {
-
+    _queuedBytes = 0;
+    _pendingFolders = 0;
 }
 
-void MapTilesImporter::importMapFromMapnikFiles(const QString &destDB, const QString &srcFolderName, int sourceId)
+MapTilesImporter::~MapTilesImporter()
 {
-    qDebug() << "Import Tiles Started";
-    QSqlDatabase destinationDatabase = QSqlDatabase::addDatabase("QSQLITE", "TileFilesDestDB");
-    destinationDatabase.setDatabaseName(destDB);
-    destinationDatabase.open();
-    QSqlQuery destDBQuery(destinationDatabase);
-    destDBQuery.exec("CREATE TABLE MapTile (x INTEGER, y INTEGER, scale INTEGER, sourceId INTEGER, format INTEGER, autogenerated INTEGER, datetime REAL, signature INTEGER, tile BLOB)");
-
-    QSqlQuery insertQuery(destinationDatabase);
-    insertQuery.prepare("INSERT INTO MapTile (x, y, scale, sourceId, format, tile) " \
-                        "VALUES (?, ?, ?, ?, ?, ?)");
-
-    destinationDatabase.transaction();
+    _threadPool.waitForDone();
+}
 
-    qint64 processedCount = 0;
-    //Root
+QList<MapTilesImporter::TileFolder> MapTilesImporter::findMapnikFolders(const QString &srcFolderName)
+{
+    // z/x/y.png
+    QList<TileFolder> folders;
     QDir rootDir(srcFolderName);
-    QStringList zFolderNames = rootDir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Time);
-    foreach (const QString &zFolderName, zFolderNames)
+    foreach (const QString &zFolderName, rootDir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Name))
     {
         int z = zFolderName.toInt();
-        QString fullZFolderName = srcFolderName + "\\" + zFolderName;
-        QDir zDir(fullZFolderName);
-        QStringList xFolderNames = zDir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Time);
-
-        foreach (const QString &xFolderName, xFolderNames)
+        QDir zDir(rootDir.filePath(zFolderName));
+        foreach (const QString &xFolderName, zDir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Name))
         {
-            int x = xFolderName.toInt();
-            QString fullXFolderName = fullZFolderName + "\\" + xFolderName;
-            QDir xDir(fullXFolderName);
+            TileFolder folder = {zFolderName + "/" + xFolderName, z, xFolderName.toInt(), false};
+            folders.append(folder);
+        }
+    }
+    return folders;
+}
 
-            QStringList yFileNames = xDir.entryList(QDir::Files);
-            foreach (const QString &yFileName, yFileNames)
+QList<MapTilesImporter::TileFolder> MapTilesImporter::findSASFolders(const QString &srcFolderName)
+{
+    // z{z + 1}/{x / 1024}/x{x}/{y / 1024}/y{y}.jpg
+    QList<TileFolder> folders;
+    QDir rootDir(srcFolderName);
+    foreach (const QString &zFolderName1, rootDir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Name))
+    {
+        int z = zFolderName1.mid(1).toInt() - 1;
+        QDir zDir1(rootDir.filePath(zFolderName1));
+        foreach (const QString &zFolderName2, zDir1.entryList(QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Name))
+        {
+            QDir zDir2(zDir1.filePath(zFolderName2));
+            foreach (const QString &xFolderName1, zDir2.entryList(QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Name))
             {
-                QString yStr = yFileName;
-                int y = yStr.section(".", 0, 0).toInt();
-
-                QString extension = yStr.section('.', -1).toUpper();
-                int tileFormat = 0;
-                if (extension == "JPEG" || extension == "JPG")
-                    tileFormat = 1;
-                else if (extension == "PNG")
-                    tileFormat = 2;
-
-                QString fullYFileName = fullXFolderName + "\\" + yFileName;
-                QFile file(fullYFileName);
-                if (tileFormat != 0 && file.open(QIODevice::ReadOnly))
+                int x = xFolderName1.mid(1).toInt();
+                QDir xDir1(zDir2.filePath(xFolderName1));
+                foreach (const QString &xFolderName2, xDir1.entryList(QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Name))
                 {
-                    QByteArray blob = file.readAll();
-
-                    insertQuery.addBindValue(x);
-                    insertQuery.addBindValue(y);
-                    insertQuery.addBindValue(z);
-                    insertQuery.addBindValue(sourceId);
-                    insertQuery.addBindValue(tileFormat);
-                    insertQuery.addBindValue(blob);
-
-                    insertQuery.exec();
-
-                    processedCount++;
-
-                    if (processedCount % 5000 == 0)
-                        qDebug() << "Import Tiles Progress:" << processedCount;
+                    TileFolder folder = {zFolderName1 + "/" + zFolderName2 + "/" + xFolderName1 + "/" + xFolderName2, z, x, true};
+                    folders.append(folder);
                 }
             }
         }
     }
+    return folders;
+}
 
+int MapTilesImporter::tileFormat(const QByteArray &data)
+{
+    // The format is taken from the content, damaged and unknown files (like SAS *.tne markers) are skipped
+    auto bytes = reinterpret_cast<const uchar*>(data.constData());
+    if (data.size() > 3 && bytes[0] == 0xFF && bytes[1] == 0xD8)
+        return 1;
+    if (data.size() > 8 && bytes[0] == 0x89 && bytes[1] == 'P' && bytes[2] == 'N' && bytes[3] == 'G')
+        return 2;
+    return 0;
+}
 
-    destinationDatabase.commit();
+void MapTilesImporter::enqueueBatch(TileBatch &batch)
+{
+    {
+        QMutexLocker locker(&_mutex);
+        while (_queuedBytes > 0 && _queuedBytes + batch.Bytes > IMPORT_QUEUE_MAX_BYTES)
+            _queueSpaceAvailable.wait(&_mutex);
 
-    destDBQuery.exec("CREATE UNIQUE INDEX TILE_SCALE_X_Y_SourceID ON MapTile (x, y, scale, sourceId)");
+        _queuedBytes += batch.Bytes;
+        _batches.enqueue(batch);
+        _batchAvailable.wakeOne();
+    }
 
-    destinationDatabase.close();
-    QSqlDatabase::removeDatabase("TileFilesDestDB");
+    batch.Tiles.clear();
+    batch.Bytes = 0;
+    batch.SkippedFiles = 0;
+}
+
+void MapTilesImporter::readFolder(const QString &srcFolderName, const TileFolder &folder)
+{
+    QDir dir(QDir(srcFolderName).filePath(folder.RelativePath));
+
+    TileBatch batch;
+    batch.Folder = folder.RelativePath;
+    batch.Bytes = 0;
+    batch.SkippedFiles = 0;
+    batch.FolderFinished = false;
+
+    foreach (const QString &yFileName, dir.entryList(QDir::Files, QDir::Name))
+    {
+        QString yStr = yFileName.section('.', 0, 0);
+        if (folder.SASNames)
+            yStr.remove(0, 1);
+        bool isNumber = false;
+        int y = yStr.toInt(&isNumber);
+
+        QFile file(dir.filePath(yFileName));
+        if (!isNumber || !file.open(QIODevice::ReadOnly))
+        {
+            batch.SkippedFiles++;
+            continue;
+        }
+
+        QByteArray data(static_cast<int>(file.size()), Qt::Uninitialized);
+        int format = file.read(data.data(), data.size()) == data.size() ? tileFormat(data) : 0;
+        if (format == 0)
+        {
+            batch.SkippedFiles++;
+            continue;
+        }
+
+        Tile tile = {folder.X, y, folder.Scale, format, data};
+        batch.Tiles.append(tile);
+        batch.Bytes += data.size();
 
-    qDebug() << "Import Tiles Finished";
+        if (batch.Tiles.count() >= IMPORT_BATCH_TILES)
+            enqueueBatch(batch);
+    }
+
+    batch.FolderFinished = true;
+    enqueueBatch(batch);
 
+    QMutexLocker locker(&_mutex);
+    _pendingFolders--;
+    _batchAvailable.wakeAll();
 }
 
-void MapTilesImporter::importMapFromSASFiles(const QString &destDB, const QString &srcFolderName, int sourceId)
+MapTilesImportStatistics MapTilesImporter::importFolders(const QString &destDB, const QString &srcFolderName,
+                                                         const QList<TileFolder> &folders, int sourceId)
 {
-    qDebug() << "Import Tiles Started";
-    QSqlDatabase destinationDatabase = QSqlDatabase::addDatabase("QSQLITE", "TileFilesDestDB");
-    destinationDatabase.setDatabaseName(destDB);
-    destinationDatabase.open();
-    QSqlQuery destDBQuery(destinationDatabase);
-    destDBQuery.exec("CREATE TABLE MapTile (x INTEGER, y INTEGER, scale INTEGER, sourceId INTEGER, format INTEGER, autogenerated INTEGER, datetime REAL, signature INTEGER, tile BLOB)");
-    //qDebug() << "SqLite error:" << destDBQuery.lastError().text() << ", SqLite error code:" << destDBQuery.lastError().number();
+    MapTilesImportStatistics statistics;
+    QElapsedTimer timer;
+    timer.start();
 
-    //destDBQuery.exec("PRAGMA journal_mode = MEMORY");
+    qDebug() << "Import Tiles Started:" << srcFolderName << "," << folders.count() << "folders";
+    {
+        QSqlDatabase destinationDatabase = QSqlDatabase::addDatabase("QSQLITE", "TileFilesDestDB");
+        destinationDatabase.setDatabaseName(destDB);
+        if (!destinationDatabase.open())
+        {
+            qWarning() << "Import Tiles Failed:" << destinationDatabase.lastError().text();
+            destinationDatabase = QSqlDatabase();
+            QSqlDatabase::removeDatabase("TileFilesDestDB");
+            return statistics;
+        }
 
-    QSqlQuery insertQuery(destinationDatabase);
-    // autogenerated, datetime, signature
-    insertQuery.prepare("INSERT INTO MapTile (x, y, scale, sourceId, format, tile) " \
-                        "VALUES (?, ?, ?, ?, ?, ?)");
+        QSqlQuery destDBQuery(destinationDatabase);
+        destDBQuery.exec("CREATE TABLE IF NOT EXISTS MapTile (x INTEGER, y INTEGER, scale INTEGER, sourceId INTEGER, format INTEGER, autogenerated INTEGER, datetime REAL, signature INTEGER, tile BLOB)");
+        // Checkpoints without the source folder can't be matched, that import starts over
+        if (!destDBQuery.exec("SELECT source FROM MapTileImport LIMIT 1"))
+            destDBQuery.exec("DROP TABLE IF EXISTS MapTileImport");
+        destDBQuery.exec("CREATE TABLE IF NOT EXISTS MapTileImport (sourceId INTEGER, source TEXT, folder TEXT, PRIMARY KEY (sourceId, source, folder))");
+        destDBQuery.exec("PRAGMA synchronous = NORMAL");
+        destDBQuery.exec("PRAGMA cache_size = -65536");
+
+        // Tiles replace the tiles of the earlier imports, the tiles of the interrupted folder and each other
+        // (y.png and y.jpg of one folder), so the unique index is needed before the first insert
+        if (!TileDatabaseConnection::createUniqueTileIndex(destinationDatabase))
+        {
+            qWarning() << "Import Tiles Failed: no unique tile index";
+            destDBQuery.clear();
+            destinationDatabase.close();
+            destinationDatabase = QSqlDatabase();
+            QSqlDatabase::removeDatabase("TileFilesDestDB");
+            return statistics;
+        }
 
-    destinationDatabase.transaction();
+        // Folders imported before the interruption of the same source folder are skipped
+        const QString source = QDir(srcFolderName).absolutePath();
+        QSet<QString> importedFolders;
+        QSqlQuery progressQuery(destinationDatabase);
+        progressQuery.prepare("SELECT folder FROM MapTileImport WHERE sourceId = ? AND source = ?");
+        progressQuery.addBindValue(sourceId);
+        progressQuery.addBindValue(source);
+        if (progressQuery.exec())
+            while (progressQuery.next())
+                importedFolders.insert(progressQuery.value(0).toString());
+        if (!importedFolders.isEmpty())
+            qDebug() << "Import Tiles Resumed after" << importedFolders.count() << "folders";
+
+        QSqlQuery insertQuery(destinationDatabase);
+        insertQuery.prepare("INSERT OR REPLACE INTO MapTile (x, y, scale, sourceId, format, tile) " \
+                            "VALUES (?, ?, ?, ?, ?, ?)");
+        QSqlQuery checkpointQuery(destinationDatabase);
+        checkpointQuery.prepare("INSERT OR REPLACE INTO MapTileImport (sourceId, source, folder) VALUES (?, ?, ?)");
+
+        _batches.clear();
+        _queuedBytes = 0;
+        _pendingFolders = 0;
+        foreach (auto folder, folders)
+        {
+            if (importedFolders.contains(folder.RelativePath))
+            {
+                statistics.ResumedFolders++;
+                continue;
+            }
 
-    qint64 processedCount = 0;
-    //Root
-    QDir rootDir(srcFolderName);
-    QStringList zFolderNames1 = rootDir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Time);
-    foreach (const QString &zFolderName1, zFolderNames1)
-    {
-        //Z - level 1
-        QString zStr = zFolderName1;
-        int z = zStr.remove(0, 1).toInt() - 1;
-        QString fullZFolderName1 = srcFolderName + "\\" + zFolderName1;
-        QDir zDir1(fullZFolderName1);
-        QStringList zFolderNames2 = zDir1.entryList(QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Time);
-        foreach (const QString &zFolderName2, zFolderNames2)
+            _pendingFolders++;
+            _threadPool.start([this, srcFolderName, folder]()
+            {
+                readFolder(srcFolderName, folder);
+            });
+        }
+
+        destinationDatabase.transaction();
+        int transactionTileCount = 0;
+        qint64 lastProgressTimeMs = 0;
+
+        forever
         {
-            // Z - level 2
-            QString fullZFolderName2 = fullZFolderName1 + "\\" + zFolderName2;
-            QDir zDir2(fullZFolderName2);
-            QStringList xFolderNames1 = zDir2.entryList(QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Time);
-            foreach (const QString &xFolderName1, xFolderNames1)
+            TileBatch batch;
             {
-                // X - level 1
-                QString xStr = xFolderName1;
-                int x = xStr.remove(0, 1).toInt();
-                QString fullXFolderName1 = fullZFolderName2 + "\\" + xFolderName1;
-                QDir xDir1(fullXFolderName1);
-                QStringList xFolderNames2 = xDir1.entryList(QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Time);
-                foreach (const QString &xFolderName2, xFolderNames2)
-                {
-                    // X - level 2
-                    QString fullXFolderName2 = fullXFolderName1 + "\\" + xFolderName2;
-                    QDir xDir2(fullXFolderName2);
-                    QStringList yFileNames = xDir2.entryList(QDir::Files);
-                    foreach (const QString &yFileName, yFileNames)
-                    {
-                        QString yStr = yFileName;
-                        int y = yStr.section(".", 0, 0).remove(0, 1).toInt();
-
-                        QString extension = yStr.section('.', -1).toUpper();
-                        int tileFormat = 0;
-                        if (extension == "JPEG" || extension == "JPG")
-                            tileFormat = 1;
-                        else if (extension == "PNG")
-                            tileFormat = 2;
-
-                        QString fullYFileName = fullXFolderName2 + "\\" + yFileName;
-                        QFile file(fullYFileName);
-                        if (tileFormat != 0 && file.open(QIODevice::ReadOnly))
-                        {
-                            QByteArray blob = file.readAll();
-
-                            insertQuery.addBindValue(x);
-                            insertQuery.addBindValue(y);
-                            insertQuery.addBindValue(z);
-                            insertQuery.addBindValue(sourceId);
-                            insertQuery.addBindValue(tileFormat);
-                            insertQuery.addBindValue(blob);
-
-                            insertQuery.exec();
-
-                            processedCount++;
-
-                            if (processedCount % 5000 == 0)
-                                qDebug() << "Import Tiles Progress:" << processedCount;
-                        }
-                    }
-                }
+                QMutexLocker locker(&_mutex);
+                while (_batches.isEmpty() && _pendingFolders > 0)
+                    _batchAvailable.wait(&_mutex);
+                if (_batches.isEmpty())
+                    break;
+
+                batch = _batches.dequeue();
+                _queuedBytes -= batch.Bytes;
+                _queueSpaceAvailable.wakeAll();
+            }
+
+            foreach (const Tile &tile, batch.Tiles)
+            {
+                insertQuery.bindValue(0, tile.X);
+                insertQuery.bindValue(1, tile.Y);
+                insertQuery.bindValue(2, tile.Scale);
+                insertQuery.bindValue(3, sourceId);
+                insertQuery.bindValue(4, tile.Format);
+                insertQuery.bindValue(5, tile.Data);
+                if (insertQuery.exec())
+                    statistics.ImportedTiles++;
+                else
+                    statistics.SkippedFiles++;
+            }
+            statistics.ImportedBytes += batch.Bytes;
+            statistics.SkippedFiles += batch.SkippedFiles;
+            transactionTileCount += batch.Tiles.count();
+
+            // The folder is checkpointed in the transaction with its last tiles
+            if (batch.FolderFinished)
+            {
+                checkpointQuery.bindValue(0, sourceId);
+                checkpointQuery.bindValue(1, source);
+                checkpointQuery.bindValue(2, batch.Folder);
+                checkpointQuery.exec();
+            }
+
+            if (transactionTileCount >= IMPORT_TRANSACTION_TILES)
+            {
+                destinationDatabase.commit();
+                destinationDatabase.transaction();
+                transactionTileCount = 0;
+            }
+
+            qint64 elapsedMs = timer.elapsed();
+            if (elapsedMs - lastProgressTimeMs >= IMPORT_PROGRESS_INTERVAL_MS)
+            {
+                lastProgressTimeMs = elapsedMs;
+                statistics.DurationMs = elapsedMs;
+                qDebug() << "Import Tiles Progress:" << statistics.ImportedTiles << "tiles," << statistics.tilesPerSecond() << "tiles/s";
+                emit importProgressChanged(statistics.ImportedTiles, statistics.tilesPerSecond());
             }
         }
+
+        destinationDatabase.commit();
+        _threadPool.waitForDone();
+
+        // Import is completed, the next import of the source folder starts from the beginning
+        destDBQuery.prepare("DELETE FROM MapTileImport WHERE sourceId = ? AND source = ?");
+        destDBQuery.addBindValue(sourceId);
+        destDBQuery.addBindValue(source);
+        destDBQuery.exec();
+        if (destDBQuery.exec("SELECT COUNT(*) FROM MapTileImport") && destDBQuery.next() && destDBQuery.value(0).toInt() == 0)
+            destDBQuery.exec("DROP TABLE MapTileImport");
+
+        destDBQuery.clear();
+        insertQuery.clear();
+        checkpointQuery.clear();
+        progressQuery.clear();
+        destinationDatabase.close();
     }
+    QSqlDatabase::removeDatabase("TileFilesDestDB");
 
-    destinationDatabase.commit();
+    statistics.DurationMs = timer.elapsed();
+    qDebug() << "Import Tiles Finished:" << statistics.ImportedTiles << "tiles," << statistics.SkippedFiles << "skipped files,"
+             << statistics.ResumedFolders << "resumed folders," << statistics.tilesPerSecond() << "tiles/s";
+    emit importProgressChanged(statistics.ImportedTiles, statistics.tilesPerSecond());
 
-    destDBQuery.exec("CREATE UNIQUE INDEX TILE_SCALE_X_Y_SourceID ON MapTile (x, y, scale, sourceId)");
+    return statistics;
+}
 
-    destinationDatabase.close();
-    QSqlDatabase::removeDatabase("TileFilesDestDB");
+MapTilesImportStatistics MapTilesImporter::importMapFromMapnikFiles(const QString &destDB, const QString &srcFolderName, int sourceId)
+{
+    return importFolders(destDB, srcFolderName, findMapnikFolders(srcFolderName), sourceId);
+}
 
-    qDebug() << "Import Tiles Finished";
+MapTilesImportStatistics MapTilesImporter::importMapFromSASFiles(const QString &destDB, const QString &srcFolderName, int sourceId)
+{
+    return importFolders(destDB, srcFolderName, findSASFolders(srcFolderName), sourceId);
 }
@@ -2,14 +2,91 @@
 #define MAPTILESIMPORTER_H
 
 #include <QObject>
+#include <QThreadPool>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QVector>
+#include <QList>
+#include <QByteArray>
 
+struct MapTilesImportStatistics final
+{
+    qint64 ImportedTiles;
+    qint64 ImportedBytes;
+    qint64 SkippedFiles;        // unknown formats and damaged tiles
+    int ResumedFolders;         // folders imported before the interruption
+    qint64 DurationMs;
+
+    MapTilesImportStatistics()
+    {
+        ImportedTiles = 0;
+        ImportedBytes = 0;
+        SkippedFiles = 0;
+        ResumedFolders = 0;
+        DurationMs = 0;
+    }
+
+    double tilesPerSecond() const
+    {
+        return DurationMs > 0 ? 1000.0 * ImportedTiles / DurationMs : 0;
+    }
+};
+
+// Folders are scanned and tiles are read and validated on the thread pool, the calling thread writes them
+// in large transactions. Imported folders are checkpointed in the destination database with the tiles,
+// so the interrupted import of the same source folder and source id resumes
 class MapTilesImporter final : public QObject
 {
     Q_OBJECT
+
+    // All tiles of a folder have the same scale and x
+    struct TileFolder final
+    {
+        QString RelativePath;
+        int Scale, X;
+        bool SASNames;
+    };
+
+    struct Tile final
+    {
+        int X, Y, Scale, Format;
+        QByteArray Data;
+    };
+
+    struct TileBatch final
+    {
+        QString Folder;
+        QVector<Tile> Tiles;
+        qint64 Bytes;
+        qint64 SkippedFiles;
+        bool FolderFinished;    // the last batch of the folder
+    };
+
+    QThreadPool _threadPool;
+    QMutex _mutex;
+    QWaitCondition _batchAvailable;
+    QWaitCondition _queueSpaceAvailable;
+    QQueue<TileBatch> _batches;
+    qint64 _queuedBytes;
+    int _pendingFolders;
+
+    static QList<TileFolder> findMapnikFolders(const QString &srcFolderName);
+    static QList<TileFolder> findSASFolders(const QString &srcFolderName);
+    static int tileFormat(const QByteArray &data);
+
+    MapTilesImportStatistics importFolders(const QString &destDB, const QString &srcFolderName,
+                                           const QList<TileFolder> &folders, int sourceId);
+    void readFolder(const QString &srcFolderName, const TileFolder &folder);
+    void enqueueBatch(TileBatch &batch);
 public:
     explicit MapTilesImporter(QObject *parent = nullptr);
-    void importMapFromMapnikFiles(const QString &destDB, const QString &srcFolderName, int sourceId);
-    void importMapFromSASFiles(const QString &destDB, const QString &srcFolderName, int sourceId);
+    ~MapTilesImporter();
+
+    MapTilesImportStatistics importMapFromMapnikFiles(const QString &destDB, const QString &srcFolderName, int sourceId);
+    MapTilesImportStatistics importMapFromSASFiles(const QString &destDB, const QString &srcFolderName, int sourceId);
+signals:
+    void importProgressChanged(qint64 importedTiles, double tilesPerSecond);
 };
 
 #endif // MAPTILESIMPORTER_H
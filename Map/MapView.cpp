@@ -24,7 +24,7 @@ void MapView::closeEvent(QCloseEvent *event)
 MapView::MapView(QWidget *parent) :
     QWidget(parent)
 {    
-    EnterProc("MapView::MapView");
+    EnterProcStart("MapView::MapView");
 
     qInfo() << "Begin Init Map View";
 
@@ -52,34 +52,34 @@ MapView::~MapView()
 
 void MapView::showMapMarkers()
 {
-    EnterProc("MapView::showMapMarkers");
+    EnterProcStart("MapView::showMapMarkers");
     _view->loadMapMarkers();
 }
 
 void MapView::showArealObjects()
 {
-    EnterProc("MapView::showArealObjects");
+    EnterProcStart("MapView::showArealObjects");
     _view->loadArealObjects();
 }
 
-void MapView::loadTrajectory(const QVector<TelemetryDataFrame> &telemetryFrames)
+void MapView::loadTrajectory(const TelemetryFrameStore &telemetryFrames)
 {
-    EnterProc("MapView::loadTrajectory");
+    EnterProcStart("MapView::loadTrajectory");
 
     int frameCount = telemetryFrames.count();
     if (frameCount == 0)
         return;
-    TelemetryDataFrame telemetryFrame;
-    for (int i = 0; i < frameCount; i++)
+    for (int i = telemetryFrames.firstIndex(); i < frameCount; i++)
     {
-        telemetryFrame = telemetryFrames.at(i);
-        WorldGPSCoord pointCoords(telemetryFrame.UavLatitude_GPS, telemetryFrame.UavLongitude_GPS, 0);
+        WorldGPSCoord pointCoords(telemetryFrames.UavLatitude_GPS(i), telemetryFrames.UavLongitude_GPS(i), 0);
         _scene->addTrajectoryPoint(pointCoords, i == frameCount - 1);
     }
 
-    if (telemetryFrame.TelemetryFrameNumber > 0)
+    int lastIndex = frameCount - 1;
+    if (telemetryFrames.TelemetryFrameNumber(lastIndex) > 0)
     {
-        WorldGPSCoord uavCoord(telemetryFrame.UavLatitude_GPS, telemetryFrame.UavLongitude_GPS, telemetryFrame.UavAltitude_GPS);
+        WorldGPSCoord uavCoord(telemetryFrames.UavLatitude_GPS(lastIndex), telemetryFrames.UavLongitude_GPS(lastIndex),
+                               telemetryFrames.UavAltitude_GPS(lastIndex));
         setViewCenter(uavCoord);
     }
 }
@@ -111,14 +111,14 @@ void MapView::setViewCenter(const WorldGPSCoord &coord)
 
 void MapView::onMapZoomInClicked()
 {
-    EnterProc("MapView::onMapZoomInClicked");
+    EnterProcStart("MapView::onMapZoomInClicked");
     if (_scene->ScaleUp())
         _view->scale(2, 2);
 }
 
 void MapView::onMapZoomOutClicked()
 {
-    EnterProc("MapView::onMapZoomOutClicked");
+    EnterProcStart("MapView::onMapZoomOutClicked");
     if (_scene->ScaleDown())
         _view->scale(.5, .5);
 }
@@ -6,6 +6,7 @@
 #include <QTimerEvent>
 #include "MapGraphicsScene.h"
 #include "MapGraphicsView.h"
+#include "TelemetryFrameStore.h"
 
 class MapView final : public QWidget
 {
@@ -23,7 +24,7 @@ public:
     ~MapView();
     void showMapMarkers();
     void showArealObjects();
-    void loadTrajectory(const QVector<TelemetryDataFrame> &telemetryFrames);
+    void loadTrajectory(const TelemetryFrameStore &telemetryFrames);
     void appendTrajectoryPoint(const TelemetryDataFrame &telemetryFrame);
     void processTelemetry(const TelemetryDataFrame &telemetryFrame);
     void clearTrajectory();
@@ -15,7 +15,7 @@
 
 MarkerStorage::MarkerStorage(QObject *parent) : QObject(parent)
 {
-    EnterProc("MarkerStorage::MarkerStorage");
+    EnterProcStart("MarkerStorage::MarkerStorage");
 
     ApplicationSettings& applicationSettings = ApplicationSettings::Instance();
     QString databaseFile = applicationSettings.MarkerStorageDatabase;
@@ -52,7 +52,7 @@ void MarkerStorage::timerEvent(QTimerEvent *event)
 {
     //http://doc.qt.io/qt-5/qobject.html#startTimer
     Q_UNUSED(event)
-    EnterProc("MarkerStorage::timerEvent");
+    EnterProcStart("MarkerStorage::timerEvent");
     saveAllDirtyMarkers();
 }
 
@@ -73,7 +73,7 @@ MarkerStorage &MarkerStorage::Instance()
 
 void MarkerStorage::saveMarker(MapMarker *mapMarker)
 {
-    EnterProc("MarkerStorage::saveMarker");
+    EnterProcStart("MarkerStorage::saveMarker");
 
     auto partyMapMarker = dynamic_cast<PartyMapMarker*>(mapMarker);
     MarkerParty markerParty = (partyMapMarker == nullptr ? MarkerParty::Neutral : partyMapMarker->getParty());
@@ -103,7 +103,7 @@ void MarkerStorage::saveMarker(MapMarker *mapMarker)
 MapMarker *MarkerStorage::addMapMarkerToList(const QString &templateGUID, const QString &markerGUID, const WorldGPSCoord &gpsCoord,
                                              int markerTag, const QString &description, MarkerParty party, ArtillerySpotterState artillerySpotterState)
 {
-    EnterProc("MarkerStorage::addMapMarkerToList");
+    EnterProcStart("MarkerStorage::addMapMarkerToList");
 
     MarkerThesaurus& markerThesaurus = MarkerThesaurus::Instance();
     auto mapMarkerTemplate = markerThesaurus.getMarkerTemplateByGUID(templateGUID);
@@ -145,7 +145,7 @@ MapMarker *MarkerStorage::addMapMarkerToList(const QString &templateGUID, const
 
 void MarkerStorage::saveAllDirtyMarkers()
 {
-    EnterProc("MarkerStorage::saveAllDirtyMarkers");
+    EnterProcStart("MarkerStorage::saveAllDirtyMarkers");
     foreach (auto mapMarker, _mapMarkers)
         if (mapMarker->dirty())
             saveMarker(mapMarker);
@@ -153,7 +153,7 @@ void MarkerStorage::saveAllDirtyMarkers()
 
 MapMarker *MarkerStorage::createNewMarker(const QString &markerTemplateGUID, const WorldGPSCoord &gpsCoord)
 {
-    EnterProc("MarkerStorage::createNewMarker");
+    EnterProcStart("MarkerStorage::createNewMarker");
 
     ApplicationSettings& applicationSettings = ApplicationSettings::Instance();
 
@@ -187,7 +187,7 @@ MapMarker *MarkerStorage::createNewMarker(const QString &markerTemplateGUID, con
 
 void MarkerStorage::deleteMarker(MapMarker *mapMarker)
 {
-    EnterProc("MarkerStorage::deleteMarker");
+    EnterProcStart("MarkerStorage::deleteMarker");
 
     double deletedDT = GetCurrentDateTimeForDB();
 
@@ -255,7 +255,7 @@ void MarkerStorage::loadMarkerList()
     if (_mapMarkersLoaded)
         return;
 
-    EnterProc("MarkerStorage::loadMarkerList");
+    EnterProcStart("MarkerStorage::loadMarkerList");
 
     QSqlQuery selectQuery = EXEC_SQL(_mapMarkerDatabase,
                                      "SELECT GUID, TemplateGUID, Latitude, Longitude, Hmsl, "
@@ -286,7 +286,7 @@ void MarkerStorage::loadMarkerList()
 
 const QList<MapMarker *> *MarkerStorage::getMapMarkers()
 {
-    EnterProc("MarkerStorage::getMapMarkers");
+    EnterProcStart("MarkerStorage::getMapMarkers");
 
     loadMarkerList();
     return &_mapMarkers;
@@ -294,7 +294,7 @@ const QList<MapMarker *> *MarkerStorage::getMapMarkers()
 
 const QList<TargetMapMarker *> *MarkerStorage::getTargetMapMarkers()
 {
-    EnterProc("MarkerStorage::getTargetMapMarkers");
+    EnterProcStart("MarkerStorage::getTargetMapMarkers");
 
     loadMarkerList();
     return &_targetMapMarkers;
@@ -307,7 +307,7 @@ ArtillerySalvoCenterMarker *MarkerStorage::getSalvoCenterMarker()
 
 MapMarker *MarkerStorage::getMapMarkerByGUID(const QString &markerGUID)
 {
-    EnterProc("MarkerStorage::getMapMarkerByGUID");
+    EnterProcStart("MarkerStorage::getMapMarkerByGUID");
     loadMarkerList();
 
     foreach (auto mapMarker, _mapMarkers)
@@ -318,7 +318,7 @@ MapMarker *MarkerStorage::getMapMarkerByGUID(const QString &markerGUID)
 
 void MarkerStorage::cleanupObsoleteMapMarkers()
 {
-    EnterProc("MarkerStorage::CleanupObsoleteMapMarkers");
+    EnterProcStart("MarkerStorage::CleanupObsoleteMapMarkers");
     EXEC_SQL(_mapMarkerDatabase, "DELETE FROM MapMarker WHERE DeletedDT IS NOT NULL");
 }
 
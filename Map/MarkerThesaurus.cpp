@@ -17,7 +17,7 @@
 
 MarkerThesaurus::MarkerThesaurus(QObject *parent) : QObject(parent)
 {
-    EnterProc("MarkerThesaurus::MarkerThesaurus");
+    EnterProcStart("MarkerThesaurus::MarkerThesaurus");
 
     ApplicationSettings& applicationSettings = ApplicationSettings::Instance();
     QString databaseFile = applicationSettings.MarkerThesaurusDatabase;
@@ -76,7 +76,7 @@ QString getImageFixedPath(const QString &xmlFile, const QString &imagePath)
 
 void MarkerThesaurus::importAndReplaceFromXML(const QString &xmlFileName)
 {
-    EnterProc("MarkerThesaurus::ImportAndReplaceFromXML");
+    EnterProcStart("MarkerThesaurus::ImportAndReplaceFromXML");
 
     double deletedDT = GetCurrentDateTimeForDB();
     QSqlQuery deleteQuery(_markerThesaurusDatabase);
@@ -160,14 +160,14 @@ void MarkerThesaurus::importAndReplaceFromXML(const QString &xmlFileName)
 
 void MarkerThesaurus::cleanUp()
 {
-    EnterProc("MarkerThesaurus::CleanupObsoleteMarkerTemplates");
+    EnterProcStart("MarkerThesaurus::CleanupObsoleteMarkerTemplates");
     EXEC_SQL(_markerThesaurusDatabase, "DELETE FROM MarkerThesaurus WHERE DeletedDT IS NOT NULL");
     EXEC_SQL(_markerThesaurusDatabase, "VACUUM");
 }
 
 void MarkerThesaurus::saveMarkerTemplate(MarkerTemplate *markerTemplate)
 {
-    EnterProc("MarkerThesaurus::saveMarkerTemplate");
+    EnterProcStart("MarkerThesaurus::saveMarkerTemplate");
     saveMarkerTemplate(
                 markerTemplate->parentGUID(), markerTemplate->GUID(),
                 markerTemplate->description(), markerTemplate->comments(),
@@ -177,7 +177,7 @@ void MarkerThesaurus::saveMarkerTemplate(MarkerTemplate *markerTemplate)
 
 MarkerTemplate *MarkerThesaurus::createNewMarkerTemplate(QString parentGUID)
 {
-    EnterProc("MarkerThesaurus::createNewMarkerTemplate");
+    EnterProcStart("MarkerThesaurus::createNewMarkerTemplate");
     QString templateGUID = QUuid::createUuid().toString();
     if (parentGUID.isEmpty())
         parentGUID = templateGUID;
@@ -191,7 +191,7 @@ void MarkerThesaurus::saveMarkerTemplate(const QString &parentGUID, const QStrin
                                          const QPixmap &image,
                                          bool useParty, const QByteArray &rawSAMData, quint32 order)
 {
-    EnterProc("MarkerThesaurus::saveMarkerTemplate_2");
+    EnterProcStart("MarkerThesaurus::saveMarkerTemplate_2");
     double deletedDT = GetCurrentDateTimeForDB();
     QSqlQuery deleteQuery(_markerThesaurusDatabase);
     deleteQuery.prepare("UPDATE MarkerThesaurus SET DeletedDT = ? WHERE GUID = ?");
@@ -230,7 +230,7 @@ void MarkerThesaurus::saveMarkerTemplate(const QString &parentGUID, const QStrin
 
 void MarkerThesaurus::clearLists()
 {
-    EnterProc("MarkerThesaurus::clearLists");
+    EnterProcStart("MarkerThesaurus::clearLists");
 
     auto i = _markerTemplatesHash.begin();
     while (i != _markerTemplatesHash.end())
@@ -255,7 +255,7 @@ void MarkerThesaurus::appendMarkerTemplateToHash(const QString &parentGUID, cons
                                                  bool useParty, const QByteArray rawSAMData,
                                                  quint32 orderNo)
 {
-    EnterProc("MarkerThesaurus::appendMarkerTemplateToHash");
+    EnterProcStart("MarkerThesaurus::appendMarkerTemplateToHash");
     auto markerTemplate = new MarkerTemplate(this, parentGUID, markerGUID);
 
     markerTemplate->setDescription(description);
@@ -280,7 +280,7 @@ void MarkerThesaurus::appendMarkerTemplateToHash(const QString &parentGUID, cons
 
 const QList<MarkerTemplate *> *MarkerThesaurus::getMarkerTemplates()
 {
-    EnterProc("MarkerThesaurus::getMarkerTemplates");
+    EnterProcStart("MarkerThesaurus::getMarkerTemplates");
 
     if (_markerTemplates.count() > 0)
         return &_markerTemplates;
@@ -319,7 +319,7 @@ const QList<MarkerTemplate *> *MarkerThesaurus::getMarkerTemplates()
 
 MarkerTemplate *MarkerThesaurus::getMarkerTemplateByGUID(const QString &GUID)
 {
-    EnterProc("MarkerThesaurus::getMarkerTemplateByGUID");
+    EnterProcStart("MarkerThesaurus::getMarkerTemplateByGUID");
 
     getMarkerTemplates();
     auto markerTemplate = _markerTemplatesHash.value(GUID, NULL);
@@ -0,0 +1,270 @@
+#include "PipelineBenchmark.h"
+#include <QTimer>
+#include <QTextStream>
+#include <QDebug>
+#include <QtMath>
+#include <algorithm>
+#include <ctime>
+#ifdef Q_OS_LINUX
+#include <sys/resource.h>
+#endif
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+#include "ApplicationSettings.h"
+#include "CoordinateCalculator.h"
+#include "Map/HeightMapContainer.h"
+
+constexpr int BENCHMARK_START_TIMEOUT_MS = 60000;   // for the first frame
+
+void LatencySeries::received(quint32 frameNumber, qint64 timeUs)
+{
+    // Frames with the same number are measured from the first of them
+    if (!_receiveTimes.contains(frameNumber))
+        _receiveTimes.insert(frameNumber, timeUs);
+}
+
+void LatencySeries::processed(quint32 frameNumber, qint64 timeUs)
+{
+    auto receiveTime = _receiveTimes.find(frameNumber);
+    if (receiveTime == _receiveTimes.end())
+        return;
+
+    _latencies.append(timeUs - receiveTime.value());
+    _receiveTimes.erase(receiveTime);
+}
+
+int LatencySeries::count() const
+{
+    return _latencies.count();
+}
+
+int LatencySeries::pendingCount() const
+{
+    return _receiveTimes.count();
+}
+
+qint64 LatencySeries::percentile(const QVector<qint64> &sortedLatencies, double percent)
+{
+    if (sortedLatencies.isEmpty())
+        return 0;
+    int index = qBound(0, qCeil(percent / 100 * sortedLatencies.count()) - 1, sortedLatencies.count() - 1);
+    return sortedLatencies[index];
+}
+
+const QVector<qint64> LatencySeries::sortedLatencies() const
+{
+    QVector<qint64> latencies = _latencies;
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
+PipelineBenchmark::PipelineBenchmark(QObject *parent, int durationSec, bool recordSession, bool telemetryWithVideo) :
+    QObject(parent)
+{
+    qRegisterMetaType<TelemetryDataFrame>("TelemetryDataFrame");
+
+    _durationSec = durationSec;
+    _recordSession = recordSession;
+    _telemetryWithVideo = telemetryWithVideo;
+    _measuring = false;
+    _startCpuTimeUs = 0;
+    _lastTelemetryFrame.clear();
+
+    ApplicationSettings& applicationSettings = ApplicationSettings::Instance();
+    auto cameraSettings = applicationSettings.installedCameraSettings();
+
+    _dataStorage = new TelemetryDataStorage(this, applicationSettings.SessionsFolder,
+                                            applicationSettings.VideoFileFrameCount, applicationSettings.VideoFileQuality,
+                                            applicationSettings.OVRDisplayTelemetry,
+                                            applicationSettings.OVRTelemetryIndicatorFontSize,
+                                            applicationSettings.OVRTelemetryTimeFormat,
+                                            applicationSettings.OVRDisplayTargetRectangle,
+                                            applicationSettings.OVRGimbalIndicatorType,
+                                            applicationSettings.OVRGimbalIndicatorAngles,
+                                            applicationSettings.OVRGimbalIndicatorSize,
+                                            applicationSettings.isLaserRangefinderLicensed(),
+                                            applicationSettings.TelemetryHistoryMemoryLimitMb);
+
+    _hardwareLink = new HardwareLink(this);
+    connect(_hardwareLink, &HardwareLink::telemetryDataReceived, this, &PipelineBenchmark::hardwareLinkTelemetryReceived);
+    connect(_hardwareLink, &HardwareLink::videoDataReceived, this, &PipelineBenchmark::hardwareLinkVideoReceived);
+
+    auto heightMapContainer = new HeightMapContainer(this, applicationSettings.DatabaseHeightMap);
+    auto coordinateCalculator = new CoordinateCalculator(this, heightMapContainer);
+
+    _imageProcessor = new ImageProcessor(this, coordinateCalculator,
+                                         cameraSettings->opticalDeviceSetting(1)->UseVerticalFrameMirrororing,
+                                         applicationSettings.ObjectTrackerType,
+                                         applicationSettings.VideoProcessingQueueSize,
+                                         applicationSettings.VideoProcessingDropPolicy);
+    _imageProcessor->setStabilizationType(applicationSettings.VideoStabilizationType);
+    _imageProcessor->setStabilizationEnabled(applicationSettings.SoftwareStabilizationEnabled);
+
+    // Frames are measured after the storage has got them, so the storage slots are connected first
+    connect(_imageProcessor, &ImageProcessor::onTelemetryProcessed, _dataStorage, &TelemetryDataStorage::onTelemetryReceived);
+    connect(_imageProcessor, &ImageProcessor::onDataProcessed, _dataStorage, &TelemetryDataStorage::onDataReceived);
+    connect(_imageProcessor, &ImageProcessor::onTelemetryProcessed, this, &PipelineBenchmark::onTelemetryStored);
+    connect(_imageProcessor, &ImageProcessor::onDataProcessed, this, &PipelineBenchmark::onDataStored);
+}
+
+PipelineBenchmark::~PipelineBenchmark()
+{
+    //don't change order
+    delete _imageProcessor;
+    _imageProcessor = nullptr;
+    delete _hardwareLink;
+    _hardwareLink = nullptr;
+}
+
+void PipelineBenchmark::start()
+{
+    qInfo() << "Pipeline benchmark for" << _durationSec << "s, session recording:" << _recordSession
+            << ", telemetry with video:" << _telemetryWithVideo;
+
+    if (_recordSession)
+        _dataStorage->newSession();
+
+    _clock.start();
+    _hardwareLink->open();
+    _hardwareLink->openVideoSource();
+
+    QTimer::singleShot(BENCHMARK_START_TIMEOUT_MS, this, [this]()
+    {
+        if (!_measuring)
+        {
+            qWarning() << "Pipeline benchmark got no frames";
+            finish();
+        }
+    });
+}
+
+qint64 PipelineBenchmark::clockUs() const
+{
+    return _clock.nsecsElapsed() / 1000;
+}
+
+// User and system time of all threads
+qint64 PipelineBenchmark::processCpuTimeUs()
+{
+#if defined(Q_OS_LINUX)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return (qint64)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#elif defined(Q_OS_WIN)
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+        return 0;
+    auto toUs = [](const FILETIME &time) { return (qint64)(((quint64)time.dwHighDateTime << 32) | time.dwLowDateTime) / 10; };
+    return toUs(kernelTime) + toUs(userTime);
+#else
+    return (qint64)std::clock() * 1000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+void PipelineBenchmark::startMeasuring()
+{
+    // The measuring time starts with the first received frame, the replay may be started later than the benchmark
+    if (_measuring)
+        return;
+
+    _measuring = true;
+    _clock.restart();
+    _startCpuTimeUs = processCpuTimeUs();
+    QTimer::singleShot(_durationSec * 1000, this, &PipelineBenchmark::finish);
+}
+
+void PipelineBenchmark::hardwareLinkTelemetryReceived(const TelemetryDataFrame &telemetryFrame)
+{
+    startMeasuring();
+    _telemetryLatencies.received(telemetryFrame.TelemetryFrameNumber, clockUs());
+
+    // The former path: the tick is a video frame that is corrected, tracked and stored again
+    if (_telemetryWithVideo && !_lastVideoFrame.isNull())
+        _imageProcessor->processDataAsync(telemetryFrame, _lastVideoFrame);
+    else
+        _imageProcessor->processTelemetry(telemetryFrame);
+}
+
+void PipelineBenchmark::hardwareLinkVideoReceived(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame)
+{
+    startMeasuring();
+    _videoLatencies.received(telemetryFrame.VideoFrameNumber, clockUs());
+    _imageProcessor->processDataAsync(telemetryFrame, videoFrame);
+    _lastVideoFrame = videoFrame;
+}
+
+void PipelineBenchmark::onTelemetryStored(const TelemetryDataFrame &telemetryFrame)
+{
+    _telemetryLatencies.processed(telemetryFrame.TelemetryFrameNumber, clockUs());
+    _lastTelemetryFrame = telemetryFrame;
+}
+
+void PipelineBenchmark::onDataStored(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame)
+{
+    Q_UNUSED(videoFrame)
+
+    _videoLatencies.processed(telemetryFrame.VideoFrameNumber, clockUs());
+    if (_telemetryWithVideo)
+        _telemetryLatencies.processed(telemetryFrame.TelemetryFrameNumber, clockUs());
+    _lastTelemetryFrame = telemetryFrame;
+}
+
+void PipelineBenchmark::finish()
+{
+    _hardwareLink->closeVideoSource();
+    _hardwareLink->close();
+
+    report();
+
+    if (_recordSession)
+        _dataStorage->stopSession();
+    emit finished();
+}
+
+void PipelineBenchmark::report()
+{
+    double durationSec = _clock.nsecsElapsed() / 1e9;
+    double cpuTimeSec = (processCpuTimeUs() - _startCpuTimeUs) / 1e6;
+    auto imageProcessorStatistics = _imageProcessor->statistics();
+
+    QString text;
+    QTextStream out(&text);
+    out << "Pipeline benchmark, " << durationSec << " s" << Qt::endl;
+
+    auto reportSeries = [&out, durationSec](const QString &name, const LatencySeries &series)
+    {
+        QVector<qint64> latencies = series.sortedLatencies();
+        out << name << ": " << series.count() << " frames, " << (durationSec > 0 ? series.count() / durationSec : 0) << " frames/s";
+        out << ", not completed " << series.pendingCount() << Qt::endl;
+        out << "    latency, ms: p50 " << LatencySeries::percentile(latencies, 50) / 1000.0
+            << ", p90 " << LatencySeries::percentile(latencies, 90) / 1000.0
+            << ", p99 " << LatencySeries::percentile(latencies, 99) / 1000.0
+            << ", max " << LatencySeries::percentile(latencies, 100) / 1000.0 << Qt::endl;
+    };
+    reportSeries("Telemetry", _telemetryLatencies);
+    reportSeries("Video", _videoLatencies);
+
+    out << "CPU time " << cpuTimeSec << " s, " << (durationSec > 0 ? 100 * cpuTimeSec / durationSec : 0) << "% of one core"
+        << (_telemetryWithVideo ? ", telemetry ticks are processed with the last video frame" : "") << Qt::endl;
+
+    out << "Image processor: dropped video frames " << imageProcessorStatistics.DroppedVideoFrames
+        << ", max queue depth " << imageProcessorStatistics.MaxQueueDepth
+        << ", max frame delay " << imageProcessorStatistics.MaxFrameDelayMs << " ms" << Qt::endl;
+    out << "Stabilization: max frame time " << imageProcessorStatistics.MaxStabilizationTimeUs / 1000.0
+        << " ms, frames over the " << ImageStabilazation::timeBudgetNs() / 1000000.0 << " ms budget "
+        << imageProcessorStatistics.OverBudgetStabilizationFrames << Qt::endl;
+    out << "Dropped telemetry datagrams: " << _lastTelemetryFrame.DroppedTelemetryDatagramCount << Qt::endl;
+
+    if (_recordSession)
+    {
+        auto writerStatistics = _dataStorage->getSessionWriterStatistics();
+        out << "Session writer: written frames " << writerStatistics.WrittenTelemetryFrames
+            << ", backpressure events " << writerStatistics.BackpressureEvents
+            << ", max frame latency " << writerStatistics.MaxFrameLatencyUs / 1000.0 << " ms" << Qt::endl;
+    }
+
+    qInfo().noquote() << text;
+    QTextStream(stdout) << text;
+}
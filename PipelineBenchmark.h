@@ -0,0 +1,75 @@
+#ifndef PIPELINEBENCHMARK_H
+#define PIPELINEBENCHMARK_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QImage>
+#include "TelemetryDataFrame.h"
+#include "TelemetryDataStorage.h"
+#include "HardwareLink/HardwareLink.h"
+#include "ImageProcessor/ImageProcessor.h"
+
+// Latencies of one kind of frames, us
+class LatencySeries final
+{
+    QHash<quint32, qint64> _receiveTimes;   // frame number -> receive time
+    QVector<qint64> _latencies;
+public:
+    void received(quint32 frameNumber, qint64 timeUs);
+    void processed(quint32 frameNumber, qint64 timeUs);
+
+    int count() const;
+    int pendingCount() const;
+    const QVector<qint64> sortedLatencies() const;
+    // Percentile 0...100 of the sorted latencies
+    static qint64 percentile(const QVector<qint64> &sortedLatencies, double percent);
+};
+
+// Headless pipeline HardwareLink -> ImageProcessor (with CoordinateCalculator) -> TelemetryDataStorage, it is
+// wired as the main window does. Reports the throughput, the latency from receiving to storing of the frames and
+// the CPU time. Telemetry ticks can be sent through the image pipeline with the last video frame, as it was done
+// before they were separated, to compare the CPU time
+class PipelineBenchmark final : public QObject
+{
+    Q_OBJECT
+
+    TelemetryDataStorage *_dataStorage;
+    HardwareLink *_hardwareLink;
+    ImageProcessor *_imageProcessor;
+
+    int _durationSec;
+    bool _recordSession;
+    bool _telemetryWithVideo;
+    QImage _lastVideoFrame;
+
+    QElapsedTimer _clock;
+    qint64 _startCpuTimeUs;
+    bool _measuring;
+    LatencySeries _telemetryLatencies;
+    LatencySeries _videoLatencies;
+    TelemetryDataFrame _lastTelemetryFrame;
+
+    qint64 clockUs() const;
+    void startMeasuring();
+    void report();
+public:
+    explicit PipelineBenchmark(QObject *parent, int durationSec, bool recordSession, bool telemetryWithVideo);
+    ~PipelineBenchmark();
+
+    void start();
+
+    // User and system time of all threads
+    static qint64 processCpuTimeUs();
+private slots:
+    void hardwareLinkTelemetryReceived(const TelemetryDataFrame &telemetryFrame);
+    void hardwareLinkVideoReceived(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame);
+    void onTelemetryStored(const TelemetryDataFrame &telemetryFrame);
+    void onDataStored(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame);
+    void finish();
+signals:
+    void finished();
+};
+
+#endif // PIPELINEBENCHMARK_H
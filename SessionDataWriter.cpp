@@ -0,0 +1,328 @@
+#include "SessionDataWriter.h"
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QMutexLocker>
+#include <QDebug>
+#include "Common/CommonUtils.h"
+
+constexpr int TELEMETRY_QUEUE_CAPACITY = 8192;
+constexpr int TELEMETRY_ROWS_PER_INSERT = 25;   // 25 rows * 38 columns fits SQLITE_MAX_VARIABLE_NUMBER=999
+constexpr int TELEMETRY_ROWS_PER_TRANSACTION = 2000;
+constexpr int WRITER_WAKEUP_QUEUE_DEPTH = 50;
+constexpr int WRITER_IDLE_TIMEOUT_MS = 250;
+
+static const QString TELEMETRY_FRAMES_COLUMNS =
+        "FrameTime, Roll, Pitch, Yaw, GPSLat, GPSLon, GPSHmsl, Altitude, VSpeed, CamRoll, CamPitch, CamYaw, CamZoom, "
+        "CamEncoderRoll, CamEncoderPitch, CamEncoderYaw, "
+        "AirSpeed, GroundSpeed_GPS, "
+        "WindDirection, WindSpeed, GroundSpeedNorth_GPS, GroundSpeedEast_GPS,  BombState, RangefinderDistance, "
+        "StabilizedCenterX, StabilizedCenterY, "
+        "TargetCenterX, TargetCenterY, TargetRectWidth, TargetRectHeight, "
+        "CalculatedTargetGPSLat, CalculatedTargetGPSLon, CalculatedTargetGPSHmsl, "
+        "CalculatedTargetSpeed, CalculatedTargetDirection, "
+        "TelemetryFrameNumber, VideoFrameNumber, SessionTimeMs";
+constexpr int TELEMETRY_FRAMES_COLUMN_COUNT = 38;
+
+const QString getTelemetryFramesInsertSQL(int rowCount)
+{
+    QStringList placeholders;
+    for (int i = 0; i < TELEMETRY_FRAMES_COLUMN_COUNT; i++)
+        placeholders.append("?");
+    QString rowPlaceholders = "(" + placeholders.join(", ") + ")";
+
+    QStringList rows;
+    for (int i = 0; i < rowCount; i++)
+        rows.append(rowPlaceholders);
+
+    return QString("INSERT INTO TelemetryFrames (%1) VALUES %2").arg(TELEMETRY_FRAMES_COLUMNS, rows.join(", "));
+}
+
+void bindTelemetryFrame(QSqlQuery &query, const TelemetryDataFrame &telemetryFrame)
+{
+    query.addBindValue(telemetryFrame.Time);
+    query.addBindValue(telemetryFrame.UavRoll);
+    query.addBindValue(telemetryFrame.UavPitch);
+    query.addBindValue(telemetryFrame.UavYaw);
+    query.addBindValue(telemetryFrame.UavLatitude_GPS);
+    query.addBindValue(telemetryFrame.UavLongitude_GPS);
+    query.addBindValue(telemetryFrame.UavAltitude_GPS);
+    query.addBindValue(telemetryFrame.UavAltitude_Barometric);
+    query.addBindValue(telemetryFrame.VerticalSpeed);
+    query.addBindValue(telemetryFrame.CamRoll);
+    query.addBindValue(telemetryFrame.CamPitch);
+    query.addBindValue(telemetryFrame.CamYaw);
+    query.addBindValue(telemetryFrame.CamZoom);
+    query.addBindValue(telemetryFrame.CamEncoderRoll);
+    query.addBindValue(telemetryFrame.CamEncoderPitch);
+    query.addBindValue(telemetryFrame.CamEncoderYaw);
+    query.addBindValue(telemetryFrame.AirSpeed);
+    query.addBindValue(telemetryFrame.GroundSpeed_GPS);
+    query.addBindValue(telemetryFrame.WindDirection);
+    query.addBindValue(telemetryFrame.WindSpeed);
+    query.addBindValue(telemetryFrame.GroundSpeedNorth_GPS);
+    query.addBindValue(telemetryFrame.GroundSpeedEast_GPS);
+    query.addBindValue(telemetryFrame.BombState);
+    query.addBindValue(telemetryFrame.RangefinderDistance);
+    query.addBindValue(telemetryFrame.StabilizedCenterX);
+    query.addBindValue(telemetryFrame.StabilizedCenterY);
+    query.addBindValue(telemetryFrame.TrackedTargetCenterX);
+    query.addBindValue(telemetryFrame.TrackedTargetCenterY);
+    query.addBindValue(telemetryFrame.TrackedTargetRectWidth);
+    query.addBindValue(telemetryFrame.TrackedTargetRectHeight);
+    query.addBindValue(telemetryFrame.CalculatedTrackedTargetGPSLat);
+    query.addBindValue(telemetryFrame.CalculatedTrackedTargetGPSLon);
+    query.addBindValue(telemetryFrame.CalculatedTrackedTargetGPSHmsl);
+    query.addBindValue(telemetryFrame.CalculatedTrackedTargetSpeed);
+    query.addBindValue(telemetryFrame.CalculatedTrackedTargetDirection);
+    query.addBindValue(telemetryFrame.TelemetryFrameNumber);
+    query.addBindValue(telemetryFrame.VideoFrameNumber);
+    query.addBindValue(telemetryFrame.SessionTimeMs);
+}
+
+SessionDataWriterThread::SessionDataWriterThread(QObject *parent, const QString &databaseFileName) : QThread(parent),
+    _telemetryFrames(TELEMETRY_QUEUE_CAPACITY)
+{
+    _databaseFileName = databaseFileName;
+    _connectionName = QString("SessionDataWriterConnection_%1").arg((quintptr)this);
+    _overflowActive = 0;
+    _queuedTelemetryFrameCount = 0;
+    _backpressureEventCount = 0;
+    _maxQueueDepth = 0;
+    _quit = false;
+    _clock.start();
+}
+
+SessionDataWriterThread::~SessionDataWriterThread()
+{
+    stop();
+}
+
+void SessionDataWriterThread::run()
+{
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", _connectionName);
+        database.setDatabaseName(_databaseFileName);
+        database.open();
+        LOG_SQL_ERROR(database);
+        EXEC_SQL(database, "PRAGMA journal_mode = WAL");
+        EXEC_SQL(database, "PRAGMA synchronous = NORMAL");
+
+        QSqlQuery batchInsertQuery(database);
+        batchInsertQuery.prepare(getTelemetryFramesInsertSQL(TELEMETRY_ROWS_PER_INSERT));
+        LOG_SQL_ERROR(batchInsertQuery);
+
+        QSqlQuery singleInsertQuery(database);
+        singleInsertQuery.prepare(getTelemetryFramesInsertSQL(1));
+        LOG_SQL_ERROR(singleInsertQuery);
+
+        bool quit = false;
+        while (!quit)
+        {
+            _mutex.lock();
+            if (!_quit)
+                _waitCondition.wait(&_mutex, WRITER_IDLE_TIMEOUT_MS);
+            quit = _quit;
+            _mutex.unlock();
+
+            writePendingData(database, batchInsertQuery, singleInsertQuery);
+        }
+
+        batchInsertQuery.finish();
+        singleInsertQuery.finish();
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(_connectionName);
+}
+
+void SessionDataWriterThread::writePendingData(QSqlDatabase &database, QSqlQuery &batchInsertQuery, QSqlQuery &singleInsertQuery)
+{
+    bool hasMoreFrames = true;
+    while (hasMoreFrames)
+    {
+        QVector<QueuedTelemetryFrame> frames;
+        frames.reserve(TELEMETRY_ROWS_PER_TRANSACTION);
+
+        QueuedTelemetryFrame queuedFrame;
+        while (frames.count() < TELEMETRY_ROWS_PER_TRANSACTION && _telemetryFrames.pop(queuedFrame))
+            frames.append(queuedFrame);
+
+        QQueue<DataExchangePackage> clientCommands;
+        QQueue<DataExchangePackage> artillerySpotterDataPackages;
+
+        _mutex.lock();
+        if (frames.count() < TELEMETRY_ROWS_PER_TRANSACTION && _overflowActive.loadRelaxed())
+        {
+            while (frames.count() < TELEMETRY_ROWS_PER_TRANSACTION && !_overflowTelemetryFrames.isEmpty())
+                frames.append(_overflowTelemetryFrames.dequeue());
+            if (_overflowTelemetryFrames.isEmpty())
+                _overflowActive = 0;
+        }
+        clientCommands.swap(_clientCommands);
+        artillerySpotterDataPackages.swap(_artillerySpotterDataPackages);
+        _mutex.unlock();
+
+        hasMoreFrames = (frames.count() == TELEMETRY_ROWS_PER_TRANSACTION);
+
+        if (frames.isEmpty() && clientCommands.isEmpty() && artillerySpotterDataPackages.isEmpty())
+            break;
+
+        QElapsedTimer commitTimer;
+        commitTimer.start();
+
+        database.transaction();
+        LOG_SQL_ERROR(database);
+        writeTelemetryFrames(batchInsertQuery, singleInsertQuery, frames);
+        writeClientCommands(database, clientCommands);
+        writeArtillerySpotterDataPackages(database, artillerySpotterDataPackages);
+        database.commit();
+        LOG_SQL_ERROR(database);
+
+        quint32 commitTimeUs = commitTimer.nsecsElapsed() / 1000;
+        qint64 currentTimeNs = _clock.nsecsElapsed();
+
+        QMutexLocker locker(&_statisticsMutex);
+        _statistics.WrittenTelemetryFrames += frames.count();
+        _statistics.LastCommitTimeUs = commitTimeUs;
+        _statistics.MaxCommitTimeUs = qMax(_statistics.MaxCommitTimeUs, commitTimeUs);
+        if (!frames.isEmpty())
+        {
+            quint32 frameLatencyUs = (currentTimeNs - frames.first().EnqueueTimeNs) / 1000;
+            _statistics.MaxFrameLatencyUs = qMax(_statistics.MaxFrameLatencyUs, frameLatencyUs);
+        }
+    }
+}
+
+void SessionDataWriterThread::writeTelemetryFrames(QSqlQuery &batchInsertQuery, QSqlQuery &singleInsertQuery,
+                                                   const QVector<QueuedTelemetryFrame> &frames)
+{
+    int frameCount = frames.count();
+    int i = 0;
+    for (; i + TELEMETRY_ROWS_PER_INSERT <= frameCount; i += TELEMETRY_ROWS_PER_INSERT)
+    {
+        for (int k = i; k < i + TELEMETRY_ROWS_PER_INSERT; k++)
+            bindTelemetryFrame(batchInsertQuery, frames[k].Frame);
+        batchInsertQuery.exec();
+        LOG_SQL_ERROR(batchInsertQuery);
+    }
+    for (; i < frameCount; i++)
+    {
+        bindTelemetryFrame(singleInsertQuery, frames[i].Frame);
+        singleInsertQuery.exec();
+        LOG_SQL_ERROR(singleInsertQuery);
+    }
+}
+
+void SessionDataWriterThread::writeClientCommands(QSqlDatabase &database, const QQueue<DataExchangePackage> &clientCommands)
+{
+    if (clientCommands.isEmpty())
+        return;
+
+    QSqlQuery insertQuery(database);
+    insertQuery.prepare("INSERT INTO ClientCommands "
+                        "(SessionTimeMs, TelemetryFrameNumber, VideoFrameNumber, CommandHEX, Description) "
+                        "VALUES (?, ?, ?, ?, ?)"
+                        );
+    LOG_SQL_ERROR(insertQuery);
+
+    foreach (auto clientCommand, clientCommands)
+    {
+        insertQuery.addBindValue(clientCommand.SessionTimeMs);
+        insertQuery.addBindValue(clientCommand.TelemetryFrameNumber);
+        insertQuery.addBindValue(clientCommand.VideoFrameNumber);
+        insertQuery.addBindValue(clientCommand.contentHex());
+        insertQuery.addBindValue(clientCommand.Description);
+
+        insertQuery.exec();
+        LOG_SQL_ERROR(insertQuery);
+    }
+}
+
+void SessionDataWriterThread::writeArtillerySpotterDataPackages(QSqlDatabase &database, const QQueue<DataExchangePackage> &dataPackages)
+{
+    if (dataPackages.isEmpty())
+        return;
+
+    QSqlQuery insertQuery(database);
+    insertQuery.prepare("INSERT INTO ArtillerySpotterData "
+                        "(SessionTimeMs, TelemetryFrameNumber, VideoFrameNumber, ContentHEX, Description, Direction) "
+                        "VALUES (?, ?, ?, ?, ?, ?)"
+                        );
+    LOG_SQL_ERROR(insertQuery);
+
+    foreach (auto dataPackage, dataPackages)
+    {
+        insertQuery.addBindValue(dataPackage.SessionTimeMs);
+        insertQuery.addBindValue(dataPackage.TelemetryFrameNumber);
+        insertQuery.addBindValue(dataPackage.VideoFrameNumber);
+        insertQuery.addBindValue(dataPackage.contentHex());
+        insertQuery.addBindValue(dataPackage.Description);
+        insertQuery.addBindValue(dataPackage.Direction);
+
+        insertQuery.exec();
+        LOG_SQL_ERROR(insertQuery);
+    }
+}
+
+void SessionDataWriterThread::enqueueTelemetryFrame(const TelemetryDataFrame &telemetryFrame)
+{
+    QueuedTelemetryFrame queuedFrame;
+    queuedFrame.Frame = telemetryFrame;
+    queuedFrame.EnqueueTimeNs = _clock.nsecsElapsed();
+
+    // Once the lock-free queue overflows, frames go to the overflow queue until the writer drains it, to keep frame order
+    bool queued = !_overflowActive.loadRelaxed() && _telemetryFrames.push(queuedFrame);
+    if (!queued)
+    {
+        _mutex.lock();
+        _overflowActive = 1;
+        _overflowTelemetryFrames.enqueue(queuedFrame);
+        _mutex.unlock();
+    }
+
+    quint32 queueDepth = _telemetryFrames.size();
+
+    _queuedTelemetryFrameCount.fetchAndAddRelaxed(1);
+    if (!queued)
+        _backpressureEventCount.fetchAndAddRelaxed(1);
+    if (_maxQueueDepth.loadRelaxed() < queueDepth)
+        _maxQueueDepth.storeRelaxed(queueDepth);
+
+    if (queueDepth >= WRITER_WAKEUP_QUEUE_DEPTH)
+        _waitCondition.wakeOne();
+}
+
+void SessionDataWriterThread::enqueueClientCommand(const DataExchangePackage &clientCommand)
+{
+    _mutex.lock();
+    _clientCommands.enqueue(clientCommand);
+    _mutex.unlock();
+}
+
+void SessionDataWriterThread::enqueueArtillerySpotterDataPackage(const DataExchangePackage &dataPackage)
+{
+    _mutex.lock();
+    _artillerySpotterDataPackages.enqueue(dataPackage);
+    _mutex.unlock();
+}
+
+void SessionDataWriterThread::stop()
+{
+    if (!isRunning())
+        return;
+
+    _mutex.lock();
+    _quit = true;
+    _waitCondition.wakeOne();
+    _mutex.unlock();
+    wait();
+}
+
+const SessionDataWriterStatistics SessionDataWriterThread::statistics() const
+{
+    QMutexLocker locker(&_statisticsMutex);
+    SessionDataWriterStatistics statistics = _statistics;
+    statistics.QueuedTelemetryFrames = _queuedTelemetryFrameCount.loadRelaxed();
+    statistics.BackpressureEvents = _backpressureEventCount.loadRelaxed();
+    statistics.MaxQueueDepth = _maxQueueDepth.loadRelaxed();
+    return statistics;
+}
@@ -0,0 +1,86 @@
+#ifndef SESSIONDATAWRITER_H
+#define SESSIONDATAWRITER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QSqlQuery>
+#include "TelemetryDataFrame.h"
+#include "Common/SpscRingBuffer.h"
+
+struct SessionDataWriterStatistics final
+{
+    quint64 QueuedTelemetryFrames;
+    quint64 WrittenTelemetryFrames;
+    quint64 BackpressureEvents;     // frames which did not fit into the lock-free queue
+    quint32 MaxQueueDepth;
+    quint32 LastCommitTimeUs;
+    quint32 MaxCommitTimeUs;
+    quint32 MaxFrameLatencyUs;      // from enqueueing on the GUI thread to commit
+
+    SessionDataWriterStatistics()
+    {
+        memset(this, 0, sizeof(SessionDataWriterStatistics));
+    }
+};
+
+// Persists session data to the session SQLite database on its own thread and connection.
+// Telemetry frames are passed over a lock-free queue, the GUI thread never waits for the disk.
+class SessionDataWriterThread final : public QThread
+{
+    Q_OBJECT
+
+    struct QueuedTelemetryFrame
+    {
+        TelemetryDataFrame Frame;
+        qint64 EnqueueTimeNs;
+    };
+
+    QString _databaseFileName;
+    QString _connectionName;
+    QElapsedTimer _clock;
+
+    SpscRingBuffer<QueuedTelemetryFrame> _telemetryFrames;
+    QAtomicInt _overflowActive;
+    QQueue<QueuedTelemetryFrame> _overflowTelemetryFrames;
+    QQueue<DataExchangePackage> _clientCommands;
+    QQueue<DataExchangePackage> _artillerySpotterDataPackages;
+
+    QMutex _mutex;
+    QWaitCondition _waitCondition;
+    bool _quit;
+
+    // Producer side counters are atomics, so enqueueing stays lock-free
+    QAtomicInteger<quint64> _queuedTelemetryFrameCount;
+    QAtomicInteger<quint64> _backpressureEventCount;
+    QAtomicInteger<quint32> _maxQueueDepth;
+    mutable QMutex _statisticsMutex;
+    SessionDataWriterStatistics _statistics;
+
+    void writePendingData(QSqlDatabase &database, QSqlQuery &batchInsertQuery, QSqlQuery &singleInsertQuery);
+    void writeTelemetryFrames(QSqlQuery &batchInsertQuery, QSqlQuery &singleInsertQuery, const QVector<QueuedTelemetryFrame> &frames);
+    void writeClientCommands(QSqlDatabase &database, const QQueue<DataExchangePackage> &clientCommands);
+    void writeArtillerySpotterDataPackages(QSqlDatabase &database, const QQueue<DataExchangePackage> &dataPackages);
+public:
+    SessionDataWriterThread(QObject *parent, const QString &databaseFileName);
+    ~SessionDataWriterThread();
+
+    void run();
+
+    void enqueueTelemetryFrame(const TelemetryDataFrame &telemetryFrame);
+    void enqueueClientCommand(const DataExchangePackage &clientCommand);
+    void enqueueArtillerySpotterDataPackage(const DataExchangePackage &dataPackage);
+    // Writes all queued data and finishes the thread
+    void stop();
+
+    const SessionDataWriterStatistics statistics() const;
+};
+
+// INSERT of rowCount TelemetryFrames rows and binding of one row to it
+const QString getTelemetryFramesInsertSQL(int rowCount);
+void bindTelemetryFrame(QSqlQuery &query, const TelemetryDataFrame &telemetryFrame);
+
+#endif // SESSIONDATAWRITER_H
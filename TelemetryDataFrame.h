@@ -3,6 +3,7 @@
 #define TELEMETRYDATAFRAME_H
 
 #include <QString>
+#include <QByteArray>
 #include <QQuaternion>
 #include <QRect>
 #include <QPoint>
@@ -59,6 +60,13 @@ struct TelemetryDataFrame final
     qint32 VideoFPS;
     qint32 TelemetryFPS;
 
+    qint32 VideoProcessingQueueDepth;   // video frames waiting for image processing
+    qint32 VideoProcessingDelayMs;      // time from receiving of the video frame to the end of its processing
+    quint32 DroppedVideoFrameCount;     // video frames dropped by image processing during the session
+    quint32 DroppedTelemetryDatagramCount; // telemetry datagrams dropped by the receive sockets
+    quint32 CameraTelemetryFramingErrorCount;  // MUSV frames with a known head and a wrong length
+    quint32 CameraTelemetryChecksumErrorCount;
+
     static bool UseGimbalTelemetryOnlyForCalculation;
 
     float RangefinderDistance;      // Значение дистанции от дальномера
@@ -127,7 +135,7 @@ struct DataExchangePackage final
     quint32 VideoFrameNumber;
     quint32 SessionTimeMs;
 
-    QString ContentHEX;
+    QByteArray Content;             // raw bytes, hex is formatted only for consoles and the session storage
     QString Description;
     DataExchangePackageDirection Direction;
 
@@ -137,6 +145,11 @@ struct DataExchangePackage final
         VideoFrameNumber = 0;
         SessionTimeMs = 0;
     }
+
+    const QString contentHex() const
+    {
+        return Content.toHex();
+    }
 };
 
 struct WeatherDataItem final
@@ -11,7 +11,7 @@
 #include "EnterProc.h"
 
 const QString SCREENSHOTS_FOLDER_NAME = "Screenshots";
-const qint32 FRAME_FLUSH_BATCH_SIZE = 50;
+const int RECENT_TELEMETRY_FRAME_COUNT = 3000;
 
 TelemetryDataStorage::TelemetryDataStorage(QObject *parent, const QString &sessionFolder,
                                            const quint32 videoFileFrameCount,
@@ -23,7 +23,9 @@ TelemetryDataStorage::TelemetryDataStorage(QObject *parent, const QString &sessi
                                            const OSDGimbalIndicatorType gimbalIndicatorType,
                                            const OSDGimbalIndicatorAngles gimbalIndicatorAngles,
                                            const quint32 gimbalIndicatorSize,
-                                           const bool isLaserRangefinderLicensed) : QObject(parent)
+                                           const bool isLaserRangefinderLicensed,
+                                           const quint32 telemetryHistoryMemoryLimitMb) : QObject(parent),
+    _telemetryFrames(telemetryHistoryMemoryLimitMb, RECENT_TELEMETRY_FRAME_COUNT)
 {
     EnterProcStart("TelemetryDataStorage::TelemetryDataStorage");
 
@@ -38,11 +40,13 @@ TelemetryDataStorage::TelemetryDataStorage(QObject *parent, const QString &sessi
     _gimbalIndicatorSize = gimbalIndicatorSize;
     _displayTargetRectangleOnVideo = displayTargetRectangleOnVideo;
     _isLaserRangefinderLicensed = isLaserRangefinderLicensed;
+    _telemetryHistoryMemoryLimitMb = telemetryHistoryMemoryLimitMb;
 
     _workMode = WorkMode::DisplayOnly;
     _destroing = false;
 
     _videoRecordingStubImage = nullptr;
+    _sessionWriter = nullptr;
 
     _videoRecorder = new PartitionedVideoRecorder(this);
 
@@ -83,15 +87,10 @@ void TelemetryDataStorage::stopSession()
 
     _mediaPlayer->stop();
     _videoRecorder->stop();
-    flushTelemetryDataFrames();
-    flushClientCommands();
-    flushArtillerySpotterDataPackages();
+    stopSessionWriter();
     flushSessionInfos();
 
     _sessionDatabase.close();
-    _lastSavedTelemetryFrameIndex = -1;
-    _lastSavedClientCommandIndex = -1;
-    _lastSavedArtillerySpotterDataPackageIndex = -1;
     _lastVideoFrameNumber = -1;
     // _telemetryFramesDatabase.close();
 
@@ -99,8 +98,7 @@ void TelemetryDataStorage::stopSession()
     QSqlDatabase::removeDatabase("TelemetryFramesStorageConnection");
 
     _telemetryFrames.clear();
-    _clientCommands.clear();
-    _artillerySpotterDataPackages.clear();
+    _telemetryFrames.setMemoryLimit(_telemetryHistoryMemoryLimitMb);
 
     _workMode = WorkMode::DisplayOnly;
     _sessionName = "";
@@ -138,157 +136,24 @@ void TelemetryDataStorage::openTelemetryFramesDatabase()
                                "SessionTimeMs INTEGER, TelemetryFrameNumber INTEGER, VideoFrameNumber INTEGER, "
                                "ContentHEX TEXT, Description VARCHAR(255), Direction INTEGER )");
 
-    EXEC_SQL(_sessionDatabase, "PRAGMA journal_mode = MEMORY");
-
     loadSessionInfos();
 }
 
-void TelemetryDataStorage::flushTelemetryDataFrames()
-{
-    if (!_sessionDatabase.isOpen() || (_workMode != WorkMode::RecordAndDisplay))
-        return;
-    EnterProcStart("TelemetryDataStorage::flushTelemetryDataFrames");
-
-
-    _sessionDatabase.transaction();
-    LOG_SQL_ERROR(_sessionDatabase);
-
-    QSqlQuery insertQuery(_sessionDatabase);
-    insertQuery.prepare("INSERT INTO TelemetryFrames "
-                        "(FrameTime, Roll, Pitch, Yaw, GPSLat, GPSLon, GPSHmsl, Altitude, VSpeed, CamRoll, CamPitch, CamYaw, CamZoom, "
-                        "CamEncoderRoll, CamEncoderPitch, CamEncoderYaw, "
-                        "AirSpeed, GroundSpeed_GPS, "
-                        "WindDirection, WindSpeed, GroundSpeedNorth_GPS, GroundSpeedEast_GPS,  BombState, RangefinderDistance, "
-                        "StabilizedCenterX, StabilizedCenterY, "
-                        "TargetCenterX, TargetCenterY, TargetRectWidth, TargetRectHeight, "
-                        "CalculatedTargetGPSLat, CalculatedTargetGPSLon, CalculatedTargetGPSHmsl, "
-                        "CalculatedTargetSpeed, CalculatedTargetDirection, "
-                        "TelemetryFrameNumber, VideoFrameNumber, SessionTimeMs) "
-                        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"
-                        );
-    LOG_SQL_ERROR(insertQuery);
-
-    int telemetryFramesCount = _telemetryFrames.count();
-    for (int i = _lastSavedTelemetryFrameIndex + 1; i < telemetryFramesCount; i++)
-    {
-        const TelemetryDataFrame telemetryFrame = _telemetryFrames[i];
-
-        insertQuery.addBindValue(telemetryFrame.Time);
-        insertQuery.addBindValue(telemetryFrame.UavRoll);
-        insertQuery.addBindValue(telemetryFrame.UavPitch);
-        insertQuery.addBindValue(telemetryFrame.UavYaw);
-        insertQuery.addBindValue(telemetryFrame.UavLatitude_GPS);
-        insertQuery.addBindValue(telemetryFrame.UavLongitude_GPS);
-        insertQuery.addBindValue(telemetryFrame.UavAltitude_GPS);
-        insertQuery.addBindValue(telemetryFrame.UavAltitude_Barometric);
-        insertQuery.addBindValue(telemetryFrame.VerticalSpeed);
-        insertQuery.addBindValue(telemetryFrame.CamRoll);
-        insertQuery.addBindValue(telemetryFrame.CamPitch);
-        insertQuery.addBindValue(telemetryFrame.CamYaw);
-        insertQuery.addBindValue(telemetryFrame.CamZoom);
-        insertQuery.addBindValue(telemetryFrame.CamEncoderRoll);
-        insertQuery.addBindValue(telemetryFrame.CamEncoderPitch);
-        insertQuery.addBindValue(telemetryFrame.CamEncoderYaw);
-        insertQuery.addBindValue(telemetryFrame.AirSpeed);
-        insertQuery.addBindValue(telemetryFrame.GroundSpeed_GPS);
-        insertQuery.addBindValue(telemetryFrame.WindDirection);
-        insertQuery.addBindValue(telemetryFrame.WindSpeed);
-        insertQuery.addBindValue(telemetryFrame.GroundSpeedNorth_GPS);
-        insertQuery.addBindValue(telemetryFrame.GroundSpeedEast_GPS);
-        insertQuery.addBindValue(telemetryFrame.BombState);
-        insertQuery.addBindValue(telemetryFrame.RangefinderDistance);
-        insertQuery.addBindValue(telemetryFrame.StabilizedCenterX);
-        insertQuery.addBindValue(telemetryFrame.StabilizedCenterY);
-        insertQuery.addBindValue(telemetryFrame.TrackedTargetCenterX);
-        insertQuery.addBindValue(telemetryFrame.TrackedTargetCenterY);
-        insertQuery.addBindValue(telemetryFrame.TrackedTargetRectWidth);
-        insertQuery.addBindValue(telemetryFrame.TrackedTargetRectHeight);
-        insertQuery.addBindValue(telemetryFrame.CalculatedTrackedTargetGPSLat);
-        insertQuery.addBindValue(telemetryFrame.CalculatedTrackedTargetGPSLon);
-        insertQuery.addBindValue(telemetryFrame.CalculatedTrackedTargetGPSHmsl);
-        insertQuery.addBindValue(telemetryFrame.CalculatedTrackedTargetSpeed);
-        insertQuery.addBindValue(telemetryFrame.CalculatedTrackedTargetDirection);
-        insertQuery.addBindValue(telemetryFrame.TelemetryFrameNumber);
-        insertQuery.addBindValue(telemetryFrame.VideoFrameNumber);
-        insertQuery.addBindValue(telemetryFrame.SessionTimeMs);
-        insertQuery.exec();
-        LOG_SQL_ERROR(insertQuery);
-    }
-
-    _sessionDatabase.commit();
-    LOG_SQL_ERROR(_sessionDatabase);
-    _lastSavedTelemetryFrameIndex = telemetryFramesCount - 1;
-}
-
-void TelemetryDataStorage::flushClientCommands()
-{
-    if (!_sessionDatabase.isOpen() || (_workMode != WorkMode::RecordAndDisplay))
-        return;
-    EnterProcStart("TelemetryDataStorage::flushClientCommands");
-
-    _sessionDatabase.transaction();
-    LOG_SQL_ERROR(_sessionDatabase);
-
-    QSqlQuery insertQuery(_sessionDatabase);
-    insertQuery.prepare("INSERT INTO ClientCommands "
-                        "(SessionTimeMs, TelemetryFrameNumber, VideoFrameNumber, CommandHEX, Description) "
-                        "VALUES (?, ?, ?, ?, ?)"
-                        );
-    LOG_SQL_ERROR(insertQuery);
-
-    int clientCommandsCount = _clientCommands.count();
-    for (int i = _lastSavedClientCommandIndex + 1; i < clientCommandsCount; i++)
-    {
-        const DataExchangePackage clientCommand = _clientCommands[i];
-        insertQuery.addBindValue(clientCommand.SessionTimeMs);
-        insertQuery.addBindValue(clientCommand.TelemetryFrameNumber);
-        insertQuery.addBindValue(clientCommand.VideoFrameNumber);
-        insertQuery.addBindValue(clientCommand.ContentHEX);
-        insertQuery.addBindValue(clientCommand.Description);
-
-        insertQuery.exec();
-        LOG_SQL_ERROR(insertQuery);
-    }
-
-    _sessionDatabase.commit();
-    LOG_SQL_ERROR(_sessionDatabase);
-    _lastSavedClientCommandIndex = clientCommandsCount - 1;
-}
-
-void TelemetryDataStorage::flushArtillerySpotterDataPackages()
+void TelemetryDataStorage::stopSessionWriter()
 {
-    if (!_sessionDatabase.isOpen() || (_workMode != WorkMode::RecordAndDisplay))
+    if (_sessionWriter == nullptr)
         return;
-    EnterProcStart("TelemetryDataStorage::flushArtillerySpotterDataPackages");
-
-    _sessionDatabase.transaction();
-    LOG_SQL_ERROR(_sessionDatabase);
+    EnterProcStart("TelemetryDataStorage::stopSessionWriter");
 
-    QSqlQuery insertQuery(_sessionDatabase);
-    insertQuery.prepare("INSERT INTO ArtillerySpotterData "
-                        "(SessionTimeMs, TelemetryFrameNumber, VideoFrameNumber, ContentHEX, Description, Direction) "
-                        "VALUES (?, ?, ?, ?, ?, ?)"
-                        );
-    LOG_SQL_ERROR(insertQuery);
-
-    int artillerySpotterDataPackagesCount = _artillerySpotterDataPackages.count();
-    for (int i = _lastSavedArtillerySpotterDataPackageIndex + 1; i < artillerySpotterDataPackagesCount; i++)
-    {
-        const DataExchangePackage dataPackage = _artillerySpotterDataPackages[i];
-        insertQuery.addBindValue(dataPackage.SessionTimeMs);
-        insertQuery.addBindValue(dataPackage.TelemetryFrameNumber);
-        insertQuery.addBindValue(dataPackage.VideoFrameNumber);
-        insertQuery.addBindValue(dataPackage.ContentHEX);
-        insertQuery.addBindValue(dataPackage.Description);
-        insertQuery.addBindValue(dataPackage.Direction);
+    _sessionWriter->stop();
 
-        insertQuery.exec();
-        LOG_SQL_ERROR(insertQuery);
-    }
+    auto statistics = _sessionWriter->statistics();
+    qDebug() << "Session writer. Frames:" << statistics.WrittenTelemetryFrames << "of" << statistics.QueuedTelemetryFrames
+             << "Backpressure:" << statistics.BackpressureEvents << "Max queue depth:" << statistics.MaxQueueDepth
+             << "Max commit (us):" << statistics.MaxCommitTimeUs << "Max latency (us):" << statistics.MaxFrameLatencyUs;
 
-    _sessionDatabase.commit();
-    LOG_SQL_ERROR(_sessionDatabase);
-    _lastSavedArtillerySpotterDataPackageIndex = artillerySpotterDataPackagesCount - 1;
+    delete _sessionWriter;
+    _sessionWriter = nullptr;
 }
 
 const QString TelemetryDataStorage::getSessionFolder() const
@@ -310,12 +175,16 @@ void TelemetryDataStorage::newSession()
         return;
 
     openTelemetryFramesDatabase();
+    EXEC_SQL(_sessionDatabase, "PRAGMA journal_mode = WAL");
 
+    _workMode = WorkMode::RecordAndDisplay;
     initSessionInfos();
 
+    _sessionWriter = new SessionDataWriterThread(this, _sessionDatabase.databaseName());
+    _sessionWriter->start();
+
     _videoRecorder->start(sessionFolder, _sessionName, _defaultVideoFileFrameCount, _defaultVideoFileQuality);
 
-    _workMode = WorkMode::RecordAndDisplay;
     emit workModeChanged();
 }
 
@@ -329,6 +198,8 @@ void TelemetryDataStorage::openSession(const QString &sessionName)
 
     openTelemetryFramesDatabase();
 
+    // Stored sessions are played back as a whole
+    _telemetryFrames.setMemoryLimit(0);
     readTelemetryFrames();
 
     _workMode = WorkMode::PlayStored;
@@ -533,64 +404,103 @@ int TelemetryDataStorage::getTelemetryDataFrameCount() const
     return _telemetryFrames.count();
 }
 
-const QVector<TelemetryDataFrame> &TelemetryDataStorage::getTelemetryDataFrames()
+int TelemetryDataStorage::getFirstTelemetryDataFrameIndex() const
+{
+    return _telemetryFrames.firstIndex();
+}
+
+const TelemetryFrameStore &TelemetryDataStorage::getTelemetryDataFrames() const
 {
     return _telemetryFrames;
 }
 
-const QList<TelemetryDataFrame> TelemetryDataStorage::getLastTelemetryDataFrames(quint32 mseconds)
+const QList<WorldGPSCoord> TelemetryDataStorage::getLastTelemetryCoords(quint32 mseconds, TelemetryCoordSource coordSource) const
 {
-    QList<TelemetryDataFrame> selectedFrames;
-    auto lastTime = _telemetryFrames.last().SessionTimeMs;
-    int i = _telemetryFrames.count() - 1;
-    while ( (i > 0) && ( (lastTime - _telemetryFrames[i].SessionTimeMs) <= mseconds) )
+    QList<WorldGPSCoord> coords;
+    int frameCount = _telemetryFrames.count();
+    if (frameCount == 0)
+        return coords;
+
+    quint32 lastTime = _telemetryFrames.SessionTimeMs(frameCount - 1);
+    int firstIndex = _telemetryFrames.lowerBoundBySessionTime(lastTime > mseconds ? lastTime - mseconds : 0);
+    for (int i = qMax(firstIndex, 1); i < frameCount; i++)
     {
-        selectedFrames.prepend(_telemetryFrames[i]);
-        i--;
+        WorldGPSCoord coord;
+        switch (coordSource)
+        {
+        case TelemetryCoordSource::UavCoords:
+            coord = WorldGPSCoord(_telemetryFrames.UavLatitude_GPS(i), _telemetryFrames.UavLongitude_GPS(i), _telemetryFrames.UavAltitude_GPS(i));
+            break;
+        case TelemetryCoordSource::RangefinderCoords:
+            coord = WorldGPSCoord(_telemetryFrames.CalculatedRangefinderGPSLat(i), _telemetryFrames.CalculatedRangefinderGPSLon(i),
+                                  _telemetryFrames.CalculatedRangefinderGPSHmsl(i));
+            break;
+        case TelemetryCoordSource::TrackedTargetCoords:
+            coord = WorldGPSCoord(_telemetryFrames.CalculatedTrackedTargetGPSLat(i), _telemetryFrames.CalculatedTrackedTargetGPSLon(i),
+                                  _telemetryFrames.CalculatedTrackedTargetGPSHmsl(i));
+            break;
+        }
+        if (_telemetryFrames.TelemetryFrameNumber(i) <= 0)
+            coord.setIncorrect();
+        coords.append(coord);
     }
-    return selectedFrames;
+    return coords;
 }
 
-void TelemetryDataStorage::onDataReceived(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame)
+void TelemetryDataStorage::onTelemetryReceived(const TelemetryDataFrame &telemetryFrame)
 {
-    //0.
     _telemetryFrames.append(telemetryFrame);
 
+    if (_workMode == WorkMode::RecordAndDisplay)
+        _sessionWriter->enqueueTelemetryFrame(telemetryFrame);
+}
+
+void TelemetryDataStorage::onDataReceived(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame)
+{
+    // The telemetry of video frames is stored too, playback finds frames by it
+    onTelemetryReceived(telemetryFrame);
+
     if (_workMode != WorkMode::RecordAndDisplay)
         return;
     EnterProcStart("TelemetryDataStorage::onDataReceived");
-    //1. Telemetry
-    if (_telemetryFrames.count() - _lastSavedTelemetryFrameIndex > FRAME_FLUSH_BATCH_SIZE)
-        flushTelemetryDataFrames();
 
-    //2. Video
     if (_lastVideoFrameNumber != (qint32)telemetryFrame.VideoFrameNumber)
     {
         if (!videoFrame.isNull())
         {
-            QImage videoFrameForSave = videoFrame.copy();
-            QPainter painter(&videoFrameForSave);
-            painter.setRenderHint(QPainter::Antialiasing, true);
-            QFont font = painter.font();
-            font.setPointSize(14);
-            painter.setFont(font);
-            QPen pen = painter.pen();
-            pen.setColor(Qt::green);
-            painter.setPen(pen);
-            if (_displayTelemetryOnVideo)
-                drawTelemetryOnVideo(painter, telemetryFrame, _telemetryIndicatorFontSize, _isLaserRangefinderLicensed,  _telemetryTimeFormat);
-
-            drawGimbalOnVideo(painter, _gimbalIndicatorType, _gimbalIndicatorAngles, _gimbalIndicatorSize, telemetryFrame);
-
-            if (_displayTargetRectangleOnVideo && telemetryFrame.targetIsVisible())
+            // OSD is drawn by the recorder encoder threads, not on the GUI thread
+            const bool displayTelemetryOnVideo = _displayTelemetryOnVideo;
+            const bool displayTargetRectangleOnVideo = _displayTargetRectangleOnVideo;
+            const quint32 telemetryIndicatorFontSize = _telemetryIndicatorFontSize;
+            const bool isLaserRangefinderLicensed = _isLaserRangefinderLicensed;
+            const OSDTelemetryTimeFormat telemetryTimeFormat = _telemetryTimeFormat;
+            const OSDGimbalIndicatorType gimbalIndicatorType = _gimbalIndicatorType;
+            const OSDGimbalIndicatorAngles gimbalIndicatorAngles = _gimbalIndicatorAngles;
+            const quint32 gimbalIndicatorSize = _gimbalIndicatorSize;
+
+            _videoRecorder->saveFrame(videoFrame, [=](QImage &videoFrameForSave)
             {
-                const QColor targetRectColor = ((AutomaticTracerMode)telemetryFrame.CamTracerMode == AutomaticTracerMode::atmScreenPoint) ?  Qt::blue : Qt::red;
-                pen.setColor(targetRectColor);
+                QPainter painter(&videoFrameForSave);
+                painter.setRenderHint(QPainter::Antialiasing, true);
+                QFont font = painter.font();
+                font.setPointSize(14);
+                painter.setFont(font);
+                QPen pen = painter.pen();
+                pen.setColor(Qt::green);
                 painter.setPen(pen);
-                drawTargetRectangleOnVideo(painter, telemetryFrame.targetRect());
-            }
-
-            _videoRecorder->saveFrame(videoFrameForSave);
+                if (displayTelemetryOnVideo)
+                    drawTelemetryOnVideo(painter, telemetryFrame, telemetryIndicatorFontSize, isLaserRangefinderLicensed, telemetryTimeFormat);
+
+                drawGimbalOnVideo(painter, gimbalIndicatorType, gimbalIndicatorAngles, gimbalIndicatorSize, telemetryFrame);
+
+                if (displayTargetRectangleOnVideo && telemetryFrame.targetIsVisible())
+                {
+                    const QColor targetRectColor = ((AutomaticTracerMode)telemetryFrame.CamTracerMode == AutomaticTracerMode::atmScreenPoint) ?  Qt::blue : Qt::red;
+                    pen.setColor(targetRectColor);
+                    painter.setPen(pen);
+                    drawTargetRectangleOnVideo(painter, telemetryFrame.targetRect());
+                }
+            });
         }
         _lastVideoFrameNumber = telemetryFrame.VideoFrameNumber;
     }
@@ -601,9 +511,7 @@ void TelemetryDataStorage::onClientCommandSent(const DataExchangePackage &client
     if (_workMode != WorkMode::RecordAndDisplay)
         return;
     EnterProcStart("TelemetryDataStorage::onClientCommandSent");
-    _clientCommands.append(clientCommand);
-    if (_clientCommands.count() - _lastSavedClientCommandIndex > FRAME_FLUSH_BATCH_SIZE)
-        flushClientCommands();
+    _sessionWriter->enqueueClientCommand(clientCommand);
 }
 
 void TelemetryDataStorage::onArtillerySpotterDataExchange(const DataExchangePackage &dataPackage)
@@ -611,16 +519,14 @@ void TelemetryDataStorage::onArtillerySpotterDataExchange(const DataExchangePack
     if (_workMode != WorkMode::RecordAndDisplay)
         return;
     EnterProcStart("TelemetryDataStorage::onArtillerySpotterDataExchange");
-    _artillerySpotterDataPackages.append(dataPackage);
-    if (_artillerySpotterDataPackages.count() - _lastSavedArtillerySpotterDataPackageIndex > FRAME_FLUSH_BATCH_SIZE)
-        flushArtillerySpotterDataPackages();
+    _sessionWriter->enqueueArtillerySpotterDataPackage(dataPackage);
 }
 
 const TelemetryDataFrame TelemetryDataStorage::getTelemetryDataFrameByIndex(int frameIndex)
 {
-    if (_telemetryFrames.count() <= 0)
-        qDebug() << "getTelemetryDataFrameByIndex crash";
-    return _telemetryFrames[frameIndex];
+    if (!_telemetryFrames.isValidIndex(frameIndex))
+        qDebug() << "Telemetry frame index is out of the stored range:" << frameIndex;
+    return _telemetryFrames.frame(frameIndex);
 }
 
 const QVector<WeatherDataItem> TelemetryDataStorage::getWeatherData(quint32 lastMSeconds)
@@ -634,29 +540,31 @@ const QVector<WeatherDataItem> TelemetryDataStorage::getWeatherData(quint32 last
     double atmospherePressureSum[WEATHER_ITEMS_MAX_COUNT] = { 0 };
     double atmosphereTemperatureSum[WEATHER_ITEMS_MAX_COUNT] = { 0 };
 
-    quint32 frameCount = _telemetryFrames.count();
-    quint32 endTime = _telemetryFrames.at(frameCount - 1).SessionTimeMs;
+    qint32 frameCount = _telemetryFrames.count();
+    if (frameCount == 0)
+        return QVector<WeatherDataItem>();
+    quint32 endTime = _telemetryFrames.SessionTimeMs(frameCount - 1);
     quint32 prevTelemetryFrameNumber = 0;
 
-    TelemetryDataFrame telemetryFrame;
-    for (int i = frameCount - 1; i > 0; i--)
+    for (int i = frameCount - 1; i > qMax(0, _telemetryFrames.firstIndex() - 1); i--)
     {
-        telemetryFrame = _telemetryFrames.at(i);
-
-        if (prevTelemetryFrameNumber == telemetryFrame.TelemetryFrameNumber)
+        quint32 telemetryFrameNumber = _telemetryFrames.TelemetryFrameNumber(i);
+        if (prevTelemetryFrameNumber == telemetryFrameNumber)
             continue;
-        if (endTime - telemetryFrame.SessionTimeMs > lastMSeconds) // 1800000 ms = 30 minutes
+        if (endTime - _telemetryFrames.SessionTimeMs(i) > lastMSeconds) // 1800000 ms = 30 minutes
             break;
 
-        prevTelemetryFrameNumber = telemetryFrame.TelemetryFrameNumber;
-        double altitide = telemetryFrame.UavAltitude_GPS; //??? UavAltitude_Barometric;
+        prevTelemetryFrameNumber = telemetryFrameNumber;
+        double altitide = _telemetryFrames.UavAltitude_GPS(i); //??? UavAltitude_Barometric;
         quint32 index = altitide < 0 ? 0 : round(altitide / WEATHER_ITEMS_ALTITUDE_STEP);
+        if (index >= WEATHER_ITEMS_MAX_COUNT)
+            continue;
 
         measureCount[index] += 1;
-        windDirectionSum[index] += telemetryFrame.WindDirection;
-        windSpeedSum[index] += telemetryFrame.WindSpeed;
-        atmospherePressureSum[index] += telemetryFrame.AtmospherePressure;
-        atmosphereTemperatureSum[index] += telemetryFrame.AtmosphereTemperature;
+        windDirectionSum[index] += _telemetryFrames.WindDirection(i);
+        windSpeedSum[index] += _telemetryFrames.WindSpeed(i);
+        atmospherePressureSum[index] += _telemetryFrames.AtmospherePressure(i);
+        atmosphereTemperatureSum[index] += _telemetryFrames.AtmosphereTemperature(i);
     }
 
     QVector<WeatherDataItem> weatherDataColl;
@@ -685,12 +593,19 @@ const QString TelemetryDataStorage::getTelemetryFrameTimeAsString(const Telemetr
     return result;
 }
 
+const SessionDataWriterStatistics TelemetryDataStorage::getSessionWriterStatistics() const
+{
+    if (_sessionWriter == nullptr)
+        return SessionDataWriterStatistics();
+    return _sessionWriter->statistics();
+}
+
 const QString TelemetryDataStorage::getLastTelemetryFrameTimeAsString() const
 {
     unsigned int timeMs = 0;
     int frameCount = _telemetryFrames.count();
     if (frameCount > 0)
-        timeMs = _telemetryFrames[frameCount - 1].SessionTimeMs;
+        timeMs = _telemetryFrames.SessionTimeMs(frameCount - 1);
     QString result = getTimeAsString(timeMs);
     return result;
 }
@@ -705,14 +620,14 @@ void TelemetryDataStorage::showStoredDataAsync(const TelemetryDataFrame &telemet
 
     unsigned int frameNumber = -1;
     if (telemetryFramesCount > 0)
-        frameNumber = telemetryDataFrame.VideoFrameNumber - _telemetryFrames[0].VideoFrameNumber;
+        frameNumber = telemetryDataFrame.VideoFrameNumber - _telemetryFrames.firstVideoFrameNumber();
     QString currentVideoFile = getVideoFileNameForFrame(getSessionFolder(), _sessionName, _sessionVideoFileFrameCount, frameNumber);
 
     if ((telemetryFramesCount > 0) && (_workMode == WorkMode::RecordAndDisplay))
     {
         unsigned int recordingFrameNumber =
-                _telemetryFrames[telemetryFramesCount - 1].VideoFrameNumber -
-                _telemetryFrames[0].VideoFrameNumber;
+                _telemetryFrames.VideoFrameNumber(telemetryFramesCount - 1) -
+                _telemetryFrames.firstVideoFrameNumber();
         QString recordingVideoFile = getVideoFileNameForFrame(getSessionFolder(), _sessionName, _sessionVideoFileFrameCount, recordingFrameNumber);
         if (recordingVideoFile == currentVideoFile)
         {
@@ -9,6 +9,8 @@
 #include <QImage>
 #include "VideoRecorder/CameraFrameGrabber.h"
 #include "TelemetryDataFrame.h"
+#include "TelemetryFrameStore.h"
+#include "SessionDataWriter.h"
 #include "VideoRecorder/PartitionedVideoRecorder.h"
 #include "Common/CommonData.h"
 #include "Constants.h"
@@ -24,6 +26,13 @@ public:
         RecordAndDisplay
     };
 
+    enum TelemetryCoordSource
+    {
+        UavCoords,
+        RangefinderCoords,
+        TrackedTargetCoords
+    };
+
     explicit TelemetryDataStorage(QObject *parent, const QString &sessionFolder,
                                   const quint32 videoFileFrameCount,
                                   const quint32 videoFileQuality,
@@ -34,7 +43,8 @@ public:
                                   const OSDGimbalIndicatorType gimbalIndicatorType,
                                   const OSDGimbalIndicatorAngles gimbalIndicatorAngles,
                                   const quint32 gimbalIndicatorSize,
-                                  const bool isLaserRangefinderLicensed);
+                                  const bool isLaserRangefinderLicensed,
+                                  const quint32 telemetryHistoryMemoryLimitMb);
     ~TelemetryDataStorage();
 
     WorkMode getWorkMode() const;
@@ -49,10 +59,11 @@ public:
     const QString getScreenshotFolder() const;
 
     int getTelemetryDataFrameCount() const;
+    int getFirstTelemetryDataFrameIndex() const;    // older frames are released by the memory limit
 
-    const QVector<TelemetryDataFrame> &getTelemetryDataFrames();
+    const TelemetryFrameStore &getTelemetryDataFrames() const;
 
-    const QList<TelemetryDataFrame> getLastTelemetryDataFrames(quint32 mseconds);
+    const QList<WorldGPSCoord> getLastTelemetryCoords(quint32 mseconds, TelemetryCoordSource coordSource) const;
 
     const TelemetryDataFrame getTelemetryDataFrameByIndex(int frameIndex);
 
@@ -61,9 +72,12 @@ public:
     const QString getTelemetryFrameTimeAsString(const TelemetryDataFrame &telemetryFrame) const;
     const QString getLastTelemetryFrameTimeAsString() const;
 
+    const SessionDataWriterStatistics getSessionWriterStatistics() const;
+
     void showStoredDataAsync(const TelemetryDataFrame &telemetryDataFrame);
 
 public slots:
+    void onTelemetryReceived(const TelemetryDataFrame &telemetryFrame);
     void onDataReceived(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame);
     void onClientCommandSent(const DataExchangePackage &clientCommand);
     void onArtillerySpotterDataExchange(const DataExchangePackage &dataPackage);
@@ -92,10 +106,10 @@ private:
     OSDGimbalIndicatorAngles _gimbalIndicatorAngles;
     quint32 _gimbalIndicatorSize;
     bool _isLaserRangefinderLicensed;
+    quint32 _telemetryHistoryMemoryLimitMb;
 
-    QVector<TelemetryDataFrame> _telemetryFrames;
-    QVector<DataExchangePackage> _clientCommands;
-    QVector<DataExchangePackage> _artillerySpotterDataPackages;
+    TelemetryFrameStore _telemetryFrames;
+    SessionDataWriterThread * _sessionWriter;
     PartitionedVideoRecorder * _videoRecorder;
     QMediaPlayer * _mediaPlayer;
     CameraFrameGrabber * _mediaPlayerFrameGraber;
@@ -105,9 +119,6 @@ private:
 
     TelemetryDataFrame _telemetryDataFrameForAsyncShow;
 
-    qint32 _lastSavedTelemetryFrameIndex;
-    qint32 _lastSavedClientCommandIndex;
-    qint32 _lastSavedArtillerySpotterDataPackageIndex;
     qint32 _lastVideoFrameNumber;
     QString _lastOpenedVideoFile;
 
@@ -126,9 +137,7 @@ private:
 
     const QString getSessionFolder() const;
     void openTelemetryFramesDatabase();
-    void flushTelemetryDataFrames();
-    void flushClientCommands();
-    void flushArtillerySpotterDataPackages();
+    void stopSessionWriter();
 signals:
     void storedDataReceived(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame);
     void workModeChanged();
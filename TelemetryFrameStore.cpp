@@ -0,0 +1,151 @@
+#include "TelemetryFrameStore.h"
+#include <QtGlobal>
+#include <limits>
+
+constexpr int TELEMETRY_STORE_MIN_SEGMENT_COUNT = 2;
+
+TelemetryFrameStore::TelemetryFrameStore(quint32 memoryLimitMb, int recentFrameCapacity)
+{
+    _firstSegmentIndex = 0;
+    _count = 0;
+    _firstVideoFrameNumber = 0;
+    _recentFrameCapacity = qMax(1, recentFrameCapacity);
+    _recentFrames.resize(_recentFrameCapacity);
+    setMemoryLimit(memoryLimitMb);
+}
+
+TelemetryFrameStore::~TelemetryFrameStore()
+{
+    clear();
+}
+
+const TelemetryFrameStore::Segment *TelemetryFrameStore::segmentForIndex(int index, int &offset) const
+{
+    // Empty store and frames released by the memory limit are requested by the slider and playback too
+    if (!isValidIndex(index))
+        return nullptr;
+
+    offset = index % TELEMETRY_STORE_SEGMENT_SIZE;
+    return _segments.at(index / TELEMETRY_STORE_SEGMENT_SIZE - _firstSegmentIndex);
+}
+
+void TelemetryFrameStore::releaseOldSegments()
+{
+    while (_segments.count() > TELEMETRY_STORE_MIN_SEGMENT_COUNT && memoryUsage() > _memoryLimitBytes)
+    {
+        delete _segments.takeFirst();
+        _firstSegmentIndex++;
+    }
+}
+
+void TelemetryFrameStore::append(const TelemetryDataFrame &frame)
+{
+    int offset = _count % TELEMETRY_STORE_SEGMENT_SIZE;
+    if (offset == 0)
+    {
+        _segments.append(new Segment);
+        releaseOldSegments();
+    }
+    if (_count == 0)
+        _firstVideoFrameNumber = frame.VideoFrameNumber;
+
+    Segment *segment = _segments.last();
+#define TELEMETRY_STORE_SET_COLUMN(type, name) segment->name[offset] = frame.name;
+    TELEMETRY_STORE_COLUMNS(TELEMETRY_STORE_SET_COLUMN)
+#undef TELEMETRY_STORE_SET_COLUMN
+
+    _recentFrames[_count % _recentFrameCapacity] = frame;
+    _count++;
+}
+
+void TelemetryFrameStore::clear()
+{
+    qDeleteAll(_segments);
+    _segments.clear();
+    _firstSegmentIndex = 0;
+    _count = 0;
+    _firstVideoFrameNumber = 0;
+}
+
+int TelemetryFrameStore::count() const
+{
+    return _count;
+}
+
+int TelemetryFrameStore::firstIndex() const
+{
+    return _firstSegmentIndex * TELEMETRY_STORE_SEGMENT_SIZE;
+}
+
+bool TelemetryFrameStore::isEmpty() const
+{
+    return _count == 0;
+}
+
+bool TelemetryFrameStore::isValidIndex(int index) const
+{
+    return index >= firstIndex() && index < _count;
+}
+
+quint64 TelemetryFrameStore::memoryUsage() const
+{
+    return (quint64)_segments.count() * sizeof(Segment) + (quint64)_recentFrameCapacity * sizeof(TelemetryDataFrame);
+}
+
+void TelemetryFrameStore::setMemoryLimit(quint32 memoryLimitMb)
+{
+    _memoryLimitBytes = memoryLimitMb > 0 ? (quint64)memoryLimitMb * 1024 * 1024 : std::numeric_limits<quint64>::max();
+    releaseOldSegments();
+}
+
+const TelemetryDataFrame TelemetryFrameStore::frame(int index) const
+{
+    TelemetryDataFrame result;
+    int offset;
+    const Segment *segment = segmentForIndex(index, offset);
+    if (segment == nullptr)
+        return result;
+
+    if (index >= _count - _recentFrameCapacity)
+        return _recentFrames.at(index % _recentFrameCapacity);
+
+#define TELEMETRY_STORE_GET_COLUMN(type, name) result.name = segment->name[offset];
+    TELEMETRY_STORE_COLUMNS(TELEMETRY_STORE_GET_COLUMN)
+#undef TELEMETRY_STORE_GET_COLUMN
+    return result;
+}
+
+const TelemetryDataFrame TelemetryFrameStore::last() const
+{
+    return frame(_count - 1);
+}
+
+int TelemetryFrameStore::lowerBoundBySessionTime(quint32 sessionTimeMs) const
+{
+    int low = firstIndex();
+    int high = _count;
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (SessionTimeMs(middle) < sessionTimeMs)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+quint32 TelemetryFrameStore::firstVideoFrameNumber() const
+{
+    return _firstVideoFrameNumber;
+}
+
+#define TELEMETRY_STORE_DEFINE_GETTER(type, name) \
+type TelemetryFrameStore::name(int index) const \
+{ \
+    int offset; \
+    const Segment *segment = segmentForIndex(index, offset); \
+    return segment != nullptr ? segment->name[offset] : type(); \
+}
+TELEMETRY_STORE_COLUMNS(TELEMETRY_STORE_DEFINE_GETTER)
+#undef TELEMETRY_STORE_DEFINE_GETTER
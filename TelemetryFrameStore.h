@@ -0,0 +1,115 @@
+#ifndef TELEMETRYFRAMESTORE_H
+#define TELEMETRYFRAMESTORE_H
+
+#include <QVector>
+#include <QList>
+#include "TelemetryDataFrame.h"
+
+// Fields of TelemetryDataFrame kept for the whole session (all persisted session columns and a few more).
+// Other fields (view field borders, bombing and antenna data) are kept only for the most recent frames.
+#define TELEMETRY_STORE_COLUMNS(COLUMN) \
+    COLUMN(quint32, Time) \
+    COLUMN(quint32, SessionTimeMs) \
+    COLUMN(quint32, TelemetryFrameNumber) \
+    COLUMN(quint32, VideoFrameNumber) \
+    COLUMN(double, UavRoll) \
+    COLUMN(double, UavPitch) \
+    COLUMN(double, UavYaw) \
+    COLUMN(double, UavLatitude_GPS) \
+    COLUMN(double, UavLongitude_GPS) \
+    COLUMN(double, UavAltitude_GPS) \
+    COLUMN(double, UavAltitude_Barometric) \
+    COLUMN(float, AirSpeed) \
+    COLUMN(float, GroundSpeed_GPS) \
+    COLUMN(float, Course_GPS) \
+    COLUMN(float, VerticalSpeed) \
+    COLUMN(float, WindDirection) \
+    COLUMN(float, WindSpeed) \
+    COLUMN(float, GroundSpeedNorth_GPS) \
+    COLUMN(float, GroundSpeedEast_GPS) \
+    COLUMN(float, AtmospherePressure) \
+    COLUMN(float, AtmosphereTemperature) \
+    COLUMN(double, CamRoll) \
+    COLUMN(double, CamPitch) \
+    COLUMN(double, CamYaw) \
+    COLUMN(double, CamZoom) \
+    COLUMN(qint32, CamEncoderRoll) \
+    COLUMN(qint32, CamEncoderPitch) \
+    COLUMN(qint32, CamEncoderYaw) \
+    COLUMN(float, StabilizedCenterX) \
+    COLUMN(float, StabilizedCenterY) \
+    COLUMN(float, StabilizedRotationAngle) \
+    COLUMN(float, TrackedTargetCenterX) \
+    COLUMN(float, TrackedTargetCenterY) \
+    COLUMN(float, TrackedTargetRectWidth) \
+    COLUMN(float, TrackedTargetRectHeight) \
+    COLUMN(quint32, TrackedTargetState) \
+    COLUMN(double, CalculatedTrackedTargetGPSLat) \
+    COLUMN(double, CalculatedTrackedTargetGPSLon) \
+    COLUMN(double, CalculatedTrackedTargetGPSHmsl) \
+    COLUMN(float, CalculatedTrackedTargetSpeed) \
+    COLUMN(float, CalculatedTrackedTargetDirection) \
+    COLUMN(float, RangefinderDistance) \
+    COLUMN(double, CalculatedRangefinderGPSLat) \
+    COLUMN(double, CalculatedRangefinderGPSLon) \
+    COLUMN(double, CalculatedRangefinderGPSHmsl) \
+    COLUMN(quint32, CamTracerMode) \
+    COLUMN(quint32, BombState)
+
+constexpr int TELEMETRY_STORE_SEGMENT_SIZE = 4096;
+
+// Segmented struct-of-arrays storage of session telemetry.
+// Frames are addressed by their index in the session; when the memory limit is exceeded
+// the oldest segments are released and only the indexes firstIndex()...count()-1 stay valid.
+class TelemetryFrameStore final
+{
+    struct Segment final
+    {
+#define TELEMETRY_STORE_DECLARE_COLUMN(type, name) type name[TELEMETRY_STORE_SEGMENT_SIZE];
+        TELEMETRY_STORE_COLUMNS(TELEMETRY_STORE_DECLARE_COLUMN)
+#undef TELEMETRY_STORE_DECLARE_COLUMN
+    };
+
+    QList<Segment *> _segments;
+    int _firstSegmentIndex;
+    int _count;
+    quint32 _firstVideoFrameNumber;
+    quint64 _memoryLimitBytes;
+
+    QVector<TelemetryDataFrame> _recentFrames;
+    int _recentFrameCapacity;
+
+    const Segment *segmentForIndex(int index, int &offset) const;    // nullptr for an invalid index
+    void releaseOldSegments();
+public:
+    TelemetryFrameStore(quint32 memoryLimitMb, int recentFrameCapacity);
+    ~TelemetryFrameStore();
+
+    void append(const TelemetryDataFrame &frame);
+    void clear();
+
+    int count() const;
+    int firstIndex() const;
+    bool isEmpty() const;
+    bool isValidIndex(int index) const;
+    quint64 memoryUsage() const;
+    void setMemoryLimit(quint32 memoryLimitMb); // 0 - unlimited
+
+    // The last recentFrameCapacity frames are returned whole. Older frames are lossy: only the TELEMETRY_STORE_COLUMNS
+    // fields are restored, the others (OpticalSystemId, FOV angles, FPS and queue counters, RangefinderTemperature,
+    // CalculatedGroundLevel, view field borders, bombing place, antenna data) are zero.
+    // An invalid index gives a cleared frame with TelemetryFrameNumber == 0
+    const TelemetryDataFrame frame(int index) const;
+    const TelemetryDataFrame last() const;
+
+    // Index of the first frame with SessionTimeMs >= sessionTimeMs
+    int lowerBoundBySessionTime(quint32 sessionTimeMs) const;
+
+    quint32 firstVideoFrameNumber() const;
+    // Column values, zero for an invalid index
+#define TELEMETRY_STORE_DECLARE_GETTER(type, name) type name(int index) const;
+    TELEMETRY_STORE_COLUMNS(TELEMETRY_STORE_DECLARE_GETTER)
+#undef TELEMETRY_STORE_DECLARE_GETTER
+};
+
+#endif // TELEMETRYFRAMESTORE_H
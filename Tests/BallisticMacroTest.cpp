@@ -0,0 +1,218 @@
+#include "BallisticMacroTest.h"
+#include <QtTest>
+#include <QJSEngine>
+#include <QRandomGenerator>
+#include <QVector>
+#include "CoordinateCalculator.h"
+#include "ApplicationSettings.h"
+
+constexpr int AGREEMENT_FRAME_COUNT = 10000;
+constexpr double AGREEMENT_TOLERANCE = 1e-9;
+
+// Uses wind and course, the stock macro does not
+const QString CustomBallisticMacro =
+    "var headWind = wind_speed * Math.cos((wind_direction - uav_course) * Math.PI / 180);\n"
+    "var speed = uav_groundspeed - headWind * 0.1;\n"
+    "if (speed > 0) {\n"
+    "  var fallTime = Math.sqrt(2 * (uav_hmsl - target_hmsl) / 9.80665);\n"
+    "  droppoint_distance = target_distance - speed * fallTime;\n"
+    "  droppoint_time = droppoint_distance / speed;\n"
+    "} else\n"
+    "  droppoint_time = -1;\n";
+
+static const QString stockBallisticMacro()
+{
+    return ApplicationSettings::Instance().BallisticMacro.defaultValue();
+}
+
+// UAV always above the target, the stock macro has no NaN branch to compare
+static QVector<TelemetryDataFrame> makeTelemetryFrames(int count)
+{
+    QRandomGenerator random(20240601);
+    QVector<TelemetryDataFrame> frames(count);
+    for (int i = 0; i < count; i++)
+    {
+        TelemetryDataFrame &frame = frames[i];
+        frame.TelemetryFrameNumber = i + 1;
+        frame.WindDirection = random.bounded(360.0);
+        frame.WindSpeed = random.bounded(20.0);
+        frame.UavLatitude_GPS = 53.9 + random.bounded(0.1);
+        frame.UavLongitude_GPS = 27.5 + random.bounded(0.1);
+        frame.BombingPlacePosHmsl = random.bounded(500.0);
+        frame.UavAltitude_GPS = frame.BombingPlacePosHmsl + 1 + random.bounded(3000.0);
+        // zero and negative ground speed take the droppoint_time = -1 branch
+        frame.GroundSpeed_GPS = (i % 50 == 0) ? 0 : -5 + random.bounded(85.0);
+        frame.AirSpeed = frame.GroundSpeed_GPS;
+        frame.Course_GPS = random.bounded(360.0);
+        frame.VerticalSpeed = -2 + random.bounded(4.0);
+        frame.BombingPlacePosLat = 53.9 + random.bounded(0.1);
+        frame.BombingPlacePosLon = 27.5 + random.bounded(0.1);
+        frame.DistanceToBombingPlace = random.bounded(5000.0);
+        frame.AzimuthToBombingPlace = random.bounded(360.0);
+    }
+    return frames;
+}
+
+// The former CoordinateCalculator evaluation: arguments are set as globals and the macro text is evaluated each frame
+static double evaluateMacroPerFrame(QJSEngine &engine, const QString &macro, const TelemetryDataFrame &frame)
+{
+    QJSValue global = engine.globalObject();
+    global.setProperty("wind_direction", frame.WindDirection);
+    global.setProperty("wind_speed", frame.WindSpeed);
+    global.setProperty("uav_lat", frame.UavLatitude_GPS);
+    global.setProperty("uav_lon", frame.UavLongitude_GPS);
+    global.setProperty("uav_hmsl", frame.UavAltitude_GPS);
+    global.setProperty("uav_groundspeed", frame.GroundSpeed_GPS);
+    global.setProperty("uav_airspeed", frame.AirSpeed);
+    global.setProperty("uav_course", frame.Course_GPS);
+    global.setProperty("uav_verticalspeed", frame.VerticalSpeed);
+    global.setProperty("target_lat", frame.BombingPlacePosLat);
+    global.setProperty("target_lon", frame.BombingPlacePosLon);
+    global.setProperty("target_hmsl", frame.BombingPlacePosHmsl);
+    global.setProperty("target_distance", frame.DistanceToBombingPlace);
+    global.setProperty("target_azimuth", frame.AzimuthToBombingPlace);
+    global.setProperty("droppoint_time", 0);
+    global.setProperty("droppoint_distance", 0);
+    global.setProperty("debug_info", "");
+
+    engine.evaluate(macro);
+
+    QJSValue dropPointTime = global.property("droppoint_time");
+    return dropPointTime.isNumber() ? dropPointTime.toNumber() : -1;
+}
+
+static bool isSameTime(double expected, double actual)
+{
+    return qAbs(expected - actual) <= AGREEMENT_TOLERANCE * qMax(1.0, qAbs(expected));
+}
+
+//---------------------------------------------------------------------------------------
+
+BallisticMacroTest::BallisticMacroTest(QObject *parent) : QObject(parent)
+{
+}
+
+void BallisticMacroTest::stockMacroAgreesWithNativeSolver()
+{
+    const QString macro = stockBallisticMacro();
+
+    BallisticMacroSolver nativeSolver;
+    nativeSolver.setMacro(macro);
+    QVERIFY(nativeSolver.isNativeSolverUsed());
+
+    BallisticMacroSolver compiledSolver;
+    compiledSolver.setMacro(macro, false);
+    QVERIFY(!compiledSolver.isNativeSolverUsed());
+
+    QJSEngine engine;
+    int droppedCount = 0;
+    const auto frames = makeTelemetryFrames(AGREEMENT_FRAME_COUNT);
+    foreach (auto frame, frames)
+    {
+        const double expected = evaluateMacroPerFrame(engine, macro, frame);
+        const double compiled = compiledSolver.timeToDrop(frame);
+        const double native = nativeSolver.timeToDrop(frame);
+        if (!isSameTime(expected, compiled) || !isSameTime(expected, native))
+            QFAIL(qPrintable(QString("Frame %1: evaluated %2, compiled %3, native %4")
+                             .arg(frame.TelemetryFrameNumber).arg(expected, 0, 'g', 17)
+                             .arg(compiled, 0, 'g', 17).arg(native, 0, 'g', 17)));
+        if (expected >= 0)
+            droppedCount++;
+    }
+
+    // both branches of the macro are covered
+    QVERIFY(droppedCount > 0);
+    QVERIFY(droppedCount < frames.count());
+}
+
+void BallisticMacroTest::customMacroAgreesWithEvaluation()
+{
+    BallisticMacroSolver compiledSolver;
+    compiledSolver.setMacro(CustomBallisticMacro);
+    QVERIFY(!compiledSolver.isNativeSolverUsed());
+
+    QJSEngine engine;
+    const auto frames = makeTelemetryFrames(AGREEMENT_FRAME_COUNT);
+    foreach (auto frame, frames)
+    {
+        const double expected = evaluateMacroPerFrame(engine, CustomBallisticMacro, frame);
+        const double compiled = compiledSolver.timeToDrop(frame);
+        if (!isSameTime(expected, compiled))
+            QFAIL(qPrintable(QString("Frame %1: evaluated %2, compiled %3")
+                             .arg(frame.TelemetryFrameNumber).arg(expected, 0, 'g', 17).arg(compiled, 0, 'g', 17)));
+    }
+}
+
+void BallisticMacroTest::macroIsRecompiledOnChange()
+{
+    TelemetryDataFrame frame = makeTelemetryFrames(1).first();
+    frame.GroundSpeed_GPS = 50;
+    frame.DistanceToBombingPlace = 4000;
+
+    BallisticMacroSolver solver;
+    solver.setMacro("droppoint_time = 1;");
+    QCOMPARE(solver.timeToDrop(frame), 1.0);
+
+    solver.setMacro("droppoint_time = target_distance / uav_groundspeed;");
+    QVERIFY(isSameTime(80, solver.timeToDrop(frame)));
+
+    // macro with a syntax error is not callable
+    solver.setMacro("droppoint_time = (;");
+    QCOMPARE(solver.timeToDrop(frame), -1.0);
+
+    solver.setMacro(stockBallisticMacro());
+    QVERIFY(solver.isNativeSolverUsed());
+    QVERIFY(isSameTime(CalculateStockTimeToDropBomb(frame), solver.timeToDrop(frame)));
+}
+
+//---------------------------------------------------------------------------------------
+
+BallisticMacroBenchmark::BallisticMacroBenchmark(QObject *parent) : QObject(parent)
+{
+}
+
+// QBENCHMARK reports the cost of a single frame
+void BallisticMacroBenchmark::evaluatePerFrame()
+{
+    const QString macro = stockBallisticMacro();
+    const auto frames = makeTelemetryFrames(AGREEMENT_FRAME_COUNT);
+    QJSEngine engine;
+    int index = 0;
+    double timeToDrop = 0;
+    QBENCHMARK
+    {
+        timeToDrop += evaluateMacroPerFrame(engine, macro, frames[index]);
+        index = (index + 1) % frames.count();
+    }
+    QVERIFY(qIsFinite(timeToDrop));
+}
+
+void BallisticMacroBenchmark::compiledMacro()
+{
+    const auto frames = makeTelemetryFrames(AGREEMENT_FRAME_COUNT);
+    BallisticMacroSolver solver;
+    solver.setMacro(stockBallisticMacro(), false);
+    int index = 0;
+    double timeToDrop = 0;
+    QBENCHMARK
+    {
+        timeToDrop += solver.timeToDrop(frames[index]);
+        index = (index + 1) % frames.count();
+    }
+    QVERIFY(qIsFinite(timeToDrop));
+}
+
+void BallisticMacroBenchmark::nativeSolver()
+{
+    const auto frames = makeTelemetryFrames(AGREEMENT_FRAME_COUNT);
+    BallisticMacroSolver solver;
+    solver.setMacro(stockBallisticMacro());
+    int index = 0;
+    double timeToDrop = 0;
+    QBENCHMARK
+    {
+        timeToDrop += solver.timeToDrop(frames[index]);
+        index = (index + 1) % frames.count();
+    }
+    QVERIFY(qIsFinite(timeToDrop));
+}
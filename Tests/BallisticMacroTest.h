@@ -0,0 +1,30 @@
+#ifndef BALLISTICMACROTEST_H
+#define BALLISTICMACROTEST_H
+
+#include <QObject>
+
+// Compares the compiled ballistic macro and the native stock solver with the former per-frame evaluation
+class BallisticMacroTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BallisticMacroTest(QObject *parent);
+private slots:
+    void stockMacroAgreesWithNativeSolver();
+    void customMacroAgreesWithEvaluation();
+    void macroIsRecompiledOnChange();
+};
+
+// Per-frame cost of the former evaluation, the compiled macro and the native stock solver
+class BallisticMacroBenchmark final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BallisticMacroBenchmark(QObject *parent);
+private slots:
+    void evaluatePerFrame();
+    void compiledMacro();
+    void nativeSolver();
+};
+
+#endif // BALLISTICMACROTEST_H
@@ -0,0 +1,254 @@
+#include "ImageCorrectorTest.h"
+#include <QtTest>
+#include <QImage>
+#include <QRandomGenerator>
+#include <cmath>
+#include "ImageProcessor/ImageCorrector.h"
+
+static QImage makeFrame(int width, int height, QImage::Format format)
+{
+    QRandomGenerator random(width * height);
+    QImage frame(width, height, QImage::Format_RGB32);
+    for (int y = 0; y < height; y++)
+    {
+        QRgb *line = reinterpret_cast<QRgb *>(frame.scanLine(y));
+        for (int x = 0; x < width; x++)
+            line[x] = random.generate();
+    }
+    return frame.convertToFormat(format);
+}
+
+// Former corrections, a pass over the RGB32 frame each: contrast and brightness, gamma, grayscale
+static void referenceContrastFilter(uchar *imageData, size_t dataSize, int fixContrast, int fixBrightness)
+{
+    uchar table[256];
+    quint64 midBright = 0;
+    for (size_t i = 0; i < dataSize; i += 4)
+        midBright += imageData[i] * 77 + imageData[i + 1] * 150 + imageData[i + 2] * 29;
+    midBright /= (256 * dataSize / 4);
+    for (int i = 0; i < 256; i++)
+    {
+        int a = (((i - midBright) * fixContrast) >> 8) + midBright + fixBrightness;
+        table[i] = qBound(0, a, 255);
+    }
+    for (size_t i = 0; i < dataSize; i += 4)
+    {
+        imageData[i + 0] = table[imageData[i + 0]];
+        imageData[i + 1] = table[imageData[i + 1]];
+        imageData[i + 2] = table[imageData[i + 2]];
+        imageData[i + 3] = 255;
+    }
+}
+
+static void referenceGammaTable(uchar *table, int step)
+{
+    for (int i = 0; i < 256; i++)
+    {
+        double value = std::sin(i * 0.01255) * step * 10;
+        uchar result = i;
+        if (double(result) + value > 255)
+            result = 255;
+        else if (double(result) + value < 0)
+            result = 0;
+        else
+            result += value;
+        table[i] = result;
+    }
+}
+
+static void referenceGammaFilter(uchar *imageData, size_t dataSize, float K)
+{
+    uchar tables[3][256];
+    referenceGammaTable(tables[0], -K * 2);
+    referenceGammaTable(tables[1], K);
+    referenceGammaTable(tables[2], K);
+    for (size_t i = 0; i < dataSize; i += 4)
+    {
+        imageData[i + 0] = tables[0][imageData[i + 0]];
+        imageData[i + 1] = tables[1][imageData[i + 1]];
+        imageData[i + 2] = tables[2][imageData[i + 2]];
+        imageData[i + 3] = 255;
+    }
+}
+
+static void referenceGrayscale(uchar *imageData, size_t dataSize)
+{
+    for (size_t i = 0; i < dataSize; i += 4)
+    {
+        int average = (imageData[i + 0] + imageData[i + 1] + imageData[i + 2]) / 3;
+        imageData[i + 0] = average;
+        imageData[i + 1] = average;
+        imageData[i + 2] = average;
+        imageData[i + 3] = 255;
+    }
+}
+
+static QImage referenceProcessFrame(const QImage &frame, qreal brightness, qreal contrast, qreal gamma, bool grayscale)
+{
+    QImage result = frame.convertToFormat(QImage::Format_RGB32);
+    if (contrast != 0 || brightness != 0)
+        referenceContrastFilter(result.bits(), result.sizeInBytes(), contrast * 255 + 255, 255 * brightness);
+    if (gamma != 0)
+        referenceGammaFilter(result.bits(), result.sizeInBytes(), gamma * 10);
+    if (grayscale)
+        referenceGrayscale(result.bits(), result.sizeInBytes());
+    return result;
+}
+
+static QString firstDifference(const QImage &result, const QImage &expected)
+{
+    for (int y = 0; y < expected.height(); y++)
+    {
+        const QRgb *resultLine = reinterpret_cast<const QRgb *>(result.constScanLine(y));
+        const QRgb *expectedLine = reinterpret_cast<const QRgb *>(expected.constScanLine(y));
+        for (int x = 0; x < expected.width(); x++)
+            if (resultLine[x] != expectedLine[x])
+                return QString("Pixel at %1, %2 is %3 instead of %4").arg(x).arg(y)
+                        .arg(resultLine[x], 8, 16, QChar('0')).arg(expectedLine[x], 8, 16, QChar('0'));
+    }
+    return QString();
+}
+
+//---------------------------------------------------------------------------------------
+
+ImageCorrectorTest::ImageCorrectorTest(QObject *parent) : QObject(parent)
+{
+}
+
+void ImageCorrectorTest::vectorizedMatchesScalar_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("format");
+    QTest::addColumn<qreal>("brightness");
+    QTest::addColumn<qreal>("contrast");
+    QTest::addColumn<qreal>("gamma");
+    QTest::addColumn<bool>("grayscale");
+
+    // Odd widths leave tails after the vector loops
+    QTest::newRow("rgb32 no correction") << QSize(720, 576) << (int)QImage::Format_RGB32 << 0.0 << 0.0 << 0.0 << false;
+    QTest::newRow("rgb32 contrast") << QSize(721, 5) << (int)QImage::Format_RGB32 << 0.2 << 0.5 << 0.0 << false;
+    QTest::newRow("rgb32 gamma") << QSize(735, 7) << (int)QImage::Format_RGB32 << 0.0 << 0.0 << -0.4 << false;
+    QTest::newRow("rgb32 all grayscale") << QSize(1921, 3) << (int)QImage::Format_RGB32 << -0.3 << 0.7 << 0.3 << true;
+    QTest::newRow("rgb32 grayscale only") << QSize(15, 15) << (int)QImage::Format_RGB32 << 0.0 << 0.0 << 0.0 << true;
+    QTest::newRow("argb32 gamma") << QSize(720, 9) << (int)QImage::Format_ARGB32 << 0.0 << -0.5 << 0.6 << false;
+    QTest::newRow("grayscale8 contrast") << QSize(723, 11) << (int)QImage::Format_Grayscale8 << 0.1 << 0.4 << 0.2 << false;
+}
+
+void ImageCorrectorTest::vectorizedMatchesScalar()
+{
+    QFETCH(QSize, size);
+    QFETCH(int, format);
+    QFETCH(qreal, brightness);
+    QFETCH(qreal, contrast);
+    QFETCH(qreal, gamma);
+    QFETCH(bool, grayscale);
+
+    const QImage frame = makeFrame(size.width(), size.height(), (QImage::Format)format);
+
+    ImageCorrector scalarCorrector;
+    scalarCorrector.setVectorized(false);
+    scalarCorrector.setTuneImageSettings(brightness, contrast, gamma, grayscale);
+    QImage scalarGrayscale;
+    const QImage scalarResult = scalarCorrector.ProcessFrame(frame, &scalarGrayscale);
+
+    ImageCorrector vectorizedCorrector;
+    vectorizedCorrector.setTuneImageSettings(brightness, contrast, gamma, grayscale);
+    QImage vectorizedGrayscale;
+    const QImage vectorizedResult = vectorizedCorrector.ProcessFrame(frame, &vectorizedGrayscale);
+
+    QCOMPARE(vectorizedResult.format(), QImage::Format_RGB32);
+    QVERIFY(vectorizedResult == scalarResult);
+    QVERIFY(vectorizedGrayscale == scalarGrayscale);
+
+    // Tracker plane is the gray of the corrected frame
+    for (int y = 0; y < size.height(); y++)
+    {
+        const QRgb *resultLine = reinterpret_cast<const QRgb *>(vectorizedResult.constScanLine(y));
+        const uchar *grayscaleLine = vectorizedGrayscale.constScanLine(y);
+        for (int x = 0; x < size.width(); x++)
+            if (grayscaleLine[x] != qGray(resultLine[x]))
+                QFAIL(qPrintable(QString("Gray mismatch at %1, %2").arg(x).arg(y)));
+    }
+}
+
+void ImageCorrectorTest::fusedMatchesThreePass_data()
+{
+    vectorizedMatchesScalar_data();
+
+    // Clipped by brightness and contrast, strongest gamma
+    QTest::newRow("rgb32 clipped") << QSize(97, 13) << (int)QImage::Format_RGB32 << 0.8 << 1.0 << 0.0 << false;
+    QTest::newRow("rgb32 dark") << QSize(97, 13) << (int)QImage::Format_RGB32 << -0.9 << -0.6 << -1.0 << true;
+    QTest::newRow("rgb32 gamma max") << QSize(64, 8) << (int)QImage::Format_RGB32 << 0.0 << 0.0 << 1.0 << false;
+    QTest::newRow("grayscale8 all grayscale") << QSize(65, 9) << (int)QImage::Format_Grayscale8 << -0.2 << 0.6 << -0.3 << true;
+}
+
+// The fused table pass gives the pixels of the former three passes
+void ImageCorrectorTest::fusedMatchesThreePass()
+{
+    QFETCH(QSize, size);
+    QFETCH(int, format);
+    QFETCH(qreal, brightness);
+    QFETCH(qreal, contrast);
+    QFETCH(qreal, gamma);
+    QFETCH(bool, grayscale);
+
+    const QImage frame = makeFrame(size.width(), size.height(), (QImage::Format)format);
+    const QImage expected = referenceProcessFrame(frame, brightness, contrast, gamma, grayscale);
+
+    for (bool vectorized : {false, true})
+    {
+        ImageCorrector corrector;
+        corrector.setVectorized(vectorized);
+        corrector.setTuneImageSettings(brightness, contrast, gamma, grayscale);
+        const QImage result = corrector.ProcessFrame(frame);
+
+        QCOMPARE(result.format(), QImage::Format_RGB32);
+        QCOMPARE(result.size(), expected.size());
+        QString difference = firstDifference(result, expected);
+        QVERIFY2(difference.isEmpty(), qPrintable(QString(vectorized ? "Vectorized: " : "Scalar: ") + difference));
+    }
+}
+
+//---------------------------------------------------------------------------------------
+
+ImageCorrectorBenchmark::ImageCorrectorBenchmark(QObject *parent) : QObject(parent)
+{
+}
+
+void ImageCorrectorBenchmark::processFrame_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<bool>("vectorized");
+    QTest::addColumn<bool>("grayscale");
+
+    const QList<QSize> sizes = { QSize(720, 576), QSize(1920, 1080) };
+    foreach (auto size, sizes)
+    {
+        const QString sizeName = QString("%1x%2").arg(size.width()).arg(size.height());
+        QTest::newRow(qPrintable(sizeName + " scalar")) << size << false << false;
+        QTest::newRow(qPrintable(sizeName + " vectorized")) << size << true << false;
+        QTest::newRow(qPrintable(sizeName + " scalar grayscale")) << size << false << true;
+        QTest::newRow(qPrintable(sizeName + " vectorized grayscale")) << size << true << true;
+    }
+}
+
+// Contrast and gamma are on, so every pixel goes through the tables
+void ImageCorrectorBenchmark::processFrame()
+{
+    QFETCH(QSize, size);
+    QFETCH(bool, vectorized);
+    QFETCH(bool, grayscale);
+
+    const QImage frame = makeFrame(size.width(), size.height(), QImage::Format_RGB32);
+    ImageCorrector corrector;
+    corrector.setVectorized(vectorized);
+    corrector.setTuneImageSettings(0.1, 0.3, 0.2, grayscale);
+
+    QImage grayscaleFrame;
+    QImage result;
+    QBENCHMARK
+    {
+        result = corrector.ProcessFrame(frame, &grayscaleFrame);
+    }
+    QCOMPARE(result.size(), size);
+}
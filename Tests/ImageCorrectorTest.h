@@ -0,0 +1,31 @@
+#ifndef IMAGECORRECTORTEST_H
+#define IMAGECORRECTORTEST_H
+
+#include <QObject>
+
+// Vectorized corrections give the same frames as the scalar ones, both give the frames of the former
+// contrast, gamma and grayscale passes
+class ImageCorrectorTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ImageCorrectorTest(QObject *parent);
+private slots:
+    void vectorizedMatchesScalar_data();
+    void vectorizedMatchesScalar();
+    void fusedMatchesThreePass_data();
+    void fusedMatchesThreePass();
+};
+
+// Corrected frame with the tracker plane at PAL and Full HD sizes, scalar and vectorized
+class ImageCorrectorBenchmark final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ImageCorrectorBenchmark(QObject *parent);
+private slots:
+    void processFrame_data();
+    void processFrame();
+};
+
+#endif // IMAGECORRECTORTEST_H
@@ -0,0 +1,81 @@
+#include "ImageStabilazationBenchmark.h"
+#include <QtTest>
+#include <QImage>
+#include <QPainter>
+#include <QRandomGenerator>
+#include "ImageProcessor/ImageStabilazation.h"
+
+constexpr int MOVING_FRAME_COUNT = 8;
+
+// Noise texture drawn with a small shift and rotation per frame
+static QVector<QImage> makeMovingFrames(const QSize &size, QImage::Format format)
+{
+    QRandomGenerator random(size.width() * size.height());
+    QImage texture(size / 8, QImage::Format_RGB32);
+    for (int y = 0; y < texture.height(); y++)
+    {
+        QRgb *line = reinterpret_cast<QRgb *>(texture.scanLine(y));
+        for (int x = 0; x < texture.width(); x++)
+            line[x] = random.generate();
+    }
+
+    QVector<QImage> frames;
+    for (int i = 0; i < MOVING_FRAME_COUNT; i++)
+    {
+        QImage frame(size, QImage::Format_RGB32);
+        QPainter painter(&frame);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.translate(size.width() / 2 + i * 3, size.height() / 2 + i * 2);
+        painter.rotate(i * 0.3);
+        painter.translate(-size.width() / 2, -size.height() / 2);
+        painter.drawImage(QRect(QPoint(-size.width() / 4, -size.height() / 4), size * 1.5), texture);
+        painter.end();
+        frames.append(frame.convertToFormat(format));
+    }
+    return frames;
+}
+
+//---------------------------------------------------------------------------------------
+
+ImageStabilazationBenchmark::ImageStabilazationBenchmark(QObject *parent) : QObject(parent)
+{
+}
+
+void ImageStabilazationBenchmark::processFrame_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("format");
+
+    // Grayscale frames come from the tracker's plane, RGB32 ones when there is no tracker
+    const QList<QSize> sizes = { QSize(720, 576), QSize(1920, 1080) };
+    foreach (auto size, sizes)
+    {
+        const QString sizeName = QString("%1x%2").arg(size.width()).arg(size.height());
+        QTest::newRow(qPrintable(sizeName + " grayscale")) << size << (int)QImage::Format_Grayscale8;
+        QTest::newRow(qPrintable(sizeName + " rgb32")) << size << (int)QImage::Format_RGB32;
+    }
+}
+
+void ImageStabilazationBenchmark::processFrame()
+{
+    QFETCH(QSize, size);
+    QFETCH(int, format);
+
+    const QVector<QImage> frames = makeMovingFrames(size, (QImage::Format)format);
+    ImageStabilazation stabilazation(false);
+    stabilazation.ProcessFrame(frames[0]);
+
+    int frameNumber = 0;
+    int frameCount = 0;
+    qint64 maxFrameTimeNs = 0;
+    QBENCHMARK
+    {
+        stabilazation.ProcessFrame(frames[++frameNumber % MOVING_FRAME_COUNT]);
+        maxFrameTimeNs = qMax(maxFrameTimeNs, stabilazation.lastFrameTimeNs());
+        frameCount++;
+    }
+
+    qInfo("Max frame time %.2f ms, %llu of %d frames over the %.1f ms budget",
+          maxFrameTimeNs / 1000000.0, stabilazation.overBudgetFrameCount(), frameCount,
+          ImageStabilazation::timeBudgetNs() / 1000000.0);
+}
@@ -0,0 +1,17 @@
+#ifndef IMAGESTABILAZATIONBENCHMARK_H
+#define IMAGESTABILAZATIONBENCHMARK_H
+
+#include <QObject>
+
+// Frame time of the motion estimation against its per-frame budget, the frame moves and turns between calls
+class ImageStabilazationBenchmark final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ImageStabilazationBenchmark(QObject *parent);
+private slots:
+    void processFrame_data();
+    void processFrame();
+};
+
+#endif // IMAGESTABILAZATIONBENCHMARK_H
@@ -0,0 +1,320 @@
+#include "ImageTrackerCorrelationTest.h"
+#include <QtTest>
+#include <QImage>
+#include <QVector>
+#include <QThread>
+#include <QElapsedTimer>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "ImageProcessor/CorrelationVideoTracker/ImageTrackerCorrelation.h"
+#include "Tests/TestUtils.h"
+
+constexpr int FRAME_WIDTH = 720;
+constexpr int FRAME_HEIGHT = 576;
+constexpr int TARGET_POSITION_COUNT = 32;
+constexpr int WARM_UP_FRAME_COUNT = 200;
+constexpr int COUNTED_FRAME_COUNT = 500;
+constexpr int COMPARED_FRAME_COUNT = 80;
+constexpr int LATENCY_TARGET_SIZE = 64;
+constexpr int LATENCY_FRAME_COUNT = 3 * CVT_MAXIMUM_FRAME_BUFFER_SIZE;     // the deepest buffer wraps around
+// Spatial correlation searches a 4 pixel grid and refines around its maximum, the frequency one takes the maximum
+// of the whole surface. When the true peak is next to the refined area the trackers diverge, but stay this close
+constexpr int SPATIAL_COARSE_SEARCH_TOLERANCE = 2;
+
+// Allocations through operator new of the whole test binary are counted while countAllocations is set
+namespace
+{
+    std::atomic<bool> countAllocations(false);
+    std::atomic<int> allocationCount(0);
+
+    void *countedAllocation(std::size_t size) noexcept
+    {
+        if (countAllocations.load(std::memory_order_relaxed))
+            allocationCount++;
+        return std::malloc(size == 0 ? 1 : size);
+    }
+}
+
+void *operator new(std::size_t size)
+{
+    void *memory = countedAllocation(size);
+    if (memory == nullptr)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAllocation(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return countedAllocation(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+// Textured background with a bright rectangle, the rectangle moves back and forth
+static QVector<QImage> makeTargetFrames(int targetWidth, int targetHeight)
+{
+    QVector<QImage> frames;
+    for (int position = 0; position < TARGET_POSITION_COUNT; position++)
+    {
+        QImage frame(FRAME_WIDTH, FRAME_HEIGHT, QImage::Format_Grayscale8);
+        for (int y = 0; y < FRAME_HEIGHT; y++)
+        {
+            uchar *line = frame.scanLine(y);
+            for (int x = 0; x < FRAME_WIDTH; x++)
+                line[x] = static_cast<uchar>(((x * 7) ^ (y * 13)) & 0x3f);
+        }
+
+        int left = FRAME_WIDTH / 2 - targetWidth / 2 + position * 2;
+        int top = FRAME_HEIGHT / 2 - targetHeight / 2 + position;
+        for (int y = top; y < top + targetHeight; y++)
+        {
+            uchar *line = frame.scanLine(y);
+            for (int x = left; x < left + targetWidth; x++)
+                line[x] = static_cast<uchar>(160 + ((x - left) * 3 + (y - top) * 5) % 90);
+        }
+        frames.append(frame);
+    }
+    return frames;
+}
+
+static int pingPongIndex(int frameNumber)
+{
+    int period = 2 * (TARGET_POSITION_COUNT - 1);
+    int phase = frameNumber % period;
+    return phase < TARGET_POSITION_COUNT ? phase : period - phase;
+}
+
+//---------------------------------------------------------------------------------------
+
+ImageTrackerCorrelationTest::ImageTrackerCorrelationTest(QObject *parent) : QObject(parent)
+{
+}
+
+void ImageTrackerCorrelationTest::processesFramesWithoutAllocations_data()
+{
+    QTest::addColumn<int>("targetSize");
+
+    // Small targets are correlated spatially, large ones through FFT
+    QTest::newRow("16") << 16;
+    QTest::newRow("48") << 48;
+    QTest::newRow("96") << 96;
+}
+
+void ImageTrackerCorrelationTest::processesFramesWithoutAllocations()
+{
+    QFETCH(int, targetSize);
+
+    const QVector<QImage> frames = makeTargetFrames(targetSize, targetSize);
+    ImageTrackerCorrelation tracker;
+    tracker.setTargetSize(targetSize);
+
+    tracker.doProcessFrame(frames[0]);
+    tracker.lockTarget(QPoint(FRAME_WIDTH / 2, FRAME_HEIGHT / 2));
+    int frameNumber = 0;
+    for (int i = 0; i < WARM_UP_FRAME_COUNT; i++)
+        tracker.doProcessFrame(frames[pingPongIndex(++frameNumber)]);
+    QRect lockedRect = tracker.doProcessFrame(frames[pingPongIndex(++frameNumber)]);
+    QVERIFY2(lockedRect.isValid(), "Target is lost during the warm-up");
+
+    allocationCount = 0;
+    countAllocations = true;
+    for (int i = 0; i < COUNTED_FRAME_COUNT; i++)
+        tracker.doProcessFrame(frames[pingPongIndex(++frameNumber)]);
+    countAllocations = false;
+
+    QCOMPARE(allocationCount.load(), 0);
+}
+
+void ImageTrackerCorrelationTest::frequencyCorrelationMatchesSpatial_data()
+{
+    QTest::addColumn<int>("targetWidth");
+    QTest::addColumn<int>("targetHeight");
+
+    // Odd sides are shifted inside of the maximum tracking rectangle
+    QTest::newRow("40x40") << 40 << 40;
+    QTest::newRow("42x42") << 42 << 42;
+    QTest::newRow("41x41") << 41 << 41;
+    QTest::newRow("33x33") << 33 << 33;
+    QTest::newRow("41x33") << 41 << 33;
+    QTest::newRow("33x41") << 33 << 41;
+    QTest::newRow("40x33") << 40 << 33;
+    // The target texture repeats every 30 pixels horizontally, wide targets have narrow peaks between the coarse grid
+    QTest::newRow("120x40") << 120 << 40;
+    QTest::newRow("100x60") << 100 << 60;
+    QTest::newRow("128x32") << 128 << 32;
+    QTest::newRow("96x48") << 96 << 48;
+    QTest::newRow("40x120") << 40 << 120;
+    QTest::newRow("60x100") << 60 << 100;
+}
+
+void ImageTrackerCorrelationTest::frequencyCorrelationMatchesSpatial()
+{
+    QFETCH(int, targetWidth);
+    QFETCH(int, targetHeight);
+
+    using namespace vtracker;
+    const QVector<QImage> frames = makeTargetFrames(targetWidth, targetHeight);
+    CorrelationVideoTracker spatialTracker;
+    CorrelationVideoTracker frequencyTracker;
+    CorrelationVideoTracker *trackers[] = { &spatialTracker, &frequencyTracker };
+    for (auto tracker : trackers)
+    {
+        tracker->SetProperty(CorrelationVideoTrackerProperty::NUM_THREADS, 1);
+        tracker->SetProperty(CorrelationVideoTrackerProperty::CORRELATION_METHOD,
+                             tracker == &spatialTracker ? CVT_CORRELATION_METHOD_SPATIAL : CVT_CORRELATION_METHOD_FREQUENCY);
+        tracker->SetProperty(CorrelationVideoTrackerProperty::TRACKING_RECTANGLE_WIDTH, targetWidth);
+        tracker->SetProperty(CorrelationVideoTrackerProperty::TRACKING_RECTANGLE_HEIGHT, targetHeight);
+        tracker->ProcessFrameReference(frames[0].constBits(), FRAME_WIDTH, FRAME_HEIGHT);
+        tracker->ExecuteCommand(CorrelationVideoTrackerCommand::CAPTURE, FRAME_WIDTH / 2, FRAME_HEIGHT / 2, -1, nullptr);
+    }
+
+    // Integer sums are restored exactly from the spectra, the surfaces have the same values where both are calculated.
+    // Only the maximum found in them can differ
+    int divergedFrameCount = 0;
+    int maximalDifference = 0;
+    for (int frameNumber = 1; frameNumber <= COMPARED_FRAME_COUNT; frameNumber++)
+    {
+        const QImage &frame = frames[pingPongIndex(frameNumber)];
+        spatialTracker.ProcessFrameReference(frame.constBits(), FRAME_WIDTH, FRAME_HEIGHT);
+        frequencyTracker.ProcessFrameReference(frame.constBits(), FRAME_WIDTH, FRAME_HEIGHT);
+
+        const CorrelationVideoTrackerResultData spatialResult = spatialTracker.GetTrackerResultData();
+        const CorrelationVideoTrackerResultData frequencyResult = frequencyTracker.GetTrackerResultData();
+        QCOMPARE(frequencyResult.mode, spatialResult.mode);
+        int difference = qMax(qAbs(frequencyResult.trackingRectangleCenterX - spatialResult.trackingRectangleCenterX),
+                              qAbs(frequencyResult.trackingRectangleCenterY - spatialResult.trackingRectangleCenterY));
+        QVERIFY2(difference <= SPATIAL_COARSE_SEARCH_TOLERANCE,
+                 qPrintable(QString("Frame %1: frequency tracker at (%2, %3), spatial at (%4, %5)").arg(frameNumber)
+                            .arg(frequencyResult.trackingRectangleCenterX).arg(frequencyResult.trackingRectangleCenterY)
+                            .arg(spatialResult.trackingRectangleCenterX).arg(spatialResult.trackingRectangleCenterY)));
+        if (difference > 0)
+            divergedFrameCount++;
+        maximalDifference = qMax(maximalDifference, difference);
+    }
+    if (divergedFrameCount > 0)
+        qInfo("Trackers differ in %d of %d frames by %d pixels at most", divergedFrameCount, COMPARED_FRAME_COUNT, maximalDifference);
+    QCOMPARE(spatialTracker.GetTrackerResultData().mode, CVT_TRACKING_MODE_INDEX);
+    QCOMPARE(frequencyTracker.GetTrackerResultData().mode, CVT_TRACKING_MODE_INDEX);
+}
+
+//---------------------------------------------------------------------------------------
+
+ImageTrackerCorrelationBenchmark::ImageTrackerCorrelationBenchmark(QObject *parent) : QObject(parent)
+{
+}
+
+void ImageTrackerCorrelationBenchmark::spatialCorrelation_data()
+{
+    QTest::addColumn<int>("targetSize");
+    QTest::addColumn<int>("threadCount");
+
+    // ImageTrackerCorrelation uses half of the cores
+    const int trackerThreadCount = qBound(1, QThread::idealThreadCount() / 2, CVT_MAXIMUM_NUM_THREADS);
+    const QList<int> targetSizes = { 32, 64, 128 };
+    foreach (auto targetSize, targetSizes)
+    {
+        QTest::newRow(qPrintable(QString("target %1, 1 thread").arg(targetSize))) << targetSize << 1;
+        if (trackerThreadCount > 1)
+            QTest::newRow(qPrintable(QString("target %1, %2 threads").arg(targetSize).arg(trackerThreadCount)))
+                    << targetSize << trackerThreadCount;
+    }
+}
+
+void ImageTrackerCorrelationBenchmark::spatialCorrelation()
+{
+    QFETCH(int, targetSize);
+    QFETCH(int, threadCount);
+
+    using namespace vtracker;
+    const QVector<QImage> frames = makeTargetFrames(targetSize, targetSize);
+    CorrelationVideoTracker tracker;
+    tracker.SetProperty(CorrelationVideoTrackerProperty::NUM_THREADS, threadCount);
+    tracker.SetProperty(CorrelationVideoTrackerProperty::CORRELATION_METHOD, CVT_CORRELATION_METHOD_SPATIAL);
+    tracker.SetProperty(CorrelationVideoTrackerProperty::TRACKING_RECTANGLE_WIDTH, targetSize);
+    tracker.SetProperty(CorrelationVideoTrackerProperty::TRACKING_RECTANGLE_HEIGHT, targetSize);
+    tracker.ProcessFrameReference(frames[0].constBits(), FRAME_WIDTH, FRAME_HEIGHT);
+    tracker.ExecuteCommand(CorrelationVideoTrackerCommand::CAPTURE, FRAME_WIDTH / 2, FRAME_HEIGHT / 2, -1, nullptr);
+
+    int frameNumber = 0;
+    QBENCHMARK
+    {
+        tracker.ProcessFrameReference(frames[pingPongIndex(++frameNumber)].constBits(), FRAME_WIDTH, FRAME_HEIGHT);
+    }
+    QCOMPARE(tracker.GetTrackerResultData().mode, CVT_TRACKING_MODE_INDEX);
+}
+
+void ImageTrackerCorrelationBenchmark::frameLatency_data()
+{
+    QTest::addColumn<int>("frameBufferSize");
+    QTest::addColumn<bool>("copyFrames");
+
+    const QList<int> frameBufferSizes = { CVT_DEFAULT_FRAME_BUFFER_SIZE, CVT_MAXIMUM_FRAME_BUFFER_SIZE };
+    foreach (auto frameBufferSize, frameBufferSizes)
+    {
+        QTest::newRow(qPrintable(QString("buffer %1, referenced").arg(frameBufferSize))) << frameBufferSize << false;
+        QTest::newRow(qPrintable(QString("buffer %1, copied").arg(frameBufferSize))) << frameBufferSize << true;
+    }
+}
+
+// Frames are referenced as ImageTrackerCorrelation does for unpadded frames and copied for the padded ones
+void ImageTrackerCorrelationBenchmark::frameLatency()
+{
+    QFETCH(int, frameBufferSize);
+    QFETCH(bool, copyFrames);
+
+    using namespace vtracker;
+    QVector<QImage> frames = makeTargetFrames(LATENCY_TARGET_SIZE, LATENCY_TARGET_SIZE);
+    CorrelationVideoTracker tracker;
+    QVERIFY(tracker.SetProperty(CorrelationVideoTrackerProperty::FRAME_BUFFER_SIZE, frameBufferSize));
+    tracker.SetProperty(CorrelationVideoTrackerProperty::NUM_THREADS, qBound(1, QThread::idealThreadCount() / 2, CVT_MAXIMUM_NUM_THREADS));
+    tracker.SetProperty(CorrelationVideoTrackerProperty::TRACKING_RECTANGLE_WIDTH, LATENCY_TARGET_SIZE);
+    tracker.SetProperty(CorrelationVideoTrackerProperty::TRACKING_RECTANGLE_HEIGHT, LATENCY_TARGET_SIZE);
+
+    auto processFrame = [&tracker, &frames, copyFrames](int frameNumber)
+    {
+        QImage &frame = frames[pingPongIndex(frameNumber)];
+        if (copyFrames)
+            tracker.ProcessFrame(frame.bits(), FRAME_WIDTH, FRAME_HEIGHT);
+        else
+            tracker.ProcessFrameReference(frame.constBits(), FRAME_WIDTH, FRAME_HEIGHT);
+    };
+
+    // The frame buffer is allocated with the first frame
+    int frameNumber = 0;
+    processFrame(frameNumber);
+    tracker.ExecuteCommand(CorrelationVideoTrackerCommand::CAPTURE, FRAME_WIDTH / 2, FRAME_HEIGHT / 2, -1, nullptr);
+    for (int i = 0; i < WARM_UP_FRAME_COUNT; i++)
+        processFrame(++frameNumber);
+
+    QVector<qint64> durationsNs;
+    durationsNs.reserve(LATENCY_FRAME_COUNT);
+    QElapsedTimer timer;
+    for (int i = 0; i < LATENCY_FRAME_COUNT; i++)
+    {
+        timer.start();
+        processFrame(++frameNumber);
+        durationsNs.append(timer.nsecsElapsed());
+    }
+    QCOMPARE(tracker.GetTrackerResultData().mode, CVT_TRACKING_MODE_INDEX);
+
+    reportDurations(QString("Frame, buffer %1, %2").arg(frameBufferSize).arg(copyFrames ? "copied" : "referenced"), durationsNs);
+}
@@ -0,0 +1,34 @@
+#ifndef IMAGETRACKERCORRELATIONTEST_H
+#define IMAGETRACKERCORRELATIONTEST_H
+
+#include <QObject>
+
+// Tracking of a synthetic target must not allocate once the tracker is warmed up,
+// frequency domain correlation must track it as the spatial one within the spatial coarse grid tolerance
+class ImageTrackerCorrelationTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ImageTrackerCorrelationTest(QObject *parent);
+private slots:
+    void processesFramesWithoutAllocations_data();
+    void processesFramesWithoutAllocations();
+    void frequencyCorrelationMatchesSpatial_data();
+    void frequencyCorrelationMatchesSpatial();
+};
+
+// Frame time of the spatial correlation surface, single thread and tiled between threads.
+// Per-frame tail latency at the default and at the maximal frame buffer depth, referenced and copied frames
+class ImageTrackerCorrelationBenchmark final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ImageTrackerCorrelationBenchmark(QObject *parent);
+private slots:
+    void spatialCorrelation_data();
+    void spatialCorrelation();
+    void frameLatency_data();
+    void frameLatency();
+};
+
+#endif // IMAGETRACKERCORRELATIONTEST_H
@@ -0,0 +1,215 @@
+#include "MUSVProtocolTest.h"
+#include <QtTest>
+#include <QByteArray>
+#include <QVector>
+#include <QRandomGenerator>
+#include <QtEndian>
+#include <QtMath>
+#include <QElapsedTimer>
+#include <cstring>
+#include "HardwareLink/MUSV/protocol.h"
+
+constexpr int ANGLE_FRAME_COUNT = 20000;
+constexpr int ANGLE_FRAME_LENGTH = 15;
+constexpr int CORRUPTED_FRAME_PERCENT = 10;
+constexpr int NOISE_FRAME_PERCENT = 10;
+constexpr int MAXIMAL_NOISE_LENGTH = 6;
+constexpr int MAXIMAL_FRAME_LENGTH = 52;
+// A false frame started in the noise or in a corrupted frame hides at most its length of the following bytes,
+// the decoder is in sync again after the next frame at the latest
+constexpr int RESYNC_WINDOW_BYTES = 2 * MAXIMAL_FRAME_LENGTH;
+constexpr int FRAME_MATCH_LOOKAHEAD = 8;
+constexpr int SERIAL_READ_SIZE = 256;
+
+struct CameraAngles
+{
+    float Roll, Pitch, Yaw;
+};
+
+struct AngleStream
+{
+    QByteArray Data;
+    QVector<CameraAngles> IntactFrames;
+    QVector<bool> IntactFrameResynced;      // starts after the resync window of the last noise or corrupted frame
+    int CorruptedFrameCount = 0;
+};
+
+static void appendValue(QByteArray &frame, float value)
+{
+    quint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    char bytes[4];
+    qToBigEndian(bits, bytes);
+    frame.append(bytes, sizeof(bytes));
+}
+
+// Smooth gimbal motion like in recorded camera telemetry. Heads and valid lengths occur in the payloads and in the noise
+static AngleStream makeAngleStream(quint32 seed)
+{
+    QRandomGenerator random(seed);
+    AngleStream stream;
+    int disturbanceEnd = -1;
+    for (int i = 0; i < ANGLE_FRAME_COUNT; i++)
+    {
+        if (random.bounded(100) < NOISE_FRAME_PERCENT)
+        {
+            int noiseLength = 1 + random.bounded(MAXIMAL_NOISE_LENGTH);
+            for (int n = 0; n < noiseLength; n++)
+                stream.Data.append((char)random.bounded(256));
+            disturbanceEnd = stream.Data.size();
+        }
+
+        CameraAngles angles;
+        angles.Roll = 10.0f * qSin(i * 0.01);
+        angles.Pitch = -45.0f + 20.0f * qSin(i * 0.003);
+        angles.Yaw = 180.0f * qCos(i * 0.0007);
+
+        QByteArray frame;
+        frame.append((char)MUSV_IN_ANGLES);
+        frame.append((char)ANGLE_FRAME_LENGTH);
+        appendValue(frame, angles.Roll);
+        appendValue(frame, angles.Pitch);
+        appendValue(frame, angles.Yaw);
+        quint8 checkSum = 0;
+        for (auto value : frame)
+            checkSum += (quint8)value;
+        frame.append((char)checkSum);
+
+        if (random.bounded(100) < CORRUPTED_FRAME_PERCENT)
+        {
+            frame[frame.size() - 1] = (char)(checkSum ^ (1 + random.bounded(255)));
+            stream.CorruptedFrameCount++;
+            stream.Data.append(frame);
+            disturbanceEnd = stream.Data.size();
+        }
+        else
+        {
+            stream.IntactFrames.append(angles);
+            stream.IntactFrameResynced.append(disturbanceEnd < 0 || stream.Data.size() - disturbanceEnd >= RESYNC_WINDOW_BYTES);
+            stream.Data.append(frame);
+        }
+    }
+    return stream;
+}
+
+static bool isSameAngles(const protocolName::InputData *data, const CameraAngles &angles)
+{
+    return data->angles.roll == angles.Roll && data->angles.pitch == angles.Pitch && data->angles.yaw == angles.Yaw;
+}
+
+// Decodes byte by byte and finds the decoded angles among the intact frames in order,
+// false frames decoded of the payload and the noise bytes match none of them
+static QVector<bool> decodeIntactFrames(const AngleStream &stream, protocolName::DecoderStatistics &statistics)
+{
+    QVector<bool> isDecoded(stream.IntactFrames.count(), false);
+    protocolName::protocol decoder;
+    protocolName::InputData *data = decoder.GetData();
+    data->newAngles = false;
+
+    int nextFrame = 0;
+    for (int position = 0; position < stream.Data.size(); position++)
+    {
+        decoder.SetData(stream.Data.mid(position, 1));
+        if (!data->newAngles)
+            continue;
+        data->newAngles = false;
+
+        int lastFrame = qMin(nextFrame + FRAME_MATCH_LOOKAHEAD, stream.IntactFrames.count());
+        for (int i = nextFrame; i < lastFrame; i++)
+            if (isSameAngles(data, stream.IntactFrames[i]))
+            {
+                isDecoded[i] = true;
+                nextFrame = i + 1;
+                break;
+            }
+    }
+
+    statistics = decoder.GetStatistics();
+    return isDecoded;
+}
+
+//---------------------------------------------------------------------------------------
+
+MUSVProtocolTest::MUSVProtocolTest(QObject *parent) : QObject(parent)
+{
+}
+
+void MUSVProtocolTest::decodesCorruptedStream_data()
+{
+    QTest::addColumn<int>("maximalChunkSize");
+
+    QTest::newRow("byte by byte") << 1;
+    QTest::newRow("chunks up to 7") << 7;
+    QTest::newRow("chunks up to 64") << 64;
+    QTest::newRow("whole stream") << 0;
+}
+
+void MUSVProtocolTest::decodesCorruptedStream()
+{
+    QFETCH(int, maximalChunkSize);
+
+    const AngleStream stream = makeAngleStream(17);
+    protocolName::DecoderStatistics expectedStatistics;
+    const QVector<bool> isDecoded = decodeIntactFrames(stream, expectedStatistics);
+
+    // Frames are checked as their bytes arrive, the chunks don't change the decoding
+    QRandomGenerator random(maximalChunkSize);
+    protocolName::protocol decoder;
+    int position = 0;
+    while (position < stream.Data.size())
+    {
+        int chunkSize = maximalChunkSize > 0 ? 1 + random.bounded(maximalChunkSize) : stream.Data.size();
+        chunkSize = qMin(chunkSize, stream.Data.size() - position);
+        decoder.SetData(stream.Data.mid(position, chunkSize));
+        position += chunkSize;
+    }
+    const protocolName::DecoderStatistics &statistics = decoder.GetStatistics();
+    QCOMPARE(statistics.frames, expectedStatistics.frames);
+    QCOMPARE(statistics.skippedBytes, expectedStatistics.skippedBytes);
+    QCOMPARE(statistics.framingErrors, expectedStatistics.framingErrors);
+    QCOMPARE(statistics.checksumErrors, expectedStatistics.checksumErrors);
+
+    // A false frame passes the checksum rarely and hides the intact frames under it
+    QVERIFY((int)statistics.frames <= stream.IntactFrames.count());
+    QVERIFY((int)statistics.checksumErrors >= stream.CorruptedFrameCount);
+
+    int lostFrameCount = 0;
+    for (int i = 0; i < isDecoded.count(); i++)
+    {
+        if (isDecoded[i])
+            continue;
+        lostFrameCount++;
+        QVERIFY2(!stream.IntactFrameResynced[i], qPrintable(QString("Intact frame %1 after the resync window is lost").arg(i)));
+    }
+    if (lostFrameCount > 0)
+        qInfo("%d intact frames are lost in the resync windows", lostFrameCount);
+}
+
+//---------------------------------------------------------------------------------------
+
+MUSVProtocolBenchmark::MUSVProtocolBenchmark(QObject *parent) : QObject(parent)
+{
+}
+
+void MUSVProtocolBenchmark::decodeStream()
+{
+    const AngleStream stream = makeAngleStream(17);
+    QVector<QByteArray> chunks;
+    for (int position = 0; position < stream.Data.size(); position += SERIAL_READ_SIZE)
+        chunks.append(stream.Data.mid(position, SERIAL_READ_SIZE));
+
+    int iterationCount = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK
+    {
+        protocolName::protocol decoder;
+        foreach (auto chunk, chunks)
+            decoder.SetData(chunk);
+        QVERIFY((int)decoder.GetStatistics().frames <= stream.IntactFrames.count());
+        iterationCount++;
+    }
+    qint64 elapsedNs = timer.nsecsElapsed();
+    qInfo("Stream of %d bytes, %d frames: %.1f MB/s", stream.Data.size(), ANGLE_FRAME_COUNT,
+          1e3 * stream.Data.size() * iterationCount / qMax<qint64>(elapsedNs, 1));
+}
@@ -0,0 +1,29 @@
+#ifndef MUSVPROTOCOLTEST_H
+#define MUSVPROTOCOLTEST_H
+
+#include <QObject>
+
+// Camera angle stream with unmodified float payloads, noise between frames and corrupted frames, split at random
+// points: the chunks don't change the decoding, no more frames are decoded than sent and every intact frame after
+// the resync window of a disturbance is decoded
+class MUSVProtocolTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MUSVProtocolTest(QObject *parent);
+private slots:
+    void decodesCorruptedStream_data();
+    void decodesCorruptedStream();
+};
+
+// Decoding time and throughput of the same stream read in serial port sized chunks
+class MUSVProtocolBenchmark final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MUSVProtocolBenchmark(QObject *parent);
+private slots:
+    void decodeStream();
+};
+
+#endif // MUSVPROTOCOLTEST_H
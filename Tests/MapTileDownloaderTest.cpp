@@ -0,0 +1,192 @@
+#include "MapTileDownloaderTest.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QImage>
+#include <QPainter>
+#include <QSet>
+#include <QList>
+#include "Map/MapTileContainer.h"
+#include "Map/MapTileDownloader.h"
+#include "UAVSimulator/UAVSimTileServer.h"
+
+constexpr int TILE_SCALE = 12;
+constexpr double TILE_X = 2000.5;
+constexpr double TILE_Y = 1300.5;
+constexpr int MAP_IMAGE_SIZE = 512;
+constexpr int PIXEL_SAMPLE_STEP = 16;
+constexpr int REQUEST_QUEUE_DELAY_MS = 50;             // much shorter than the server latency
+constexpr int RECEIVE_TIMEOUT_MS = 20000;
+constexpr double SERVER_ERROR_RATE = 0.3;
+
+typedef QSet<quint64> TileSet;
+
+static void setMapCenter(MapTileContainer &container, double x, double y)
+{
+    WorldGPSCoord coord;
+    container.convertGoogleXY2GPS(TILE_SCALE, x, y, coord);
+    container.setImageCenter(coord);
+}
+
+// One drawing pass
+static QImage drawMap(MapTileContainer &container)
+{
+    QImage image(MAP_IMAGE_SIZE, MAP_IMAGE_SIZE, QImage::Format_RGB32);
+    image.fill(Qt::black);
+    QPainter painter(&image);
+    LegendPresentationParam legendPresentationParam = {false, false, false};
+    container.getMapImage(&painter, legendPresentationParam);
+    painter.end();
+    return image;
+}
+
+// Missing tiles are black, the server tiles are not
+static bool hasMissingTiles(const QImage &image)
+{
+    for (int y = PIXEL_SAMPLE_STEP / 2; y < image.height(); y += PIXEL_SAMPLE_STEP)
+        for (int x = PIXEL_SAMPLE_STEP / 2; x < image.width(); x += PIXEL_SAMPLE_STEP)
+            if (image.pixel(x, y) == qRgb(0, 0, 0))
+                return true;
+    return false;
+}
+
+// Tiles of the needTile(sourceId, scale, x, y, isPrefetch) signals starting from the index
+static TileSet requestedTiles(const QSignalSpy &needTileSpy, int fromIndex, bool isPrefetch)
+{
+    TileSet tiles;
+    for (int i = fromIndex; i < needTileSpy.count(); i++)
+    {
+        const QList<QVariant> &arguments = needTileSpy.at(i);
+        if (arguments.at(4).toBool() == isPrefetch)
+            tiles.insert(MapTile::calculateMapTileHash(arguments.at(0).toInt(), arguments.at(1).toInt(),
+                                                      arguments.at(2).toInt(), arguments.at(3).toInt()));
+    }
+    return tiles;
+}
+
+// Tiles in the order the server received them
+static QList<quint64> serverRequests(const QSignalSpy &tileRequestedSpy)
+{
+    QList<quint64> tiles;
+    for (const QList<QVariant> &arguments : tileRequestedSpy)
+        tiles.append(MapTile::calculateMapTileHash(arguments.at(0).toInt(), arguments.at(1).toInt(),
+                                                   arguments.at(2).toInt(), arguments.at(3).toInt()));
+    return tiles;
+}
+
+static MapTileContainer *createContainer(const QTemporaryDir &folder, const UAVSimTileServer &tileServer)
+{
+    auto container = new MapTileContainer(nullptr, QList<QString>(), QString(), folder.filePath("HeightMap.db"));
+    container->setTileReceivingMode(NetworkOnly);
+    container->setTileServerURL(QString("http://127.0.0.1:%1/{source}/{z}/{x}/{y}").arg(tileServer.serverPort()));
+    container->setMapBaseSourceId(GoogleSatellite);
+    container->setMapHybridSourceId(NoHybridTile);
+    container->setScale(TILE_SCALE);
+    return container;
+}
+
+//---------------------------------------------------------------------------------------
+
+MapTileDownloaderTest::MapTileDownloaderTest(QObject *parent) : QObject(parent)
+{
+}
+
+void MapTileDownloaderTest::promotesVisiblePrefetchedTiles()
+{
+    QTemporaryDir folder;
+    QVERIFY(folder.isValid());
+    UAVSimTileServer tileServer(nullptr, 300, 0);
+    QVERIFY(tileServer.listen(0));
+    QSignalSpy tileRequestedSpy(&tileServer, &UAVSimTileServer::tileRequested);
+
+    QScopedPointer<MapTileContainer> container(createContainer(folder, tileServer));
+    QSignalSpy needTileSpy(container.data(), &MapTileContainer::needTile);
+
+    setMapCenter(*container, TILE_X, TILE_Y);
+    drawMap(*container);
+    QTest::qWait(REQUEST_QUEUE_DELAY_MS);
+    TileSet firstVisibleTiles = requestedTiles(needTileSpy, 0, false);
+    TileSet firstPrefetchTiles = requestedTiles(needTileSpy, 0, true);
+    QVERIFY(!firstVisibleTiles.isEmpty());
+    QVERIFY(!firstPrefetchTiles.isEmpty());
+
+    // The map is moved by a tile before the prefetched tiles are downloaded, a prefetched column becomes visible
+    int secondPassIndex = needTileSpy.count();
+    setMapCenter(*container, TILE_X + 1, TILE_Y);
+    drawMap(*container);
+    TileSet secondVisibleTiles = requestedTiles(needTileSpy, secondPassIndex, false);
+    TileSet promotedTiles = TileSet(secondVisibleTiles).intersect(firstPrefetchTiles);
+    QVERIFY2(!promotedTiles.isEmpty(), "Prefetched tiles that became visible are not requested as visible");
+
+    QTRY_VERIFY_WITH_TIMEOUT(!hasMissingTiles(drawMap(*container)), RECEIVE_TIMEOUT_MS);
+
+    // The promoted tiles are requested with the visible ones, before the other prefetched tiles.
+    // Parallel requests can reach the server in a different order
+    TileSet visibleTiles = TileSet(firstVisibleTiles).unite(secondVisibleTiles);
+    QList<quint64> requests = serverRequests(tileRequestedSpy);
+    for (quint64 tile : promotedTiles)
+    {
+        int requestIndex = requests.indexOf(tile);
+        QVERIFY(requestIndex >= 0);
+        QVERIFY2(requestIndex < visibleTiles.count() + MapTileDownloader::MAX_SOURCE_CONCURRENCY,
+                 qPrintable(QString("Promoted tile is requested %1th of %2 visible").arg(requestIndex + 1).arg(visibleTiles.count())));
+    }
+}
+
+void MapTileDownloaderTest::dropsTilesOutOfSight()
+{
+    const int serverLatencyMs = 500;
+
+    QTemporaryDir folder;
+    QVERIFY(folder.isValid());
+    UAVSimTileServer tileServer(nullptr, serverLatencyMs, 0);
+    QVERIFY(tileServer.listen(0));
+    QSignalSpy tileRequestedSpy(&tileServer, &UAVSimTileServer::tileRequested);
+
+    QScopedPointer<MapTileContainer> container(createContainer(folder, tileServer));
+    QSignalSpy needTileSpy(container.data(), &MapTileContainer::needTile);
+
+    setMapCenter(*container, TILE_X, TILE_Y);
+    drawMap(*container);
+    QTest::qWait(REQUEST_QUEUE_DELAY_MS);
+    TileSet firstTiles = requestedTiles(needTileSpy, 0, false).unite(requestedTiles(needTileSpy, 0, true));
+
+    // Far away before the first downloads are finished. The first area is drawn during the pass before the jump,
+    // so its downloads are stale from the second pass at the new place
+    setMapCenter(*container, TILE_X + 100, TILE_Y);
+    drawMap(*container);
+    QTest::qWait(REQUEST_QUEUE_DELAY_MS);
+    drawMap(*container);
+
+    QTRY_VERIFY_WITH_TIMEOUT(!hasMissingTiles(drawMap(*container)), RECEIVE_TIMEOUT_MS);
+    // Prefetched tiles of the new area are downloaded meanwhile, the old ones would follow them
+    QTest::qWait(serverLatencyMs * 3);
+    drawMap(*container);
+
+    int firstAreaRequests = 0;
+    for (quint64 tile : serverRequests(tileRequestedSpy))
+        if (firstTiles.contains(tile))
+            firstAreaRequests++;
+    // Only the downloads started before the jump, they are aborted
+    QVERIFY2(firstAreaRequests <= MapTileDownloader::MAX_SOURCE_CONCURRENCY,
+             qPrintable(QString("%1 tiles out of sight are requested").arg(firstAreaRequests)));
+}
+
+// Failed downloads are repeated and the redrawn map requests the given up tiles again
+void MapTileDownloaderTest::retriesUnavailableServer()
+{
+    QTemporaryDir folder;
+    QVERIFY(folder.isValid());
+    UAVSimTileServer tileServer(nullptr, 100, SERVER_ERROR_RATE);
+    QVERIFY(tileServer.listen(0));
+
+    QScopedPointer<MapTileContainer> container(createContainer(folder, tileServer));
+
+    setMapCenter(*container, TILE_X, TILE_Y);
+    QTRY_VERIFY_WITH_TIMEOUT(!hasMissingTiles(drawMap(*container)), RECEIVE_TIMEOUT_MS);
+
+    QVERIFY(tileServer.failedRequests() > 0);
+    int maxActiveRequests = tileServer.maxActiveRequests(GoogleSatellite);
+    QVERIFY(maxActiveRequests > 0);
+    QVERIFY2(maxActiveRequests <= MapTileDownloader::MAX_SOURCE_CONCURRENCY,
+             qPrintable(QString("%1 requests of the source are in flight").arg(maxActiveRequests)));
+}
@@ -0,0 +1,20 @@
+#ifndef MAPTILEDOWNLOADERTEST_H
+#define MAPTILEDOWNLOADERTEST_H
+
+#include <QObject>
+
+// Draws the map in the network mode against the simulator tile server: prefetched tiles that become visible
+// are downloaded before the other prefetched ones, tiles out of sight are not downloaded anymore, failed downloads
+// are repeated without exceeding the concurrency of the source
+class MapTileDownloaderTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MapTileDownloaderTest(QObject *parent);
+private slots:
+    void promotesVisiblePrefetchedTiles();
+    void dropsTilesOutOfSight();
+    void retriesUnavailableServer();
+};
+
+#endif // MAPTILEDOWNLOADERTEST_H
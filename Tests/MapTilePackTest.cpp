@@ -0,0 +1,369 @@
+#include "MapTilePackTest.h"
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QMap>
+#include <QSet>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QtMath>
+#include <cstring>
+#include <numeric>
+#include "Map/MapTilePack.h"
+#include "Map/MapTileLoader.h"
+#include "Tests/TestUtils.h"
+
+constexpr int SOURCE_ID = 3;
+constexpr int OTHER_SOURCE_ID = 7;
+constexpr int UNKNOWN_SOURCE_ID = 5;
+constexpr int SCALE = 12;
+constexpr int FIRST_X = 2400;
+constexpr int FIRST_Y = 1300;
+constexpr int TILE_COLUMNS = 4;
+constexpr int TILE_ROWS = 3;
+constexpr int TILE_KEY_COORDINATE_LIMIT = 1 << 20;
+
+constexpr int BENCHMARK_TILE_COUNT = 10000;
+constexpr int BENCHMARK_MAX_TILE_SIZE = 8192;
+constexpr int BENCHMARK_READ_COUNT = 100000;
+
+struct TestTile
+{
+    int SourceId, Scale, X, Y, Format;
+    QByteArray Data;
+};
+
+static QByteArray makeTileData(int sourceId, int x, int y, int revision)
+{
+    return QString("tile %1 %2 %3 %4;").arg(sourceId).arg(x).arg(y).arg(revision).toLatin1().repeated(1 + (x + y) % 5);
+}
+
+// MapTile table as MapTileContainer creates it, without the unique index: rows are inserted in the given order
+static bool writeTileDatabase(const QString &fileName, const QVector<TestTile> &tiles)
+{
+    bool isWritten = false;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "MapTilePackTestDB");
+        database.setDatabaseName(fileName);
+        if (database.open())
+        {
+            QSqlQuery query(database);
+            isWritten = query.exec("CREATE TABLE MapTile (x INTEGER, y INTEGER, scale INTEGER, sourceId INTEGER, format INTEGER, autogenerated INTEGER, datetime REAL, signature INTEGER, tile BLOB)") &&
+                        query.exec("CREATE INDEX TILE_SCALE_X_Y_SourceID ON MapTile (x, y, scale, sourceId)") &&
+                        database.transaction();
+            query.prepare("INSERT INTO MapTile (x, y, scale, sourceId, format, autogenerated, datetime, signature, tile) VALUES (?, ?, ?, ?, ?, 0, 0, 0, ?)");
+            foreach (const TestTile &tile, tiles)
+            {
+                if (!isWritten)
+                    break;
+                query.bindValue(0, tile.X);
+                query.bindValue(1, tile.Y);
+                query.bindValue(2, tile.Scale);
+                query.bindValue(3, tile.SourceId);
+                query.bindValue(4, tile.Format);
+                query.bindValue(5, tile.Data);
+                isWritten = query.exec();
+            }
+            isWritten = database.commit() && isWritten;
+            query.clear();
+            database.close();
+        }
+    }
+    QSqlDatabase::removeDatabase("MapTilePackTestDB");
+    return isWritten;
+}
+
+static bool readTileDatabase(const QString &fileName, QVector<TestTile> &tiles, QSet<int> &sources)
+{
+    bool isRead = false;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "MapTilePackTestDB");
+        database.setDatabaseName(fileName);
+        if (database.open())
+        {
+            QSqlQuery query(database);
+            isRead = query.exec("SELECT sourceId, scale, x, y, format, tile FROM MapTile");
+            while (isRead && query.next())
+            {
+                TestTile tile = {query.value(0).toInt(), query.value(1).toInt(), query.value(2).toInt(), query.value(3).toInt(),
+                                 query.value(4).toInt(), query.value(5).toByteArray()};
+                tiles.append(tile);
+            }
+            isRead = isRead && query.exec("SELECT sourceId FROM MapTileSources");
+            while (isRead && query.next())
+                sources.insert(query.value(0).toInt());
+            query.clear();
+            database.close();
+        }
+    }
+    QSqlDatabase::removeDatabase("MapTilePackTestDB");
+    return isRead;
+}
+
+// FNV-1a of the tile, every byte is read: the mapped pack pages are loaded as the database rows are
+static quint64 tileChecksum(const QByteArray &tileData)
+{
+    quint64 checksum = Q_UINT64_C(14695981039346656037);
+    auto bytes = reinterpret_cast<const uchar *>(tileData.constData());
+    for (int i = 0; i < tileData.size(); i++)
+        checksum = (checksum ^ bytes[i]) * Q_UINT64_C(1099511628211);
+    return checksum;
+}
+
+//---------------------------------------------------------------------------------------
+
+MapTilePackTest::MapTilePackTest(QObject *parent) : QObject(parent)
+{
+}
+
+void MapTilePackTest::roundTrip()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+
+    // Expected tiles by the pack key, the first written of the duplicated tiles is kept
+    QVector<TestTile> tiles;
+    QMap<quint64, TestTile> expectedTiles;
+    const QList<int> sourceIds = { SOURCE_ID, OTHER_SOURCE_ID };
+    foreach (int sourceId, sourceIds)
+        for (int x = FIRST_X; x < FIRST_X + TILE_COLUMNS; x++)
+            for (int y = FIRST_Y; y < FIRST_Y + TILE_ROWS; y++)
+            {
+                TestTile tile = {sourceId, SCALE, x, y, (x + y) % 2 == 0 ? ImagePNG : ImageJPEG, makeTileData(sourceId, x, y, 0)};
+                tiles.append(tile);
+                expectedTiles.insert(MapTilePack::tileKey(sourceId, SCALE, x, y), tile);
+            }
+    TestTile duplicatedTile = {SOURCE_ID, SCALE, FIRST_X + 1, FIRST_Y + 1, ImageJPEG, makeTileData(SOURCE_ID, FIRST_X + 1, FIRST_Y + 1, 1)};
+    tiles.append(duplicatedTile);
+
+    // Rows the pack skips
+    const QVector<TestTile> skippedTiles = {
+        {SOURCE_ID, 0, FIRST_X, FIRST_Y, ImagePNG, makeTileData(SOURCE_ID, FIRST_X, FIRST_Y, 2)},
+        {SOURCE_ID, SCALE, -1, FIRST_Y, ImagePNG, makeTileData(SOURCE_ID, -1, FIRST_Y, 2)},
+        {SOURCE_ID, SCALE, FIRST_X + TILE_KEY_COORDINATE_LIMIT, FIRST_Y, ImagePNG, makeTileData(SOURCE_ID, FIRST_X, FIRST_Y, 3)},
+        {SOURCE_ID, SCALE, FIRST_X + TILE_COLUMNS, FIRST_Y, ImagePNG, QByteArray()}
+    };
+    tiles.append(skippedTiles);
+
+    const QString databaseFileName = directory.filePath("tiles.db");
+    const QString packFileName = directory.filePath("tiles.tpk");
+    QVERIFY(writeTileDatabase(databaseFileName, tiles));
+    QVERIFY(MapTilePack::convertFromDatabase(databaseFileName, packFileName));
+
+    {
+        MapTilePack tilePack(packFileName);
+        QVERIFY(tilePack.isOpen());
+        QCOMPARE(tilePack.tileCount(), static_cast<quint32>(expectedTiles.count()));
+        QCOMPARE(tilePack.sources(), QSet<int>({ SOURCE_ID, OTHER_SOURCE_ID }));
+
+        QByteArray tileData;
+        int tileFormat;
+        foreach (const TestTile &tile, expectedTiles)
+        {
+            QVERIFY2(tilePack.findTile(tile.SourceId, tile.Scale, tile.X, tile.Y, tileData, tileFormat),
+                     qPrintable(QString("Tile %1 %2 %3 is not found").arg(tile.SourceId).arg(tile.X).arg(tile.Y)));
+            QCOMPARE(tileData, tile.Data);
+            QCOMPARE(tileFormat, tile.Format);
+        }
+
+        // Neighbours of the stored area, other scale and source, the empty tile
+        QVERIFY(!tilePack.findTile(SOURCE_ID, SCALE, FIRST_X - 1, FIRST_Y, tileData, tileFormat));
+        QVERIFY(!tilePack.findTile(SOURCE_ID, SCALE, FIRST_X + TILE_COLUMNS, FIRST_Y, tileData, tileFormat));
+        QVERIFY(!tilePack.findTile(SOURCE_ID, SCALE, FIRST_X, FIRST_Y - 1, tileData, tileFormat));
+        QVERIFY(!tilePack.findTile(SOURCE_ID, SCALE, FIRST_X, FIRST_Y + TILE_ROWS, tileData, tileFormat));
+        QVERIFY(!tilePack.findTile(SOURCE_ID, SCALE + 1, FIRST_X, FIRST_Y, tileData, tileFormat));
+        QVERIFY(!tilePack.findTile(SOURCE_ID, 0, FIRST_X, FIRST_Y, tileData, tileFormat));
+        QVERIFY(!tilePack.findTile(UNKNOWN_SOURCE_ID, SCALE, FIRST_X, FIRST_Y, tileData, tileFormat));
+
+        // Coordinates out of the key fields are not truncated to a stored tile
+        QVERIFY(!tilePack.findTile(SOURCE_ID, SCALE, FIRST_X + TILE_KEY_COORDINATE_LIMIT, FIRST_Y, tileData, tileFormat));
+        QVERIFY(!tilePack.findTile(SOURCE_ID, SCALE, FIRST_X, FIRST_Y + TILE_KEY_COORDINATE_LIMIT, tileData, tileFormat));
+        QVERIFY(!tilePack.findTile(SOURCE_ID, SCALE + 256, FIRST_X, FIRST_Y, tileData, tileFormat));
+        QVERIFY(!tilePack.findTile(SOURCE_ID + 0x10000, SCALE, FIRST_X, FIRST_Y, tileData, tileFormat));
+        QVERIFY(!tilePack.findTile(SOURCE_ID, SCALE, -1, FIRST_Y, tileData, tileFormat));
+    }
+
+    // Entry with the payload out of the payload area is skipped, the other entries are found
+    const QString damagedPackFileName = directory.filePath("damaged.tpk");
+    {
+        QFile packFile(packFileName);
+        QVERIFY(packFile.open(QIODevice::ReadOnly));
+        QByteArray packData = packFile.readAll();
+        MapTilePackHeader header;
+        memcpy(&header, packData.constData(), sizeof(header));
+        MapTilePackEntry entry;
+        memcpy(&entry, packData.constData() + header.IndexOffset, sizeof(entry));
+        entry.Offset = header.IndexOffset;
+        memcpy(packData.data() + header.IndexOffset, &entry, sizeof(entry));
+
+        QFile damagedPackFile(damagedPackFileName);
+        QVERIFY(damagedPackFile.open(QIODevice::WriteOnly));
+        QCOMPARE(damagedPackFile.write(packData), static_cast<qint64>(packData.size()));
+    }
+    {
+        MapTilePack damagedPack(damagedPackFileName);
+        QVERIFY(damagedPack.isOpen());
+        QByteArray tileData;
+        int tileFormat;
+        const TestTile &damagedTile = expectedTiles.first();
+        QVERIFY(!damagedPack.findTile(damagedTile.SourceId, damagedTile.Scale, damagedTile.X, damagedTile.Y, tileData, tileFormat));
+        const TestTile &intactTile = expectedTiles.last();
+        QVERIFY(damagedPack.findTile(intactTile.SourceId, intactTile.Scale, intactTile.X, intactTile.Y, tileData, tileFormat));
+        QCOMPARE(tileData, intactTile.Data);
+    }
+
+    const QString convertedDatabaseFileName = directory.filePath("converted.db");
+    QVERIFY(MapTilePack::convertToDatabase(packFileName, convertedDatabaseFileName));
+
+    QVector<TestTile> convertedTiles;
+    QSet<int> convertedSources;
+    QVERIFY(readTileDatabase(convertedDatabaseFileName, convertedTiles, convertedSources));
+    QCOMPARE(convertedTiles.count(), expectedTiles.count());
+    QCOMPARE(convertedSources, QSet<int>({ SOURCE_ID, OTHER_SOURCE_ID }));
+    foreach (const TestTile &tile, convertedTiles)
+    {
+        auto expectedTile = expectedTiles.constFind(MapTilePack::tileKey(tile.SourceId, tile.Scale, tile.X, tile.Y));
+        QVERIFY(expectedTile != expectedTiles.constEnd());
+        QCOMPARE(tile.SourceId, expectedTile->SourceId);
+        QCOMPARE(tile.Scale, expectedTile->Scale);
+        QCOMPARE(tile.X, expectedTile->X);
+        QCOMPARE(tile.Y, expectedTile->Y);
+        QCOMPARE(tile.Format, expectedTile->Format);
+        QCOMPARE(tile.Data, expectedTile->Data);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+
+MapTilePackBenchmark::MapTilePackBenchmark(QObject *parent) : QObject(parent)
+{
+}
+
+void MapTilePackBenchmark::initTestCase()
+{
+    QVERIFY(_directory.isValid());
+
+    _databaseFileName = qEnvironmentVariable("TILEPACK_BENCHMARK_DATABASE");
+    if (_databaseFileName.isEmpty())
+    {
+        // Incompressible tiles of the map tile sizes
+        QRandomGenerator random(1);
+        QVector<TestTile> tiles;
+        int columnCount = qCeil(qSqrt(BENCHMARK_TILE_COUNT));
+        for (int i = 0; i < BENCHMARK_TILE_COUNT; i++)
+        {
+            QByteArray tileData(random.bounded(BENCHMARK_MAX_TILE_SIZE / 8, BENCHMARK_MAX_TILE_SIZE), 0);
+            for (int j = 0; j < tileData.size(); j++)
+                tileData[j] = static_cast<char>(random.bounded(256));
+            TestTile tile = {SOURCE_ID, SCALE, FIRST_X + i % columnCount, FIRST_Y + i / columnCount, i % 2 == 0 ? ImagePNG : ImageJPEG, tileData};
+            tiles.append(tile);
+        }
+        _databaseFileName = _directory.filePath("tiles.db");
+        QVERIFY(writeTileDatabase(_databaseFileName, tiles));
+    }
+    _packFileName = _directory.filePath("tiles.tpk");
+    QVERIFY(MapTilePack::convertFromDatabase(_databaseFileName, _packFileName));
+}
+
+void MapTilePackBenchmark::readFromDatabase()
+{
+    QVector<qint64> latenciesNs;
+    qint64 openTimeNs = 0;
+    qint64 readBytes = 0;
+    {
+        QElapsedTimer timer;
+        timer.start();
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "MapTilePackBenchmarkDB");
+        database.setDatabaseName(_databaseFileName);
+        database.setConnectOptions("QSQLITE_OPEN_READONLY");
+        QVERIFY(database.open());
+        // Of the duplicated tiles the pack keeps the first written one
+        QSqlQuery selectTileQuery(database);
+        selectTileQuery.prepare("SELECT tile FROM MapTile WHERE x=? AND y=? AND scale=? AND sourceId=? ORDER BY rowid LIMIT 1");
+        openTimeNs = timer.nsecsElapsed();
+
+        QVector<BenchmarkTile> allTiles;
+        QSqlQuery keyQuery(database);
+        keyQuery.setForwardOnly(true);
+        keyQuery.exec("SELECT sourceId, scale, x, y FROM MapTile WHERE scale > 0 AND x >= 0 AND y >= 0 AND length(tile) > 0");
+        while (keyQuery.next())
+        {
+            BenchmarkTile tile = {keyQuery.value(0).toInt(), keyQuery.value(1).toInt(), keyQuery.value(2).toInt(), keyQuery.value(3).toInt()};
+            allTiles.append(tile);
+        }
+        keyQuery.clear();
+        QVERIFY(!allTiles.isEmpty());
+
+        // The same random sequence for both paths
+        QRandomGenerator random(1);
+        _reads.clear();
+        for (int i = 0; i < BENCHMARK_READ_COUNT; i++)
+            _reads.append(allTiles[random.bounded(allTiles.count())]);
+
+        latenciesNs.reserve(_reads.count());
+        _databaseChecksums.clear();
+        foreach (const BenchmarkTile &tile, _reads)
+        {
+            timer.restart();
+            selectTileQuery.addBindValue(tile.X);
+            selectTileQuery.addBindValue(tile.Y);
+            selectTileQuery.addBindValue(tile.Scale);
+            selectTileQuery.addBindValue(tile.SourceId);
+            selectTileQuery.exec();
+            QByteArray tileData;
+            if (selectTileQuery.next())
+                tileData = selectTileQuery.value(0).toByteArray();
+            selectTileQuery.finish();
+            quint64 checksum = tileChecksum(tileData);
+            latenciesNs.append(timer.nsecsElapsed());
+
+            readBytes += tileData.size();
+            _databaseChecksums.append(checksum);
+        }
+
+        selectTileQuery.clear();
+        database.close();
+    }
+    QSqlDatabase::removeDatabase("MapTilePackBenchmarkDB");
+
+    qint64 totalNs = std::accumulate(latenciesNs.begin(), latenciesNs.end(), Q_INT64_C(0));
+    reportLine(QString("SQLite: open %1 ms, %2 MB/s").arg(openTimeNs / 1e6, 0, 'f', 2).arg(1e3 * readBytes / qMax<qint64>(totalNs, 1), 0, 'f', 0));
+    reportDurations("SQLite read", latenciesNs);
+}
+
+void MapTilePackBenchmark::readFromTilePack()
+{
+    QVERIFY(!_reads.isEmpty());
+
+    QElapsedTimer timer;
+    timer.start();
+    MapTilePack tilePack(_packFileName);
+    qint64 openTimeNs = timer.nsecsElapsed();
+    QVERIFY(tilePack.isOpen());
+
+    QVector<qint64> latenciesNs;
+    latenciesNs.reserve(_reads.count());
+    qint64 readBytes = 0;
+    int mismatchCount = 0;
+    for (int i = 0; i < _reads.count(); i++)
+    {
+        const BenchmarkTile &tile = _reads[i];
+        timer.restart();
+        QByteArray tileData;
+        int tileFormat;
+        tilePack.findTile(tile.SourceId, tile.Scale, tile.X, tile.Y, tileData, tileFormat);
+        quint64 checksum = tileChecksum(tileData);
+        latenciesNs.append(timer.nsecsElapsed());
+
+        readBytes += tileData.size();
+        if (checksum != _databaseChecksums[i])
+            mismatchCount++;
+    }
+
+    qint64 totalNs = std::accumulate(latenciesNs.begin(), latenciesNs.end(), Q_INT64_C(0));
+    reportLine(QString("Tile pack: %1 tiles, open %2 ms, %3 MB/s").arg(tilePack.tileCount())
+               .arg(openTimeNs / 1e6, 0, 'f', 2).arg(1e3 * readBytes / qMax<qint64>(totalNs, 1), 0, 'f', 0));
+    reportDurations("Tile pack read", latenciesNs);
+    QCOMPARE(mismatchCount, 0);
+}
@@ -0,0 +1,43 @@
+#ifndef MAPTILEPACKTEST_H
+#define MAPTILEPACKTEST_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QVector>
+
+// Tile pack made of a map database with duplicated tiles and both formats finds the same tiles as the database
+// and converts back to it
+class MapTilePackTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MapTilePackTest(QObject *parent);
+private slots:
+    void roundTrip();
+};
+
+// Random tile reads from a map database and from the tile pack made of it: open time and read latency of both.
+// The database is generated, TILEPACK_BENCHMARK_DATABASE=<database> measures a real one
+class MapTilePackBenchmark final : public QObject
+{
+    Q_OBJECT
+
+    struct BenchmarkTile
+    {
+        int SourceId, Scale, X, Y;
+    };
+
+    QTemporaryDir _directory;
+    QString _databaseFileName;
+    QString _packFileName;
+    QVector<BenchmarkTile> _reads;
+    QVector<quint64> _databaseChecksums;
+public:
+    explicit MapTilePackBenchmark(QObject *parent);
+private slots:
+    void initTestCase();
+    void readFromDatabase();
+    void readFromTilePack();
+};
+
+#endif // MAPTILEPACKTEST_H
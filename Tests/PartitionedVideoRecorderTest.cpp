@@ -0,0 +1,116 @@
+#include "PartitionedVideoRecorderTest.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QImage>
+#include <QPainter>
+#include <QFile>
+#include <QDir>
+#include <QMap>
+#include <QtEndian>
+#include "VideoRecorder/PartitionedVideoRecorder.h"
+
+constexpr qint64 AVIH_TOTAL_FRAMES_POS = 48;
+
+static QImage makeSyntheticFrame(int frameNumber)
+{
+    QImage frame(320, 240, QImage::Format_RGB32);
+    frame.fill(QColor::fromHsv((frameNumber * 7) % 360, 200, 200));
+    QPainter painter(&frame);
+    painter.fillRect((frameNumber * 5) % 280, 100, 40, 40, Qt::white);
+    return frame;
+}
+
+// Frame count of the idx1 index, -1 for a broken file. Every index entry must point to a JPEG frame chunk
+static int readAviIndexFrameCount(const QString &fileName, quint32 &headerFrameCount)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+    QByteArray data = file.readAll();
+    if (data.size() < AVIH_TOTAL_FRAMES_POS + 4 || !data.startsWith("RIFF") || data.mid(8, 4) != "AVI ")
+        return -1;
+    headerFrameCount = qFromLittleEndian<quint32>(data.constData() + AVIH_TOTAL_FRAMES_POS);
+
+    qint64 moviPos = -1;
+    qint64 pos = 12;
+    while (pos + 8 <= data.size())
+    {
+        QByteArray chunkId = data.mid(pos, 4);
+        quint32 chunkSize = qFromLittleEndian<quint32>(data.constData() + pos + 4);
+        if (chunkId == "LIST" && data.mid(pos + 8, 4) == "movi")
+        {
+            moviPos = pos + 8;
+        }
+        else if (chunkId == "idx1")
+        {
+            if (moviPos < 0 || chunkSize % 16 != 0 || pos + 8 + chunkSize > data.size())
+                return -1;
+
+            int frameCount = chunkSize / 16;
+            for (int i = 0; i < frameCount; i++)
+            {
+                const char *entry = data.constData() + pos + 8 + i * 16;
+                qint64 framePos = moviPos + qFromLittleEndian<quint32>(entry + 8);
+                quint32 frameSize = qFromLittleEndian<quint32>(entry + 12);
+                if (framePos + 8 + frameSize > data.size() || data.mid(framePos, 4) != "00dc" ||
+                        qFromLittleEndian<quint32>(data.constData() + framePos + 4) != frameSize ||
+                        frameSize < 2 || quint8(data[framePos + 8]) != 0xFF || quint8(data[framePos + 9]) != 0xD8)
+                    return -1;
+            }
+            return frameCount;
+        }
+        pos += 8 + chunkSize + chunkSize % 2;
+    }
+    return -1;
+}
+
+PartitionedVideoRecorderTest::PartitionedVideoRecorderTest(QObject *parent) : QObject(parent)
+{
+}
+
+void PartitionedVideoRecorderTest::recordsAllFramesIntoPartitions_data()
+{
+    QTest::addColumn<int>("framesPerFile");
+    QTest::addColumn<int>("frameCount");
+
+    QTest::newRow("partial last file") << 10 << 25;
+    QTest::newRow("whole files") << 10 << 30;
+    QTest::newRow("single frame") << 10 << 1;
+    QTest::newRow("not partitioned") << 0 << 40;
+}
+
+void PartitionedVideoRecorderTest::recordsAllFramesIntoPartitions()
+{
+    QFETCH(int, framesPerFile);
+    QFETCH(int, frameCount);
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+
+    PartitionedVideoRecorder recorder(nullptr);
+    recorder.start(directory.path(), "session", framesPerFile, 75);
+    for (int i = 0; i < frameCount; i++)
+        recorder.saveFrame(makeSyntheticFrame(i));
+    QCOMPARE(recorder.frameCount(), quint32(frameCount));
+    recorder.stop();
+
+    // Dropped frames are written as repeats of the previous one, so the files hold every frame number
+    QCOMPARE(recorder.writtenFrameCount(), quint32(frameCount));
+    QVERIFY(recorder.droppedFrameCount() < quint32(frameCount));
+
+    QMap<QString, int> expectedFrameCounts;
+    for (int i = 0; i < frameCount; i++)
+        expectedFrameCounts[getVideoFileNameForFrame(directory.path(), "session", framesPerFile, i)]++;
+
+    QStringList videoFiles = QDir(directory.path()).entryList({"*.avi"}, QDir::Files);
+    QCOMPARE(videoFiles.count(), expectedFrameCounts.count());
+
+    for (auto i = expectedFrameCounts.constBegin(); i != expectedFrameCounts.constEnd(); ++i)
+    {
+        quint32 headerFrameCount = 0;
+        int indexFrameCount = readAviIndexFrameCount(i.key(), headerFrameCount);
+        QVERIFY2(indexFrameCount >= 0, qPrintable(i.key()));
+        QCOMPARE(indexFrameCount, i.value());
+        QCOMPARE(headerFrameCount, quint32(i.value()));
+    }
+}
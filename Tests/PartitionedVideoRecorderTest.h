@@ -0,0 +1,17 @@
+#ifndef PARTITIONEDVIDEORECORDERTEST_H
+#define PARTITIONEDVIDEORECORDERTEST_H
+
+#include <QObject>
+
+// Records synthetic frames and checks the partitions against the idx1 index of the written files
+class PartitionedVideoRecorderTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PartitionedVideoRecorderTest(QObject *parent);
+private slots:
+    void recordsAllFramesIntoPartitions_data();
+    void recordsAllFramesIntoPartitions();
+};
+
+#endif // PARTITIONEDVIDEORECORDERTEST_H
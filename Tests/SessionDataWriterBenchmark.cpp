@@ -0,0 +1,174 @@
+#include "SessionDataWriterBenchmark.h"
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QElapsedTimer>
+#include <QVector>
+#include "SessionDataWriter.h"
+#include "Common/CommonUtils.h"
+#include "Tests/TestUtils.h"
+
+constexpr int BENCHMARK_FRAME_COUNT = 100000;
+constexpr int CALLING_THREAD_FLUSH_BATCH_SIZE = 50;   // as the former TelemetryDataStorage flush
+
+static TelemetryDataFrame makeTelemetryFrame(int frameNumber)
+{
+    TelemetryDataFrame frame;
+    frame.Time = frameNumber * 10;
+    frame.SessionTimeMs = frameNumber * 10;
+    frame.TelemetryFrameNumber = frameNumber + 1;
+    frame.VideoFrameNumber = frameNumber / 4;
+    frame.UavRoll = (frameNumber % 60) - 30;
+    frame.UavPitch = (frameNumber % 20) - 10;
+    frame.UavYaw = frameNumber % 360;
+    frame.UavLatitude_GPS = 53.9 + frameNumber * 1e-6;
+    frame.UavLongitude_GPS = 27.5 + frameNumber * 1e-6;
+    frame.UavAltitude_GPS = 1000 + frameNumber % 100;
+    frame.CamYaw = frameNumber % 360;
+    frame.CamZoom = 1;
+    return frame;
+}
+
+SessionDataWriterBenchmark::SessionDataWriterBenchmark(QObject *parent) : QObject(parent)
+{
+}
+
+const QString SessionDataWriterBenchmark::createSessionDatabase(const QString &name)
+{
+    QString databaseFileName = _directory.filePath(name + ".sqlite");
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "SessionDataWriterBenchmark");
+        database.setDatabaseName(databaseFileName);
+        database.open();
+        LOG_SQL_ERROR(database);
+        // TelemetryDataStorage::openTelemetryFramesDatabase
+        EXEC_SQL(database, "CREATE TABLE IF NOT EXISTS TelemetryFrames ( "
+                           "FrameTime INTEGER, Roll REAL, Pitch REAL, Yaw REAL, GPSLat REAL, GPSLon REAL, GPSHmsl REAL, "
+                           "Altitude REAL, VSpeed REAL, CamRoll REAL, CamPitch REAL, CamYaw REAL, CamZoom REAL, "
+                           "CamEncoderRoll INTEGER, CamEncoderPitch INTEGER, CamEncoderYaw INTEGER, "
+                           "AirSpeed REAL, GroundSpeed_GPS REAL, "
+                           "WindDirection REAL, WindSpeed REAL, GroundSpeedNorth_GPS REAL, GroundSpeedEast_GPS REAL, "
+                           "BombState INTEGER, RangefinderDistance REAL, "
+                           "StabilizedCenterX INTEGER, StabilizedCenterY INTEGER, "
+                           "TargetCenterX INTEGER, TargetCenterY INTEGER, TargetRectWidth INTEGER, TargetRectHeight INTEGER, "
+                           "CalculatedTargetGPSLat REAL, CalculatedTargetGPSLon REAL, CalculatedTargetGPSHmsl REAL, "
+                           "CalculatedTargetSpeed REAL, CalculatedTargetDirection  REAL, "
+                           "TelemetryFrameNumber INTEGER, VideoFrameNumber INTEGER, SessionTimeMs INTEGER)");
+        EXEC_SQL(database, "CREATE TABLE IF NOT EXISTS ClientCommands ( "
+                           "SessionTimeMs INTEGER, TelemetryFrameNumber INTEGER, VideoFrameNumber INTEGER, "
+                           "CommandHEX TEXT, Description VARCHAR(255) )");
+        EXEC_SQL(database, "CREATE TABLE IF NOT EXISTS ArtillerySpotterData ( "
+                           "SessionTimeMs INTEGER, TelemetryFrameNumber INTEGER, VideoFrameNumber INTEGER, "
+                           "ContentHEX TEXT, Description VARCHAR(255), Direction INTEGER )");
+        database.close();
+    }
+    QSqlDatabase::removeDatabase("SessionDataWriterBenchmark");
+    return databaseFileName;
+}
+
+int SessionDataWriterBenchmark::countTelemetryFrames(const QString &databaseFileName)
+{
+    int frameCount = -1;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "SessionDataWriterBenchmark");
+        database.setDatabaseName(databaseFileName);
+        database.open();
+        QSqlQuery query = EXEC_SQL(database, "SELECT COUNT(*) FROM TelemetryFrames");
+        if (query.next())
+            frameCount = query.value(0).toInt();
+        query.finish();
+        database.close();
+    }
+    QSqlDatabase::removeDatabase("SessionDataWriterBenchmark");
+    return frameCount;
+}
+
+void SessionDataWriterBenchmark::writeOnCallingThread()
+{
+    QVERIFY(_directory.isValid());
+    QString databaseFileName = createSessionDatabase("CallingThread");
+
+    QVector<qint64> stallsNs;
+    stallsNs.reserve(BENCHMARK_FRAME_COUNT);
+    qint64 durationNs = 0;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "CallingThreadWriter");
+        database.setDatabaseName(databaseFileName);
+        database.open();
+        LOG_SQL_ERROR(database);
+        EXEC_SQL(database, "PRAGMA journal_mode = MEMORY");
+
+        QSqlQuery insertQuery(database);
+        insertQuery.prepare(getTelemetryFramesInsertSQL(1));
+        LOG_SQL_ERROR(insertQuery);
+
+        QVector<TelemetryDataFrame> pendingFrames;
+        QElapsedTimer totalTimer;
+        totalTimer.start();
+        for (int i = 0; i < BENCHMARK_FRAME_COUNT; i++)
+        {
+            TelemetryDataFrame frame = makeTelemetryFrame(i);
+
+            QElapsedTimer stallTimer;
+            stallTimer.start();
+            pendingFrames.append(frame);
+            if (pendingFrames.count() == CALLING_THREAD_FLUSH_BATCH_SIZE || i == BENCHMARK_FRAME_COUNT - 1)
+            {
+                database.transaction();
+                foreach (auto pendingFrame, pendingFrames)
+                {
+                    bindTelemetryFrame(insertQuery, pendingFrame);
+                    insertQuery.exec();
+                }
+                database.commit();
+                pendingFrames.clear();
+            }
+            stallsNs.append(stallTimer.nsecsElapsed());
+        }
+        durationNs = totalTimer.nsecsElapsed();
+
+        insertQuery.finish();
+        database.close();
+    }
+    QSqlDatabase::removeDatabase("CallingThreadWriter");
+
+    QCOMPARE(countTelemetryFrames(databaseFileName), BENCHMARK_FRAME_COUNT);
+    reportLine(QString("Calling thread: %1 rows/s").arg(1e9 * BENCHMARK_FRAME_COUNT / durationNs, 0, 'f', 0));
+    reportDurations("Calling thread stall per frame", stallsNs);
+}
+
+void SessionDataWriterBenchmark::writeOnWriterThread()
+{
+    QVERIFY(_directory.isValid());
+    QString databaseFileName = createSessionDatabase("WriterThread");
+
+    QVector<qint64> stallsNs;
+    stallsNs.reserve(BENCHMARK_FRAME_COUNT);
+
+    SessionDataWriterThread writer(nullptr, databaseFileName);
+    writer.start();
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+    for (int i = 0; i < BENCHMARK_FRAME_COUNT; i++)
+    {
+        TelemetryDataFrame frame = makeTelemetryFrame(i);
+
+        QElapsedTimer stallTimer;
+        stallTimer.start();
+        writer.enqueueTelemetryFrame(frame);
+        stallsNs.append(stallTimer.nsecsElapsed());
+    }
+    writer.stop();
+    qint64 durationNs = totalTimer.nsecsElapsed();
+
+    auto statistics = writer.statistics();
+    QCOMPARE(statistics.WrittenTelemetryFrames, quint64(BENCHMARK_FRAME_COUNT));
+    QCOMPARE(countTelemetryFrames(databaseFileName), BENCHMARK_FRAME_COUNT);
+
+    reportLine(QString("Writer thread: %1 rows/s, backpressure %2, max queue depth %3, max commit %4 us, max latency %5 us")
+               .arg(1e9 * BENCHMARK_FRAME_COUNT / durationNs, 0, 'f', 0)
+               .arg(statistics.BackpressureEvents).arg(statistics.MaxQueueDepth)
+               .arg(statistics.MaxCommitTimeUs).arg(statistics.MaxFrameLatencyUs));
+    reportDurations("Writer thread stall per frame", stallsNs);
+}
@@ -0,0 +1,24 @@
+#ifndef SESSIONDATAWRITERBENCHMARK_H
+#define SESSIONDATAWRITERBENCHMARK_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+// Sustained TelemetryFrames rows/s and the worst stall of the calling (GUI) thread:
+// the former 50 row transactions on the calling thread against SessionDataWriterThread
+class SessionDataWriterBenchmark final : public QObject
+{
+    Q_OBJECT
+
+    QTemporaryDir _directory;
+
+    const QString createSessionDatabase(const QString &name);
+    int countTelemetryFrames(const QString &databaseFileName);
+public:
+    explicit SessionDataWriterBenchmark(QObject *parent);
+private slots:
+    void writeOnCallingThread();
+    void writeOnWriterThread();
+};
+
+#endif // SESSIONDATAWRITERBENCHMARK_H
@@ -0,0 +1,64 @@
+#include <QApplication>
+#include <QtTest>
+#include <QList>
+#include "TelemetryDataFrame.h"
+#include "Tests/PartitionedVideoRecorderTest.h"
+#include "Tests/SessionDataWriterBenchmark.h"
+#include "Tests/MapTilePackTest.h"
+#include "Tests/BallisticMacroTest.h"
+#include "Tests/ImageCorrectorTest.h"
+#include "Tests/XPlaneVideoReceiverTest.h"
+#include "Tests/ImageTrackerCorrelationTest.h"
+#include "Tests/ImageStabilazationBenchmark.h"
+#include "Tests/MUSVProtocolTest.h"
+#include "Tests/UdpBatchReceiverTest.h"
+#include "Tests/MapTileDownloaderTest.h"
+
+// AnimusTests [benchmarks | <class name>] [QTest options]
+// Runs the *Test classes by default, the *Benchmark classes on request
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    qRegisterMetaType<TelemetryDataFrame>("TelemetryDataFrame");
+
+    QList<QObject *> tests = {
+        new PartitionedVideoRecorderTest(&app),
+        new SessionDataWriterBenchmark(&app),
+        new MapTilePackTest(&app),
+        new MapTilePackBenchmark(&app),
+        new BallisticMacroTest(&app),
+        new BallisticMacroBenchmark(&app),
+        new ImageCorrectorTest(&app),
+        new ImageCorrectorBenchmark(&app),
+        new XPlaneVideoReceiverTest(&app),
+        new XPlaneVideoReceiverBenchmark(&app),
+        new ImageTrackerCorrelationTest(&app),
+        new ImageTrackerCorrelationBenchmark(&app),
+        new ImageStabilazationBenchmark(&app),
+        new MUSVProtocolTest(&app),
+        new MUSVProtocolBenchmark(&app),
+        new UdpBatchReceiverTest(&app),
+        new MapTileDownloaderTest(&app)
+    };
+
+    QStringList arguments = app.arguments();
+    QString selection;
+    if (arguments.count() > 1 && !arguments[1].startsWith('-'))
+        selection = arguments.takeAt(1);
+
+    int result = 0;
+    foreach (auto test, tests)
+    {
+        QString className = test->metaObject()->className();
+        bool isSelected = selection.isEmpty() ? className.endsWith("Test") :
+                          selection == "benchmarks" ? className.endsWith("Benchmark") :
+                          selection == className;
+        if (isSelected)
+            result |= QTest::qExec(test, arguments);
+    }
+
+    return result;
+}
@@ -0,0 +1,28 @@
+#include "TestUtils.h"
+#include <QTextStream>
+#include <algorithm>
+
+void reportDurations(const QString &name, QVector<qint64> &durationsNs)
+{
+    std::sort(durationsNs.begin(), durationsNs.end());
+    qint64 totalNs = 0;
+    foreach (qint64 durationNs, durationsNs)
+        totalNs += durationNs;
+
+    auto percentileUs = [&durationsNs](double percent)
+    {
+        int index = qBound(0, static_cast<int>(percent / 100 * durationsNs.count()), durationsNs.count() - 1);
+        return durationsNs.isEmpty() ? 0 : durationsNs[index] / 1000.0;
+    };
+
+    reportLine(QString("%1: %2 samples, us: mean %3, p50 %4, p99 %5, max %6")
+               .arg(name).arg(durationsNs.count())
+               .arg(durationsNs.isEmpty() ? 0 : totalNs / 1000.0 / durationsNs.count())
+               .arg(percentileUs(50)).arg(percentileUs(99)).arg(percentileUs(100)));
+}
+
+void reportLine(const QString &line)
+{
+    QTextStream out(stdout);
+    out << "    " << line << Qt::endl;
+}
@@ -0,0 +1,11 @@
+#ifndef TESTUTILS_H
+#define TESTUTILS_H
+
+#include <QString>
+#include <QVector>
+
+// Prints "<name>: count, mean, p50, p99, max" of the durations in us, sorts durationsNs
+void reportDurations(const QString &name, QVector<qint64> &durationsNs);
+void reportLine(const QString &line);
+
+#endif // TESTUTILS_H
@@ -0,0 +1,181 @@
+#include "UdpBatchReceiverTest.h"
+#include <QtTest>
+#include <QUdpSocket>
+#include <QThread>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QtEndian>
+#include "HardwareLink/UdpBatchReceiver.h"
+
+constexpr int FLOOD_DATAGRAM_COUNT = 20000;
+constexpr int TELEMETRY_PEAK_RATE_HZ = 100;
+constexpr int FLOOD_RATE_HZ = 50 * TELEMETRY_PEAK_RATE_HZ;
+constexpr int FLOOD_SENDER_SLEEP_US = 200;
+constexpr int MINIMAL_DATAGRAM_SIZE = 8;
+constexpr int MAXIMAL_DATAGRAM_SIZE = 1400;
+constexpr int MAXIMAL_RECEIVED_BATCH_SIZE = 64 * 16;  // UDP_BATCH_SIZE * UDP_MAX_BATCHES_PER_WAKEUP
+constexpr int TRUNCATED_DATAGRAM_SIZE = 9000;
+constexpr int RECEIVE_TIMEOUT_MS = 20000;
+
+// Sequence number and a pattern of it, the size varies with the number
+static QByteArray makeDatagram(quint32 sequenceNumber)
+{
+    int size = MINIMAL_DATAGRAM_SIZE + (sequenceNumber * 7919) % (MAXIMAL_DATAGRAM_SIZE - MINIMAL_DATAGRAM_SIZE);
+    QByteArray datagram(size, Qt::Uninitialized);
+    qToLittleEndian(sequenceNumber, datagram.data());
+    for (int i = sizeof(sequenceNumber); i < size; i++)
+        datagram[i] = static_cast<char>(sequenceNumber + i);
+    return datagram;
+}
+
+// Sends the numbered datagrams at FLOOD_RATE_HZ from its own thread, so the receiving event loop is not blocked
+class FloodSender final : public QThread
+{
+    quint16 _port;
+    QAtomicInt _failedDatagrams;
+    qint64 _elapsedNs;
+protected:
+    void run()
+    {
+        QUdpSocket sender;
+        QElapsedTimer timer;
+        timer.start();
+        int sentCount = 0;
+        while (sentCount < FLOOD_DATAGRAM_COUNT)
+        {
+            qint64 dueCount = qMin<qint64>(FLOOD_DATAGRAM_COUNT, timer.nsecsElapsed() * FLOOD_RATE_HZ / 1000000000 + 1);
+            for (; sentCount < dueCount; sentCount++)
+            {
+                QByteArray datagram = makeDatagram(sentCount);
+                if (sender.writeDatagram(datagram, QHostAddress::LocalHost, _port) != datagram.size())
+                    _failedDatagrams.fetchAndAddRelaxed(1);
+            }
+            QThread::usleep(FLOOD_SENDER_SLEEP_US);
+        }
+        _elapsedNs = timer.nsecsElapsed();
+    }
+public:
+    explicit FloodSender(quint16 port) : _port(port), _failedDatagrams(0), _elapsedNs(0) {}
+    ~FloodSender() { wait(); }
+
+    int failedDatagrams() const { return _failedDatagrams.loadRelaxed(); }
+    double datagramsPerSecond() const { return _elapsedNs > 0 ? FLOOD_DATAGRAM_COUNT * 1e9 / _elapsedNs : 0; }
+};
+
+static quint16 findFreeUdpPort()
+{
+    QUdpSocket socket;
+    socket.bind(QHostAddress::LocalHost, 0);
+    return socket.localPort();
+}
+
+//---------------------------------------------------------------------------------------
+
+UdpBatchReceiverTest::UdpBatchReceiverTest(QObject *parent) : QObject(parent)
+{
+}
+
+void UdpBatchReceiverTest::receivesLoopbackFlood_data()
+{
+    QTest::addColumn<bool>("useIOThread");
+
+    QTest::newRow("I/O thread") << true;
+    QTest::newRow("event loop") << false;
+}
+
+void UdpBatchReceiverTest::receivesLoopbackFlood()
+{
+    QFETCH(bool, useIOThread);
+
+    QThread *testThread = QThread::currentThread();
+    QAtomicInt decodedDatagrams = 0;
+    QAtomicInt decodedInTestThread = 0;
+
+    UdpBatchReceiver receiver(nullptr);
+    receiver.setDecoder([&](UdpDatagram &datagram)
+    {
+        decodedDatagrams.fetchAndAddRelaxed(1);
+        if (QThread::currentThread() == testThread)
+            decodedInTestThread.fetchAndAddRelaxed(1);
+        if (datagram.Data.size() >= MINIMAL_DATAGRAM_SIZE)
+            datagram.Value = qFromLittleEndian<quint32>(datagram.Data.constData());
+    });
+
+    quint16 port = findFreeUdpPort();
+    QVERIFY(receiver.open(QHostAddress::LocalHost, port, false, useIOThread));
+
+    UdpDatagramBatch received;
+    int maximalBatchSize = 0;
+    connect(&receiver, &UdpBatchReceiver::datagramsReceived, this, [&](const UdpDatagramBatch &datagrams)
+    {
+        received.append(datagrams);
+        maximalBatchSize = qMax(maximalBatchSize, datagrams.count());
+    });
+
+    QElapsedTimer receiveTimer;
+    receiveTimer.start();
+    FloodSender sender(port);
+    sender.start();
+
+    // The event loop keeps receiving while the sender works
+    QTRY_VERIFY_WITH_TIMEOUT(sender.isFinished(), RECEIVE_TIMEOUT_MS);
+    QCOMPARE(sender.failedDatagrams(), 0);
+    QTRY_VERIFY_WITH_TIMEOUT(received.count() >= FLOOD_DATAGRAM_COUNT || receiver.droppedDatagrams() > 0, RECEIVE_TIMEOUT_MS);
+    qint64 receiveTimeNs = receiveTimer.nsecsElapsed();
+    QCOMPARE(receiver.droppedDatagrams(), 0u);
+    QCOMPARE(received.count(), FLOOD_DATAGRAM_COUNT);
+    // The sender can fall behind the requested rate, the rate reached is checked too
+    QVERIFY2(sender.datagramsPerSecond() >= 10 * TELEMETRY_PEAK_RATE_HZ,
+             qPrintable(QString("Flood reached only %1 datagrams/s").arg(sender.datagramsPerSecond(), 0, 'f', 0)));
+    qInfo("Sent %.0f datagrams/s (%.0f times the telemetry peak rate), received %.0f datagrams/s",
+          sender.datagramsPerSecond(), sender.datagramsPerSecond() / TELEMETRY_PEAK_RATE_HZ,
+          FLOOD_DATAGRAM_COUNT * 1e9 / receiveTimeNs);
+
+    QCOMPARE(decodedDatagrams.loadRelaxed(), received.count());
+    QCOMPARE(decodedInTestThread.loadRelaxed(), useIOThread ? 0 : received.count());
+    QVERIFY(maximalBatchSize <= MAXIMAL_RECEIVED_BATCH_SIZE);
+
+    qint64 previousArrivalTimeNs = 0;
+    int previousSequenceNumber = -1;
+    for (const UdpDatagram &datagram : received)
+    {
+        QVERIFY(datagram.Value.isValid());
+        int sequenceNumber = datagram.Value.toInt();
+        QVERIFY2(sequenceNumber > previousSequenceNumber, qPrintable(QString("Datagram %1 is out of order").arg(sequenceNumber)));
+        QVERIFY2(datagram.Data == makeDatagram(sequenceNumber), qPrintable(QString("Datagram %1 differs").arg(sequenceNumber)));
+        QVERIFY(datagram.ArrivalTimeNs >= previousArrivalTimeNs);
+        previousSequenceNumber = sequenceNumber;
+        previousArrivalTimeNs = datagram.ArrivalTimeNs;
+    }
+
+    receiver.close();
+}
+
+void UdpBatchReceiverTest::skipsTruncatedDatagrams()
+{
+#ifndef Q_OS_LINUX
+    QSKIP("The I/O thread is Linux only");
+#endif
+
+    UdpBatchReceiver receiver(nullptr);
+    QSignalSpy batchSpy(&receiver, &UdpBatchReceiver::datagramsReceived);
+
+    quint16 port = findFreeUdpPort();
+    QVERIFY(receiver.open(QHostAddress::LocalHost, port, false, true));
+
+    QUdpSocket sender;
+    QByteArray truncatedDatagram(TRUNCATED_DATAGRAM_SIZE, 'x');
+    QByteArray datagram = makeDatagram(1);
+    QCOMPARE(sender.writeDatagram(truncatedDatagram, QHostAddress::LocalHost, port), qint64(truncatedDatagram.size()));
+    QCOMPARE(sender.writeDatagram(truncatedDatagram, QHostAddress::LocalHost, port), qint64(truncatedDatagram.size()));
+    QCOMPARE(sender.writeDatagram(datagram, QHostAddress::LocalHost, port), qint64(datagram.size()));
+
+    QTRY_COMPARE_WITH_TIMEOUT(receiver.truncatedDatagrams(), 2u, RECEIVE_TIMEOUT_MS);
+    QTRY_VERIFY_WITH_TIMEOUT(!batchSpy.isEmpty(), RECEIVE_TIMEOUT_MS);
+
+    UdpDatagramBatch received;
+    for (const auto &arguments : batchSpy)
+        received.append(arguments.at(0).value<UdpDatagramBatch>());
+    QCOMPARE(received.count(), 1);
+    QCOMPARE(received.first().Data, datagram);
+}
@@ -0,0 +1,19 @@
+#ifndef UDPBATCHRECEIVERTEST_H
+#define UDPBATCHRECEIVERTEST_H
+
+#include <QObject>
+
+// Floods a loopback port with numbered datagrams at 50 times the telemetry peak rate: every datagram arrives
+// intact, in order and decoded on the receiving thread, none is dropped
+class UdpBatchReceiverTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit UdpBatchReceiverTest(QObject *parent);
+private slots:
+    void receivesLoopbackFlood_data();
+    void receivesLoopbackFlood();
+    void skipsTruncatedDatagrams();
+};
+
+#endif // UDPBATCHRECEIVERTEST_H
@@ -0,0 +1,203 @@
+#include "XPlaneVideoReceiverTest.h"
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QImage>
+#include <QPainter>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QVector>
+#include "HardwareLink/XPlaneVideoReceiver.h"
+#include "PipelineBenchmark.h"
+#include "Common/CommonWidgets.h"
+#include "UAVSimulator/UAVSimXPlaneVideoEncoder.h"
+
+constexpr quint32 VIDEO_CONNECTION_ID = 7;
+constexpr int STREAM_WRITE_SIZE = 1000;      // not a multiple of the packet size, packets arrive split
+constexpr int RECEIVE_TIMEOUT_MS = 10000;
+constexpr int BENCHMARK_FRAME_COUNT = 50;    // written at once in every iteration
+
+// BGRA frame as X-Plane sends it, alpha is not set
+static QImage makeStreamFrame(const QSize &size, int frameNumber)
+{
+    QImage frame(size, QImage::Format_RGB32);
+    for (int y = 0; y < size.height(); y++)
+    {
+        quint32 *line = reinterpret_cast<quint32 *>(frame.scanLine(y));
+        for (int x = 0; x < size.width(); x++)
+            line[x] = (((x + frameNumber * 3) & 0xff) << 16) | (((y + frameNumber) & 0xff) << 8) | ((x * y + frameNumber) & 0xff);
+    }
+    return frame;
+}
+
+// Text over the frame as UAVSimDataSender draws it
+static void drawFrameNumber(QImage &frame, int frameNumber)
+{
+    QPainter painter;
+    painter.begin(&frame);
+    QPen pen = painter.pen();
+    pen.setColor(QColor("#FFFFFF"));
+    pen.setWidth(2);
+    painter.setPen(pen);
+    QFont font = painter.font();
+    font.setPointSize(15);
+    painter.setFont(font);
+    CommonWidgetUtils::drawText(painter, QPoint(100, 100), Qt::AlignTop | Qt::AlignLeft, QString("Frame %1").arg(frameNumber), true);
+    painter.end();
+}
+
+static QImage expectedFrame(const QImage &streamFrame, bool verticalMirror)
+{
+    QImage frame = streamFrame.copy();
+    auto pixels = reinterpret_cast<quint32 *>(frame.bits());
+    for (int i = 0; i < frame.width() * frame.height(); i++)
+        pixels[i] |= 0xFF000000;
+    return verticalMirror ? frame.mirrored(false, true) : frame;
+}
+
+//---------------------------------------------------------------------------------------
+
+XPlaneVideoReceiverTest::XPlaneVideoReceiverTest(QObject *parent) : QObject(parent)
+{
+}
+
+void XPlaneVideoReceiverTest::receivesStreamedFrames_data()
+{
+    QTest::addColumn<QSize>("firstSize");
+    QTest::addColumn<QSize>("secondSize");
+    QTest::addColumn<bool>("verticalMirror");
+
+    QTest::newRow("720x576") << QSize(720, 576) << QSize(720, 576) << false;
+    QTest::newRow("720x576 mirrored") << QSize(720, 576) << QSize(720, 576) << true;
+    QTest::newRow("size change") << QSize(720, 576) << QSize(1280, 720) << false;
+}
+
+void XPlaneVideoReceiverTest::receivesStreamedFrames()
+{
+    QFETCH(QSize, firstSize);
+    QFETCH(QSize, secondSize);
+    QFETCH(bool, verticalMirror);
+
+    // More frames than the receiver pool, the spy keeps all of them
+    const int frameCount = XPLANE_FRAME_POOL_SIZE * 3;
+
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    XPlaneVideoReceiver receiver(nullptr, VIDEO_CONNECTION_ID, verticalMirror, QHostAddress::LocalHost, server.serverPort());
+    QSignalSpy frameSpy(&receiver, &XPlaneVideoReceiver::frameAvailable);
+
+    QVERIFY(server.waitForNewConnection(RECEIVE_TIMEOUT_MS));
+    QTcpSocket *connection = server.nextPendingConnection();
+    QVERIFY(connection != nullptr);
+
+    UAVSimXPlaneVideoEncoder encoder;
+    QVector<QImage> streamFrames;
+    QByteArray stream;
+    for (int i = 0; i < frameCount; i++)
+    {
+        streamFrames.append(makeStreamFrame(i < frameCount / 2 ? firstSize : secondSize, i));
+        stream.append(encoder.encode(streamFrames.last(), i + 1));
+
+        // Packet with a broken header is skipped
+        if (i == 1)
+        {
+            XPLANE_PACKET_HEADER brokenHeader = { 100, 0, 0 };
+            stream.append(reinterpret_cast<const char *>(&brokenHeader), sizeof(brokenHeader));
+            stream.append(XPLANE_PACKET_CHUNKSIZE, '\0');
+        }
+    }
+
+    for (int offset = 0; offset < stream.size(); offset += STREAM_WRITE_SIZE)
+    {
+        connection->write(stream.constData() + offset, qMin(STREAM_WRITE_SIZE, stream.size() - offset));
+        connection->flush();
+    }
+    while (connection->bytesToWrite() > 0)
+        QVERIFY(connection->waitForBytesWritten(RECEIVE_TIMEOUT_MS));
+
+    QTRY_COMPARE_WITH_TIMEOUT(frameSpy.count(), frameCount, RECEIVE_TIMEOUT_MS);
+
+    for (int i = 0; i < frameCount; i++)
+    {
+        const QImage frame = frameSpy.at(i).at(0).value<QImage>();
+        QCOMPARE(frameSpy.at(i).at(1).toUInt(), VIDEO_CONNECTION_ID);
+        QCOMPARE(frame.size(), streamFrames[i].size());
+        QVERIFY2(frame == expectedFrame(streamFrames[i], verticalMirror), qPrintable(QString("Frame %1 differs").arg(i)));
+    }
+}
+
+//---------------------------------------------------------------------------------------
+
+XPlaneVideoReceiverBenchmark::XPlaneVideoReceiverBenchmark(QObject *parent) : QObject(parent)
+{
+}
+
+void XPlaneVideoReceiverBenchmark::receiveFrames_data()
+{
+    QTest::addColumn<QSize>("size");
+
+    QTest::newRow("720x576") << QSize(720, 576);
+    QTest::newRow("1280x720") << QSize(1280, 720);
+}
+
+// The stream is encoded before the measuring, the time is the decoding and the delivery of the frames
+void XPlaneVideoReceiverBenchmark::receiveFrames()
+{
+    QFETCH(QSize, size);
+
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    XPlaneVideoReceiver receiver(nullptr, VIDEO_CONNECTION_ID, false, QHostAddress::LocalHost, server.serverPort());
+
+    QVERIFY(server.waitForNewConnection(RECEIVE_TIMEOUT_MS));
+    QTcpSocket *connection = server.nextPendingConnection();
+    QVERIFY(connection != nullptr);
+
+    UAVSimXPlaneVideoEncoder encoder;
+    QByteArray stream;
+    for (int i = 0; i < BENCHMARK_FRAME_COUNT; i++)
+    {
+        QImage frame = makeStreamFrame(size, i).convertToFormat(QImage::Format_ARGB32);
+        drawFrameNumber(frame, i + 1);
+        stream.append(encoder.encode(frame, i + 1));
+    }
+
+    QEventLoop loop;
+    int receivedFrames = 0;
+    int expectedFrames = 0;
+    connect(&receiver, &XPlaneVideoReceiver::frameAvailable, &loop, [&]()
+    {
+        receivedFrames++;
+        if (receivedFrames == expectedFrames)
+            loop.quit();
+    });
+
+    QElapsedTimer clock;
+    qint64 elapsedNs = 0;
+    qint64 cpuTimeUs = 0;
+    int measuredFrames = 0;
+    QBENCHMARK
+    {
+        expectedFrames = receivedFrames + BENCHMARK_FRAME_COUNT;
+        clock.start();
+        qint64 startCpuTimeUs = PipelineBenchmark::processCpuTimeUs();
+
+        connection->write(stream);
+        QTimer timeout;
+        timeout.setSingleShot(true);
+        connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+        timeout.start(RECEIVE_TIMEOUT_MS);
+        loop.exec();
+
+        elapsedNs += clock.nsecsElapsed();
+        cpuTimeUs += PipelineBenchmark::processCpuTimeUs() - startCpuTimeUs;
+        measuredFrames += BENCHMARK_FRAME_COUNT;
+        QCOMPARE(receivedFrames, expectedFrames);
+    }
+
+    qInfo("%d frames of %d bytes: %.0f frames/s, %.0f CPU us/frame",
+          measuredFrames, static_cast<int>(stream.size() / BENCHMARK_FRAME_COUNT),
+          measuredFrames * 1e9 / qMax<qint64>(elapsedNs, 1), static_cast<double>(cpuTimeUs) / measuredFrames);
+}
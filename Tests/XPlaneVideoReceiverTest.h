@@ -0,0 +1,28 @@
+#ifndef XPLANEVIDEORECEIVERTEST_H
+#define XPLANEVIDEORECEIVERTEST_H
+
+#include <QObject>
+
+// Streams frames the way UAVSimDataSender does over a loopback TCP connection and checks the received frames
+class XPlaneVideoReceiverTest final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit XPlaneVideoReceiverTest(QObject *parent);
+private slots:
+    void receivesStreamedFrames_data();
+    void receivesStreamedFrames();
+};
+
+// Frames of the simulator received over a loopback TCP connection, frames/s and CPU time per frame
+class XPlaneVideoReceiverBenchmark final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit XPlaneVideoReceiverBenchmark(QObject *parent);
+private slots:
+    void receiveFrames_data();
+    void receiveFrames();
+};
+
+#endif // XPLANEVIDEORECEIVERTEST_H
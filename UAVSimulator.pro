@@ -18,6 +18,10 @@ SOURCES +=\
 	UAVSimulator/UAVSimMainWindow.cpp \
 	UAVSimulator/UAVSimMain.cpp \
         UAVSimulator/UAVSimDataSender.cpp \
+        UAVSimulator/UAVSimPacketCapture.cpp \
+        UAVSimulator/UAVSimXPlaneVideoEncoder.cpp \
+        UAVSimulator/UAVSimPacketReplayer.cpp \
+        UAVSimulator/UAVSimTileServer.cpp \
         ApplicationSettingsImpl.cpp \
         ApplicationSettings.cpp \
         CamPreferences.cpp \
@@ -32,6 +36,10 @@ SOURCES +=\
 HEADERS  +=\
 	UAVSimulator/UAVSimMainWindow.h \
         UAVSimulator/UAVSimDataSender.h \
+        UAVSimulator/UAVSimPacketCapture.h \
+        UAVSimulator/UAVSimXPlaneVideoEncoder.h \
+        UAVSimulator/UAVSimPacketReplayer.h \
+        UAVSimulator/UAVSimTileServer.h \
         ApplicationSettingsImpl.h \
         ApplicationSettings.h \
         CamPreferences.h \
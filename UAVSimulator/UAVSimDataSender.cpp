@@ -1,5 +1,4 @@
 #include "UAVSimDataSender.h"
-#include "HardwareLink/lz4.h"
 #include "DataAccess/csv.h"
 #include <QFileInfo>
 #include <QStringList>
@@ -19,21 +18,6 @@ struct UDPSimpleVideoMessage {
 };
 #pragma pack(pop)
 
-const int  XPLANE_PACKET_CHUNKSIZE = 1400;
-const int  XPLANE_IMAGE_WIDTH      =  720;
-const int  XPLANE_IMAGE_HEIGHT     =  576;
-const int  XPLANE_IMAGE_BPP        =    4;
-const int  XPLANE_IMAGE_DATA_SIZE  = XPLANE_IMAGE_WIDTH * XPLANE_IMAGE_HEIGHT * XPLANE_IMAGE_BPP;
-
-
-#pragma pack(push,1)
-struct XPLANE_PACKET {
-    unsigned       frameId        = 0;
-    int            frameTotalSize = 0;
-    unsigned short framePartNo    = 0;
-    quint8         frameData[XPLANE_PACKET_CHUNKSIZE];
-};
-#pragma pack(pop)
 
 void UAVSimDataSender::updateCamPitchRoll()
 {
@@ -157,6 +141,7 @@ void UAVSimDataSender::sendTelemetryMassage()
 
     _udpTelemetrySocket.writeDatagram((char*)&telemetryMessage, sizeof(telemetryMessage),
                                       QHostAddress::LocalHost, _telemetryUDPPort);
+    _captureWriter.append(UAVSimPacketChannel::UAVTelemetry, (char*)&telemetryMessage, sizeof(telemetryMessage));
 
     if (!_pause)
     {
@@ -165,14 +150,16 @@ void UAVSimDataSender::sendTelemetryMassage()
             _currentMessageNumber = 0;
     }
 
-    QByteArray msg = QByteArray::fromHex("0f0b00000000000000001a");
-    _udpTelemetrySocket.writeDatagram(msg, QHostAddress::LocalHost, 50011);
-    msg = QByteArray::fromHex("050f0000000041980000421000003f");
-    _udpTelemetrySocket.writeDatagram(msg, QHostAddress::LocalHost, 50011);
-    msg = QByteArray::fromHex("030fbf28c0003eca8000c09b640000");
-    _udpTelemetrySocket.writeDatagram(msg, QHostAddress::LocalHost, 50011);
-    msg = QByteArray::fromHex("100f06000606000000000000000031");
+    sendCamTelemetryMessage(QByteArray::fromHex("0f0b00000000000000001a"));
+    sendCamTelemetryMessage(QByteArray::fromHex("050f0000000041980000421000003f"));
+    sendCamTelemetryMessage(QByteArray::fromHex("030fbf28c0003eca8000c09b640000"));
+    sendCamTelemetryMessage(QByteArray::fromHex("100f06000606000000000000000031"));
+}
+
+void UAVSimDataSender::sendCamTelemetryMessage(const QByteArray &msg)
+{
     _udpTelemetrySocket.writeDatagram(msg, QHostAddress::LocalHost, 50011);
+    _captureWriter.append(UAVSimPacketChannel::CamTelemetry, msg.constData(), msg.size());
 }
 
 
@@ -198,49 +185,25 @@ void UAVSimDataSender::sendXPLaneVideoMessage()
 
     painter.end();
 
-    int compressedSizeEstimation = LZ4_compressBound(XPLANE_IMAGE_DATA_SIZE);
-    _compressedXPlaneData = new quint8[compressedSizeEstimation];
-
-    _compressedXPlaneDataSize = LZ4_compress_default((char*)_frame.bits(),
-                                                     (char*)_compressedXPlaneData,
-                                                     XPLANE_IMAGE_DATA_SIZE,
-                                                     compressedSizeEstimation);
-
-
-
-
-
-
-    XPLANE_PACKET videoPacket;
-    int beginPos = 0, endPos = 0;
-    videoPacket.framePartNo = 0;
-    videoPacket.frameTotalSize = _compressedXPlaneDataSize;
-    videoPacket.frameId = _frameNumber;
-
-    int framePartCount = qCeil((float)videoPacket.frameTotalSize / XPLANE_PACKET_CHUNKSIZE);
-    //int framePartCount = (videoPacket.frameTotalSize / XPLANE_PACKET_CHUNKSIZE);
-
     QTcpSocket *clientConnection = _tcpVideoServer->nextPendingConnection();
     if (clientConnection != nullptr)
         _clientConnection = clientConnection;
 
-    if (_clientConnection == nullptr)
+    if (_clientConnection == nullptr && !_captureWriter.isOpen())
+        return;
+
+    // All packets of the frame are one packet of the capture
+    const QByteArray &packets = _xplaneVideoEncoder.encode(_frame, _frameNumber);
+    if (packets.isEmpty())
         return;
 
-    for (beginPos = 0; endPos < _compressedXPlaneDataSize - 1; beginPos += XPLANE_PACKET_CHUNKSIZE)
+    if (_clientConnection != nullptr && _clientConnection->isValid())
     {
-        endPos = beginPos + XPLANE_PACKET_CHUNKSIZE - 1;
-        if (endPos >= _compressedXPlaneDataSize)
-            endPos = _compressedXPlaneDataSize - 1;
-        int frameSize = endPos - beginPos + 1;
-        memcpy(videoPacket.frameData, _compressedXPlaneData + beginPos, frameSize);
-
-        qint64 len = sizeof(videoPacket);
-        if (_clientConnection->isValid())
-            _clientConnection->write((char*)&videoPacket, len);
+        _clientConnection->write(packets);
         _clientConnection->flush();
-        videoPacket.framePartNo++;
     }
+    if (_captureWriter.isOpen())
+        _captureWriter.append(UAVSimPacketChannel::XPlaneVideo, packets.constData(), packets.size());
 }
 
 void UAVSimDataSender::timerEvent(QTimerEvent *event)
@@ -311,6 +274,11 @@ void UAVSimDataSender::setPause(bool pause)
     _pause = pause;
 }
 
+bool UAVSimDataSender::startCapture(const QString &fileName)
+{
+    return _captureWriter.open(fileName);
+}
+
 double UAVSimDataSender::camXTarget()
 {
     return _camX;
@@ -8,6 +8,8 @@
 #include <QTcpServer>
 #include <QImage>
 #include "ApplicationSettings.h"
+#include "UAVSimPacketCapture.h"
+#include "UAVSimXPlaneVideoEncoder.h"
 
 #pragma pack(push, 1)
 struct UDPSimulatorTelemetryMessageV4
@@ -65,8 +67,6 @@ class UAVSimDataSender : public QObject
     QByteArray _urionVideo;
     int _urionVideoPosition;
 
-    quint8 * _compressedXPlaneData;
-    int _compressedXPlaneDataSize;
     int _frameNumber;
 
     QUdpSocket _udpTelemetrySocket;
@@ -77,11 +77,14 @@ class UAVSimDataSender : public QObject
     QTcpSocket *_clientConnection;
 
     QImage _frame;
+    UAVSimXPlaneVideoEncoder _xplaneVideoEncoder;
     int _telemetryTimerId;
     int _videoTimerId;
 
     bool _pause;
 
+    UAVSimPacketCaptureWriter _captureWriter;
+
     CameraControlModes _controlMode;
     double _camX, _camY, _camZ, _camZoom, _camYTarget, _camXTarget, _camZoomTarget;
 
@@ -115,6 +118,7 @@ class UAVSimDataSender : public QObject
     void loadXPlaneVideo(const QString &fileName);
 
     void sendTelemetryMassage();
+    void sendCamTelemetryMessage(const QByteArray &msg);
     void sendXPLaneVideoMessage();
 
     void timerEvent(QTimerEvent *event);
@@ -125,6 +129,8 @@ public:
                               CameraControlModes controlMode);
 
     void setPause(bool pause);
+    // Sent packets are written to the capture for the headless replay
+    bool startCapture(const QString &fileName);
 
 
     double camXTarget();
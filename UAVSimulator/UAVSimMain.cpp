@@ -1,8 +1,100 @@
 #include "UAVSimMainWindow.h"
+#include "UAVSimPacketReplayer.h"
+#include "UAVSimTileServer.h"
 #include <QApplication>
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QTimer>
+#include "ApplicationSettings.h"
+#include "Common/CommonUtils.h"
+
+// Headless replay: REPLAY=<capture file> [SPEED=<factor>|max] [LOOPS=<count>]
+static int replayPacketCapture(const QString &captureFileName)
+{
+    auto arguments = QCoreApplication::arguments();
+    QString speedValue = getCommandLineValue(arguments, "SPEED");
+    double speed = 1;
+    if (speedValue.compare("max", Qt::CaseInsensitive) == 0)
+        speed = 0;
+    else if (!speedValue.isEmpty())
+        speed = speedValue.toDouble();
+    int loops = qMax(1, getCommandLineValue(arguments, "LOOPS").toInt());
+
+    QVector<UAVSimPacket> packets;
+    if (!loadPacketCapture(captureFileName, packets))
+        return 1;
+
+    ApplicationSettings& applicationSettings = ApplicationSettings::Instance();
+    auto videoConnectionSetting = applicationSettings.installedCameraSettings()->videoConnectionSetting(1);
+
+    UAVSimPacketReplayer replayer(nullptr, packets, speed, loops,
+                                  applicationSettings.UAVTelemetryUDPPort.value(),
+                                  applicationSettings.CamTelemetryUDPPort.value(),
+                                  videoConnectionSetting->VideoFrameSourceXPlanePort->value());
+    QObject::connect(&replayer, &QThread::finished, qApp, &QCoreApplication::quit);
+    replayer.start(QThread::TimeCriticalPriority);
+    QCoreApplication::exec();
+    replayer.wait();
+
+    auto statistics = replayer.statistics();
+    double durationSec = statistics.DurationNs / 1e9;
+    QTextStream out(stdout);
+    out << "Packets: " << statistics.SentPackets << ", failed: " << statistics.FailedPackets << Qt::endl;
+    out << "Duration: " << durationSec << " s, "
+        << (durationSec > 0 ? statistics.SentPackets / durationSec : 0) << " packets/s, "
+        << (durationSec > 0 ? statistics.SentBytes / durationSec / 1e6 : 0) << " MB/s" << Qt::endl;
+    if (speed > 0)
+        out << "Schedule lateness, us: mean " << statistics.TotalLatenessNs / 1000 / qMax<quint64>(1, statistics.SentPackets + statistics.FailedPackets)
+            << ", max " << statistics.MaxLatenessNs / 1000 << Qt::endl;
+
+    return statistics.FailedPackets == 0 ? 0 : 2;
+}
+
+// Headless tile server: TILESERVER=<port> [TILE_LATENCY_MS=<ms>] [TILE_ERROR_RATE=<0...1>]
+static int runTileServer(quint16 port)
+{
+    auto arguments = QCoreApplication::arguments();
+    int latencyMs = getCommandLineValue(arguments, "TILE_LATENCY_MS").toInt();
+    double errorRate = getCommandLineValue(arguments, "TILE_ERROR_RATE").toDouble();
+
+    UAVSimTileServer tileServer(nullptr, latencyMs, errorRate);
+    if (!tileServer.listen(port))
+        return 1;
+
+    QTextStream out(stdout);
+    out << "Tile server: http://127.0.0.1:" << port << "/{source}/{z}/{x}/{y}, latency " << latencyMs
+        << " ms, error rate " << errorRate << Qt::endl;
+
+    QTimer statisticsTimer;
+    QObject::connect(&statisticsTimer, &QTimer::timeout, [&out, &tileServer]()
+    {
+        out << "Served tiles: " << tileServer.servedTiles() << ", failed requests: " << tileServer.failedRequests() << Qt::endl;
+    });
+    statisticsTimer.start(10000);
+
+    return QCoreApplication::exec();
+}
 
 int main(int argc, char *argv[])
 {
+    QStringList arguments;
+    for (int i = 0; i < argc; i++)
+        arguments.append(QString::fromLocal8Bit(argv[i]));
+
+    QString captureFileName = getCommandLineValue(arguments, "REPLAY");
+    if (!captureFileName.isEmpty())
+    {
+        QCoreApplication a(argc, argv);
+        return replayPacketCapture(captureFileName);
+    }
+
+    quint16 tileServerPort = getCommandLineValue(arguments, "TILESERVER").toUShort();
+    if (tileServerPort > 0)
+    {
+        QCoreApplication a(argc, argv);
+        return runTileServer(tileServerPort);
+    }
+
     QApplication a(argc, argv);
     UAVSimMainWindow w(nullptr);
     w.show();
@@ -4,8 +4,10 @@
 #include <QGridLayout>
 #include <QDebug>
 #include <QTemporaryDir>
+#include <QCoreApplication>
 #include "ApplicationSettings.h"
 #include "HardwareLink/lz4.h"
+#include "Common/CommonUtils.h"
 
 QCheckBox *UAVSimMainWindow::createCheckBox(const QString &caption)
 {
@@ -169,6 +171,10 @@ UAVSimMainWindow::UAVSimMainWindow(QWidget *parent) : QMainWindow(parent)
                                        cameraSettings->CameraControlMode.value()
                                        );
 
+    QString captureFileName = getCommandLineValue(QCoreApplication::arguments(), "RECORD");
+    if (!captureFileName.isEmpty() && _dataSender->startCapture(captureFileName))
+        qDebug() << "Sent packets are captured to" << captureFileName;
+
     qDebug() << "UAV Telemetry UDP Port" << applicationSettings.UAVTelemetryUDPPort;
     qDebug() << "Video X-Plane Port" << videoConnectionSetting->VideoFrameSourceXPlanePort->value();
     qDebug() << "Commands Port" << applicationSettings.CommandUDPPort;
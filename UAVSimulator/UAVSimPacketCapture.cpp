@@ -0,0 +1,120 @@
+#include "UAVSimPacketCapture.h"
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+
+static const char CAPTURE_SIGNATURE[] = "UAVSIMPC";
+constexpr int CAPTURE_SIGNATURE_SIZE = 8;
+constexpr quint32 CAPTURE_FORMAT_VERSION = 1;
+constexpr int CAPTURE_PACKET_HEADER_SIZE = 8 + 1 + 4;
+constexpr quint32 CAPTURE_MAX_PACKET_SIZE = 64 * 1024 * 1024;
+
+UAVSimPacketCaptureWriter::UAVSimPacketCaptureWriter()
+{
+}
+
+UAVSimPacketCaptureWriter::~UAVSimPacketCaptureWriter()
+{
+    close();
+}
+
+bool UAVSimPacketCaptureWriter::open(const QString &fileName)
+{
+    close();
+
+    _file.setFileName(fileName);
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "Can't create packet capture" << fileName << ":" << _file.errorString();
+        return false;
+    }
+
+    char version[4];
+    qToLittleEndian<quint32>(CAPTURE_FORMAT_VERSION, version);
+    _file.write(CAPTURE_SIGNATURE, CAPTURE_SIGNATURE_SIZE);
+    _file.write(version, sizeof(version));
+
+    _timer.start();
+    return true;
+}
+
+void UAVSimPacketCaptureWriter::close()
+{
+    if (_file.isOpen())
+        _file.close();
+}
+
+bool UAVSimPacketCaptureWriter::isOpen() const
+{
+    return _file.isOpen();
+}
+
+void UAVSimPacketCaptureWriter::append(UAVSimPacketChannel channel, const char *data, int size)
+{
+    if (!_file.isOpen())
+        return;
+
+    char header[CAPTURE_PACKET_HEADER_SIZE];
+    qToLittleEndian<qint64>(_timer.nsecsElapsed(), header);
+    header[8] = static_cast<char>(channel);
+    qToLittleEndian<quint32>(static_cast<quint32>(size), header + 9);
+
+    _file.write(header, sizeof(header));
+    _file.write(data, size);
+}
+
+bool loadPacketCapture(const QString &fileName, QVector<UAVSimPacket> &packets)
+{
+    packets.clear();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Can't open packet capture" << fileName << ":" << file.errorString();
+        return false;
+    }
+
+    QByteArray content = file.readAll();
+    const char *data = content.constData();
+    qint64 size = content.size();
+
+    if (size < CAPTURE_SIGNATURE_SIZE + 4 || memcmp(data, CAPTURE_SIGNATURE, CAPTURE_SIGNATURE_SIZE) != 0)
+    {
+        qWarning() << "File" << fileName << "is not a packet capture";
+        return false;
+    }
+
+    quint32 version = qFromLittleEndian<quint32>(data + CAPTURE_SIGNATURE_SIZE);
+    if (version != CAPTURE_FORMAT_VERSION)
+    {
+        qWarning() << "Unsupported packet capture version" << version;
+        return false;
+    }
+
+    qint64 position = CAPTURE_SIGNATURE_SIZE + 4;
+    while (position + CAPTURE_PACKET_HEADER_SIZE <= size)
+    {
+        UAVSimPacket packet;
+        packet.TimeNs = qFromLittleEndian<qint64>(data + position);
+        packet.Channel = static_cast<UAVSimPacketChannel>(data[position + 8]);
+        quint32 packetSize = qFromLittleEndian<quint32>(data + position + 9);
+        position += CAPTURE_PACKET_HEADER_SIZE;
+
+        if (packetSize > CAPTURE_MAX_PACKET_SIZE || position + packetSize > size)
+        {
+            qWarning() << "Packet capture" << fileName << "is truncated after" << packets.count() << "packets";
+            break;
+        }
+
+        packet.Data = content.mid(position, packetSize);
+        position += packetSize;
+
+        // Packets of the unknown channels are skipped, newer captures can be replayed partially
+        if (packet.Channel == UAVSimPacketChannel::UAVTelemetry ||
+            packet.Channel == UAVSimPacketChannel::CamTelemetry ||
+            packet.Channel == UAVSimPacketChannel::XPlaneVideo)
+            packets.append(packet);
+    }
+
+    return !packets.isEmpty();
+}
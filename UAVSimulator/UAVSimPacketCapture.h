@@ -0,0 +1,44 @@
+#ifndef UAVSIMPACKETCAPTURE_H
+#define UAVSIMPACKETCAPTURE_H
+
+#include <QFile>
+#include <QByteArray>
+#include <QVector>
+#include <QElapsedTimer>
+
+// Capture file: "UAVSIMPC" signature and format version, then packets one after another:
+// time from the capture start (ns), channel, payload size and the payload. Numbers are little endian
+enum class UAVSimPacketChannel : quint8
+{
+    UAVTelemetry = 1,       // UDP telemetry datagram
+    CamTelemetry = 2,       // UDP camera (MUSV) telemetry datagram
+    XPlaneVideo = 3         // all LZ4 XPlane packets of one video frame, sent over TCP
+};
+
+struct UAVSimPacket final
+{
+    qint64 TimeNs;
+    UAVSimPacketChannel Channel;
+    QByteArray Data;
+};
+
+class UAVSimPacketCaptureWriter final
+{
+    QFile _file;
+    QElapsedTimer _timer;
+public:
+    UAVSimPacketCaptureWriter();
+    ~UAVSimPacketCaptureWriter();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const;
+
+    // Packet time is the time of the call
+    void append(UAVSimPacketChannel channel, const char *data, int size);
+};
+
+// The whole capture is loaded before the replay, the disk does not disturb the packet timing
+bool loadPacketCapture(const QString &fileName, QVector<UAVSimPacket> &packets);
+
+#endif // UAVSIMPACKETCAPTURE_H
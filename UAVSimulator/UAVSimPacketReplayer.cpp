@@ -0,0 +1,148 @@
+#include "UAVSimPacketReplayer.h"
+#include <QUdpSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QDebug>
+#include <algorithm>
+
+constexpr qint64 REPLAY_SPIN_INTERVAL_NS = 1000000;     // the last millisecond before a packet is spun
+constexpr int VIDEO_CLIENT_WAIT_MS = 200;
+constexpr int VIDEO_WRITE_TIMEOUT_MS = 1000;
+
+UAVSimPacketReplayer::UAVSimPacketReplayer(QObject *parent, const QVector<UAVSimPacket> &packets, double speed, int loops,
+                                           quint16 uavTelemetryPort, quint16 camTelemetryPort, quint16 videoTcpPort) : QThread(parent)
+{
+    setObjectName("UAVSimPacketReplayer");
+    _packets = packets;
+    _speed = speed;
+    _loops = qMax(1, loops);
+    _uavTelemetryPort = uavTelemetryPort;
+    _camTelemetryPort = camTelemetryPort;
+    _videoTcpPort = videoTcpPort;
+    _quit = 0;
+}
+
+UAVSimPacketReplayer::~UAVSimPacketReplayer()
+{
+    stop();
+}
+
+void UAVSimPacketReplayer::stop()
+{
+    _quit = 1;
+    wait();
+}
+
+const UAVSimReplayStatistics UAVSimPacketReplayer::statistics() const
+{
+    return _statistics;
+}
+
+void UAVSimPacketReplayer::waitUntil(const QElapsedTimer &timer, qint64 timeNs)
+{
+    qint64 remainingNs = timeNs - timer.nsecsElapsed();
+    if (remainingNs > REPLAY_SPIN_INTERVAL_NS)
+        QThread::usleep(static_cast<unsigned long>((remainingNs - REPLAY_SPIN_INTERVAL_NS) / 1000));
+
+    while (timer.nsecsElapsed() < timeNs)
+    {
+    }
+}
+
+void UAVSimPacketReplayer::run()
+{
+    if (_packets.isEmpty())
+        return;
+
+    QUdpSocket udpSocket;
+    udpSocket.setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 4000000);
+
+    // Video receiver connects to the simulator, the replay waits for it
+    QTcpServer videoServer;
+    QTcpSocket *videoSocket = nullptr;
+    bool hasVideo = std::any_of(_packets.cbegin(), _packets.cend(), [](const UAVSimPacket &packet)
+    {
+        return packet.Channel == UAVSimPacketChannel::XPlaneVideo;
+    });
+    if (hasVideo)
+    {
+        if (!videoServer.listen(QHostAddress::Any, _videoTcpPort))
+        {
+            qWarning() << "Can't listen the video port" << _videoTcpPort << ":" << videoServer.errorString();
+            return;
+        }
+
+        qInfo() << "Waiting for the video client on the port" << _videoTcpPort;
+        while (!_quit.loadRelaxed() && !videoServer.waitForNewConnection(VIDEO_CLIENT_WAIT_MS))
+        {
+        }
+        videoSocket = videoServer.nextPendingConnection();
+        if (videoSocket == nullptr)
+            return;
+        videoSocket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 4000000);
+    }
+
+    // Loops follow one another with the interval of the last two packets
+    qint64 captureDurationNs = _packets.last().TimeNs - _packets.first().TimeNs;
+    if (_packets.count() > 1)
+        captureDurationNs += _packets.last().TimeNs - _packets[_packets.count() - 2].TimeNs;
+
+    _statistics = UAVSimReplayStatistics();
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int loop = 0; loop < _loops && !_quit.loadRelaxed(); loop++)
+    {
+        for (int i = 0; i < _packets.count() && !_quit.loadRelaxed(); i++)
+        {
+            const UAVSimPacket &packet = _packets[i];
+
+            if (_speed > 0)
+            {
+                qint64 packetTimeNs = loop * captureDurationNs + packet.TimeNs - _packets.first().TimeNs;
+                qint64 scheduledTimeNs = static_cast<qint64>(packetTimeNs / _speed);
+                waitUntil(timer, scheduledTimeNs);
+
+                qint64 latenessNs = timer.nsecsElapsed() - scheduledTimeNs;
+                _statistics.TotalLatenessNs += latenessNs;
+                _statistics.MaxLatenessNs = qMax(_statistics.MaxLatenessNs, latenessNs);
+            }
+
+            qint64 sentSize = -1;
+            switch (packet.Channel)
+            {
+            case UAVSimPacketChannel::UAVTelemetry:
+                sentSize = udpSocket.writeDatagram(packet.Data, QHostAddress::LocalHost, _uavTelemetryPort);
+                break;
+            case UAVSimPacketChannel::CamTelemetry:
+                sentSize = udpSocket.writeDatagram(packet.Data, QHostAddress::LocalHost, _camTelemetryPort);
+                break;
+            case UAVSimPacketChannel::XPlaneVideo:
+                sentSize = videoSocket->write(packet.Data);
+                if (sentSize > 0)
+                    videoSocket->waitForBytesWritten(VIDEO_WRITE_TIMEOUT_MS);
+                break;
+            }
+
+            if (sentSize == packet.Data.size())
+            {
+                _statistics.SentPackets++;
+                _statistics.SentBytes += static_cast<quint64>(sentSize);
+            }
+            else
+            {
+                _statistics.FailedPackets++;
+            }
+        }
+    }
+
+    _statistics.DurationNs = timer.nsecsElapsed();
+
+    if (videoSocket != nullptr)
+    {
+        videoSocket->flush();
+        videoSocket->disconnectFromHost();
+        if (videoSocket->state() != QAbstractSocket::UnconnectedState)
+            videoSocket->waitForDisconnected(VIDEO_WRITE_TIMEOUT_MS);
+    }
+}
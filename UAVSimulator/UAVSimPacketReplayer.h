@@ -0,0 +1,55 @@
+#ifndef UAVSIMPACKETREPLAYER_H
+#define UAVSIMPACKETREPLAYER_H
+
+#include <QThread>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <cstring>
+#include "UAVSimPacketCapture.h"
+
+struct UAVSimReplayStatistics final
+{
+    quint64 SentPackets;
+    quint64 SentBytes;
+    quint64 FailedPackets;
+    qint64 DurationNs;
+    qint64 TotalLatenessNs;     // how late the packets were sent relative to their schedule
+    qint64 MaxLatenessNs;
+
+    UAVSimReplayStatistics()
+    {
+        memset(this, 0, sizeof(UAVSimReplayStatistics));
+    }
+};
+
+// Replays a packet capture over the loopback keeping the recorded inter-packet intervals.
+// Sleeping gives the bulk of an interval, its end is spun to keep the timing exact
+class UAVSimPacketReplayer final : public QThread
+{
+    Q_OBJECT
+
+    QVector<UAVSimPacket> _packets;
+    double _speed;
+    int _loops;
+    quint16 _uavTelemetryPort;
+    quint16 _camTelemetryPort;
+    quint16 _videoTcpPort;
+
+    QAtomicInt _quit;
+    UAVSimReplayStatistics _statistics;
+
+    void waitUntil(const QElapsedTimer &timer, qint64 timeNs);
+protected:
+    void run() override;
+public:
+    // speed is the factor of the recorded rate, 0 sends as fast as possible
+    explicit UAVSimPacketReplayer(QObject *parent, const QVector<UAVSimPacket> &packets, double speed, int loops,
+                                  quint16 uavTelemetryPort, quint16 camTelemetryPort, quint16 videoTcpPort);
+    ~UAVSimPacketReplayer();
+
+    void stop();
+    const UAVSimReplayStatistics statistics() const;
+};
+
+#endif // UAVSIMPACKETREPLAYER_H
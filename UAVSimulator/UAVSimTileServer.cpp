@@ -0,0 +1,168 @@
+#include "UAVSimTileServer.h"
+#include <QImage>
+#include <QPainter>
+#include <QBuffer>
+#include <QPointer>
+#include <QTimer>
+#include <QRandomGenerator>
+#include <QHostAddress>
+#include <QDebug>
+
+constexpr int TILE_SIZE = 256;
+constexpr int MAX_REQUEST_HEADER_SIZE = 8192;
+
+UAVSimTileServer::UAVSimTileServer(QObject *parent, int latencyMs, double errorRate) : QObject(parent),
+    _server(this)
+{
+    _latencyMs = qMax(0, latencyMs);
+    _errorRate = qBound(0.0, errorRate, 1.0);
+    _servedTiles = 0;
+    _failedRequests = 0;
+
+    connect(&_server, &QTcpServer::newConnection, this, &UAVSimTileServer::onNewConnection);
+}
+
+bool UAVSimTileServer::listen(quint16 port)
+{
+    if (!_server.listen(QHostAddress::Any, port))
+    {
+        qWarning() << "Tile server can't listen port" << port << ":" << _server.errorString();
+        return false;
+    }
+    return true;
+}
+
+quint16 UAVSimTileServer::serverPort() const
+{
+    return _server.serverPort();
+}
+
+quint64 UAVSimTileServer::servedTiles() const
+{
+    return _servedTiles;
+}
+
+quint64 UAVSimTileServer::failedRequests() const
+{
+    return _failedRequests;
+}
+
+int UAVSimTileServer::maxActiveRequests(int sourceId) const
+{
+    return _maxActiveRequests.value(sourceId, 0);
+}
+
+void UAVSimTileServer::onNewConnection()
+{
+    while (_server.hasPendingConnections())
+    {
+        QTcpSocket *socket = _server.nextPendingConnection();
+        _requestBuffers.insert(socket, QByteArray());
+        connect(socket, &QTcpSocket::readyRead, this, &UAVSimTileServer::onReadyRead);
+        connect(socket, &QTcpSocket::disconnected, this, &UAVSimTileServer::onDisconnected);
+    }
+}
+
+void UAVSimTileServer::onDisconnected()
+{
+    auto socket = qobject_cast<QTcpSocket *>(sender());
+    _requestBuffers.remove(socket);
+    socket->deleteLater();
+}
+
+void UAVSimTileServer::onReadyRead()
+{
+    auto socket = qobject_cast<QTcpSocket *>(sender());
+    QByteArray &buffer = _requestBuffers[socket];
+    buffer.append(socket->readAll());
+
+    // One request at a time per connection, the client doesn't pipeline them
+    int headerEnd;
+    while ((headerEnd = buffer.indexOf("\r\n\r\n")) >= 0)
+    {
+        QByteArray requestLine = buffer.left(buffer.indexOf("\r\n"));
+        buffer.remove(0, headerEnd + 4);
+        processRequest(socket, requestLine);
+    }
+
+    if (buffer.size() > MAX_REQUEST_HEADER_SIZE)
+        socket->abort();
+}
+
+void UAVSimTileServer::processRequest(QTcpSocket *socket, const QByteArray &requestLine)
+{
+    // GET /{source}/{z}/{x}/{y}[?...] HTTP/1.1
+    QList<QByteArray> requestParts = requestLine.split(' ');
+    QList<QByteArray> pathParts;
+    if (requestParts.count() >= 2 && requestParts[0] == "GET")
+        pathParts = requestParts[1].split('?').first().split('/');
+    pathParts.removeAll(QByteArray());
+
+    bool isValid = pathParts.count() == 4;
+    int values[4] = {0, 0, 0, 0};
+    for (int i = 0; i < pathParts.count() && isValid; i++)
+        values[i] = pathParts[i].toInt(&isValid);
+
+    bool isFailed = isValid && QRandomGenerator::global()->generateDouble() < _errorRate;
+    if (isValid)
+    {
+        int activeRequests = ++_activeRequests[values[0]];
+        _maxActiveRequests[values[0]] = qMax(_maxActiveRequests.value(values[0], 0), activeRequests);
+        emit tileRequested(values[0], values[1], values[2], values[3]);
+    }
+
+    QPointer<QTcpSocket> socketPointer(socket);
+    QTimer::singleShot(_latencyMs, this, [this, socketPointer, isValid, isFailed, values]()
+    {
+        if (isValid)
+            _activeRequests[values[0]]--;
+        if (socketPointer.isNull())
+            return;
+
+        if (!isValid)
+        {
+            sendResponse(socketPointer, "404 Not Found", "text/plain", "Not Found");
+        }
+        else if (isFailed)
+        {
+            _failedRequests++;
+            sendResponse(socketPointer, "503 Service Unavailable", "text/plain", "Service Unavailable");
+        }
+        else
+        {
+            _servedTiles++;
+            sendResponse(socketPointer, "200 OK", "image/png", makeTile(values[0], values[1], values[2], values[3]));
+        }
+    });
+}
+
+void UAVSimTileServer::sendResponse(QTcpSocket *socket, const QByteArray &status, const QByteArray &contentType, const QByteArray &body)
+{
+    QByteArray header = "HTTP/1.1 " + status + "\r\n" +
+            "Content-Type: " + contentType + "\r\n" +
+            "Content-Length: " + QByteArray::number(body.size()) + "\r\n" +
+            "Connection: keep-alive\r\n\r\n";
+    socket->write(header);
+    socket->write(body);
+}
+
+const QByteArray UAVSimTileServer::makeTile(int sourceId, int scale, int x, int y)
+{
+    // Colour tells the tile, the grid shows its borders
+    quint32 hash = qHash(QString("%1/%2/%3/%4").arg(sourceId).arg(scale).arg(x).arg(y));
+    QImage tileImage(TILE_SIZE, TILE_SIZE, QImage::Format_RGB32);
+    tileImage.fill(QColor::fromRgb(64 + hash % 128, 64 + (hash >> 8) % 128, 64 + (hash >> 16) % 128));
+
+    QPainter painter(&tileImage);
+    painter.setPen(Qt::white);
+    painter.drawRect(0, 0, TILE_SIZE - 1, TILE_SIZE - 1);
+    painter.drawLine(0, TILE_SIZE / 2, TILE_SIZE, TILE_SIZE / 2);
+    painter.drawLine(TILE_SIZE / 2, 0, TILE_SIZE / 2, TILE_SIZE);
+    painter.end();
+
+    QByteArray tileData;
+    QBuffer buffer(&tileData);
+    buffer.open(QIODevice::WriteOnly);
+    tileImage.save(&buffer, "PNG");
+    return tileData;
+}
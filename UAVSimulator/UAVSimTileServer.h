@@ -0,0 +1,44 @@
+#ifndef UAVSIMTILESERVER_H
+#define UAVSIMTILESERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHash>
+#include <QByteArray>
+
+// Local stand-in for the tile providers: answers GET /{source}/{z}/{x}/{y} with a synthetic PNG tile
+// after the configured latency, the given share of the requests fails with 503
+class UAVSimTileServer final : public QObject
+{
+    Q_OBJECT
+
+    QTcpServer _server;
+    int _latencyMs;
+    double _errorRate;
+    QHash<QTcpSocket *, QByteArray> _requestBuffers;
+    quint64 _servedTiles, _failedRequests;
+    QHash<int, int> _activeRequests, _maxActiveRequests;     // by source
+
+    void processRequest(QTcpSocket *socket, const QByteArray &requestLine);
+    static void sendResponse(QTcpSocket *socket, const QByteArray &status, const QByteArray &contentType, const QByteArray &body);
+    static const QByteArray makeTile(int sourceId, int scale, int x, int y);
+public:
+    explicit UAVSimTileServer(QObject *parent, int latencyMs, double errorRate);
+
+    bool listen(quint16 port);     // 0 takes a free port
+    quint16 serverPort() const;
+    quint64 servedTiles() const;
+    quint64 failedRequests() const;
+    // Most requests of the source received and not answered yet at the same time
+    int maxActiveRequests(int sourceId) const;
+signals:
+    // Valid request is received, it is answered after the latency
+    void tileRequested(int sourceId, int scale, int x, int y);
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onDisconnected();
+};
+
+#endif // UAVSIMTILESERVER_H
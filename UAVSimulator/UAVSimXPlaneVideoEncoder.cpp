@@ -0,0 +1,43 @@
+#include "UAVSimXPlaneVideoEncoder.h"
+#include <cstring>
+#include "HardwareLink/lz4.h"
+#include "HardwareLink/XPlaneVideoReceiver.h"
+
+UAVSimXPlaneVideoEncoder::UAVSimXPlaneVideoEncoder()
+{
+}
+
+const QByteArray &UAVSimXPlaneVideoEncoder::encode(const QImage &frame, quint32 frameId)
+{
+    int dataSize = static_cast<int>(frame.sizeInBytes());
+    int compressedSizeEstimation = LZ4_compressBound(dataSize);
+    if (_compressedData.size() < compressedSizeEstimation)
+        _compressedData.resize(compressedSizeEstimation);
+
+    int compressedDataSize = LZ4_compress_default(reinterpret_cast<const char *>(frame.constBits()), _compressedData.data(),
+                                                  dataSize, compressedSizeEstimation);
+    if (compressedDataSize <= 0)
+    {
+        _packets.clear();
+        return _packets;
+    }
+
+    int packetCount = (compressedDataSize + XPLANE_PACKET_CHUNKSIZE - 1) / XPLANE_PACKET_CHUNKSIZE;
+    _packets.resize(packetCount * XPLANE_PACKET_SIZE);
+
+    XPLANE_PACKET_HEADER header;
+    header.frameId = frameId;
+    header.frameTotalSize = static_cast<quint32>(compressedDataSize);
+    char *packet = _packets.data();
+    for (int partNo = 0; partNo < packetCount; partNo++)
+    {
+        int chunkOffset = partNo * XPLANE_PACKET_CHUNKSIZE;
+        int chunkSize = qMin(XPLANE_PACKET_CHUNKSIZE, compressedDataSize - chunkOffset);
+        header.framePartNo = static_cast<quint16>(partNo);
+        memcpy(packet, &header, sizeof(header));
+        memcpy(packet + sizeof(header), _compressedData.constData() + chunkOffset, chunkSize);
+        memset(packet + sizeof(header) + chunkSize, 0, XPLANE_PACKET_CHUNKSIZE - chunkSize);
+        packet += XPLANE_PACKET_SIZE;
+    }
+    return _packets;
+}
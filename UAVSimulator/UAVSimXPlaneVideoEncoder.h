@@ -0,0 +1,20 @@
+#ifndef UAVSIMXPLANEVIDEOENCODER_H
+#define UAVSIMXPLANEVIDEOENCODER_H
+
+#include <QByteArray>
+#include <QImage>
+
+// X-Plane video stream of the simulator in the packets of XPlaneVideoReceiver: the LZ4 compressed frame is split into
+// packets of a header and a whole chunk, the last chunk is padded. Buffers are reused between frames
+class UAVSimXPlaneVideoEncoder final
+{
+    QByteArray _compressedData;
+    QByteArray _packets;
+public:
+    UAVSimXPlaneVideoEncoder();
+
+    // All packets of the frame, valid until the next call
+    const QByteArray &encode(const QImage &frame, quint32 frameId);
+};
+
+#endif // UAVSIMXPLANEVIDEOENCODER_H
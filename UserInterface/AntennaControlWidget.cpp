@@ -2,7 +2,7 @@
 
 void AntennaControlWidget::initWidgets()
 {
-    EnterProc("AntennaControlWidget::initWidgets");
+    EnterProcStart("AntennaControlWidget::initWidgets");
 
     _mainLayout = new QGridLayout(this);
     _mainLayout->setContentsMargins(0, 0, 0, 0);
@@ -121,7 +121,7 @@ void AntennaControlWidget::applyState()
 
 AntennaControlWidget::AntennaControlWidget(QWidget *parent, HardwareLink *hardwareLink) : QWidget(parent)
 {
-    EnterProc("AntennaControlWidget::AntennaControlWidget");
+    EnterProcStart("AntennaControlWidget::AntennaControlWidget");
     _hardwareLink = hardwareLink;
     initWidgets();
 
@@ -4,23 +4,32 @@
 #include <QHeaderView>
 #include "ApplicationSettings.h"
 #include "EnterProc.h"
+#include "Common/CommonWidgets.h"
 
-class QTableWidgetItemWithIntValue : public QTableWidgetItem
+class QTableWidgetItemWithNumericValue : public QTableWidgetItem
 {
 public:
-    QTableWidgetItemWithIntValue(const QString &text, int type = Type) : QTableWidgetItem(text, type)
+    QTableWidgetItemWithNumericValue(const QString &text, int type = Type) : QTableWidgetItem(text, type)
     {
     }
 
     bool operator < (const QTableWidgetItem &other) const
     {
-        return (this->text().toInt() < other.text().toInt());
+        return (this->text().toDouble() < other.text().toDouble());
     }
 };
 
-QTableWidgetItem * createTableWidgetItemWithIntValue(int value)
+QTableWidgetItem * createTableWidgetItemWithIntValue(quint64 value)
 {
-    QTableWidgetItem * item = new QTableWidgetItemWithIntValue(QString::number(value));
+    QTableWidgetItem * item = new QTableWidgetItemWithNumericValue(QString::number(value));
+    item->setTextAlignment(Qt::AlignRight);
+    return item;
+}
+
+// Time is shown in microseconds
+QTableWidgetItem * createTableWidgetItemWithTimeValue(quint64 timeNs)
+{
+    QTableWidgetItem * item = new QTableWidgetItemWithNumericValue(QString::number(timeNs / 1000.0, 'f', 1));
     item->setTextAlignment(Qt::AlignRight);
     return item;
 }
@@ -32,21 +41,23 @@ void ApplicationStatisticView::fillStatisticsList()
     _statisticsList->setSortingEnabled(false);
     _statisticsList->clearContents();
 
-    QList<EnterProcMeasure *> measures = EnterProc::getMeasures();
+    QList<EnterProcMeasure> measures = EnterProc::getMeasures();
 
     _statisticsList->setRowCount(measures.count());
 
     int row = 0;
     int col;
-    foreach (EnterProcMeasure * measure, measures)
+    foreach (auto measure, measures)
     {
         col = 0;
-        _statisticsList->setItem(row, col++, new QTableWidgetItem(measure->ProcName));
-        _statisticsList->setItem(row, col++, createTableWidgetItemWithIntValue(measure->CallCount));
-        _statisticsList->setItem(row, col++, createTableWidgetItemWithIntValue(measure->TotalTime));
-        _statisticsList->setItem(row, col++, createTableWidgetItemWithIntValue(measure->MinTime));
-        _statisticsList->setItem(row, col++, createTableWidgetItemWithIntValue(measure->getAvgTime()));
-        _statisticsList->setItem(row, col++, createTableWidgetItemWithIntValue(measure->MaxTime));
+        _statisticsList->setItem(row, col++, new QTableWidgetItem(measure.ProcName));
+        _statisticsList->setItem(row, col++, createTableWidgetItemWithIntValue(measure.CallCount));
+        _statisticsList->setItem(row, col++, createTableWidgetItemWithTimeValue(measure.TotalTimeNs));
+        _statisticsList->setItem(row, col++, createTableWidgetItemWithTimeValue(measure.MinTimeNs));
+        _statisticsList->setItem(row, col++, createTableWidgetItemWithTimeValue(measure.getAvgTimeNs()));
+        _statisticsList->setItem(row, col++, createTableWidgetItemWithTimeValue(measure.P50TimeNs));
+        _statisticsList->setItem(row, col++, createTableWidgetItemWithTimeValue(measure.P99TimeNs));
+        _statisticsList->setItem(row, col++, createTableWidgetItemWithTimeValue(measure.MaxTimeNs));
 
         row++;
     }
@@ -74,8 +85,12 @@ ApplicationStatisticView::ApplicationStatisticView(QWidget *parent) : QWidget(pa
     auto btnRefreshStatistics = new QPushButton(tr("Refresh"), this);
     connect(btnRefreshStatistics, &QPushButton::clicked, this, &ApplicationStatisticView::onRefreshStatisticsCicked);
 
+    auto btnExportTrace = new QPushButton(tr("Export Trace"), this);
+    connect(btnExportTrace, &QPushButton::clicked, this, &ApplicationStatisticView::onExportTraceClicked);
+
     QStringList horizontalHeaderLabels = QStringList();
-    horizontalHeaderLabels << tr("Proc Name") << tr("Call Count") << tr("Total Time") << tr("Min Time") << tr("Avg Time") << tr("Max Time");
+    horizontalHeaderLabels << tr("Proc Name") << tr("Call Count") << tr("Total Time, us") << tr("Min Time, us") << tr("Avg Time, us")
+                            << tr("P50 Time, us") << tr("P99 Time, us") << tr("Max Time, us");
 
     _statisticsList = new QTableWidget(this);
     _statisticsList->horizontalHeader()->sortIndicatorOrder();
@@ -86,6 +101,7 @@ ApplicationStatisticView::ApplicationStatisticView(QWidget *parent) : QWidget(pa
     buttonsLayout->addWidget(chkEnableComputingStatistics, 1);
     buttonsLayout->addWidget(btnClearStatistics, 0);
     buttonsLayout->addWidget(btnRefreshStatistics, 0);
+    buttonsLayout->addWidget(btnExportTrace, 0);
     statisticsLayout->addLayout(buttonsLayout, 0);
     statisticsLayout->addWidget(_statisticsList, 1);
     fillStatisticsList();
@@ -114,3 +130,13 @@ void ApplicationStatisticView::onEnableComputingToggled(bool checked)
     EnterProc::setEnableComputingStatistics(checked);
 }
 
+
+void ApplicationStatisticView::onExportTraceClicked()
+{
+    QString fileName = CommonWidgetUtils::showSaveFileDialog(tr("Export Trace"), QString(), tr("Chrome Trace (*.json)"));
+    if (fileName.isEmpty())
+        return;
+
+    if (!EnterProc::exportChromeTrace(fileName))
+        CommonWidgetUtils::showInfoDialog(tr("Unable to export trace to file %1").arg(fileName));
+}
@@ -19,6 +19,7 @@ private slots:
     void onRefreshStatisticsCicked();
     void onClearStatisticsCicked();
     void onEnableComputingToggled(bool checked);
+    void onExportTraceClicked();
 };
 
 #endif // APPLICATIONSTATISTICVIEW_H
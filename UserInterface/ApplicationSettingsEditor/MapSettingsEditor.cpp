@@ -17,6 +17,15 @@ MapSettingsEditor::MapSettingsEditor(QWidget *parent) :
 
     pathLayout->addWidget(cbTileReceivingMode);
 
+    auto tileServerLayout = new QHBoxLayout();
+    tileServerLayout->setContentsMargins(0, 0, 0, 0);
+    auto lblTileServerURL = new QLabel(tr("Tile Server URL"), this);
+    auto edtTileServerURL = new QLineEdit(this);
+    edtTileServerURL->setPlaceholderText("http://127.0.0.1:8090/{source}/{z}/{x}/{y}");
+    tileServerLayout->addWidget(lblTileServerURL);
+    tileServerLayout->addWidget(edtTileServerURL, 1);
+    pathLayout->addLayout(tileServerLayout);
+
     _mapDatabaseFiles = new QListWidget(this);
     _mapDatabaseFiles->setDragDropMode(QAbstractItemView::InternalMove);
     connect(_mapDatabaseFiles, &QListWidget::itemSelectionChanged, this, &MapSettingsEditor::onMapDatabaseFilesSelectionChanged);
@@ -45,6 +54,7 @@ MapSettingsEditor::MapSettingsEditor(QWidget *parent) :
 
 
     _association.addBinding(&applicationSettings.TileReceivingMode,                    cbTileReceivingMode);
+    _association.addBinding(&applicationSettings.TileServerURL,                        edtTileServerURL);
     _association.addBinding(&applicationSettings.DatabaseMapDownloadCashe,             fpsMapDownloadCashe);
     _association.addBinding(&applicationSettings.DatabaseHeightMap,                    fpsHeightMap);
     _association.addBinding(&applicationSettings.DatabaseGeocoder,                     fpsGeocoder);
@@ -76,7 +86,7 @@ void MapSettingsEditor::saveSettings()
 
 FilePathSelector *MapSettingsEditor::addDBPathEditor(QVBoxLayout *layout, const QString &caption)
 {
-    auto pathSelector = new FilePathSelector(this, caption, tr("Open %1 Database File").arg(caption), tr("Database Files (*.db);;KML Files (*.kml)"));
+    auto pathSelector = new FilePathSelector(this, caption, tr("Open %1 Database File").arg(caption), tr("Database Files (*.db);;KML Files (*.kml);;Tile Pack Files (*.tpk)"));
     if (layout != nullptr)
         layout->addWidget(pathSelector);
 
@@ -52,6 +52,10 @@ SessionsSettingsEditor::SessionsSettingsEditor(QWidget *parent):
     auto sbLogFolderMaxSizeMb = CommonWidgetUtils::createRangeSpinbox(this, 10, 1000);
     auto lblLogFolderMaxSizeMb = new QLabel(tr("Mb (Maximal Log Folder Size)"), this);
 
+    auto lblTelemetryHistoryMemoryLimitMb = new QLabel(tr("Telemetry History Memory"), this);
+    auto sbTelemetryHistoryMemoryLimitMb = CommonWidgetUtils::createRangeSpinbox(this, 16, 4096);
+    auto lblTelemetryHistoryMemoryLimitMbUnit = new QLabel(tr("Mb (Maximal Telemetry History Size)"), this);
+
     auto netInfo = new NetworkInformationWidget(this);
 
     auto computerInfoLayout = new QGridLayout();
@@ -66,6 +70,11 @@ SessionsSettingsEditor::SessionsSettingsEditor(QWidget *parent):
     computerInfoLayout->addWidget(lblLogFolderMaxSizeMb,      row, 2, 1, 1, Qt::AlignLeft);
     row++;
 
+    computerInfoLayout->addWidget(lblTelemetryHistoryMemoryLimitMb,        row, 0, 1, 1);
+    computerInfoLayout->addWidget(sbTelemetryHistoryMemoryLimitMb,         row, 1, 1, 1, Qt::AlignLeft);
+    computerInfoLayout->addWidget(lblTelemetryHistoryMemoryLimitMbUnit,    row, 2, 1, 1, Qt::AlignLeft);
+    row++;
+
     computerInfoLayout->addWidget(netInfo,                    row, 0, 1, 4);
     row++;
 
@@ -147,6 +156,8 @@ SessionsSettingsEditor::SessionsSettingsEditor(QWidget *parent):
     auto chkCamTelemetryUDP = new QCheckBox(tr("Camera Telemetry UDP"), this);
     auto edCamTelemetryUDPPort = CommonWidgetUtils::createPortEditor(this);
 
+    auto chkBatchUDPReceiving = new QCheckBox(tr("Receive UDP Telemetry in Batches (Linux)"), this);
+
     auto lblCurrentCamera = new QLabel(tr("Camera"), this);
     _cbCurrentCamera = CameraSettingsEditor::createCamListCombo(this);
     connect(_cbCurrentCamera, static_cast<void(QComboBoxExt::*)(int)>(&QComboBoxExt::currentIndexChanged), this, &SessionsSettingsEditor::onCurrentCameraChanged);
@@ -183,6 +194,9 @@ SessionsSettingsEditor::SessionsSettingsEditor(QWidget *parent):
     dataReceptionLayout->addWidget(edCamTelemetryUDPPort,           row, 2, 1, 1);
     row++;
 
+    dataReceptionLayout->addWidget(chkBatchUDPReceiving,            row, 0, 1, 2);
+    row++;
+
     dataReceptionLayout->addWidget(lblCurrentCamera,                row, 0, 1, 1, Qt::AlignTop | Qt::AlignLeft);
     dataReceptionLayout->addWidget(_cbCurrentCamera,                row, 1, 1, 1, Qt::AlignTop | Qt::AlignLeft);
     dataReceptionLayout->addWidget(_lblCurrentCameraInfo,           row, 2, 1, 1, Qt::AlignTop | Qt::AlignLeft);
@@ -247,6 +261,9 @@ SessionsSettingsEditor::SessionsSettingsEditor(QWidget *parent):
 
         auto lblExternalDataConsole = new QLabel(tr("External Data Console (UDP)"), this);
         auto naeExternalDataConsole = new NetworkAddressEditor(this, &_association, nullptr, &applicationSettings.ExternalDataConsoleUDPPort);
+        auto sbExternalDataConsoleSubscription = CommonWidgetUtils::createRangeSpinbox(this, 1, 100);
+        auto lblExternalDataConsoleSubscription = new QLabel(tr("Subscription Port Offset"), this);
+        auto chkExternalDataConsoleAlwaysBroadcast = new QCheckBox(tr("Always Broadcast"), this);
 
         spoilerDataForwarding = makeSessionsSpoilerGrid(tr("Data Forwarding"), this);
         auto dataForwardingLayout = spoilerDataForwarding->gridLayout();
@@ -260,8 +277,15 @@ SessionsSettingsEditor::SessionsSettingsEditor(QWidget *parent):
         dataForwardingLayout->addWidget(lblExternalDataConsole,          row, 0, 1, 1);
         dataForwardingLayout->addWidget(naeExternalDataConsole,          row, 1, 1, 1);
         row++;
+        dataForwardingLayout->addWidget(sbExternalDataConsoleSubscription,  row, 1, 1, 1, Qt::AlignLeft);
+        dataForwardingLayout->addWidget(lblExternalDataConsoleSubscription, row, 2, 1, 1, Qt::AlignLeft);
+        row++;
+        dataForwardingLayout->addWidget(chkExternalDataConsoleAlwaysBroadcast, row, 1, 1, 1);
+        row++;
 
         _association.addBinding(&applicationSettings.EnableForwarding,                  chkEnableForwarding);
+        _association.addBinding(&applicationSettings.ExternalDataConsoleSubscriptionPortOffset, sbExternalDataConsoleSubscription);
+        _association.addBinding(&applicationSettings.ExternalDataConsoleAlwaysBroadcast,        chkExternalDataConsoleAlwaysBroadcast);
     }
 
     // Init Artillery Spotter Tools
@@ -318,6 +342,11 @@ SessionsSettingsEditor::SessionsSettingsEditor(QWidget *parent):
     auto cmbObjectTrackerType = new QComboBoxExt(this, ConstantNames::ObjectTrackerTypeCaptions());
     auto chkShowExternalTrackerRectangle = new QCheckBox(tr("Show External Tracker Cursor"), this);
 
+    auto lblVideoProcessingQueue = new QLabel(tr("Video Processing Queue"), this);
+    auto cmbVideoProcessingDropPolicy = new QComboBoxExt(this, ConstantNames::VideoFrameDropPolicyCaptions());
+    auto sbVideoProcessingQueueSize = CommonWidgetUtils::createRangeSpinbox(this, 1, 100);
+    auto lblVideoProcessingQueueSizeUnit = new QLabel(tr("Frames (Maximal Queue Size)"), this);
+
     auto lblTrackerCommandUDP = new QLabel(tr("External Tracker Commands (UDP/IP)"), this);
     auto naeTrackerCommandUDP = new NetworkAddressEditor(this, &_association, &applicationSettings.TrackerCommandUDPAddress, &applicationSettings.TrackerCommandUDPPort);
 
@@ -342,6 +371,12 @@ SessionsSettingsEditor::SessionsSettingsEditor(QWidget *parent):
     trackerLayout->addWidget(naeTrackerTelemetryUDP,                    row, 1, 1, 1);
     row++;
 
+    trackerLayout->addWidget(lblVideoProcessingQueue,                   row, 0, 1, 1);
+    trackerLayout->addWidget(cmbVideoProcessingDropPolicy,              row, 1, 1, 1);
+    trackerLayout->addWidget(sbVideoProcessingQueueSize,                row, 2, 1, 1, Qt::AlignLeft);
+    trackerLayout->addWidget(lblVideoProcessingQueueSizeUnit,           row, 3, 1, 1, Qt::AlignLeft);
+    row++;
+
     // Fill main layout
     row = 0;
 
@@ -383,6 +418,7 @@ SessionsSettingsEditor::SessionsSettingsEditor(QWidget *parent):
     _association.addBinding(&applicationSettings.SessionsFolder,                    fpsSessions);
     _association.addBinding(&applicationSettings.LogFolderCleanup,                  chkLogFolderCleanup);
     _association.addBinding(&applicationSettings.LogFolderMaxSizeMb,                sbLogFolderMaxSizeMb);
+    _association.addBinding(&applicationSettings.TelemetryHistoryMemoryLimitMb,     sbTelemetryHistoryMemoryLimitMb);
     _association.addBinding(&applicationSettings.VideoFileFrameCount,               cbVideoFileFrameCount);
     _association.addBinding(&applicationSettings.VideoFileQuality,                  sbVideoFileQuality);
     _association.addBinding(&applicationSettings.OVRDisplayTelemetry,               chkOVRDisplayTelemetry);
@@ -397,6 +433,7 @@ SessionsSettingsEditor::SessionsSettingsEditor(QWidget *parent):
     _association.addBinding(&applicationSettings.ExtTelemetryUDPPort,               edExtTelemetryUDPPort);
     _association.addBinding(&applicationSettings.UseCamTelemetryUDP,                chkCamTelemetryUDP);
     _association.addBinding(&applicationSettings.CamTelemetryUDPPort,               edCamTelemetryUDPPort);
+    _association.addBinding(&applicationSettings.UseBatchUDPReceiving,              chkBatchUDPReceiving);
 
     _association.addBinding(&applicationSettings.VideoLagFromTelemetry,             sbTelemetryLag);
     _association.addBinding(&applicationSettings.VideoLagFromCameraTelemetry,       sbCameraTelemetryLag);
@@ -409,6 +446,8 @@ SessionsSettingsEditor::SessionsSettingsEditor(QWidget *parent):
 
     _association.addBinding(&applicationSettings.ObjectTrackerType,                 cmbObjectTrackerType);
     _association.addBinding(&applicationSettings.ShowExternalTrackerRectangle,      chkShowExternalTrackerRectangle);
+    _association.addBinding(&applicationSettings.VideoProcessingDropPolicy,         cmbVideoProcessingDropPolicy);
+    _association.addBinding(&applicationSettings.VideoProcessingQueueSize,          sbVideoProcessingQueueSize);
 
 }
 
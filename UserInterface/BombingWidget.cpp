@@ -106,7 +106,7 @@ BombingWidget::BombingWidget(QWidget *parent, HardwareLink *hardwareLink, Artill
     _artillerySpotter(artillerySpotter),
     _telemetryDataStorage(telemetryDataStorage)
 {
-    EnterProc("BombingWidget::BombingWidget");
+    EnterProcStart("BombingWidget::BombingWidget");
 
     _weatherView = nullptr;
 
@@ -180,7 +180,7 @@ void BombingWidget::addNewMarker(const WorldGPSCoord &coord, bool showEditor)
 
 void BombingWidget::onNewMarkerForUAVClicked()
 {
-    EnterProc("BombingWidget::onAddNewMarkerForUAVClicked");
+    EnterProcStart("BombingWidget::onAddNewMarkerForUAVClicked");
 
     QList<WorldGPSCoord> coords;
     coords.append(getUavCoordsFromTelemetry(_telemetryFrame));
@@ -188,9 +188,8 @@ void BombingWidget::onNewMarkerForUAVClicked()
     ApplicationSettings& applicationSettings = ApplicationSettings::Instance();
     if (applicationSettings.CoordCalulationHistoryMs > 0)
     {
-        auto frames = _telemetryDataStorage->getLastTelemetryDataFrames(applicationSettings.CoordCalulationHistoryMs);
-        foreach (auto frame, frames)
-            coords.append(getUavCoordsFromTelemetry(frame));
+        coords.append(_telemetryDataStorage->getLastTelemetryCoords(applicationSettings.CoordCalulationHistoryMs,
+                                                                    TelemetryDataStorage::TelemetryCoordSource::UavCoords));
     }
 
     addNewMarker(coords, false);
@@ -198,7 +197,7 @@ void BombingWidget::onNewMarkerForUAVClicked()
 
 void BombingWidget::onNewMarkerForLaserClicked()
 {
-    EnterProc("BombingWidget::onAddNewMarkerForLaserClicked");
+    EnterProcStart("BombingWidget::onAddNewMarkerForLaserClicked");
 
     QList<WorldGPSCoord> coords;
     coords.append(getRangefinderCoordsFromTelemetry(_telemetryFrame));
@@ -206,9 +205,8 @@ void BombingWidget::onNewMarkerForLaserClicked()
     ApplicationSettings& applicationSettings = ApplicationSettings::Instance();
     if (applicationSettings.CoordCalulationHistoryMs > 0)
     {
-        auto frames = _telemetryDataStorage->getLastTelemetryDataFrames(applicationSettings.CoordCalulationHistoryMs);
-        foreach (auto frame, frames)
-            coords.append(getRangefinderCoordsFromTelemetry(frame));
+        coords.append(_telemetryDataStorage->getLastTelemetryCoords(applicationSettings.CoordCalulationHistoryMs,
+                                                                    TelemetryDataStorage::TelemetryCoordSource::RangefinderCoords));
     }
 
     addNewMarker(coords, false);
@@ -235,7 +233,7 @@ void BombingWidget::onNewMarkerButtonRightClicked()
 
 void BombingWidget::onNewMarkerForTargetClicked()
 {
-    EnterProc("BombingWidget::onNewMarkerForTargetClicked");
+    EnterProcStart("BombingWidget::onNewMarkerForTargetClicked");
 
     QList<WorldGPSCoord> coords;
     coords.append(getTrackedTargetCoordsFromTelemetry(_telemetryFrame));
@@ -243,9 +241,8 @@ void BombingWidget::onNewMarkerForTargetClicked()
     ApplicationSettings& applicationSettings = ApplicationSettings::Instance();
     if (applicationSettings.CoordCalulationHistoryMs > 0)
     {
-        auto frames = _telemetryDataStorage->getLastTelemetryDataFrames(applicationSettings.CoordCalulationHistoryMs);
-        foreach (auto frame, frames)
-            coords.append(getTrackedTargetCoordsFromTelemetry(frame));
+        coords.append(_telemetryDataStorage->getLastTelemetryCoords(applicationSettings.CoordCalulationHistoryMs,
+                                                                    TelemetryDataStorage::TelemetryCoordSource::TrackedTargetCoords));
     }
 
     addNewMarker(coords, false);
@@ -253,7 +250,7 @@ void BombingWidget::onNewMarkerForTargetClicked()
 
 void BombingWidget::onDropBombClicked()
 {
-    EnterProc("BombingWidget::onDropBombClicked");
+    EnterProcStart("BombingWidget::onDropBombClicked");
     _hardwareLink->dropBomb(1);
 }
 
@@ -143,6 +143,12 @@ DashboardWidget::DashboardWidget(QWidget *parent) : QWidget(parent)
     addParameter(RowSessionTime, tr("Session Time"), submenuSystem);
     addParameter(RowTelemetryFPS, tr("Telemetry FPS"), submenuSystem);
     addParameter(RowVideoFPS, tr("Video FPS"), submenuSystem);
+    addParameter(RowVideoProcessingQueueDepth, tr("Video Processing Queue"), submenuSystem);
+    addParameter(RowVideoProcessingDelay, tr("Video Processing Delay"), submenuSystem);
+    addParameter(RowDroppedVideoFrameCount, tr("Dropped Video Frames"), submenuSystem);
+    addParameter(RowDroppedTelemetryDatagramCount, tr("Dropped Telemetry Datagrams"), submenuSystem);
+    addParameter(RowCameraTelemetryFramingErrorCount, tr("Camera Telemetry Framing Errors"), submenuSystem);
+    addParameter(RowCameraTelemetryChecksumErrorCount, tr("Camera Telemetry Checksum Errors"), submenuSystem);
     addParameter(RowOpticalSystem, tr("Optical System"), submenuSystem);
 
 
@@ -199,6 +205,12 @@ void DashboardWidget::processTelemetry(const TelemetryDataFrame &telemetryDataFr
     setTelemetryTableRowDouble(RowSessionTime, 0.001 * telemetryDataFrame.SessionTimeMs, 3);
     setTelemetryTableRowDouble(RowTelemetryFPS, telemetryDataFrame.TelemetryFPS, 0);
     setTelemetryTableRowDouble(RowVideoFPS, telemetryDataFrame.VideoFPS, 0);
+    setTelemetryTableRowDouble(RowVideoProcessingQueueDepth, telemetryDataFrame.VideoProcessingQueueDepth, 0);
+    setTelemetryTableRowDouble(RowVideoProcessingDelay, telemetryDataFrame.VideoProcessingDelayMs, 0);
+    setTelemetryTableRowDouble(RowDroppedVideoFrameCount, telemetryDataFrame.DroppedVideoFrameCount, 0);
+    setTelemetryTableRowDouble(RowDroppedTelemetryDatagramCount, telemetryDataFrame.DroppedTelemetryDatagramCount, 0);
+    setTelemetryTableRowDouble(RowCameraTelemetryFramingErrorCount, telemetryDataFrame.CameraTelemetryFramingErrorCount, 0);
+    setTelemetryTableRowDouble(RowCameraTelemetryChecksumErrorCount, telemetryDataFrame.CameraTelemetryChecksumErrorCount, 0);
     setTelemetryTableRowDoubleOrIncorrect(RowCalculatedRangefinderGPSLat, telemetryDataFrame.CalculatedRangefinderGPSLat, 6, INCORRECT_COORDINATE);
     setTelemetryTableRowDoubleOrIncorrect(RowCalculatedRangefinderGPSLon, telemetryDataFrame.CalculatedRangefinderGPSLon, 6, INCORRECT_COORDINATE);
     setTelemetryTableRowDoubleOrIncorrect(RowCalculatedRangefinderGPSHmsl, telemetryDataFrame.CalculatedRangefinderGPSHmsl, 1, INCORRECT_COORDINATE);
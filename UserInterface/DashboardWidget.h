@@ -39,6 +39,9 @@ class DashboardWidget final: public QWidget
                             RowCalculatedTrackedTargetGPSLat, RowCalculatedTrackedTargetGPSLon, RowCalculatedTrackedTargetGPSHmsl,
                             RowTrackedTargetCenterX, RowTrackedTargetCenterY, RowTrackedTargetRectWidth, RowTrackedTargetRectHeight,
                             RowTrackedTargetState,
+                            RowVideoProcessingQueueDepth, RowVideoProcessingDelay, RowDroppedVideoFrameCount,
+                            RowDroppedTelemetryDatagramCount,
+                            RowCameraTelemetryFramingErrorCount, RowCameraTelemetryChecksumErrorCount,
                             //insert items before this line. Don't change the order of the items
                             RowLast
                            };
@@ -79,18 +79,25 @@ DataConsole::~DataConsole()
 
 }
 
+// The data is disconnected while the console is closed, so the telemetry is not formatted for it
+void DataConsole::closeEvent(QCloseEvent *event)
+{
+    emit closed();
+    QWidget::closeEvent(event);
+}
+
 void DataConsole::onHardwareLinkCommandSent(const DataExchangePackage &command)
 {
     if (!_acShowCommands->isChecked() || _pauseButton->isChecked())
         return;
 
-    QString logLine = QString("<body>%1&emsp;&emsp;<font color=""#00FF00"">%2</font><br></body>").arg(command.ContentHEX).arg(command.Description);
+    QString logLine = QString("<body>%1&emsp;&emsp;<font color=""#00FF00"">%2</font><br></body>").arg(command.contentHex()).arg(command.Description);
     _logText->moveCursor(QTextCursor::End);
     _logText->insertHtml(logLine);
     clearObsoleteLines();
 }
 
-void DataConsole::onHardwareLinkTelemetryReceived(const QString &telemetryHEX)
+void DataConsole::onHardwareLinkTelemetryReceived(const QByteArray &rawData)
 {
     if (!_acShowTelemetry->isChecked() || _pauseButton->isChecked())
         return;
@@ -100,7 +107,7 @@ void DataConsole::onHardwareLinkTelemetryReceived(const QString &telemetryHEX)
     if (_countRAWTelemetry % (_skipRAWTelemetry + 1) > 0)
         return;
 
-    QString logLine = QString("<body><font color=""#00BFFF"">%1</font><br></body>").arg(telemetryHEX);
+    QString logLine = QString("<body><font color=""#00BFFF"">%1</font><br></body>").arg(QString(rawData.toHex()));
     _logText->moveCursor(QTextCursor::End);
     _logText->insertHtml(logLine);
     clearObsoleteLines();
@@ -6,6 +6,7 @@
 #include <QMenu>
 #include <QAction>
 #include <QPushButton>
+#include <QCloseEvent>
 #include "Common/CommonWidgets.h"
 #include "TelemetryDataFrame.h"
 
@@ -26,12 +27,16 @@ class DataConsole : public QWidget
     qint32 _skipRAWTelemetry;
 
     void clearObsoleteLines();
+protected:
+    void closeEvent(QCloseEvent *event);
 public:    
     explicit DataConsole(QWidget *parent);
     ~DataConsole();
+signals:
+    void closed();
 public slots:
     void onHardwareLinkCommandSent(const DataExchangePackage &clientCommand);
-    void onHardwareLinkTelemetryReceived(const QString &telemetryHEX);
+    void onHardwareLinkTelemetryReceived(const QByteArray &rawData);
 private slots:
     void onSetingsButtonClicked();
 };
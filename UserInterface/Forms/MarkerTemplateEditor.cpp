@@ -9,7 +9,7 @@
 
 void MarkerTemplateEditor::fillControls()
 {
-    EnterProc("MarkerTemplateEditor::fillControls");
+    EnterProcStart("MarkerTemplateEditor::fillControls");
 
     if (_parentTemplate != nullptr)
     {
@@ -65,7 +65,7 @@ bool MarkerTemplateEditor::isModified()
 
 void MarkerTemplateEditor::initWidgets()
 {
-    EnterProc("MarkerTemplateEditor::initWidgets");
+    EnterProcStart("MarkerTemplateEditor::initWidgets");
 
     //Dialog Form
     this->setWindowTitle(tr("Marker Template Editor"));
@@ -151,7 +151,7 @@ void MarkerTemplateEditor::initWidgets()
 
 MarkerTemplateEditor::MarkerTemplateEditor(QWidget *parent, const QString &markerGUID, const QString &parentGUID) : QDialog(parent)
 {
-    EnterProc("MarkerTemplateEditor::MarkerTemplateEditor");
+    EnterProcStart("MarkerTemplateEditor::MarkerTemplateEditor");
 
     MarkerThesaurus& markerThesaurus = MarkerThesaurus::Instance();
     _markerTemplate = markerGUID != "" ? markerThesaurus.getMarkerTemplateByGUID(markerGUID) : nullptr ;
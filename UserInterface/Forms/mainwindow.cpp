@@ -36,12 +36,14 @@ MainWindow::MainWindow(QWidget *parent) : QWidget(parent)
                                             applicationSettings.OVRGimbalIndicatorType,
                                             applicationSettings.OVRGimbalIndicatorAngles,
                                             applicationSettings.OVRGimbalIndicatorSize,
-                                            applicationSettings.isLaserRangefinderLicensed());
+                                            applicationSettings.isLaserRangefinderLicensed(),
+                                            applicationSettings.TelemetryHistoryMemoryLimitMb);
     connect(_dataStorage, &TelemetryDataStorage::workModeChanged, this, &MainWindow::workModeChanged);
     connect(_dataStorage, &TelemetryDataStorage::storedDataReceived, this, &MainWindow::storedDataReceived);
 
     _hardwareLink = new HardwareLink(this);
-    connect(_hardwareLink, &HardwareLink::dataReceived, this, &MainWindow::hardwareLinkDataReceived);
+    connect(_hardwareLink, &HardwareLink::telemetryDataReceived, this, &MainWindow::hardwareLinkTelemetryReceived);
+    connect(_hardwareLink, &HardwareLink::videoDataReceived, this, &MainWindow::hardwareLinkVideoReceived);
     connect(_hardwareLink, &HardwareLink::onClientCommandSent, _dataStorage, &TelemetryDataStorage::onClientCommandSent);
 
 
@@ -59,10 +61,14 @@ MainWindow::MainWindow(QWidget *parent) : QWidget(parent)
 
     _imageProcessor = new ImageProcessor(this, coordinateCalculator,
                                          cameraSettings->opticalDeviceSetting(1)->UseVerticalFrameMirrororing, //todo set array for all optical systems [1, 2, 3]
-                                         applicationSettings.ObjectTrackerType);
+                                         applicationSettings.ObjectTrackerType,
+                                         applicationSettings.VideoProcessingQueueSize,
+                                         applicationSettings.VideoProcessingDropPolicy);
     _imageProcessor->setStabilizationType(applicationSettings.VideoStabilizationType);
 
     connect(_hardwareLink, &HardwareLink::onHardwareLinkStateChanged, this, &MainWindow::onHardwareLinkStateChanged);
+    connect(_imageProcessor, &ImageProcessor::onTelemetryProcessed, this, &MainWindow::onTelemetryReceived);
+    connect(_imageProcessor, &ImageProcessor::onTelemetryProcessed, _dataStorage, &TelemetryDataStorage::onTelemetryReceived);
     connect(_imageProcessor, &ImageProcessor::onDataProcessed, this, &MainWindow::onDataReceived);
     connect(_imageProcessor, &ImageProcessor::onDataProcessed, _dataStorage, &TelemetryDataStorage::onDataReceived);
 
@@ -521,12 +527,14 @@ void MainWindow::addWidgetsVideoDisplay()
     _videoWidget->setTargetSize(_camControlsWidget->selectedTargetSize());
 
     connect(_camControlsWidget, &CamControlsWidget::enableSoftwareStabilization, _videoWidget, &VideoDisplayWidget::onEnableStabilization);
+    connect(_camControlsWidget, &CamControlsWidget::enableSoftwareStabilization, _imageProcessor, &ImageProcessor::setStabilizationEnabled);
     if (_useMinimalisticDesign)
         _videoWidget->setMinimumSize(200, 50);
     else
         _videoWidget->setMinimumSize(200, 200);
 
     _videoWidget->onEnableStabilization(applicationSettings.SoftwareStabilizationEnabled);
+    _imageProcessor->setStabilizationEnabled(applicationSettings.SoftwareStabilizationEnabled);
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
@@ -534,7 +542,7 @@ void MainWindow::closeEvent(QCloseEvent *event)
     EnterProcStart("MainWindow::closeEvent");
 
     if (_dataConsole != nullptr)
-        _dataConsole->hide();
+        _dataConsole->close();
     if (_emulatorConsole != nullptr)
         _emulatorConsole->hide();
 
@@ -566,7 +574,7 @@ void MainWindow::onOpenApplicationSettingsEditorClicked()
 {
     EnterProcStart("MainWindow::onOpenApplicationSettingsEditorClicked");
     if (_dataConsole != nullptr)
-        _dataConsole->hide();
+        _dataConsole->close();
     if (_emulatorConsole != nullptr)
         _emulatorConsole->hide();
 
@@ -583,9 +591,15 @@ void MainWindow::onOpenDataConsoleClicked()
     if (_dataConsole == nullptr)
     {
         _dataConsole = new DataConsole(nullptr);
-        connect(_hardwareLink, &HardwareLink::onClientCommandSent, _dataConsole, &DataConsole::onHardwareLinkCommandSent);
-        connect(_hardwareLink, &HardwareLink::onTelemetryReceived, _dataConsole, &DataConsole::onHardwareLinkTelemetryReceived);
+        connect(_dataConsole, &DataConsole::closed, this, [this]()
+        {
+            disconnect(_hardwareLink, &HardwareLink::onClientCommandSent, _dataConsole, &DataConsole::onHardwareLinkCommandSent);
+            disconnect(_hardwareLink, &HardwareLink::onTelemetryReceived, _dataConsole, &DataConsole::onHardwareLinkTelemetryReceived);
+        });
     }
+    // HardwareLink formats the received data only while somebody is connected
+    connect(_hardwareLink, &HardwareLink::onClientCommandSent, _dataConsole, &DataConsole::onHardwareLinkCommandSent, Qt::UniqueConnection);
+    connect(_hardwareLink, &HardwareLink::onTelemetryReceived, _dataConsole, &DataConsole::onHardwareLinkTelemetryReceived, Qt::UniqueConnection);
     _dataConsole->show();
 }
 
@@ -628,6 +642,9 @@ void MainWindow::timeSliderValueChanged(int value)
     if (_dataStorage->getTelemetryDataFrameCount() == 0) // for first frame in RecordAndDisplay mode
         return;
 
+    if (value < _dataStorage->getFirstTelemetryDataFrameIndex()) // released by the telemetry memory limit
+        return;
+
     if (_playStatus == PlayRealtime)
         SetPlayStatus(Pause);
 
@@ -718,8 +735,16 @@ void MainWindow::onDataReceived(const TelemetryDataFrame &telemetryFrame, const
     EnterProcStart("MainWindow::onDataReceived");
 
     if (_playStatus == PlayStatus::PlayRealtime)
-    {
         _videoWidget->setData(telemetryFrame, videoFrame);
+}
+
+void MainWindow::onTelemetryReceived(const TelemetryDataFrame &telemetryFrame)
+{
+    EnterProcStart("MainWindow::onTelemetryReceived");
+
+    if (_playStatus == PlayStatus::PlayRealtime)
+    {
+        _videoWidget->setTelemetry(telemetryFrame);
         _artillerySpotter->processTelemetry(telemetryFrame);
         if (_mapView != nullptr)
             _mapView->processTelemetry(telemetryFrame);
@@ -737,32 +762,50 @@ void MainWindow::tuneImageChange(qreal brightness, qreal contrast, qreal gamma,
     _imageProcessor->setTuneImageSettings(brightness, contrast, gamma, grayscale);
 }
 
-void MainWindow::hardwareLinkDataReceived(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame)
+void MainWindow::hardwareLinkTelemetryReceived(const TelemetryDataFrame &telemetryFrame)
 {
-    EnterProcStart("MainWindow::hardwareLinkDataReceived");
+    EnterProcStart("MainWindow::hardwareLinkTelemetryReceived");
 
     if (_dataStorage->getWorkMode() == TelemetryDataStorage::WorkMode::PlayStored)
         return;
 
-    // 1. Video
-    //    if (videoFrame.isNull())
-    {
-        _imageProcessor->processDataAsync(telemetryFrame, videoFrame);
-        if (_playStatus == PlayRealtime)
-            _timeFromStartIndicator->display(_dataStorage->getLastTelemetryFrameTimeAsString());
-    }
+    _imageProcessor->processTelemetry(telemetryFrame);
 
-    // 2. Telemetry
     if (telemetryFrame.TelemetryFrameNumber > 0)
         if (_mapView != nullptr)
             _mapView->appendTrajectoryPoint(telemetryFrame);
 
+    updateRealtimeTimeIndicators();
+}
+
+void MainWindow::hardwareLinkVideoReceived(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame)
+{
+    EnterProcStart("MainWindow::hardwareLinkVideoReceived");
+
+    if (_dataStorage->getWorkMode() == TelemetryDataStorage::WorkMode::PlayStored)
+        return;
+
+    _imageProcessor->processDataAsync(telemetryFrame, videoFrame);
+
+    updateRealtimeTimeIndicators();
+}
+
+void MainWindow::updateRealtimeTimeIndicators()
+{
+    if (_playStatus == PlayRealtime)
+        _timeFromStartIndicator->display(_dataStorage->getLastTelemetryFrameTimeAsString());
+
     int timeSliderMax = _dataStorage->getTelemetryDataFrameCount() - 1;
     if (timeSliderMax < 0)
         timeSliderMax = 0;
     else if (timeSliderMax > 10)
         timeSliderMax = (timeSliderMax / 10) * 10;
     _timeSlider->setMaximum(timeSliderMax);
+
+    // the frames released by the memory limit can't be shown, moving the slider off them must not pause the playing
+    _timeSlider->blockSignals(true);
+    _timeSlider->setMinimum(qMin(_dataStorage->getFirstTelemetryDataFrameIndex(), timeSliderMax));
+    _timeSlider->blockSignals(false);
 }
 
 void MainWindow::storedDataReceived(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame)
@@ -106,6 +106,7 @@ private:
     void showModeSpecificWidgets(bool showCameraTab, bool showInstrumentsTab, bool showMarkersTab, bool showBombingTab,
                                  bool showPatrolTab, bool showAntennaTab, bool showTimeScale);
     void updateDashboardStatuses();
+    void updateRealtimeTimeIndicators();
 protected:
     void virtual closeEvent(QCloseEvent *event);
 private slots:
@@ -122,9 +123,11 @@ private slots:
     void playTimerTimeout();
 
     //slots for _hardwareLink
-    void hardwareLinkDataReceived(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame);
+    void hardwareLinkTelemetryReceived(const TelemetryDataFrame &telemetryFrame);
+    void hardwareLinkVideoReceived(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame);
     void onHardwareLinkStateChanged();
 
+    void onTelemetryReceived(const TelemetryDataFrame &telemetryFrame);
     void onDataReceived(const TelemetryDataFrame &telemetryFrame, const QImage &videoFrame);
     void tuneImageChange(qreal brightness, qreal contrast, qreal gamma, bool grayscale);
 
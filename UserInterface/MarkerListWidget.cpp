@@ -17,7 +17,7 @@ const QString EmptyGUID = QString("");
 
 MarkerListWidget::MarkerListWidget(QWidget *parent) : QWidget(parent)
 {
-    EnterProc("MarkerListWidget::MarkerListWidget");
+    EnterProcStart("MarkerListWidget::MarkerListWidget");
     auto verticalWindowLayout = new QVBoxLayout(this);
     verticalWindowLayout->setContentsMargins(0, 0, 0, 0);
     verticalWindowLayout->setSpacing(0);
@@ -39,7 +39,7 @@ MarkerListWidget::MarkerListWidget(QWidget *parent) : QWidget(parent)
 
 void MarkerListWidget::addMarkerTemplateToList(MarkerTemplate *markerTemplate, QTreeWidgetItem * parentItem)
 {
-    EnterProc("MarkerListWidget::addMarkerTemplateToList");
+    EnterProcStart("MarkerListWidget::addMarkerTemplateToList");
     auto newItem = new QTreeWidgetItem;
 
     if (parentItem == nullptr)
@@ -56,7 +56,7 @@ void MarkerListWidget::addMarkerTemplateToList(MarkerTemplate *markerTemplate, Q
 
 void MarkerListWidget::loadMarkerThesaurus()
 {
-    EnterProc("MarkerListWidget::loadMarkerThesaurus");
+    EnterProcStart("MarkerListWidget::loadMarkerThesaurus");
     MarkerThesaurus& markerThesaurus = MarkerThesaurus::Instance();
     _markerTree->clear();
     auto markerTemplates = *(markerThesaurus.getMarkerTemplates());
@@ -102,7 +102,7 @@ MarkerTemplate *MarkerTemplateTreeWidget::getItemTemplate(QTreeWidgetItem *item)
 
 void MarkerTemplateTreeWidget::mousePressEvent(QMouseEvent *event)
 {
-    EnterProc("MarkerListWidget::mousePressEvent");
+    EnterProcStart("MarkerListWidget::mousePressEvent");
     QTreeWidget::mousePressEvent(event);
 
     if (event->button() == Qt::RightButton)
@@ -158,7 +158,7 @@ void MarkerTemplateTreeWidget::mousePressEvent(QMouseEvent *event)
 
 void MarkerTemplateTreeWidget::mouseDoubleClickEvent(QMouseEvent *event)
 {
-    EnterProc("MarkerListWidget::mouseDoubleClickEvent");
+    EnterProcStart("MarkerListWidget::mouseDoubleClickEvent");
     auto item = this->itemAt(event->pos());
     openMarkerTemplateEditor(item);
 }
@@ -189,7 +189,7 @@ void MarkerTemplateTreeWidget::dragMoveEvent(QDragMoveEvent *event)
 
 void MarkerTemplateTreeWidget::dropEvent(QDropEvent *event)
 {
-    EnterProc("MapGraphicsView::dropEvent");
+    EnterProcStart("MapGraphicsView::dropEvent");
 
     if (event->mimeData()->hasFormat(MarkerTemplateMIMEFormat))
     {
@@ -241,7 +241,7 @@ void MarkerTemplateTreeWidget::initItem(QTreeWidgetItem *item, MarkerTemplate *m
 
 void MarkerTemplateTreeWidget::openMarkerTemplateEditor(QTreeWidgetItem *item)
 {
-    EnterProc("MarkerListWidget::openMarkerTemplateEditor");
+    EnterProcStart("MarkerListWidget::openMarkerTemplateEditor");
     auto markerTemplate = getItemTemplate(item);
     if (markerTemplate != nullptr)
     {
@@ -263,7 +263,7 @@ void MarkerTemplateTreeWidget::openMarkerTemplateEditor(QTreeWidgetItem *item)
 
 void MarkerTemplateTreeWidget::openNewMarkerTemplateEditor(QTreeWidgetItem *item)
 {    
-    EnterProc("MarkerListWidget::openNewMarkerTemplateEditor");
+    EnterProcStart("MarkerListWidget::openNewMarkerTemplateEditor");
     auto markerTemplate = getItemTemplate(item);
     MarkerTemplateEditor *editor;
     if (markerTemplate == nullptr)
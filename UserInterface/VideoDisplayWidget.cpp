@@ -144,9 +144,12 @@ void VideoDisplayWidget::saveSettings()
         cameraSettings->opticalDeviceSetting(opticalSystemId)->MagnifierScale->setValue(_camAssemblyPreferences->opticalDevice(opticalSystemId)->magnifierScale());
 }
 
+const qint64 VideoFrameTimeoutMs = 200;
+
 void VideoDisplayWidget::setData(const TelemetryDataFrame &telemetryFrame, const QImage &frame)
 {
     _frame = frame.copy();
+    _frameTimer.start();
     _telemetryFrame = telemetryFrame;
 
     if (_cursorMark.left() < 0)
@@ -156,6 +159,17 @@ void VideoDisplayWidget::setData(const TelemetryDataFrame &telemetryFrame, const
     this->repaint();
 }
 
+void VideoDisplayWidget::setTelemetry(const TelemetryDataFrame &telemetryFrame)
+{
+    // While the video goes the overlay shows the telemetry of the displayed frame,
+    // telemetry ticks repaint the widget only when there is no video
+    if (_frameTimer.isValid() && !_frameTimer.hasExpired(VideoFrameTimeoutMs))
+        return;
+
+    _telemetryFrame = telemetryFrame;
+    this->update();
+}
+
 void VideoDisplayWidget::clear()
 {
     _frame = QImage();
@@ -265,7 +279,6 @@ void VideoDisplayWidget::updateDrawParams()
 
 QPointF VideoDisplayWidget::alignPoint(const QPointF &point)
 {
-    //???rotation
     QPointF alignedPoint = point * _scale +
             _screenViewRect.center() -
             _sourceFrameRect.center() * _scale;
@@ -581,18 +594,7 @@ void VideoDisplayWidget::paintEvent(QPaintEvent *event)
 
     painter.save();
 
-    if (_enableStabilization && (qAbs(_telemetryFrame.StabilizedRotationAngle) >= 1) )
-    {
-        QPoint screenCenter = _screenViewRect.center();
-
-        qreal dx = screenCenter.x();
-        qreal dy = screenCenter.y();
-
-        painter.translate(dx, dy);
-        painter.rotate(-_telemetryFrame.StabilizedRotationAngle);
-        painter.translate(-dx, -dy);
-    }
-
+    // Rotation is compensated by the image processor, only the shift is left to the source rect
     painter.drawImage(_screenViewRect, _frame, _sourceFrameRect);
 
     drawMagnifier(painter);
@@ -10,6 +10,7 @@
 #include <QRect>
 #include <QDateTime>
 #include <QImage>
+#include <QElapsedTimer>
 #include "Common/CommonData.h"
 #include "CamPreferences.h"
 #include "VoiceInformant/VoiceInformant.h"
@@ -26,6 +27,7 @@ class VideoDisplayWidget final : public QWidget
 {
     Q_OBJECT
     QImage _frame;
+    QElapsedTimer _frameTimer;
     TelemetryDataFrame _telemetryFrame;
 
     bool _enableStabilization;
@@ -124,6 +126,7 @@ public:
     explicit VideoDisplayWidget(QWidget *parent, VoiceInformant *voiceInformant);
 
     void setData(const TelemetryDataFrame &telemetryFrame, const QImage &frame);
+    void setTelemetry(const TelemetryDataFrame &telemetryFrame);
     void clear();
     void saveScreenshot(const QString &screenShotFolder);
 public slots:
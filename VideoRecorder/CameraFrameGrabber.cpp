@@ -1,5 +1,6 @@
 #include "CameraFrameGrabber.h"
 #include <QImage>
+#include "HardwareLink/DelayLine.h"
 
 
 // https://stackoverflow.com/questions/70605931/qt6-using-qvideosink-with-qcamera-to-process-every-frame
@@ -34,6 +35,7 @@ bool CameraFrameGrabber::present(const QVideoFrame &frame)
 
 void CameraFrameGrabber::processFrameInternal(const QVideoFrame &frame)
 {
+    qint64 arrivalTimeMs = getDelayLineTimeMs();
     auto outImage = frame.toImage();
-    emit frameAvailable(outImage, _videoConnectionId);
+    emit frameAvailable(outImage, _videoConnectionId, arrivalTimeMs);
 }
@@ -17,7 +17,8 @@ public:
 private slots:
     void processFrameInternal(const QVideoFrame &frame);
 signals:
-    void frameAvailable(const QImage &frame, quint32 videoConnectionId);
+    // arrivalTimeMs is the time of getDelayLineTimeMs() when the frame is received
+    void frameAvailable(const QImage &frame, quint32 videoConnectionId, qint64 arrivalTimeMs);
 };
 
 #endif // CAMERAFRAMEGRABBER_H
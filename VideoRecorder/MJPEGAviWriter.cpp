@@ -0,0 +1,202 @@
+#include "MJPEGAviWriter.h"
+#include <QtEndian>
+
+// http://www.alexander-noe.com/video/documentation/avi.pdf
+
+constexpr quint32 AVIF_HASINDEX = 0x00000010;
+constexpr quint32 AVIIF_KEYFRAME = 0x00000010;
+
+constexpr qint64 RIFF_SIZE_POS = 4;
+constexpr qint64 AVIH_TOTAL_FRAMES_POS = 48;
+constexpr qint64 AVIH_SUGGESTED_BUFFER_SIZE_POS = 60;
+constexpr qint64 STRH_LENGTH_POS = 140;
+constexpr qint64 STRH_SUGGESTED_BUFFER_SIZE_POS = 144;
+
+MJPEGAviWriter::MJPEGAviWriter()
+{
+    _frameWidth = 0;
+    _frameHeight = 0;
+    _frameRate = 0;
+    _maxFrameSize = 0;
+    _moviListPos = 0;
+}
+
+MJPEGAviWriter::~MJPEGAviWriter()
+{
+    close();
+}
+
+void MJPEGAviWriter::writeFourCC(const char *fourCC)
+{
+    _file.write(fourCC, 4);
+}
+
+void MJPEGAviWriter::writeUInt32(quint32 value)
+{
+    quint32 leValue = qToLittleEndian(value);
+    _file.write((const char *)&leValue, sizeof(leValue));
+}
+
+void MJPEGAviWriter::writeUInt16(quint16 value)
+{
+    quint16 leValue = qToLittleEndian(value);
+    _file.write((const char *)&leValue, sizeof(leValue));
+}
+
+void MJPEGAviWriter::patchUInt32(qint64 pos, quint32 value)
+{
+    _file.seek(pos);
+    writeUInt32(value);
+}
+
+void MJPEGAviWriter::writeHeaders()
+{
+    const quint32 frameBytes = _frameWidth * _frameHeight * 3;
+
+    writeFourCC("RIFF");
+    writeUInt32(0);                     // patched on close
+    writeFourCC("AVI ");
+
+    writeFourCC("LIST");
+    writeUInt32(192);
+    writeFourCC("hdrl");
+
+    // MainAVIHeader
+    writeFourCC("avih");
+    writeUInt32(56);
+    writeUInt32(1000000 / _frameRate);  // dwMicroSecPerFrame
+    writeUInt32(frameBytes * _frameRate); // dwMaxBytesPerSec
+    writeUInt32(0);                     // dwPaddingGranularity
+    writeUInt32(AVIF_HASINDEX);         // dwFlags
+    writeUInt32(0);                     // dwTotalFrames, patched on close
+    writeUInt32(0);                     // dwInitialFrames
+    writeUInt32(1);                     // dwStreams
+    writeUInt32(0);                     // dwSuggestedBufferSize, patched on close
+    writeUInt32(_frameWidth);
+    writeUInt32(_frameHeight);
+    for (int i = 0; i < 4; i++)
+        writeUInt32(0);                 // dwReserved
+
+    writeFourCC("LIST");
+    writeUInt32(116);
+    writeFourCC("strl");
+
+    // AVIStreamHeader
+    writeFourCC("strh");
+    writeUInt32(56);
+    writeFourCC("vids");
+    writeFourCC("MJPG");
+    writeUInt32(0);                     // dwFlags
+    writeUInt16(0);                     // wPriority
+    writeUInt16(0);                     // wLanguage
+    writeUInt32(0);                     // dwInitialFrames
+    writeUInt32(1);                     // dwScale
+    writeUInt32(_frameRate);            // dwRate
+    writeUInt32(0);                     // dwStart
+    writeUInt32(0);                     // dwLength, patched on close
+    writeUInt32(0);                     // dwSuggestedBufferSize, patched on close
+    writeUInt32(0xFFFFFFFF);            // dwQuality
+    writeUInt32(0);                     // dwSampleSize
+    writeUInt16(0);                     // rcFrame
+    writeUInt16(0);
+    writeUInt16(_frameWidth);
+    writeUInt16(_frameHeight);
+
+    // BITMAPINFOHEADER
+    writeFourCC("strf");
+    writeUInt32(40);
+    writeUInt32(40);                    // biSize
+    writeUInt32(_frameWidth);
+    writeUInt32(_frameHeight);
+    writeUInt16(1);                     // biPlanes
+    writeUInt16(24);                    // biBitCount
+    writeFourCC("MJPG");                // biCompression
+    writeUInt32(frameBytes);            // biSizeImage
+    writeUInt32(0);                     // biXPelsPerMeter
+    writeUInt32(0);                     // biYPelsPerMeter
+    writeUInt32(0);                     // biClrUsed
+    writeUInt32(0);                     // biClrImportant
+
+    _moviListPos = _file.pos();
+    writeFourCC("LIST");
+    writeUInt32(0);                     // patched on close
+    writeFourCC("movi");
+}
+
+bool MJPEGAviWriter::open(const QString &fileName, quint32 frameWidth, quint32 frameHeight, quint32 frameRate)
+{
+    close();
+
+    _frameWidth = frameWidth;
+    _frameHeight = frameHeight;
+    _frameRate = frameRate > 0 ? frameRate : 1;
+    _maxFrameSize = 0;
+    _index.clear();
+
+    _file.setFileName(fileName);
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    writeHeaders();
+    return true;
+}
+
+bool MJPEGAviWriter::writeFrame(const QByteArray &jpegData)
+{
+    if (!_file.isOpen())
+        return false;
+
+    IndexEntry entry;
+    entry.Offset = _file.pos() - (_moviListPos + 8);
+    entry.Size = jpegData.size();
+
+    writeFourCC("00dc");
+    writeUInt32(entry.Size);
+    _file.write(jpegData);
+    if (entry.Size % 2 != 0)
+        _file.putChar(0);
+
+    _index.append(entry);
+    if (_maxFrameSize < entry.Size)
+        _maxFrameSize = entry.Size;
+
+    return _file.error() == QFileDevice::NoError;
+}
+
+void MJPEGAviWriter::close()
+{
+    if (!_file.isOpen())
+        return;
+
+    qint64 idx1Pos = _file.pos();
+    writeFourCC("idx1");
+    writeUInt32(_index.count() * 16);
+    foreach (auto entry, _index)
+    {
+        writeFourCC("00dc");
+        writeUInt32(AVIIF_KEYFRAME);
+        writeUInt32(entry.Offset);
+        writeUInt32(entry.Size);
+    }
+    qint64 fileSize = _file.pos();
+
+    patchUInt32(RIFF_SIZE_POS, fileSize - 8);
+    patchUInt32(AVIH_TOTAL_FRAMES_POS, _index.count());
+    patchUInt32(AVIH_SUGGESTED_BUFFER_SIZE_POS, _maxFrameSize + 8);
+    patchUInt32(STRH_LENGTH_POS, _index.count());
+    patchUInt32(STRH_SUGGESTED_BUFFER_SIZE_POS, _maxFrameSize + 8);
+    patchUInt32(_moviListPos + 4, idx1Pos - (_moviListPos + 8));
+
+    _file.close();
+    _index.clear();
+}
+
+bool MJPEGAviWriter::isOpen() const
+{
+    return _file.isOpen();
+}
+
+quint32 MJPEGAviWriter::frameCount() const
+{
+    return _index.count();
+}
@@ -0,0 +1,41 @@
+#ifndef MJPEGAVIWRITER_H
+#define MJPEGAVIWRITER_H
+
+#include <QFile>
+#include <QByteArray>
+#include <QVector>
+
+// Minimal RIFF AVI 1.0 container for intra-only MJPEG streams.
+// Each frame is a complete JPEG image, the index (idx1) and header lengths are written on close().
+class MJPEGAviWriter final
+{
+    struct IndexEntry
+    {
+        quint32 Offset;
+        quint32 Size;
+    };
+
+    QFile _file;
+    quint32 _frameWidth, _frameHeight;
+    quint32 _frameRate;
+    quint32 _maxFrameSize;
+    qint64 _moviListPos;
+    QVector<IndexEntry> _index;
+
+    void writeFourCC(const char *fourCC);
+    void writeUInt32(quint32 value);
+    void writeUInt16(quint16 value);
+    void patchUInt32(qint64 pos, quint32 value);
+    void writeHeaders();
+public:
+    MJPEGAviWriter();
+    ~MJPEGAviWriter();
+
+    bool open(const QString &fileName, quint32 frameWidth, quint32 frameHeight, quint32 frameRate);
+    bool writeFrame(const QByteArray &jpegData);
+    void close();
+    bool isOpen() const;
+    quint32 frameCount() const;
+};
+
+#endif // MJPEGAVIWRITER_H
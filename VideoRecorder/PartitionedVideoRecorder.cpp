@@ -2,13 +2,59 @@
 #include <QTime>
 #include <QDebug>
 #include <QImage>
+#include <QBuffer>
+#include <QMutexLocker>
 #include "Common/CommonData.h"
 
+constexpr int ENCODER_MAX_THREAD_COUNT = 3;
+constexpr int ENCODER_PENDING_FRAMES_PER_THREAD = 2;
 
-void PartitionedVideoRecorder::swapVideoFiles()
+void PartitionedVideoRecorder::swapVideoFiles(quint32 frameNumber)
 {
-    QString fileName = getVideoFileNameForFrame(_fileDirecory, _recordName, _videoFileFrameCount, _frameNumber);
+    QString fileName = getVideoFileNameForFrame(_fileDirecory, _recordName, _videoFileFrameCount, frameNumber);
 
+    _videoWriter.close();
+    if (!_videoWriter.open(fileName, _frameWidth, _frameHeight, VIDEO_FILE_FRAME_FREQUENCY))
+        qDebug() << "Unable to create video file " << fileName;
+}
+
+void PartitionedVideoRecorder::encodeFrame(quint32 frameNumber, const QImage &frame, const FrameOverlay &overlay,
+                                           quint32 frameWidth, quint32 frameHeight, quint32 quality)
+{
+    QImage image = frame;
+    if (image.width() != (int)frameWidth || image.height() != (int)frameHeight)
+        image = image.scaled(frameWidth, frameHeight);
+    if (overlay)
+        overlay(image);
+
+    QByteArray jpegData;
+    QBuffer buffer(&jpegData);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "JPG", quality);
+
+    QMutexLocker locker(&_writerMutex);
+    _encodedFrames.insert(frameNumber, jpegData);
+    writeEncodedFrames();
+}
+
+// Must be called with _writerMutex locked
+void PartitionedVideoRecorder::writeEncodedFrames()
+{
+    auto i = _encodedFrames.begin();
+    while (i != _encodedFrames.end() && i.key() == _nextFrameNumberToWrite)
+    {
+        if (!i.value().isNull())
+            _lastWrittenFrame = i.value();
+
+        if (_nextFrameNumberToWrite == 0 || (_videoFileFrameCount > 0 && _nextFrameNumberToWrite % _videoFileFrameCount == 0))
+            swapVideoFiles(_nextFrameNumberToWrite);
+
+        _videoWriter.writeFrame(_lastWrittenFrame);
+        _writtenFrameCount.fetchAndAddRelaxed(1);
+
+        i = _encodedFrames.erase(i);
+        _nextFrameNumberToWrite++;
+    }
 }
 
 PartitionedVideoRecorder::PartitionedVideoRecorder(QObject *parent) : QObject(parent)
@@ -16,7 +62,13 @@ PartitionedVideoRecorder::PartitionedVideoRecorder(QObject *parent) : QObject(pa
     _frameNumber = 0;
     _frameWidth = 0;
     _frameHeight = 0;
+    _videoFileFrameCount = VIDEO_FRAMES_PER_FILE_DEFAULT;
     _videoFileQuality = VIDEO_FILE_QUALITY_DEFAULT;
+    _nextFrameNumberToWrite = 0;
+
+    _encoderPool = new QThreadPool(this);
+    _encoderPool->setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, ENCODER_MAX_THREAD_COUNT));
+    _maxPendingFrameCount = _encoderPool->maxThreadCount() * ENCODER_PENDING_FRAMES_PER_THREAD;
 }
 
 PartitionedVideoRecorder::~PartitionedVideoRecorder()
@@ -34,14 +86,31 @@ void PartitionedVideoRecorder::start(const QString &fileDirecory, const QString
     _recordName = recordName;
     _videoFileFrameCount = videoFileFrameCount;
     _videoFileQuality = videoFileQuality;
+    _nextFrameNumberToWrite = 0;
+    _pendingFrameCount = 0;
+    _droppedFrameCount = 0;
+    _writtenFrameCount = 0;
 }
 
 void PartitionedVideoRecorder::stop()
 {
+    _encoderPool->waitForDone();
+
+    QMutexLocker locker(&_writerMutex);
+    writeEncodedFrames();
+    if (!_encodedFrames.isEmpty())
+        qDebug() << "Video recorder lost " << _encodedFrames.count() << " frames";
+    _encodedFrames.clear();
+    _lastWrittenFrame.clear();
+    _videoWriter.close();
 
+    if (_frameNumber > 0)
+        qDebug() << "Video recorder stopped. Frames: " << _frameNumber << " Dropped: " << droppedFrameCount();
+    _frameNumber = 0;
+    _nextFrameNumberToWrite = 0;
 }
 
-void PartitionedVideoRecorder::saveFrame(const QImage &frame)
+void PartitionedVideoRecorder::saveFrame(const QImage &frame, const FrameOverlay &overlay)
 {
     if (_frameNumber == 0)
     {
@@ -50,10 +119,26 @@ void PartitionedVideoRecorder::saveFrame(const QImage &frame)
         qDebug() << "Frame Size: " << _frameWidth << " x " << _frameHeight;
     }
 
-    if (_frameNumber == 0 || (_videoFileFrameCount > 0 && _frameNumber % _videoFileFrameCount == 0))
-        swapVideoFiles();
+    quint32 frameNumber = _frameNumber++;
 
-    _frameNumber++;
+    // The frame number is reserved even for a dropped frame, so video positions stay in sync with the telemetry index
+    if (_pendingFrameCount.loadRelaxed() >= _maxPendingFrameCount)
+    {
+        _droppedFrameCount.fetchAndAddRelaxed(1);
+        QMutexLocker locker(&_writerMutex);
+        _encodedFrames.insert(frameNumber, QByteArray());
+        return;
+    }
+
+    _pendingFrameCount.fetchAndAddRelaxed(1);
+    quint32 frameWidth = _frameWidth;
+    quint32 frameHeight = _frameHeight;
+    quint32 quality = _videoFileQuality;
+    _encoderPool->start([=]()
+    {
+        encodeFrame(frameNumber, frame, overlay, frameWidth, frameHeight, quality);
+        _pendingFrameCount.fetchAndAddRelaxed(-1);
+    });
 }
 
 quint32 PartitionedVideoRecorder::frameWidth()
@@ -66,6 +151,26 @@ quint32 PartitionedVideoRecorder::frameHeight()
     return _frameHeight;
 }
 
+quint32 PartitionedVideoRecorder::frameCount() const
+{
+    return _frameNumber;
+}
+
+quint32 PartitionedVideoRecorder::writtenFrameCount() const
+{
+    return _writtenFrameCount.loadRelaxed();
+}
+
+quint32 PartitionedVideoRecorder::droppedFrameCount() const
+{
+    return _droppedFrameCount.loadRelaxed();
+}
+
+quint32 PartitionedVideoRecorder::pendingFrameCount() const
+{
+    return _pendingFrameCount.loadRelaxed();
+}
+
 QString getVideoFileNameForFrame(const QString &fileDirecory, const QString &recordName, quint32 videoFileFrameCount, quint32 frameNumber)
 {
     quint32 partNumber = videoFileFrameCount > 0 ? frameNumber / videoFileFrameCount + 1 : 1;
@@ -2,25 +2,56 @@
 #define PARTITIONEDVIDEORECORDER_H
 
 #include <QObject>
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QThreadPool>
+#include <functional>
+#include "MJPEGAviWriter.h"
 
 class PartitionedVideoRecorder final : public QObject
 {
     Q_OBJECT
+public:
+    typedef std::function<void(QImage &frame)> FrameOverlay;
+private:
     quint32 _frameNumber;
     quint32 _frameWidth, _frameHeight;
     QString _fileDirecory, _recordName;
     quint32 _videoFileFrameCount;
     quint32 _videoFileQuality;
 
-    void swapVideoFiles();
+    QThreadPool *_encoderPool;
+    qint32 _maxPendingFrameCount;
+    QAtomicInt _pendingFrameCount;
+    QAtomicInt _droppedFrameCount;
+
+    // Frames are encoded in parallel and written strictly in order.
+    // Encoded frames waiting for their predecessors are kept in _encodedFrames,
+    // dropped frames are kept there as null arrays and replaced by the previous image.
+    QMutex _writerMutex;
+    QMap<quint32, QByteArray> _encodedFrames;
+    quint32 _nextFrameNumberToWrite;
+    QByteArray _lastWrittenFrame;
+    MJPEGAviWriter _videoWriter;
+    QAtomicInt _writtenFrameCount;
+
+    void swapVideoFiles(quint32 frameNumber);
+    void encodeFrame(quint32 frameNumber, const QImage &frame, const FrameOverlay &overlay, quint32 frameWidth, quint32 frameHeight, quint32 quality);
+    void writeEncodedFrames();
 public:
     explicit PartitionedVideoRecorder(QObject *parent);
     ~PartitionedVideoRecorder();
     void start(const QString &fileDirecory, const QString &recordName, quint32 videoFileFrameCount, quint32 videoFileQuality);
     void stop();
-    void saveFrame(const QImage &frame);
+    void saveFrame(const QImage &frame, const FrameOverlay &overlay = nullptr);
     quint32 frameWidth();
     quint32 frameHeight();
+    quint32 frameCount() const;
+    quint32 writtenFrameCount() const;
+    quint32 droppedFrameCount() const;
+    quint32 pendingFrameCount() const;
 };
 
 QString getVideoFileNameForFrame(const QString &fileDirecory, const QString &recordName, const quint32 videoFileFrameCount, const quint32 frameNumber);
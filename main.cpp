@@ -13,6 +13,8 @@
 #include "EnterProc.h"
 #include "Common/CommonUtils.h"
 #include "Common/CommonWidgets.h"
+#include "PipelineBenchmark.h"
+#include "Map/MapTilePack.h"
 #include "omp.h"
 
 QString logFilePath;
@@ -104,6 +106,36 @@ int main(int argc, char *argv[])
     qInfo() << "OMP Max Threads:" << omp_get_max_threads();
     qInfo() << "OMP Num Procs:" << omp_get_num_procs();
 
+    // Headless pipeline benchmark: BENCHMARK=<seconds> [BENCHMARK_RECORD=1] [BENCHMARK_TELEMETRY_WITH_VIDEO=1],
+    // run with -platform offscreen without a display
+    int benchmarkDurationSec = getCommandLineValue(app.arguments(), "BENCHMARK").toInt();
+    if (benchmarkDurationSec > 0)
+    {
+        ApplicationSettings& applicationSettings = ApplicationSettings::Instance();
+        EnterProc::setEnableComputingStatistics(applicationSettings.EnableComputingStatistics);
+
+        bool recordSession = getCommandLineValue(app.arguments(), "BENCHMARK_RECORD") == "1";
+        bool telemetryWithVideo = getCommandLineValue(app.arguments(), "BENCHMARK_TELEMETRY_WITH_VIDEO") == "1";
+        PipelineBenchmark benchmark(nullptr, benchmarkDurationSec, recordSession, telemetryWithVideo);
+        QObject::connect(&benchmark, &PipelineBenchmark::finished, &app, &QApplication::quit);
+        benchmark.start();
+        int benchmarkResult = app.exec();
+
+        EnterProc::outStatisticsToDebug(StatisticsSortMode::SortByProcName);
+        return benchmarkResult;
+    }
+
+    // Tile pack tool: TILEPACK_CONVERT=<source> TILEPACK_OUT=<destination>, *.db <-> *.tpk by the source extension
+    QString tilePackSourceFileName = getCommandLineValue(app.arguments(), "TILEPACK_CONVERT");
+    if (!tilePackSourceFileName.isEmpty())
+    {
+        QString tilePackDestFileName = getCommandLineValue(app.arguments(), "TILEPACK_OUT");
+        bool isConverted = MapTilePack::isTilePackFile(tilePackSourceFileName) ?
+                    MapTilePack::convertToDatabase(tilePackSourceFileName, tilePackDestFileName) :
+                    MapTilePack::convertFromDatabase(tilePackSourceFileName, tilePackDestFileName);
+        return isConverted ? 0 : 1;
+    }
+
     QSplashScreen *splashScreen = nullptr;
     if (getAnimusLicenseState() != AnimusLicenseState::Licended)
         splashScreen = makeSplashScreen();